@@ -136,8 +136,9 @@ extern const uint8_t gUseRtos_c;
 #elif defined(SDK_OS_FREE_RTOS)
 #define USE_RTOS (1)
 #if (defined(GENERIC_LIST_LIGHT) && (GENERIC_LIST_LIGHT > 0U))
-#if (defined(configSUPPORT_STATIC_ALLOCATION) && (configSUPPORT_STATIC_ALLOCATION > 0U)) && \
-    !((defined(configSUPPORT_DYNAMIC_ALLOCATION) && (configSUPPORT_DYNAMIC_ALLOCATION > 0U)))
+#if (defined(STATIC_ALLOCATION_ENABLE) && (STATIC_ALLOCATION_ENABLE > 0U)) || \
+    ((defined(configSUPPORT_STATIC_ALLOCATION) && (configSUPPORT_STATIC_ALLOCATION > 0U)) && \
+     !((defined(configSUPPORT_DYNAMIC_ALLOCATION) && (configSUPPORT_DYNAMIC_ALLOCATION > 0U))))
 #define OSA_TASK_HANDLE_SIZE (150U)
 #else
 #define OSA_TASK_HANDLE_SIZE (12U)
@@ -145,33 +146,38 @@ extern const uint8_t gUseRtos_c;
 #else
 #define OSA_TASK_HANDLE_SIZE (16U)
 #endif
-#if (defined(configSUPPORT_STATIC_ALLOCATION) && (configSUPPORT_STATIC_ALLOCATION > 0U)) && \
-    !((defined(configSUPPORT_DYNAMIC_ALLOCATION) && (configSUPPORT_DYNAMIC_ALLOCATION > 0U)))
+#if (defined(STATIC_ALLOCATION_ENABLE) && (STATIC_ALLOCATION_ENABLE > 0U)) || \
+    ((defined(configSUPPORT_STATIC_ALLOCATION) && (configSUPPORT_STATIC_ALLOCATION > 0U)) && \
+     !((defined(configSUPPORT_DYNAMIC_ALLOCATION) && (configSUPPORT_DYNAMIC_ALLOCATION > 0U))))
 #define OSA_EVENT_HANDLE_SIZE (40U)
 #else
 #define OSA_EVENT_HANDLE_SIZE (8U)
 #endif
-#if (defined(configSUPPORT_STATIC_ALLOCATION) && (configSUPPORT_STATIC_ALLOCATION > 0U)) && \
-    !((defined(configSUPPORT_DYNAMIC_ALLOCATION) && (configSUPPORT_DYNAMIC_ALLOCATION > 0U)))
+#if (defined(STATIC_ALLOCATION_ENABLE) && (STATIC_ALLOCATION_ENABLE > 0U)) || \
+    ((defined(configSUPPORT_STATIC_ALLOCATION) && (configSUPPORT_STATIC_ALLOCATION > 0U)) && \
+     !((defined(configSUPPORT_DYNAMIC_ALLOCATION) && (configSUPPORT_DYNAMIC_ALLOCATION > 0U))))
 #define OSA_SEM_HANDLE_SIZE (84U)
 #else
 #define OSA_SEM_HANDLE_SIZE (4U)
 #endif
-#if (defined(configSUPPORT_STATIC_ALLOCATION) && (configSUPPORT_STATIC_ALLOCATION > 0U)) && \
-    !((defined(configSUPPORT_DYNAMIC_ALLOCATION) && (configSUPPORT_DYNAMIC_ALLOCATION > 0U)))
+#if (defined(STATIC_ALLOCATION_ENABLE) && (STATIC_ALLOCATION_ENABLE > 0U)) || \
+    ((defined(configSUPPORT_STATIC_ALLOCATION) && (configSUPPORT_STATIC_ALLOCATION > 0U)) && \
+     !((defined(configSUPPORT_DYNAMIC_ALLOCATION) && (configSUPPORT_DYNAMIC_ALLOCATION > 0U))))
 #define OSA_MUTEX_HANDLE_SIZE (84U)
 #else
 #define OSA_MUTEX_HANDLE_SIZE (4U)
 #endif
-#if (defined(configSUPPORT_STATIC_ALLOCATION) && (configSUPPORT_STATIC_ALLOCATION > 0U)) && \
-    !((defined(configSUPPORT_DYNAMIC_ALLOCATION) && (configSUPPORT_DYNAMIC_ALLOCATION > 0U)))
+#if (defined(STATIC_ALLOCATION_ENABLE) && (STATIC_ALLOCATION_ENABLE > 0U)) || \
+    ((defined(configSUPPORT_STATIC_ALLOCATION) && (configSUPPORT_STATIC_ALLOCATION > 0U)) && \
+     !((defined(configSUPPORT_DYNAMIC_ALLOCATION) && (configSUPPORT_DYNAMIC_ALLOCATION > 0U))))
 #define OSA_MSGQ_HANDLE_SIZE (84U)
 #else
 #define OSA_MSGQ_HANDLE_SIZE (4U)
 #endif
 #define OSA_MSG_HANDLE_SIZE   (0U)
-#if (defined(configSUPPORT_STATIC_ALLOCATION) && (configSUPPORT_STATIC_ALLOCATION > 0U)) && \
-    !((defined(configSUPPORT_DYNAMIC_ALLOCATION) && (configSUPPORT_DYNAMIC_ALLOCATION > 0U)))
+#if (defined(STATIC_ALLOCATION_ENABLE) && (STATIC_ALLOCATION_ENABLE > 0U)) || \
+    ((defined(configSUPPORT_STATIC_ALLOCATION) && (configSUPPORT_STATIC_ALLOCATION > 0U)) && \
+     !((defined(configSUPPORT_DYNAMIC_ALLOCATION) && (configSUPPORT_DYNAMIC_ALLOCATION > 0U))))
 #define OSA_TIMER_HANDLE_SIZE (48U)
 #else
 #define OSA_TIMER_HANDLE_SIZE (4U)
@@ -298,8 +304,9 @@ extern const uint8_t gUseRtos_c;
     static const osa_task_def_t os_thread_def_##name = {                                \
         (name), (priority), (instances), (stackSz), s_stackBuffer##name, NULL, (uint8_t *)#name, (useFloat)}
 #else
-#if (defined(configSUPPORT_STATIC_ALLOCATION) && (configSUPPORT_STATIC_ALLOCATION > 0U)) && \
-    !((defined(configSUPPORT_DYNAMIC_ALLOCATION) && (configSUPPORT_DYNAMIC_ALLOCATION > 0U)))
+#if (defined(STATIC_ALLOCATION_ENABLE) && (STATIC_ALLOCATION_ENABLE > 0U)) || \
+    ((defined(configSUPPORT_STATIC_ALLOCATION) && (configSUPPORT_STATIC_ALLOCATION > 0U)) && \
+     !((defined(configSUPPORT_DYNAMIC_ALLOCATION) && (configSUPPORT_DYNAMIC_ALLOCATION > 0U))))
 #define OSA_TASK_DEFINE(name, priority, instances, stackSz, useFloat)                   \
     uint32_t s_stackBuffer##name[(stackSz + sizeof(uint32_t) - 1U) / sizeof(uint32_t)]; \
     static const osa_task_def_t os_thread_def_##name = {                                \
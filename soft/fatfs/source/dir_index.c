@@ -0,0 +1,1525 @@
+/*
+ * dir_index.c
+ *
+ *  Created on: 2026/10/18
+ *      Author: M.Akino
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "fsl_common.h"
+#include "dir_index.h"
+#include "diskio.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "semphr.h"
+
+#if ((defined DIR_INDEX_ENABLE) && (DIR_INDEX_ENABLE))
+
+/*
+ * f_readdir hands out one entry at a time and f_open/f_stat compare the names entry by entry, with thousands
+ * of samples in a folder both take long. The index file keeps the entries sorted by name and a {hash, entry}
+ * table sorted by hash, a listing is a sequential read and a lookup a binary search.
+ * FAT keeps no modification time for directories, an index is checked against an FNV-1a hash of the raw
+ * directory entries instead: the directory sectors are read a few at a time with disk_read and hashed up to
+ * the end mark. The entries of the index file are left out, so writing the index does not change the hash.
+ * A build lists the directory with f_readdir next to the raw walk, which supplies the first clusters, sorts
+ * the records in runs of the work buffer and merges them three at a time in the scratch area of the index
+ * file behind the final layout. The file is truncated to the layout at the end.
+ * The index file is contiguous, the walk finds its first cluster and an open index is read by sector through
+ * the disk cache. f_open would search the directory for the name once more.
+ * The walk matches the index file by name only, a file is rewritten or deleted only when its first sector
+ * starts with DIR_INDEX_MAGIC. A build writes the header with the magic first, so an interrupted build is
+ * still recognised.
+ * Lock order: index lock -> volume -> cache -> drive.
+ */
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+
+#if !FF_USE_EXPAND
+#error "the directory index needs FF_USE_EXPAND"
+#endif
+
+#if (defined(STATIC_ALLOCATION_ENABLE) && (STATIC_ALLOCATION_ENABLE > 0U))
+#define DIR_INDEX_MUTEX_CREATE() xSemaphoreCreateMutexStatic(&s_dirIndexMutexBuffer)
+#else
+#define DIR_INDEX_MUTEX_CREATE() xSemaphoreCreateMutex()
+#endif
+/* calls made before DirIndex_Init (single task) are not locked */
+#define DIR_INDEX_LOCK()                                            \
+    do                                                              \
+    {                                                               \
+        if (s_dirIndexMutex != NULL)                                \
+        {                                                           \
+            (void)xSemaphoreTake(s_dirIndexMutex, portMAX_DELAY);   \
+        }                                                           \
+    } while (0)
+#define DIR_INDEX_UNLOCK()                                          \
+    do                                                              \
+    {                                                               \
+        if (s_dirIndexMutex != NULL)                                \
+        {                                                           \
+            (void)xSemaphoreGive(s_dirIndexMutex);                  \
+        }                                                           \
+    } while (0)
+
+#if FF_FS_REENTRANT
+#define DIR_INDEX_VOLUME_LOCK(fs) ff_mutex_take((fs)->ldrv)
+#define DIR_INDEX_VOLUME_UNLOCK(fs) ff_mutex_give((fs)->ldrv)
+#else
+#define DIR_INDEX_VOLUME_LOCK(fs) (1)
+#define DIR_INDEX_VOLUME_UNLOCK(fs)
+#endif
+
+/* directory sectors per disk_read */
+#define DIR_INDEX_WALK_SECTORS (4U)
+
+/* work buffer: two FAT sectors, walk sectors and a run while the directory is listed, four streams after */
+#define DIR_INDEX_WALK_SIZE (DIR_INDEX_WALK_SECTORS * FF_MAX_SS)
+#define DIR_INDEX_FAT_SIZE (2U * FF_MAX_SS)
+#define DIR_INDEX_RUN_SIZE (DIR_INDEX_WORK_SIZE - DIR_INDEX_WALK_SIZE - DIR_INDEX_FAT_SIZE)
+#define DIR_INDEX_STREAM_SIZE (DIR_INDEX_WORK_SIZE / 4U)
+
+/* runs merged at once, one stream is the output */
+#define DIR_INDEX_MERGE_WAYS (3U)
+
+/* a sort record is a 16 bit payload length and the payload: an entry and its name, or a hash and an entry number */
+#define DIR_INDEX_HASH_RECORD (2U + 8U)
+
+/* fast seek link map of the index file while it is built, a contiguous file needs four items */
+#define DIR_INDEX_LINK_MAP (16U)
+
+/* short name of DIR_INDEX_FILE_NAME */
+#define DIR_INDEX_SFN "DIRINDEXIDX"
+
+#define DIR_INDEX_ATTR_MASK (0x37U) /* FILINFO fattrib */
+#define DIR_INDEX_ATTR_LFN (0x0FU)
+#define DIR_INDEX_ATTR_VOL (0x08U)
+#define DIR_INDEX_DELETED (0xE5U)
+
+#define DIR_INDEX_FNV_BASIS (2166136261U)
+#define DIR_INDEX_FNV_PRIME (16777619U)
+
+typedef FRESULT (*dir_index_visit_t)(DWORD sclust, FSIZE_t size, BYTE attr);
+
+/*! @brief raw directory walk */
+typedef struct _dir_index_walk
+{
+    uint32_t hash;     /*!< FNV-1a of the entries */
+    uint32_t raw;      /*!< entries hashed */
+    uint32_t files;    /*!< files and directories */
+    uint32_t names;    /*!< upper bound of the name bytes with the terminators */
+    uint8_t lfn;       /*!< FAT: LFN entries since the last short entry */
+    uint8_t secondary; /*!< exFAT: secondary entries of the set still to come */
+    uint8_t held;      /*!< exFAT: entries of a set that may be the index file, not hashed yet */
+    uint8_t nameLen;   /*!< exFAT: name length of the set */
+    BYTE attr;         /*!< exFAT: attributes of the set */
+    BYTE flags;        /*!< exFAT: stream flags of the set */
+    DWORD sclust;      /*!< exFAT: first cluster of the set */
+    FSIZE_t size;      /*!< exFAT: size of the set */
+    uint8_t index;     /*!< the index file is in the directory */
+    uint8_t indexFat;  /*!< its clusters are chained in the FAT */
+    DWORD indexClust;  /*!< its first cluster */
+    FSIZE_t indexSize; /*!< its size */
+    BYTE set[3 * 32];  /*!< exFAT: held entries */
+} dir_index_walk_t;
+
+/*! @brief buffered run reader or writer on the index file */
+typedef struct _dir_index_stream
+{
+    BYTE *buf;    /*!< DIR_INDEX_STREAM_SIZE bytes of the work buffer */
+    UINT pos;     /*!< next byte */
+    UINT len;     /*!< reader: valid bytes */
+    FSIZE_t ofs;  /*!< file offset of the next read or write */
+    FSIZE_t left; /*!< reader: bytes of the run not read yet */
+} dir_index_stream_t;
+
+/*! @brief directory listing of a build */
+typedef struct _dir_index_build
+{
+    FIL *fp;          /*!< index file */
+    DIR *dir;         /*!< the directory */
+    FSIZE_t ofs;      /*!< end of the runs written */
+    UINT used;        /*!< run buffer bytes */
+    UINT records;     /*!< records in the run buffer */
+} dir_index_build_t;
+
+/*******************************************************************************
+ * Variables
+ ******************************************************************************/
+
+static BYTE s_dirIndexWork[DIR_INDEX_WORK_SIZE] __ALIGNED(4);
+static LBA_t s_dirIndexFatSect; /* FAT sectors in the work buffer during a walk */
+static UINT s_dirIndexFatN;
+static uint32_t s_dirIndexRun[DIR_INDEX_MAX_RUNS];
+static uint32_t s_dirIndexRuns;
+static const BYTE *s_dirIndexSortBase;
+static dir_index_walk_t s_dirIndexCheck;
+static dir_index_walk_t s_dirIndexWalk;
+static dir_index_build_t s_dirIndexBuild;
+static DIR s_dirIndexDir;
+static FIL s_dirIndexFil;
+static FILINFO s_dirIndexInfo;
+static dir_index_t *s_dirIndexOpen[DIR_INDEX_MAX_OPEN];
+#if FF_USE_FASTSEEK
+static DWORD s_dirIndexLinkMap[DIR_INDEX_LINK_MAP];
+#endif
+static TCHAR s_dirIndexPath[FF_LFN_BUF + sizeof(DIR_INDEX_FILE_NAME) + 2U];
+static dir_index_stat_t s_dirIndexStat;
+static SemaphoreHandle_t s_dirIndexMutex;
+#if (defined(STATIC_ALLOCATION_ENABLE) && (STATIC_ALLOCATION_ENABLE > 0U))
+static StaticSemaphore_t s_dirIndexMutexBuffer;
+#endif
+
+/*******************************************************************************
+ * Code
+ ******************************************************************************/
+
+static inline DWORD DirIndex_LoadWord(const BYTE *p)
+{
+    return (DWORD)p[0] | ((DWORD)p[1] << 8);
+}
+
+static inline DWORD DirIndex_LoadDword(const BYTE *p)
+{
+    return (DWORD)p[0] | ((DWORD)p[1] << 8) | ((DWORD)p[2] << 16) | ((DWORD)p[3] << 24);
+}
+
+static inline uint64_t DirIndex_LoadQword(const BYTE *p)
+{
+    return (uint64_t)DirIndex_LoadDword(p) | ((uint64_t)DirIndex_LoadDword(p + 4) << 32);
+}
+
+/* case folding as FatFs compares names */
+static inline DWORD DirIndex_Upper(TCHAR c)
+{
+    BYTE b = (BYTE)c;
+
+    if (b < 0x80U)
+    {
+        return ((b >= 'a') && (b <= 'z')) ? (DWORD)(b - 0x20U) : (DWORD)b;
+    }
+    return ff_wtoupper(ff_oem2uni(b, FF_CODE_PAGE));
+}
+
+static uint32_t DirIndex_Hash(const TCHAR *name, UINT len)
+{
+    uint32_t hash = DIR_INDEX_FNV_BASIS;
+
+    for (UINT i = 0U; i < len; i++)
+    {
+        hash = (hash ^ DirIndex_Upper(name[i])) * DIR_INDEX_FNV_PRIME;
+    }
+    return hash;
+}
+
+static int DirIndex_CompareKey(const TCHAR *a, UINT alen, const TCHAR *b, UINT blen)
+{
+    UINT len = (alen < blen) ? alen : blen;
+
+    for (UINT i = 0U; i < len; i++)
+    {
+        DWORD ka = DirIndex_Upper(a[i]);
+        DWORD kb = DirIndex_Upper(b[i]);
+
+        if (ka != kb)
+        {
+            return (ka < kb) ? -1 : 1;
+        }
+    }
+    if (alen != blen)
+    {
+        return (alen < blen) ? -1 : 1;
+    }
+    return memcmp(a, b, len);
+}
+
+/* 1: the same name for FatFs */
+static int DirIndex_MatchKey(const TCHAR *a, const TCHAR *b, UINT len)
+{
+    for (UINT i = 0U; i < len; i++)
+    {
+        if (DirIndex_Upper(a[i]) != DirIndex_Upper(b[i]))
+        {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static int DirIndex_IsIndexName(const TCHAR *name)
+{
+    return (strlen(name) == (sizeof(DIR_INDEX_FILE_NAME) - 1U)) &&
+           DirIndex_MatchKey(name, DIR_INDEX_FILE_NAME, sizeof(DIR_INDEX_FILE_NAME) - 1U);
+}
+
+/* directories first, then the names */
+static int DirIndex_CompareName(const BYTE *a, const BYTE *b)
+{
+    dir_index_entry_t ea, eb;
+
+    memcpy(&ea, a + 2, sizeof(ea));
+    memcpy(&eb, b + 2, sizeof(eb));
+    if ((ea.fattrib ^ eb.fattrib) & AM_DIR)
+    {
+        return (ea.fattrib & AM_DIR) ? -1 : 1;
+    }
+    return DirIndex_CompareKey((const TCHAR *)(a + 2 + sizeof(ea)), ea.nameLen, (const TCHAR *)(b + 2 + sizeof(eb)),
+                               eb.nameLen);
+}
+
+static int DirIndex_CompareHash(const BYTE *a, const BYTE *b)
+{
+    DWORD ha = DirIndex_LoadDword(a + 2);
+    DWORD hb = DirIndex_LoadDword(b + 2);
+
+    if (ha == hb)
+    {
+        ha = DirIndex_LoadDword(a + 6);
+        hb = DirIndex_LoadDword(b + 6);
+    }
+    return (ha < hb) ? -1 : (ha > hb) ? 1 : 0;
+}
+
+static int DirIndex_SortName(const void *a, const void *b)
+{
+    return DirIndex_CompareName(s_dirIndexSortBase + *(const uint16_t *)a, s_dirIndexSortBase + *(const uint16_t *)b);
+}
+
+static int DirIndex_SortHash(const void *a, const void *b)
+{
+    return DirIndex_CompareHash(a, b);
+}
+
+/* directory or FAT sectors as FatFs sees them, the window may hold a newer copy */
+static FRESULT DirIndex_ReadSectors(FATFS *fs, BYTE *buff, LBA_t sect, UINT n)
+{
+    FRESULT res = FR_OK;
+
+    if (!DIR_INDEX_VOLUME_LOCK(fs))
+    {
+        return FR_TIMEOUT;
+    }
+    if (disk_read(fs->pdrv, buff, sect, n) != RES_OK)
+    {
+        res = FR_DISK_ERR;
+    }
+    else if (fs->wflag && (fs->winsect >= sect) && (fs->winsect < (sect + n)))
+    {
+        memcpy(&buff[(fs->winsect - sect) * FF_MAX_SS], fs->win, FF_MAX_SS);
+    }
+    DIR_INDEX_VOLUME_UNLOCK(fs);
+    return res;
+}
+
+static inline LBA_t DirIndex_ClusterSector(FATFS *fs, DWORD clst)
+{
+    return fs->database + (LBA_t)fs->csize * (clst - 2U);
+}
+
+/* FAT sectors at the start of the work buffer, kept for the next cluster of the walk */
+static FRESULT DirIndex_ReadFat(FATFS *fs, LBA_t sect, UINT n)
+{
+    FRESULT res = FR_OK;
+
+    if ((sect != s_dirIndexFatSect) || (n > s_dirIndexFatN))
+    {
+        s_dirIndexFatN = 0U;
+        res            = DirIndex_ReadSectors(fs, s_dirIndexWork, sect, n);
+        if (res == FR_OK)
+        {
+            s_dirIndexFatSect = sect;
+            s_dirIndexFatN    = n;
+        }
+    }
+    return res;
+}
+
+/* follow the FAT, *clst is 0 at the end of the chain */
+static FRESULT DirIndex_NextCluster(FATFS *fs, DWORD *clst)
+{
+    BYTE *buf = s_dirIndexWork;
+    DWORD c = *clst;
+    DWORD val;
+    DWORD end;
+    FRESULT res;
+
+    switch (fs->fs_type)
+    {
+        case FS_FAT12:
+        {
+            /* an entry may straddle two sectors */
+            UINT bc = (UINT)(c + (c / 2U));
+
+            res = DirIndex_ReadFat(fs, fs->fatbase + (bc / FF_MAX_SS), 2U);
+            val = DirIndex_LoadWord(&buf[bc % FF_MAX_SS]);
+            val = (c & 1U) ? (val >> 4) : (val & 0xFFFU);
+            end = 0xFF8U;
+            break;
+        }
+        case FS_FAT16:
+            res = DirIndex_ReadFat(fs, fs->fatbase + (c / (FF_MAX_SS / 2U)), 1U);
+            val = DirIndex_LoadWord(&buf[(c * 2U) % FF_MAX_SS]);
+            end = 0xFFF8U;
+            break;
+        case FS_FAT32:
+            res = DirIndex_ReadFat(fs, fs->fatbase + (c / (FF_MAX_SS / 4U)), 1U);
+            val = DirIndex_LoadDword(&buf[(c * 4U) % FF_MAX_SS]) & 0x0FFFFFFFU;
+            end = 0x0FFFFFF8U;
+            break;
+        default:
+            res = DirIndex_ReadFat(fs, fs->fatbase + (c / (FF_MAX_SS / 4U)), 1U);
+            val = DirIndex_LoadDword(&buf[(c * 4U) % FF_MAX_SS]);
+            end = 0xFFFFFFF8U;
+            break;
+    }
+    if (res != FR_OK)
+    {
+        return res;
+    }
+    if (val >= end)
+    {
+        *clst = 0U;
+    }
+    else if ((val < 2U) || (val >= fs->n_fatent))
+    {
+        return FR_INT_ERR;
+    }
+    else
+    {
+        *clst = val;
+    }
+    return FR_OK;
+}
+
+static inline void DirIndex_HashEntry(dir_index_walk_t *walk, const BYTE *ent)
+{
+    for (UINT i = 0U; i < 32U; i++)
+    {
+        walk->hash = (walk->hash ^ ent[i]) * DIR_INDEX_FNV_PRIME;
+    }
+    walk->raw++;
+}
+
+/* exFAT: the held set is name entry #1 of a 12 character name */
+static int DirIndex_IsIndexSet(const dir_index_walk_t *walk)
+{
+    static const char name[] = DIR_INDEX_FILE_NAME;
+
+    if ((walk->nameLen != (sizeof(name) - 1U)) || (walk->set[64] != 0xC1U))
+    {
+        return 0;
+    }
+    for (UINT i = 0U; i < (sizeof(name) - 1U); i++)
+    {
+        DWORD c = DirIndex_LoadWord(&walk->set[64 + 2 + (i * 2U)]);
+
+        if ((c >= 0x80U) || (DirIndex_Upper((TCHAR)c) != (DWORD)name[i]))
+        {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static FRESULT DirIndex_WalkFat(FATFS *fs, dir_index_walk_t *walk, const BYTE *ent, dir_index_visit_t visit)
+{
+    BYTE attr = ent[11] & 0x3FU;
+    uint8_t lfn;
+
+    if (attr == DIR_INDEX_ATTR_LFN)
+    {
+        DirIndex_HashEntry(walk, ent);
+        walk->lfn = (ent[0] == DIR_INDEX_DELETED) ? 0U : (uint8_t)(walk->lfn + 1U);
+        return FR_OK;
+    }
+    lfn       = walk->lfn;
+    walk->lfn = 0U;
+    if ((ent[0] != DIR_INDEX_DELETED) && (memcmp(ent, DIR_INDEX_SFN, 11) == 0))
+    {
+        walk->index      = 1U;
+        walk->indexFat   = 1U;
+        walk->indexClust = DirIndex_LoadWord(&ent[26]) |
+                           ((fs->fs_type == FS_FAT32) ? (DirIndex_LoadWord(&ent[20]) << 16) : 0U);
+        walk->indexSize  = DirIndex_LoadDword(&ent[28]);
+        return FR_OK;
+    }
+    DirIndex_HashEntry(walk, ent);
+    /* what f_readdir skips */
+    if ((ent[0] == DIR_INDEX_DELETED) || (ent[0] == '.') || ((attr & ~AM_ARC) == DIR_INDEX_ATTR_VOL))
+    {
+        return FR_OK;
+    }
+    walk->files++;
+    walk->names += ((lfn != 0U) ? (lfn * 13U) : 12U) + 1U;
+    if (visit == NULL)
+    {
+        return FR_OK;
+    }
+    return visit(DirIndex_LoadWord(&ent[26]) | ((fs->fs_type == FS_FAT32) ? (DirIndex_LoadWord(&ent[20]) << 16) : 0U),
+                 DirIndex_LoadDword(&ent[28]), attr);
+}
+
+static FRESULT DirIndex_WalkExfat(dir_index_walk_t *walk, const BYTE *ent, dir_index_visit_t visit)
+{
+    BYTE type = ent[0];
+
+    if (walk->secondary != 0U)
+    {
+        if ((type & 0xC0U) == 0xC0U)
+        {
+            if (type == 0xC0U)
+            {
+                /* stream extension */
+                walk->flags   = ent[1];
+                walk->nameLen = ent[3];
+                walk->sclust  = DirIndex_LoadDword(&ent[20]);
+                walk->size    = DirIndex_LoadQword(&ent[24]);
+            }
+            if (walk->held != 0U)
+            {
+                memcpy(&walk->set[walk->held * 32U], ent, 32U);
+                walk->held++;
+            }
+            else
+            {
+                DirIndex_HashEntry(walk, ent);
+            }
+            if (--walk->secondary != 0U)
+            {
+                return FR_OK;
+            }
+            if (walk->held != 0U)
+            {
+                uint8_t held = walk->held;
+
+                walk->held = 0U;
+                if (DirIndex_IsIndexSet(walk))
+                {
+                    walk->index      = 1U;
+                    walk->indexFat   = (walk->flags & 2U) ? 0U : 1U; /* NoFatChain */
+                    walk->indexClust = walk->sclust;
+                    walk->indexSize  = walk->size;
+                    return FR_OK;
+                }
+                for (uint8_t i = 0U; i < held; i++)
+                {
+                    DirIndex_HashEntry(walk, &walk->set[i * 32U]);
+                }
+            }
+            walk->files++;
+            walk->names += walk->nameLen + 1U;
+            return (visit != NULL) ? visit(walk->sclust, walk->size, walk->attr) : FR_OK;
+        }
+        /* a broken set, f_readdir does not return it either */
+        for (uint8_t i = 0U; i < walk->held; i++)
+        {
+            DirIndex_HashEntry(walk, &walk->set[i * 32U]);
+        }
+        walk->held      = 0U;
+        walk->secondary = 0U;
+    }
+    if ((type == 0x85U) && (ent[1] != 0U))
+    {
+        /* file entry, the index file has a stream and one name entry */
+        walk->secondary = ent[1];
+        walk->attr      = (BYTE)DirIndex_LoadWord(&ent[4]);
+        walk->flags     = 0U;
+        walk->nameLen   = 0U;
+        walk->sclust    = 0U;
+        walk->size      = 0U;
+        if (walk->secondary == 2U)
+        {
+            memcpy(walk->set, ent, 32U);
+            walk->held = 1U;
+            return FR_OK;
+        }
+    }
+    DirIndex_HashEntry(walk, ent);
+    return FR_OK;
+}
+
+/*
+ * hash the entries of an open directory up to the end mark, visit is called for what f_readdir returns.
+ * Contiguous clusters are read together, and a gap of a few sectors to the next cluster is read over as the
+ * disk read-ahead does for f_readdir. A check without visit uses all of the work buffer after the FAT sectors.
+ */
+static FRESULT DirIndex_Walk(const DIR *dir, dir_index_walk_t *walk, dir_index_visit_t visit)
+{
+    FATFS *fs     = dir->obj.fs;
+    BYTE *buf     = &s_dirIndexWork[DIR_INDEX_FAT_SIZE];
+    UINT max      = (visit != NULL) ? DIR_INDEX_WALK_SECTORS : ((DIR_INDEX_WORK_SIZE - DIR_INDEX_FAT_SIZE) / FF_MAX_SS);
+    LBA_t winSect = 0U; /* sectors in buf */
+    UINT winN     = 0U;
+    DWORD clst    = dir->obj.sclust;
+    DWORD next    = 0U;
+    uint8_t fat   = 0U; /* 1: the cluster after clst is looked up in the FAT, 2: it is next */
+    uint8_t end   = 0U;
+    FRESULT res   = FR_OK;
+    LBA_t sect;
+    DWORD left;
+
+    memset(walk, 0, sizeof(*walk));
+    walk->hash        = DIR_INDEX_FNV_BASIS;
+    s_dirIndexFatN    = 0U;
+    if ((clst == 0U) && (fs->fs_type < FS_FAT32))
+    {
+        /* FAT12/16 root directory */
+        sect = fs->dirbase;
+        left = fs->n_rootdir / (FF_MAX_SS / 32U);
+    }
+    else
+    {
+        if (clst == 0U)
+        {
+            clst = (DWORD)fs->dirbase;
+        }
+        sect = DirIndex_ClusterSector(fs, clst);
+        left = fs->csize;
+        fat  = 1U;
+        if ((fs->fs_type == FS_EXFAT) && (dir->obj.stat & 2U))
+        {
+            /* no FAT chain */
+            left = (DWORD)((dir->obj.objsize + ((FSIZE_t)fs->csize * FF_MAX_SS) - 1U) / ((FSIZE_t)fs->csize * FF_MAX_SS)) *
+                   fs->csize;
+            fat = 0U;
+        }
+    }
+
+    while ((res == FR_OK) && !end)
+    {
+        UINT n;
+
+        while ((res == FR_OK) && (fat == 1U) && (left < max))
+        {
+            next = clst;
+            res  = DirIndex_NextCluster(fs, &next);
+            if ((res == FR_OK) && (next == (clst + 1U)))
+            {
+                clst = next;
+                left += fs->csize;
+            }
+            else
+            {
+                fat = 2U;
+            }
+        }
+        if ((res != FR_OK) || (left == 0U))
+        {
+            if ((res != FR_OK) || (fat != 2U) || (next == 0U))
+            {
+                break;
+            }
+            clst = next;
+            sect = DirIndex_ClusterSector(fs, clst);
+            left = fs->csize;
+            fat  = 1U;
+            continue;
+        }
+        if ((sect >= winSect) && (sect < (winSect + winN)))
+        {
+            /* read ahead before */
+            n = (UINT)(winSect + winN - sect);
+        }
+        else
+        {
+            LBA_t nextSect = ((fat == 2U) && (next != 0U)) ? DirIndex_ClusterSector(fs, next) : 0U;
+
+            winSect = sect;
+            winN    = (left < max) ? (UINT)left : max;
+            if ((winN < max) && (nextSect > sect) && ((nextSect - sect) < max))
+            {
+                winN = max;
+            }
+            res = DirIndex_ReadSectors(fs, buf, winSect, winN);
+            n   = winN;
+        }
+        n = (left < n) ? (UINT)left : n;
+        for (UINT i = 0U; (res == FR_OK) && (i < (n * FF_MAX_SS)); i += 32U)
+        {
+            const BYTE *ent = &buf[((sect - winSect) * FF_MAX_SS) + i];
+
+            if (ent[0] == 0U)
+            {
+                end = 1U;
+                break;
+            }
+            res = (fs->fs_type == FS_EXFAT) ? DirIndex_WalkExfat(walk, ent, visit) :
+                                              DirIndex_WalkFat(fs, walk, ent, visit);
+        }
+        sect += n;
+        left -= n;
+    }
+    return res;
+}
+
+/* f_readdir without the index file */
+static FRESULT DirIndex_ReadDir(DIR *dir, FILINFO *fno)
+{
+    FRESULT res;
+
+    do
+    {
+        res = f_readdir(dir, fno);
+    } while ((res == FR_OK) && (fno->fname[0] != 0) && DirIndex_IsIndexName(fno->fname));
+    return res;
+}
+
+static void DirIndex_StreamInit(dir_index_stream_t *s, BYTE *buf, FSIZE_t ofs, FSIZE_t left)
+{
+    s->buf  = buf;
+    s->pos  = 0U;
+    s->len  = 0U;
+    s->ofs  = ofs;
+    s->left = left;
+}
+
+static FRESULT DirIndex_Fill(FIL *fp, dir_index_stream_t *s, UINT need)
+{
+    FRESULT res;
+    UINT n;
+    UINT br;
+
+    if ((s->len - s->pos) >= need)
+    {
+        return FR_OK;
+    }
+    memmove(s->buf, &s->buf[s->pos], s->len - s->pos);
+    s->len -= s->pos;
+    s->pos = 0U;
+    n      = ((DIR_INDEX_STREAM_SIZE - s->len) < s->left) ? (DIR_INDEX_STREAM_SIZE - s->len) : (UINT)s->left;
+    res    = f_lseek(fp, s->ofs);
+    if (res == FR_OK)
+    {
+        res = f_read(fp, &s->buf[s->len], n, &br);
+    }
+    if ((res == FR_OK) && ((br != n) || ((s->len + n) < need)))
+    {
+        res = FR_INT_ERR;
+    }
+    s->ofs += n;
+    s->left -= n;
+    s->len += n;
+    return res;
+}
+
+/* next record of a run, *rec is NULL at the end */
+static FRESULT DirIndex_Get(FIL *fp, dir_index_stream_t *s, const BYTE **rec)
+{
+    FRESULT res;
+    UINT len;
+
+    *rec = NULL;
+    if ((s->pos == s->len) && (s->left == 0U))
+    {
+        return FR_OK;
+    }
+    res = DirIndex_Fill(fp, s, 2U);
+    if (res == FR_OK)
+    {
+        len = 2U + (UINT)DirIndex_LoadWord(&s->buf[s->pos]);
+        res = DirIndex_Fill(fp, s, len);
+        if (res == FR_OK)
+        {
+            *rec = &s->buf[s->pos];
+            s->pos += len;
+        }
+    }
+    return res;
+}
+
+static FRESULT DirIndex_Flush(FIL *fp, dir_index_stream_t *s)
+{
+    FRESULT res = FR_OK;
+    UINT bw;
+
+    if (s->pos != 0U)
+    {
+        res = f_lseek(fp, s->ofs);
+        if (res == FR_OK)
+        {
+            res = f_write(fp, s->buf, s->pos, &bw);
+        }
+        if ((res == FR_OK) && (bw != s->pos))
+        {
+            res = FR_DENIED; /* disk full */
+        }
+        s->ofs += s->pos;
+        s->pos = 0U;
+    }
+    return res;
+}
+
+static FRESULT DirIndex_Put(FIL *fp, dir_index_stream_t *s, const void *data, UINT n)
+{
+    FRESULT res = FR_OK;
+
+    if ((s->pos + n) > DIR_INDEX_STREAM_SIZE)
+    {
+        res = DirIndex_Flush(fp, s);
+    }
+    memcpy(&s->buf[s->pos], data, n);
+    s->pos += n;
+    return res;
+}
+
+/* sort the run buffer and append it to the runs */
+static FRESULT DirIndex_FlushRun(dir_index_build_t *b)
+{
+    uint16_t *offset = (uint16_t *)&s_dirIndexWork[DIR_INDEX_WORK_SIZE] - b->records;
+    BYTE *run        = &s_dirIndexWork[DIR_INDEX_FAT_SIZE + DIR_INDEX_WALK_SIZE];
+    FRESULT res      = FR_OK;
+    UINT bw;
+
+    if (b->records == 0U)
+    {
+        return FR_OK;
+    }
+    if (s_dirIndexRuns >= DIR_INDEX_MAX_RUNS)
+    {
+        return FR_NOT_ENOUGH_CORE;
+    }
+    s_dirIndexSortBase = run;
+    qsort(offset, b->records, sizeof(uint16_t), DirIndex_SortName);
+    res = f_lseek(b->fp, b->ofs);
+    for (UINT i = 0U; (res == FR_OK) && (i < b->records); i++)
+    {
+        UINT len = 2U + (UINT)DirIndex_LoadWord(&run[offset[i]]);
+
+        res = f_write(b->fp, &run[offset[i]], len, &bw);
+        if ((res == FR_OK) && (bw != len))
+        {
+            res = FR_DENIED;
+        }
+    }
+    s_dirIndexRun[s_dirIndexRuns++] = b->used;
+    b->ofs += b->used;
+    b->used    = 0U;
+    b->records = 0U;
+    return res;
+}
+
+/* the walk found an entry, f_readdir returns the same one with its name */
+static FRESULT DirIndex_Visit(DWORD sclust, FSIZE_t size, BYTE attr)
+{
+    dir_index_build_t *b = &s_dirIndexBuild;
+    FILINFO *fno         = &s_dirIndexInfo;
+    BYTE *run            = &s_dirIndexWork[DIR_INDEX_FAT_SIZE + DIR_INDEX_WALK_SIZE];
+    dir_index_entry_t entry;
+    FRESULT res;
+    UINT len;
+    UINT need;
+
+    res = DirIndex_ReadDir(b->dir, fno);
+    if (res != FR_OK)
+    {
+        return res;
+    }
+    len = (UINT)strlen(fno->fname);
+    if ((len == 0U) || (len > 255U) || (fno->fattrib != (attr & DIR_INDEX_ATTR_MASK)) ||
+        (!(fno->fattrib & AM_DIR) && (fno->fsize != size)))
+    {
+        /* the directory changed meanwhile, exFAT directories have a size but f_readdir returns 0 */
+        return FR_INT_ERR;
+    }
+    memset(&entry, 0, sizeof(entry));
+    entry.fsize   = fno->fsize;
+    entry.sclust  = sclust;
+    entry.hash    = DirIndex_Hash(fno->fname, len);
+    entry.fdate   = fno->fdate;
+    entry.ftime   = fno->ftime;
+    entry.fattrib = fno->fattrib;
+    entry.nameLen = (uint8_t)len;
+
+    /* records from the front, their offsets from the back */
+    need = 2U + sizeof(entry) + len;
+    if ((b->used + need + ((b->records + 1U) * sizeof(uint16_t))) > DIR_INDEX_RUN_SIZE)
+    {
+        res = DirIndex_FlushRun(b);
+    }
+    if (res == FR_OK)
+    {
+        run[b->used]     = (BYTE)(sizeof(entry) + len);
+        run[b->used + 1] = (BYTE)((sizeof(entry) + len) >> 8);
+        memcpy(&run[b->used + 2], &entry, sizeof(entry));
+        memcpy(&run[b->used + 2 + sizeof(entry)], fno->fname, len);
+        ((uint16_t *)&s_dirIndexWork[DIR_INDEX_WORK_SIZE])[-(int)(++b->records)] = (uint16_t)b->used;
+        b->used += need;
+    }
+    return res;
+}
+
+/* merge the runs DIR_INDEX_MERGE_WAYS at a time until one is left, *from is the area holding it */
+static FRESULT DirIndex_Merge(FIL *fp, FSIZE_t *from, FSIZE_t *to, int (*compare)(const BYTE *, const BYTE *))
+{
+    dir_index_stream_t in[DIR_INDEX_MERGE_WAYS];
+    dir_index_stream_t out;
+    FRESULT res = FR_OK;
+
+    while ((res == FR_OK) && (s_dirIndexRuns > 1U))
+    {
+        FSIZE_t ofs   = *from;
+        uint32_t runs = 0U;
+        FSIZE_t swap;
+
+        DirIndex_StreamInit(&out, &s_dirIndexWork[DIR_INDEX_MERGE_WAYS * DIR_INDEX_STREAM_SIZE], *to, 0U);
+        for (uint32_t i = 0U; (res == FR_OK) && (i < s_dirIndexRuns); i += DIR_INDEX_MERGE_WAYS)
+        {
+            const BYTE *rec[DIR_INDEX_MERGE_WAYS];
+            uint32_t size = 0U;
+
+            for (uint32_t j = 0U; j < DIR_INDEX_MERGE_WAYS; j++)
+            {
+                uint32_t len = ((i + j) < s_dirIndexRuns) ? s_dirIndexRun[i + j] : 0U;
+
+                DirIndex_StreamInit(&in[j], &s_dirIndexWork[j * DIR_INDEX_STREAM_SIZE], ofs + size, len);
+                size += len;
+                rec[j] = NULL;
+                if (res == FR_OK)
+                {
+                    res = DirIndex_Get(fp, &in[j], &rec[j]);
+                }
+            }
+            while (res == FR_OK)
+            {
+                int k = -1;
+
+                for (int j = 0; j < (int)DIR_INDEX_MERGE_WAYS; j++)
+                {
+                    if ((rec[j] != NULL) && ((k < 0) || (compare(rec[j], rec[k]) < 0)))
+                    {
+                        k = j;
+                    }
+                }
+                if (k < 0)
+                {
+                    break;
+                }
+                res = DirIndex_Put(fp, &out, rec[k], 2U + (UINT)DirIndex_LoadWord(rec[k]));
+                if (res == FR_OK)
+                {
+                    res = DirIndex_Get(fp, &in[k], &rec[k]);
+                }
+            }
+            ofs += size;
+            s_dirIndexRun[runs++] = size;
+        }
+        if (res == FR_OK)
+        {
+            res = DirIndex_Flush(fp, &out);
+        }
+        s_dirIndexRuns = runs;
+        swap           = *from;
+        *from          = *to;
+        *to            = swap;
+    }
+    return res;
+}
+
+/* sorted name records -> entry array and names, hash records -> sorted runs in the other area */
+static FRESULT DirIndex_Layout(FIL *fp, FSIZE_t from, FSIZE_t to, dir_index_header_t *header, FSIZE_t *end)
+{
+    BYTE *hashRun = &s_dirIndexWork[3U * DIR_INDEX_STREAM_SIZE];
+    UINT hashUsed = 0U;
+    uint32_t nameOfs = 0U;
+    dir_index_stream_t in, entries, names;
+    const BYTE *rec;
+    FRESULT res;
+    UINT bw;
+
+    DirIndex_StreamInit(&in, s_dirIndexWork, from, (s_dirIndexRuns != 0U) ? s_dirIndexRun[0] : 0U);
+    DirIndex_StreamInit(&entries, &s_dirIndexWork[DIR_INDEX_STREAM_SIZE], header->entries, 0U);
+    DirIndex_StreamInit(&names, &s_dirIndexWork[2U * DIR_INDEX_STREAM_SIZE], header->names, 0U);
+    s_dirIndexRuns = 0U;
+    header->count  = 0U;
+    header->dirs   = 0U;
+
+    res = DirIndex_Get(fp, &in, &rec);
+    while ((res == FR_OK) && ((rec != NULL) || (hashUsed != 0U)))
+    {
+        if ((rec == NULL) || ((hashUsed + DIR_INDEX_HASH_RECORD) > DIR_INDEX_STREAM_SIZE))
+        {
+            /* hash run */
+            if (s_dirIndexRuns >= DIR_INDEX_MAX_RUNS)
+            {
+                res = FR_NOT_ENOUGH_CORE;
+                break;
+            }
+            qsort(hashRun, hashUsed / DIR_INDEX_HASH_RECORD, DIR_INDEX_HASH_RECORD, DirIndex_SortHash);
+            res = f_lseek(fp, to);
+            if (res == FR_OK)
+            {
+                res = f_write(fp, hashRun, hashUsed, &bw);
+            }
+            if ((res == FR_OK) && (bw != hashUsed))
+            {
+                res = FR_DENIED;
+            }
+            s_dirIndexRun[s_dirIndexRuns++] = hashUsed;
+            to += hashUsed;
+            hashUsed = 0U;
+            continue;
+        }
+        {
+            dir_index_entry_t entry;
+            BYTE *h = &hashRun[hashUsed];
+
+            memcpy(&entry, rec + 2, sizeof(entry));
+            entry.name = nameOfs;
+            nameOfs += entry.nameLen + 1U;
+            header->dirs += (entry.fattrib & AM_DIR) ? 1U : 0U;
+            h[0] = 8U;
+            h[1] = 0U;
+            memcpy(&h[2], &entry.hash, 4U);
+            memcpy(&h[6], &header->count, 4U);
+            hashUsed += DIR_INDEX_HASH_RECORD;
+            header->count++;
+            res = DirIndex_Put(fp, &entries, &entry, sizeof(entry));
+            if (res == FR_OK)
+            {
+                res = DirIndex_Put(fp, &names, rec + 2 + sizeof(entry), entry.nameLen);
+            }
+            if (res == FR_OK)
+            {
+                res = DirIndex_Put(fp, &names, "", 1U);
+            }
+        }
+        if (res == FR_OK)
+        {
+            res = DirIndex_Get(fp, &in, &rec);
+        }
+    }
+    if (res == FR_OK)
+    {
+        res = DirIndex_Flush(fp, &entries);
+    }
+    if (res == FR_OK)
+    {
+        res = DirIndex_Flush(fp, &names);
+    }
+    *end = header->names + nameOfs;
+    return res;
+}
+
+/* the sorted hash run without the record lengths */
+static FRESULT DirIndex_CopyHashes(FIL *fp, FSIZE_t from, const dir_index_header_t *header)
+{
+    dir_index_stream_t in, out;
+    const BYTE *rec;
+    FRESULT res;
+
+    DirIndex_StreamInit(&in, s_dirIndexWork, from, (s_dirIndexRuns != 0U) ? s_dirIndexRun[0] : 0U);
+    DirIndex_StreamInit(&out, &s_dirIndexWork[DIR_INDEX_STREAM_SIZE], header->hashes, 0U);
+    res = DirIndex_Get(fp, &in, &rec);
+    while ((res == FR_OK) && (rec != NULL))
+    {
+        res = DirIndex_Put(fp, &out, rec + 2, 8U);
+        if (res == FR_OK)
+        {
+            res = DirIndex_Get(fp, &in, &rec);
+        }
+    }
+    if (res == FR_OK)
+    {
+        res = DirIndex_Flush(fp, &out);
+    }
+    return res;
+}
+
+/*
+ * write the index into an empty file, check is the walk that sized it:
+ * [header][entries][hashes][names, at most check->names] [scratch a][scratch b]
+ * The file is expanded to all of it in contiguous clusters, the index is read by sector later.
+ */
+static FRESULT DirIndex_Build(FIL *fp, dir_index_header_t *header, DIR *dir, const dir_index_walk_t *check)
+{
+    dir_index_build_t *b = &s_dirIndexBuild;
+    FSIZE_t a, c, end = 0U;
+    FRESULT res;
+    UINT bw;
+
+    memset(header, 0, sizeof(*header));
+    header->entries = sizeof(dir_index_header_t);
+    header->hashes  = header->entries + (check->files * sizeof(dir_index_entry_t));
+    header->names   = header->hashes + (check->files * 8U);
+    a               = header->names + check->names;
+    c               = a + ((FSIZE_t)check->files * (2U + sizeof(dir_index_entry_t))) + check->names;
+
+    res = f_expand(fp, c + ((FSIZE_t)check->files * (2U + sizeof(dir_index_entry_t))) + check->names, 1U);
+    if (res != FR_OK)
+    {
+        return res;
+    }
+    /* mark the file as an index before anything else, the fingerprint stays 0 until the end */
+    header->magic = DIR_INDEX_MAGIC;
+    res           = f_write(fp, header, sizeof(*header), &bw);
+    if ((res == FR_OK) && (bw != sizeof(*header)))
+    {
+        res = FR_DENIED;
+    }
+    if (res != FR_OK)
+    {
+        return res;
+    }
+#if FF_USE_FASTSEEK
+    /* f_lseek follows the FAT chain without a link map, a contiguous file maps in a few items */
+    s_dirIndexLinkMap[0] = DIR_INDEX_LINK_MAP;
+    fp->cltbl            = s_dirIndexLinkMap;
+    if (f_lseek(fp, CREATE_LINKMAP) != FR_OK)
+    {
+        fp->cltbl = NULL;
+    }
+#endif
+    b->fp          = fp;
+    b->dir         = dir;
+    b->ofs         = a;
+    b->used        = 0U;
+    b->records     = 0U;
+    s_dirIndexRuns = 0U;
+    res            = f_readdir(dir, NULL);
+    if (res == FR_OK)
+    {
+        res = DirIndex_Walk(dir, &s_dirIndexWalk, DirIndex_Visit);
+    }
+    if (res == FR_OK)
+    {
+        res = DirIndex_FlushRun(b);
+    }
+    if (res == FR_OK)
+    {
+        res = DirIndex_ReadDir(dir, &s_dirIndexInfo);
+    }
+    if ((res == FR_OK) && ((s_dirIndexInfo.fname[0] != 0) || (s_dirIndexWalk.files != check->files) ||
+                           (s_dirIndexWalk.names > check->names)))
+    {
+        res = FR_INT_ERR;
+    }
+    if (res == FR_OK)
+    {
+        res = DirIndex_Merge(fp, &a, &c, DirIndex_CompareName);
+    }
+    if (res == FR_OK)
+    {
+        res = DirIndex_Layout(fp, a, c, header, &end);
+    }
+    if (res == FR_OK)
+    {
+        res = DirIndex_Merge(fp, &c, &a, DirIndex_CompareHash);
+    }
+    if (res == FR_OK)
+    {
+        res = DirIndex_CopyHashes(fp, c, header);
+    }
+    if (res == FR_OK)
+    {
+        header->magic       = DIR_INDEX_MAGIC;
+        header->fingerprint = s_dirIndexWalk.hash;
+        header->raw         = s_dirIndexWalk.raw;
+        res                 = f_lseek(fp, 0U);
+    }
+    if (res == FR_OK)
+    {
+        res = f_write(fp, header, sizeof(*header), &bw);
+    }
+    if ((res == FR_OK) && (bw != sizeof(*header)))
+    {
+        res = FR_DENIED;
+    }
+    if (res == FR_OK)
+    {
+        res = f_lseek(fp, end);
+    }
+    if (res == FR_OK)
+    {
+#if FF_USE_FASTSEEK
+        fp->cltbl = NULL;
+#endif
+        res = f_truncate(fp);
+    }
+#if FF_USE_FASTSEEK
+    fp->cltbl = NULL;
+#endif
+    return res;
+}
+
+/* "dir/DIRINDEX.IDX" */
+static FRESULT DirIndex_Path(const TCHAR *path)
+{
+    size_t len = strlen(path);
+
+    if ((len + sizeof(DIR_INDEX_FILE_NAME) + 1U) > sizeof(s_dirIndexPath))
+    {
+        return FR_INVALID_NAME;
+    }
+    memcpy(s_dirIndexPath, path, len);
+    if ((len != 0U) && (path[len - 1U] != '/') && (path[len - 1U] != ':'))
+    {
+        s_dirIndexPath[len++] = '/';
+    }
+    memcpy(&s_dirIndexPath[len], DIR_INDEX_FILE_NAME, sizeof(DIR_INDEX_FILE_NAME));
+    return FR_OK;
+}
+
+/* read from the index file through the disk cache, one sector is kept in the index */
+static FRESULT DirIndex_ReadAt(dir_index_t *index, FSIZE_t ofs, void *buff, UINT n)
+{
+    BYTE *dst   = (BYTE *)buff;
+    FRESULT res = FR_OK;
+
+    if ((index->fs == NULL) || (index->fs->id != index->id) || (index->fs->fs_type == 0U))
+    {
+        return FR_INVALID_OBJECT;
+    }
+    if ((ofs > index->size) || (n > (index->size - ofs)))
+    {
+        return FR_INT_ERR;
+    }
+    while ((res == FR_OK) && (n != 0U))
+    {
+        LBA_t sect = index->sect + (LBA_t)(ofs / FF_MAX_SS);
+        UINT pos   = (UINT)(ofs % FF_MAX_SS);
+        UINT len   = ((FF_MAX_SS - pos) < n) ? (FF_MAX_SS - pos) : n;
+
+        if (sect != index->bufSect)
+        {
+            index->bufSect = (LBA_t)-1;
+            res            = DirIndex_ReadSectors(index->fs, index->buf, sect, 1U);
+            if (res == FR_OK)
+            {
+                index->bufSect = sect;
+            }
+        }
+        if (res == FR_OK)
+        {
+            memcpy(dst, &index->buf[pos], len);
+            dst += len;
+            ofs += len;
+            n -= len;
+        }
+    }
+    return res;
+}
+
+/* map the index file the walk found, the clusters have to be contiguous */
+static FRESULT DirIndex_Map(dir_index_t *index, FATFS *fs, const dir_index_walk_t *walk)
+{
+    DWORD clst = walk->indexClust;
+    FRESULT res = FR_OK;
+
+    if ((clst < 2U) || (clst >= fs->n_fatent) || (walk->indexSize < sizeof(dir_index_header_t)))
+    {
+        return FR_NO_FILE;
+    }
+    if (walk->indexFat)
+    {
+        DWORD n = (DWORD)((walk->indexSize - 1U) / ((FSIZE_t)fs->csize * FF_MAX_SS));
+
+        s_dirIndexFatN = 0U;
+        for (DWORD i = 0U; (res == FR_OK) && (i < n); i++)
+        {
+            DWORD next = clst;
+
+            res = DirIndex_NextCluster(fs, &next);
+            if ((res == FR_OK) && (next != (clst + 1U)))
+            {
+                res = FR_NO_FILE; /* fragmented, the file was written elsewhere */
+            }
+            clst = next;
+        }
+    }
+    if (res == FR_OK)
+    {
+        index->fs      = fs;
+        index->id      = fs->id;
+        index->sect    = DirIndex_ClusterSector(fs, walk->indexClust);
+        index->size    = walk->indexSize;
+        index->bufSect = (LBA_t)-1;
+        res            = DirIndex_ReadAt(index, 0U, &index->header, sizeof(index->header));
+    }
+    return res;
+}
+
+/* the file the walk found was written by a build, another file of that name is left alone */
+static int DirIndex_IsOwn(FATFS *fs, const dir_index_walk_t *walk, BYTE *buf)
+{
+    DWORD clst = walk->indexClust;
+
+    if ((clst < 2U) || (clst >= fs->n_fatent) || (walk->indexSize < sizeof(dir_index_header_t)))
+    {
+        return 0;
+    }
+    if (DirIndex_ReadSectors(fs, buf, DirIndex_ClusterSector(fs, clst), 1U) != FR_OK)
+    {
+        return 0;
+    }
+    return (DirIndex_LoadDword(buf) == DIR_INDEX_MAGIC);
+}
+
+/* an open index of the same file, it is not written under a reader */
+static int DirIndex_IsOpen(FATFS *fs, DWORD clst)
+{
+    for (UINT i = 0U; i < DIR_INDEX_MAX_OPEN; i++)
+    {
+        dir_index_t *open = s_dirIndexOpen[i];
+
+        if ((open != NULL) && (open->fs == fs) && (open->id == fs->id) && (open->sect == DirIndex_ClusterSector(fs, clst)))
+        {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+void DirIndex_Init(void)
+{
+    if (s_dirIndexMutex == NULL)
+    {
+        s_dirIndexMutex = DIR_INDEX_MUTEX_CREATE();
+    }
+}
+
+/* build 0: an up to date index or FR_NO_FILE, nothing is written */
+static FRESULT DirIndex_OpenIndex(dir_index_t *index, const TCHAR *path, uint8_t build)
+{
+    dir_index_walk_t *check = &s_dirIndexCheck;
+    FATFS *fs;
+    uint32_t cycles;
+    uint8_t valid = 0U;
+    TickType_t start;
+    FRESULT res;
+    UINT slot;
+
+    index->fs = NULL;
+    DIR_INDEX_LOCK();
+    for (slot = 0U; (slot < DIR_INDEX_MAX_OPEN) && (s_dirIndexOpen[slot] != NULL); slot++)
+    {
+    }
+    if (slot >= DIR_INDEX_MAX_OPEN)
+    {
+        DIR_INDEX_UNLOCK();
+        return FR_TOO_MANY_OPEN_FILES;
+    }
+    cycles = DWT->CYCCNT;
+    res    = f_opendir(&s_dirIndexDir, path);
+    if (res != FR_OK)
+    {
+        DIR_INDEX_UNLOCK();
+        return res;
+    }
+    fs  = s_dirIndexDir.obj.fs;
+    res = DirIndex_Walk(&s_dirIndexDir, check, NULL);
+    if ((res == FR_OK) && check->index && (DirIndex_Map(index, fs, check) == FR_OK) &&
+        (index->header.magic == DIR_INDEX_MAGIC) && (index->header.fingerprint == check->hash) &&
+        (index->header.raw == check->raw) && (index->header.count == check->files))
+    {
+        valid = 1U;
+        s_dirIndexStat.valid++;
+    }
+    s_dirIndexStat.checkUs = (DWT->CYCCNT - cycles) / (SystemCoreClock / 1000000U);
+    if ((res == FR_OK) && !valid)
+    {
+        index->fs = NULL;
+        res       = build ? DirIndex_Path(path) : FR_NO_FILE;
+    }
+    if ((res == FR_OK) && !valid && check->index && !DirIndex_IsOwn(fs, check, index->buf))
+    {
+        /* a user file named DIRINDEX.IDX */
+        res = FR_EXIST;
+    }
+    if ((res == FR_OK) && !valid && check->index && DirIndex_IsOpen(fs, check->indexClust))
+    {
+        res = FR_LOCKED;
+    }
+    if ((res == FR_OK) && !valid)
+    {
+        if (check->files < DIR_INDEX_MIN_ENTRIES)
+        {
+            if (check->index)
+            {
+                (void)f_unlink(s_dirIndexPath);
+            }
+            s_dirIndexStat.small++;
+            res = FR_NO_FILE;
+        }
+        else
+        {
+            FIL *fp = &s_dirIndexFil;
+
+            start = xTaskGetTickCount();
+            res   = f_open(fp, s_dirIndexPath, FA_CREATE_ALWAYS | FA_READ | FA_WRITE);
+            if (res == FR_OK)
+            {
+                FRESULT close;
+
+                res = DirIndex_Build(fp, &index->header, &s_dirIndexDir, check);
+                /* what the next walk finds */
+                check->index      = 1U;
+                check->indexFat   = (fp->obj.stat & 2U) ? 0U : 1U;
+                check->indexClust = fp->obj.sclust;
+                check->indexSize  = fp->obj.objsize;
+                close             = f_close(fp);
+                res               = (res == FR_OK) ? close : res;
+            }
+            if (res == FR_OK)
+            {
+                res = f_chmod(s_dirIndexPath, AM_HID, AM_HID);
+            }
+            if (res == FR_OK)
+            {
+                res = DirIndex_Map(index, fs, check);
+            }
+            if (res == FR_OK)
+            {
+                s_dirIndexStat.builds++;
+                s_dirIndexStat.buildMs = (xTaskGetTickCount() - start) * portTICK_PERIOD_MS;
+            }
+            else
+            {
+                index->fs = NULL;
+                s_dirIndexStat.errors++;
+                (void)f_unlink(s_dirIndexPath);
+            }
+        }
+    }
+    if (res == FR_OK)
+    {
+        s_dirIndexOpen[slot] = index;
+        s_dirIndexStat.opens++;
+    }
+    (void)f_closedir(&s_dirIndexDir);
+    DIR_INDEX_UNLOCK();
+    return res;
+}
+
+FRESULT DirIndex_Open(dir_index_t *index, const TCHAR *path)
+{
+    return DirIndex_OpenIndex(index, path, 1U);
+}
+
+FRESULT DirIndex_OpenExisting(dir_index_t *index, const TCHAR *path)
+{
+    return DirIndex_OpenIndex(index, path, 0U);
+}
+
+FRESULT DirIndex_Read(dir_index_t *index, uint32_t n, FILINFO *fno)
+{
+    dir_index_entry_t entry;
+    FRESULT res;
+
+    fno->fname[0] = 0;
+    if (n >= index->header.count)
+    {
+        return FR_OK;
+    }
+    res = DirIndex_ReadAt(index, index->header.entries + ((FSIZE_t)n * sizeof(entry)), &entry, sizeof(entry));
+    if (res == FR_OK)
+    {
+        res = DirIndex_ReadAt(index, (FSIZE_t)index->header.names + entry.name, fno->fname, entry.nameLen + 1U);
+        fno->fname[entry.nameLen] = 0;
+    }
+    if (res == FR_OK)
+    {
+        fno->fsize      = entry.fsize;
+        fno->fdate      = entry.fdate;
+        fno->ftime      = entry.ftime;
+        fno->fattrib    = entry.fattrib;
+        fno->altname[0] = 0;
+    }
+    else
+    {
+        fno->fname[0] = 0;
+    }
+    return res;
+}
+
+FRESULT DirIndex_Find(dir_index_t *index, const TCHAR *name, dir_index_entry_t *entry)
+{
+    UINT len      = (UINT)strlen(name);
+    uint32_t hash = DirIndex_Hash(name, len);
+    uint32_t lo   = 0U;
+    uint32_t hi   = index->header.count;
+    uint32_t pair[2];
+    FRESULT res = FR_OK;
+
+    s_dirIndexStat.lookups++;
+    /* first pair with the hash */
+    while ((res == FR_OK) && (lo < hi))
+    {
+        uint32_t mid = lo + ((hi - lo) / 2U);
+
+        res = DirIndex_ReadAt(index, index->header.hashes + ((FSIZE_t)mid * sizeof(pair)), pair, sizeof(pair));
+        if (pair[0] < hash)
+        {
+            lo = mid + 1U;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+    for (; (res == FR_OK) && (lo < index->header.count); lo++)
+    {
+        res = DirIndex_ReadAt(index, index->header.hashes + ((FSIZE_t)lo * sizeof(pair)), pair, sizeof(pair));
+        if ((res != FR_OK) || (pair[0] != hash))
+        {
+            break;
+        }
+        res = DirIndex_ReadAt(index, index->header.entries + ((FSIZE_t)pair[1] * sizeof(*entry)), entry,
+                              sizeof(*entry));
+        if ((res == FR_OK) && (entry->nameLen == len))
+        {
+            /* compare the name in pieces, the task stacks are small */
+            TCHAR piece[32];
+            UINT i;
+
+            for (i = 0U; (res == FR_OK) && (i < len); i += sizeof(piece))
+            {
+                UINT n = ((len - i) < sizeof(piece)) ? (len - i) : sizeof(piece);
+
+                res = DirIndex_ReadAt(index, (FSIZE_t)index->header.names + entry->name + i, piece, n);
+                if ((res == FR_OK) && !DirIndex_MatchKey(piece, &name[i], n))
+                {
+                    break;
+                }
+            }
+            if ((res == FR_OK) && (i >= len))
+            {
+                return FR_OK;
+            }
+        }
+    }
+    return (res == FR_OK) ? FR_NO_FILE : res;
+}
+
+FRESULT DirIndex_Close(dir_index_t *index)
+{
+    FRESULT res = FR_INVALID_OBJECT;
+
+    DIR_INDEX_LOCK();
+    for (UINT i = 0U; i < DIR_INDEX_MAX_OPEN; i++)
+    {
+        if (s_dirIndexOpen[i] == index)
+        {
+            s_dirIndexOpen[i] = NULL;
+            res               = FR_OK;
+        }
+    }
+    index->fs = NULL;
+    DIR_INDEX_UNLOCK();
+    return res;
+}
+
+void DirIndex_GetStat(dir_index_stat_t *stat, uint8_t reset)
+{
+    taskENTER_CRITICAL();
+    *stat = s_dirIndexStat;
+    if (reset)
+    {
+        memset(&s_dirIndexStat, 0, sizeof(s_dirIndexStat));
+    }
+    taskEXIT_CRITICAL();
+}
+
+#endif /* DIR_INDEX_ENABLE */
@@ -0,0 +1,165 @@
+/*
+ * dir_index.h
+ *
+ *  Created on: 2026/10/18
+ *      Author: M.Akino
+ */
+
+#ifndef DIR_INDEX_H_
+#define DIR_INDEX_H_
+
+#include <stdint.h>
+#include "ff.h"
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+
+/*! @brief 0 - no index; 1 - large directories get a sorted index file */
+#define DIR_INDEX_ENABLE (1U)
+
+/*! @brief index file in the indexed directory, an 8.3 upper case name has no LFN entries */
+#define DIR_INDEX_FILE_NAME "DIRINDEX.IDX"
+
+/*! @brief directories with fewer files are listed with f_readdir */
+#define DIR_INDEX_MIN_ENTRIES (64U)
+
+/*! @brief work buffer for the directory check and the sort, a quarter of it per merge stream */
+#define DIR_INDEX_WORK_SIZE (8192U)
+
+/*! @brief sorted runs before the merge, the run size is about DIR_INDEX_WORK_SIZE * 5 / 8 */
+#define DIR_INDEX_MAX_RUNS (256U)
+
+/*! @brief indexes open at the same time, an open index is not rebuilt */
+#define DIR_INDEX_MAX_OPEN (4U)
+
+/*! @brief "DIX1" */
+#define DIR_INDEX_MAGIC (0x31584944U)
+
+/*! @brief index file header, the file offsets are from the start of the file */
+typedef struct _dir_index_header
+{
+    uint32_t magic;       /*!< DIR_INDEX_MAGIC */
+    uint32_t fingerprint; /*!< FNV-1a of the raw directory entries, those of the index file excluded */
+    uint32_t raw;         /*!< 32 byte directory entries in the fingerprint */
+    uint32_t count;       /*!< files and directories */
+    uint32_t dirs;        /*!< directories, they are sorted first */
+    uint32_t entries;     /*!< dir_index_entry_t[count] sorted by name */
+    uint32_t hashes;      /*!< {hash, entry number}[count] sorted by hash */
+    uint32_t names;       /*!< names, '\0' terminated */
+} dir_index_header_t;
+
+/*! @brief index entry */
+typedef struct _dir_index_entry
+{
+    uint64_t fsize;      /*!< file size */
+    uint32_t sclust;     /*!< first cluster, 0: empty file */
+    uint32_t hash;       /*!< name hash, see DirIndex_Find */
+    uint32_t name;       /*!< name offset in the name area */
+    uint16_t fdate;      /*!< modified date */
+    uint16_t ftime;      /*!< modified time */
+    uint8_t fattrib;     /*!< AM_xxx */
+    uint8_t nameLen;     /*!< name length without the terminator */
+    uint8_t reserved[6]; /*!< 0 */
+} dir_index_entry_t;
+
+/*! @brief open index, the contiguous file is read by sector without a FIL and its directory search */
+typedef struct _dir_index
+{
+    FATFS *fs;                 /*!< volume */
+    WORD id;                   /*!< fs->id at the open, the index is closed by a remount */
+    LBA_t sect;                /*!< first sector of the file */
+    FSIZE_t size;              /*!< file size */
+    LBA_t bufSect;             /*!< sector in buf */
+    dir_index_header_t header; /*!< its header */
+    BYTE buf[FF_MAX_SS];       /*!< last sector read */
+} dir_index_t;
+
+/*! @brief directory index statistics */
+typedef struct _dir_index_stat
+{
+    uint32_t opens;      /*!< DirIndex_Open calls that returned an index */
+    uint32_t valid;      /*!< of them, the index matched the directory */
+    uint32_t builds;     /*!< indexes written */
+    uint32_t small;      /*!< directories below DIR_INDEX_MIN_ENTRIES */
+    uint32_t errors;     /*!< failed builds: the directory changed, no contiguous space or the index is open */
+    uint32_t lookups;    /*!< DirIndex_Find calls */
+    uint32_t checkUs;    /*!< last directory check */
+    uint32_t buildMs;    /*!< last build */
+} dir_index_stat_t;
+
+#if ((defined DIR_INDEX_ENABLE) && (DIR_INDEX_ENABLE))
+
+/*******************************************************************************
+ * API
+ ******************************************************************************/
+
+/*!
+ * @brief create the lock, called once before the scheduler starts.
+ */
+extern void DirIndex_Init(void);
+
+/*!
+ * @brief open the index of a directory, build it when it is missing or out of date.
+ *
+ * The directory sectors are read in blocks and hashed, that is all an up to date index costs: the hash
+ * walk finds the index file too. A changed directory is listed once with f_readdir and sorted on the disk
+ * in the index file, the file is allocated contiguously.
+ *
+ * @param index   index to open.
+ * @param path    directory, e.g. "1:/samples".
+ * @return FR_OK: open, FR_NO_FILE: fewer than DIR_INDEX_MIN_ENTRIES files, FR_LOCKED: the out of date
+ *         index is open, FR_EXIST: a DIRINDEX.IDX without DIR_INDEX_MAGIC is in the directory, it is not
+ *         touched, FR_TOO_MANY_OPEN_FILES: DIR_INDEX_MAX_OPEN, else an f_xxx error.
+ */
+extern FRESULT DirIndex_Open(dir_index_t *index, const TCHAR *path);
+
+/*!
+ * @brief open the index of a directory only when it is up to date, the medium is never written.
+ *
+ * @param index   index to open.
+ * @param path    directory, e.g. "1:/samples".
+ * @return FR_OK: open, FR_NO_FILE: no index or an out of date one, FR_TOO_MANY_OPEN_FILES: DIR_INDEX_MAX_OPEN,
+ *         else an f_xxx error.
+ */
+extern FRESULT DirIndex_OpenExisting(dir_index_t *index, const TCHAR *path);
+
+/*!
+ * @brief get an entry in sorted order, directories first and then the names without case.
+ *
+ * @param index   open index.
+ * @param n       entry number.
+ * @param fno     name, size, date and attributes as f_readdir, fname[0] is 0 after the last entry.
+ * @return FR_OK, FR_INVALID_OBJECT after a remount or a disk error.
+ */
+extern FRESULT DirIndex_Read(dir_index_t *index, uint32_t n, FILINFO *fno);
+
+/*!
+ * @brief look up a name without case, as f_stat but with a binary search of the name hashes.
+ *
+ * @param index   open index.
+ * @param name    file or directory name without a path.
+ * @param entry   the entry, sclust and fsize locate the data.
+ * @return FR_OK, FR_NO_FILE, FR_INVALID_OBJECT after a remount or a disk error.
+ */
+extern FRESULT DirIndex_Find(dir_index_t *index, const TCHAR *name, dir_index_entry_t *entry);
+
+/*!
+ * @brief close the index.
+ *
+ * @param index   open index.
+ * @return FR_OK, FR_INVALID_OBJECT: not open.
+ */
+extern FRESULT DirIndex_Close(dir_index_t *index);
+
+/*!
+ * @brief take a snapshot of the statistics and optionally clear them.
+ *
+ * @param stat    snapshot destination.
+ * @param reset   1: clear the statistics after the snapshot.
+ */
+extern void DirIndex_GetStat(dir_index_stat_t *stat, uint8_t reset);
+
+#endif /* DIR_INDEX_ENABLE */
+
+#endif /* DIR_INDEX_H_ */
@@ -17,6 +17,7 @@
 #include "ffconf.h"     /* FatFs configuration options */
 #include "ff.h"			/* Obtains integer types */
 #include "diskio.h"		/* Declarations of disk functions */
+#include "fast_mount.h"
 
 #ifdef RAM_DISK_ENABLE
 #include "fsl_ram_disk.h"
@@ -24,6 +25,10 @@
 
 #ifdef USB_DISK_ENABLE
 #include "fsl_usb_disk.h"
+#include "diskio_cache.h"
+#if defined(SD_DISK_ENABLE) && (USB_HOST_FATFS_LUNS > 1U)
+#error "USBDISK2 and SDDISK are the same drive, set USB_HOST_FATFS_LUNS to 1"
+#endif
 #endif
 
 #ifdef SD_DISK_ENABLE
@@ -60,6 +65,9 @@ DSTATUS disk_status (
 #endif
 #ifdef USB_DISK_ENABLE
         case USBDISK:
+#if (USB_HOST_FATFS_LUNS > 1U)
+        case USBDISK2:
+#endif
             stat = USB_HostMsdGetDiskStatus(pdrv);
             return stat;
 #endif
@@ -109,6 +117,9 @@ DSTATUS disk_initialize (
 #endif
 #ifdef USB_DISK_ENABLE
         case USBDISK:
+#if (USB_HOST_FATFS_LUNS > 1U)
+        case USBDISK2:
+#endif
             stat = USB_HostMsdInitializeDisk(pdrv);
             return stat;
 #endif
@@ -162,7 +173,14 @@ DRESULT disk_read (
 #endif
 #ifdef USB_DISK_ENABLE
         case USBDISK:
+#if (USB_HOST_FATFS_LUNS > 1U)
+        case USBDISK2:
+#endif
+#if ((defined DISK_CACHE_ENABLE) && (DISK_CACHE_ENABLE))
+            res = DiskCache_Read(pdrv, buff, sector, count, 0U);
+#else
             res = USB_HostMsdReadDisk(pdrv, buff, sector, count);
+#endif
             return res;
 #endif
 #ifdef SD_DISK_ENABLE
@@ -208,6 +226,9 @@ DRESULT disk_write (
 )
 {
 	DRESULT res;
+#if ((defined FAST_MOUNT_ENABLE) && (FAST_MOUNT_ENABLE))
+    FastMount_Written(pdrv, sector, count);
+#endif
     switch (pdrv)
     {
 #ifdef RAM_DISK_ENABLE
@@ -217,7 +238,14 @@ DRESULT disk_write (
 #endif
 #ifdef USB_DISK_ENABLE
         case USBDISK:
+#if (USB_HOST_FATFS_LUNS > 1U)
+        case USBDISK2:
+#endif
+#if ((defined DISK_CACHE_ENABLE) && (DISK_CACHE_ENABLE))
+            res = DiskCache_Write(pdrv, buff, sector, count, 0U);
+#else
             res = USB_HostMsdWriteDisk(pdrv, buff, sector, count);
+#endif
             return res;
 #endif
 #ifdef SD_DISK_ENABLE
@@ -249,6 +277,59 @@ DRESULT disk_write (
 #endif
 
 
+
+/*-----------------------------------------------------------------------*/
+/* Read/Write the Sector Window of a Volume                              */
+/*-----------------------------------------------------------------------*/
+/* FatFs moves boot, FAT and directory sectors through fs->win with      */
+/* these, file data goes through disk_read/disk_write. Only the window   */
+/* sectors are kept in the sector cache.                                 */
+
+DRESULT disk_read_window (
+	BYTE pdrv,		/* Physical drive nmuber to identify the drive */
+	BYTE *buff,		/* Sector window of the volume */
+	LBA_t sector	/* Sector in LBA */
+)
+{
+#if defined(USB_DISK_ENABLE) && ((defined DISK_CACHE_ENABLE) && (DISK_CACHE_ENABLE))
+#if (USB_HOST_FATFS_LUNS > 1U)
+    if ((pdrv == USBDISK) || (pdrv == USBDISK2))
+#else
+    if (pdrv == USBDISK)
+#endif
+    {
+        return DiskCache_Read(pdrv, buff, sector, 1U, 1U);
+    }
+#endif
+    return disk_read(pdrv, buff, sector, 1U);
+}
+
+
+#if FF_FS_READONLY == 0
+DRESULT disk_write_window (
+	BYTE pdrv,			/* Physical drive nmuber to identify the drive */
+	const BYTE *buff,	/* Sector window of the volume */
+	LBA_t sector		/* Sector in LBA */
+)
+{
+#if defined(USB_DISK_ENABLE) && ((defined DISK_CACHE_ENABLE) && (DISK_CACHE_ENABLE))
+#if (USB_HOST_FATFS_LUNS > 1U)
+    if ((pdrv == USBDISK) || (pdrv == USBDISK2))
+#else
+    if (pdrv == USBDISK)
+#endif
+    {
+#if ((defined FAST_MOUNT_ENABLE) && (FAST_MOUNT_ENABLE))
+        FastMount_Written(pdrv, sector, 1U);
+#endif
+        return DiskCache_Write(pdrv, buff, sector, 1U, 1U);
+    }
+#endif
+    return disk_write(pdrv, buff, sector, 1U);
+}
+#endif
+
+
 /*-----------------------------------------------------------------------*/
 /* Miscellaneous Functions                                               */
 /*-----------------------------------------------------------------------*/
@@ -269,6 +350,24 @@ DRESULT disk_ioctl (
 #endif
 #ifdef USB_DISK_ENABLE
         case USBDISK:
+#if (USB_HOST_FATFS_LUNS > 1U)
+        case USBDISK2:
+#endif
+#if ((defined DISK_CACHE_ENABLE) && (DISK_CACHE_ENABLE))
+            if (cmd == CTRL_SYNC)
+            {
+                res = DiskCache_Sync(pdrv);
+                if (res != RES_OK)
+                {
+                    return res;
+                }
+            }
+            else if ((cmd == CTRL_TRIM) && (buff != NULL))
+            {
+                /* after the unmap the sectors read as the drive decides, not as the cache remembers */
+                DiskCache_Discard(pdrv, ((LBA_t *)buff)[0], ((LBA_t *)buff)[1]);
+            }
+#endif
             res = USB_HostMsdIoctlDisk(pdrv, cmd, buff);
             return res;
 #endif
@@ -12,6 +12,7 @@ extern "C" {
 /* Definitions of physical drive number for each drive */
 #define RAMDISK         0       /* Example: ram disk to physical drive 0 */
 #define USBDISK         1       /* usb disk to physical drive 1 */
+#define USBDISK2        2       /* second lun of a usb card reader to physical drive 2, not with SDDISK */
 #define SDDISK          2       /* sd disk to physical drive 2 */
 #define MMCDISK         3       /* mmc disk to physical drive 3 */
 #define SDSPIDISK       4       /* sdspi disk to physical drive 4 */
@@ -39,6 +40,8 @@ DSTATUS disk_status (BYTE pdrv);
 DRESULT disk_read (BYTE pdrv, BYTE* buff, LBA_t sector, UINT count);
 DRESULT disk_write (BYTE pdrv, const BYTE* buff, LBA_t sector, UINT count);
 DRESULT disk_ioctl (BYTE pdrv, BYTE cmd, void* buff);
+DRESULT disk_read_window (BYTE pdrv, BYTE* buff, LBA_t sector);			/* One sector of the volume window (boot, FAT, directory) */
+DRESULT disk_write_window (BYTE pdrv, const BYTE* buff, LBA_t sector);
 
 
 /* Disk Status Bits (DSTATUS) */
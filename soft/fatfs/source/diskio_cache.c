@@ -0,0 +1,456 @@
+/*
+ * diskio_cache.c
+ *
+ *  Created on: 2026/10/18
+ *      Author: M.Akino
+ */
+
+#include <string.h>
+#include "fsl_common.h"
+#include "ffconf.h"
+#include "diskio_cache.h"
+#include "FreeRTOS.h"
+#include "semphr.h"
+
+#ifdef USB_DISK_ENABLE
+#include "fsl_usb_disk.h"
+#endif
+
+#if ((defined DISK_CACHE_ENABLE) && (DISK_CACHE_ENABLE))
+
+/*
+ * FatFs keeps one sector window per volume, so walking a FAT chain or a directory re-reads the same
+ * few sectors over and over. Those window requests (disk_read_window/disk_write_window) are cached here;
+ * file data, whatever its length, bypasses the cache so that streamed sectors do not evict the FAT and
+ * directory lines. A bypass stays coherent with the cache: a bypass read writes the dirty lines back
+ * first and a bypass write updates the lines it covers.
+ * FatFs serialises the calls of one volume, the cache lock covers the callers outside FatFs
+ * (attach/detach, DebugMonitor) and the volumes of the other LUNs. Lock order: volume -> cache -> drive.
+ * A bypass transfer runs without the cache lock, the one sector misses keep it over the drive read.
+ */
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+
+#if (defined(STATIC_ALLOCATION_ENABLE) && (STATIC_ALLOCATION_ENABLE > 0U))
+#define DISK_CACHE_MUTEX_CREATE() xSemaphoreCreateMutexStatic(&s_diskCacheMutexBuffer)
+#else
+#define DISK_CACHE_MUTEX_CREATE() xSemaphoreCreateMutex()
+#endif
+/* calls made before DiskCache_Init (single task) are not locked */
+#define DISK_CACHE_LOCK()                                           \
+    do                                                              \
+    {                                                               \
+        if (s_diskCacheMutex != NULL)                               \
+        {                                                           \
+            (void)xSemaphoreTake(s_diskCacheMutex, portMAX_DELAY);  \
+        }                                                           \
+    } while (0)
+#define DISK_CACHE_UNLOCK()                                         \
+    do                                                              \
+    {                                                               \
+        if (s_diskCacheMutex != NULL)                               \
+        {                                                           \
+            (void)xSemaphoreGive(s_diskCacheMutex);                 \
+        }                                                           \
+    } while (0)
+
+typedef struct _disk_cache_line
+{
+    LBA_t sector;   /*!< cached sector number */
+    uint32_t stamp; /*!< last access, the smallest in a set is evicted */
+    uint8_t pdrv;   /*!< physical drive number */
+    uint8_t valid;
+    uint8_t dirty;
+} disk_cache_line_t;
+
+/*******************************************************************************
+ * Variables
+ ******************************************************************************/
+
+static disk_cache_line_t s_diskCacheLine[DISK_CACHE_SETS][DISK_CACHE_WAYS];
+static uint8_t s_diskCacheData[DISK_CACHE_SETS][DISK_CACHE_WAYS][FF_MAX_SS] __ALIGNED(4);
+static uint32_t s_diskCacheClock;
+static disk_cache_stat_t s_diskCacheStat;
+static SemaphoreHandle_t s_diskCacheMutex;
+#if (defined(STATIC_ALLOCATION_ENABLE) && (STATIC_ALLOCATION_ENABLE > 0U))
+static StaticSemaphore_t s_diskCacheMutexBuffer;
+#endif
+
+/*******************************************************************************
+ * Code
+ ******************************************************************************/
+
+static DRESULT DiskCache_DriveRead(BYTE pdrv, BYTE *buff, LBA_t sector, UINT count)
+{
+    switch (pdrv)
+    {
+#ifdef USB_DISK_ENABLE
+        case USBDISK:
+#if (USB_HOST_FATFS_LUNS > 1U)
+        case USBDISK2:
+#endif
+            return USB_HostMsdReadDisk(pdrv, buff, sector, count);
+#endif
+        default:
+            break;
+    }
+    return RES_PARERR;
+}
+
+static DRESULT DiskCache_DriveWrite(BYTE pdrv, const BYTE *buff, LBA_t sector, UINT count)
+{
+    switch (pdrv)
+    {
+#ifdef USB_DISK_ENABLE
+        case USBDISK:
+#if (USB_HOST_FATFS_LUNS > 1U)
+        case USBDISK2:
+#endif
+            return USB_HostMsdWriteDisk(pdrv, buff, sector, count);
+#endif
+        default:
+            break;
+    }
+    return RES_PARERR;
+}
+
+static inline uint8_t *DiskCache_LineData(disk_cache_line_t *line)
+{
+    uint32_t index = (uint32_t)(line - &s_diskCacheLine[0][0]);
+
+    return s_diskCacheData[index / DISK_CACHE_WAYS][index % DISK_CACHE_WAYS];
+}
+
+static disk_cache_line_t *DiskCache_Lookup(BYTE pdrv, LBA_t sector)
+{
+    disk_cache_line_t *set = s_diskCacheLine[(uint32_t)sector & (DISK_CACHE_SETS - 1U)];
+
+    for (uint32_t way = 0; way < DISK_CACHE_WAYS; way++)
+    {
+        if (set[way].valid && (set[way].sector == sector) && (set[way].pdrv == pdrv))
+        {
+            set[way].stamp = ++s_diskCacheClock;
+            return &set[way];
+        }
+    }
+    return NULL;
+}
+
+/* free the least recently used line of the set, a dirty victim is written first */
+static DRESULT DiskCache_Allocate(BYTE pdrv, LBA_t sector, disk_cache_line_t **result)
+{
+    disk_cache_line_t *set    = s_diskCacheLine[(uint32_t)sector & (DISK_CACHE_SETS - 1U)];
+    disk_cache_line_t *victim = &set[0];
+
+    for (uint32_t way = 0; way < DISK_CACHE_WAYS; way++)
+    {
+        if (!set[way].valid)
+        {
+            victim = &set[way];
+            break;
+        }
+        if ((int32_t)(set[way].stamp - victim->stamp) < 0)
+        {
+            victim = &set[way];
+        }
+    }
+    if (victim->valid)
+    {
+        if (victim->dirty)
+        {
+            DRESULT res = DiskCache_DriveWrite(victim->pdrv, DiskCache_LineData(victim), victim->sector, 1U);
+
+            if (res != RES_OK)
+            {
+                return res;
+            }
+            s_diskCacheStat.writeBacks++;
+        }
+        s_diskCacheStat.evictions++;
+    }
+    victim->valid  = 0U;
+    victim->dirty  = 0U;
+    victim->pdrv   = pdrv;
+    victim->sector = sector;
+    victim->stamp  = ++s_diskCacheClock;
+    *result        = victim;
+    return RES_OK;
+}
+
+static inline uint8_t DiskCache_Covers(disk_cache_line_t *line, BYTE pdrv, LBA_t sector, UINT count)
+{
+    return line->valid && (line->pdrv == pdrv) && (line->sector >= sector) && ((line->sector - sector) < count);
+}
+
+/* the transfer itself runs unlocked, a bulk transfer on one drive does not hold up the other LUN */
+static DRESULT DiskCache_BypassRead(BYTE pdrv, BYTE *buff, LBA_t sector, UINT count)
+{
+    DRESULT res = RES_OK;
+
+    DISK_CACHE_LOCK();
+    s_diskCacheStat.bypassReads++;
+#if ((defined DISK_CACHE_WRITE_BACK) && (DISK_CACHE_WRITE_BACK))
+    /* the drive does not have the dirty lines yet, write them back before the read */
+    for (uint32_t i = 0; (res == RES_OK) && (i < (DISK_CACHE_SETS * DISK_CACHE_WAYS)); i++)
+    {
+        disk_cache_line_t *line = &s_diskCacheLine[0][0] + i;
+
+        if (line->dirty && DiskCache_Covers(line, pdrv, sector, count))
+        {
+            res = DiskCache_DriveWrite(pdrv, DiskCache_LineData(line), line->sector, 1U);
+            if (res == RES_OK)
+            {
+                line->dirty = 0U;
+                s_diskCacheStat.writeBacks++;
+            }
+        }
+    }
+#endif
+    DISK_CACHE_UNLOCK();
+    if (res == RES_OK)
+    {
+        res = DiskCache_DriveRead(pdrv, buff, sector, count);
+    }
+    return res;
+}
+
+static DRESULT DiskCache_BypassWrite(BYTE pdrv, const BYTE *buff, LBA_t sector, UINT count)
+{
+    DRESULT res;
+
+    /* the covered lines take the new data first and are clean, no stale line is written back meanwhile */
+    DISK_CACHE_LOCK();
+    s_diskCacheStat.bypassWrites++;
+    for (uint32_t i = 0; i < (DISK_CACHE_SETS * DISK_CACHE_WAYS); i++)
+    {
+        disk_cache_line_t *line = &s_diskCacheLine[0][0] + i;
+
+        if (DiskCache_Covers(line, pdrv, sector, count))
+        {
+            memcpy(DiskCache_LineData(line), &buff[(line->sector - sector) * FF_MAX_SS], FF_MAX_SS);
+            line->dirty = 0U;
+        }
+    }
+    DISK_CACHE_UNLOCK();
+
+    res = DiskCache_DriveWrite(pdrv, buff, sector, count);
+    if (res != RES_OK)
+    {
+        /* the drive content is unknown now */
+        DISK_CACHE_LOCK();
+        for (uint32_t i = 0; i < (DISK_CACHE_SETS * DISK_CACHE_WAYS); i++)
+        {
+            disk_cache_line_t *line = &s_diskCacheLine[0][0] + i;
+
+            if (DiskCache_Covers(line, pdrv, sector, count))
+            {
+                line->valid = 0U;
+            }
+        }
+        DISK_CACHE_UNLOCK();
+    }
+    return res;
+}
+
+static DRESULT DiskCache_ReadLines(BYTE pdrv, BYTE *buff, LBA_t sector, UINT count)
+{
+    disk_cache_line_t *line;
+    DRESULT res;
+
+    for (UINT i = 0; i < count; i++, sector++, buff += FF_MAX_SS)
+    {
+        line = DiskCache_Lookup(pdrv, sector);
+        if (line != NULL)
+        {
+            s_diskCacheStat.readHits++;
+        }
+        else
+        {
+            s_diskCacheStat.readMisses++;
+            res = DiskCache_Allocate(pdrv, sector, &line);
+            if (res != RES_OK)
+            {
+                return res;
+            }
+            res = DiskCache_DriveRead(pdrv, DiskCache_LineData(line), sector, 1U);
+            if (res != RES_OK)
+            {
+                return res;
+            }
+            line->valid = 1U;
+        }
+        memcpy(buff, DiskCache_LineData(line), FF_MAX_SS);
+    }
+    return RES_OK;
+}
+
+static DRESULT DiskCache_WriteLines(BYTE pdrv, const BYTE *buff, LBA_t sector, UINT count)
+{
+    disk_cache_line_t *line;
+    DRESULT res;
+
+#if !((defined DISK_CACHE_WRITE_BACK) && (DISK_CACHE_WRITE_BACK))
+    res = DiskCache_DriveWrite(pdrv, buff, sector, count);
+    if (res != RES_OK)
+    {
+        /* the drive content is unknown now */
+        for (UINT i = 0; i < count; i++)
+        {
+            line = DiskCache_Lookup(pdrv, sector + i);
+            if (line != NULL)
+            {
+                line->valid = 0U;
+            }
+        }
+        return res;
+    }
+#endif
+
+    for (UINT i = 0; i < count; i++, sector++, buff += FF_MAX_SS)
+    {
+        line = DiskCache_Lookup(pdrv, sector);
+        if (line != NULL)
+        {
+            s_diskCacheStat.writeHits++;
+        }
+        else
+        {
+            s_diskCacheStat.writeMisses++;
+            res = DiskCache_Allocate(pdrv, sector, &line);
+            if (res != RES_OK)
+            {
+                return res;
+            }
+        }
+        memcpy(DiskCache_LineData(line), buff, FF_MAX_SS);
+        line->valid = 1U;
+#if ((defined DISK_CACHE_WRITE_BACK) && (DISK_CACHE_WRITE_BACK))
+        line->dirty = 1U;
+#endif
+    }
+    return RES_OK;
+}
+
+static DRESULT DiskCache_SyncLines(BYTE pdrv)
+{
+#if ((defined DISK_CACHE_WRITE_BACK) && (DISK_CACHE_WRITE_BACK))
+    for (uint32_t i = 0; i < (DISK_CACHE_SETS * DISK_CACHE_WAYS); i++)
+    {
+        disk_cache_line_t *line = &s_diskCacheLine[0][0] + i;
+
+        if (line->valid && line->dirty && (line->pdrv == pdrv))
+        {
+            DRESULT res = DiskCache_DriveWrite(pdrv, DiskCache_LineData(line), line->sector, 1U);
+
+            if (res != RES_OK)
+            {
+                return res;
+            }
+            line->dirty = 0U;
+            s_diskCacheStat.writeBacks++;
+        }
+    }
+#endif
+    return RES_OK;
+}
+
+void DiskCache_Init(void)
+{
+    if (s_diskCacheMutex == NULL)
+    {
+        s_diskCacheMutex = DISK_CACHE_MUTEX_CREATE();
+    }
+}
+
+DRESULT DiskCache_Read(BYTE pdrv, BYTE *buff, LBA_t sector, UINT count, uint8_t meta)
+{
+    DRESULT res;
+
+    if (!meta)
+    {
+        return DiskCache_BypassRead(pdrv, buff, sector, count);
+    }
+    DISK_CACHE_LOCK();
+    res = DiskCache_ReadLines(pdrv, buff, sector, count);
+    DISK_CACHE_UNLOCK();
+    return res;
+}
+
+DRESULT DiskCache_Write(BYTE pdrv, const BYTE *buff, LBA_t sector, UINT count, uint8_t meta)
+{
+    DRESULT res;
+
+    if (!meta)
+    {
+        return DiskCache_BypassWrite(pdrv, buff, sector, count);
+    }
+    DISK_CACHE_LOCK();
+    res = DiskCache_WriteLines(pdrv, buff, sector, count);
+    DISK_CACHE_UNLOCK();
+    return res;
+}
+
+DRESULT DiskCache_Sync(BYTE pdrv)
+{
+    DRESULT res;
+
+    DISK_CACHE_LOCK();
+    res = DiskCache_SyncLines(pdrv);
+    DISK_CACHE_UNLOCK();
+    return res;
+}
+
+void DiskCache_Invalidate(BYTE pdrv)
+{
+    DISK_CACHE_LOCK();
+    for (uint32_t i = 0; i < (DISK_CACHE_SETS * DISK_CACHE_WAYS); i++)
+    {
+        disk_cache_line_t *line = &s_diskCacheLine[0][0] + i;
+
+        if (line->valid && (line->pdrv == pdrv))
+        {
+            if (line->dirty)
+            {
+                s_diskCacheStat.lostDirty++;
+            }
+            line->valid = 0U;
+            line->dirty = 0U;
+        }
+    }
+    s_diskCacheStat.invalidations++;
+    DISK_CACHE_UNLOCK();
+}
+
+void DiskCache_Discard(BYTE pdrv, LBA_t start, LBA_t end)
+{
+    DISK_CACHE_LOCK();
+    for (uint32_t i = 0; i < (DISK_CACHE_SETS * DISK_CACHE_WAYS); i++)
+    {
+        disk_cache_line_t *line = &s_diskCacheLine[0][0] + i;
+
+        /* a dirty line here belongs to a freed cluster, writing it back after the unmap would map it again */
+        if (line->valid && (line->pdrv == pdrv) && (line->sector >= start) && (line->sector <= end))
+        {
+            line->valid = 0U;
+            line->dirty = 0U;
+        }
+    }
+    DISK_CACHE_UNLOCK();
+}
+
+void DiskCache_GetStat(disk_cache_stat_t *stat, uint8_t reset)
+{
+    uint32_t primask;
+
+    primask = DisableGlobalIRQ();
+    *stat = s_diskCacheStat;
+    if (reset)
+    {
+        memset(&s_diskCacheStat, 0, sizeof(s_diskCacheStat));
+    }
+    EnableGlobalIRQ(primask);
+}
+
+#endif /* DISK_CACHE_ENABLE */
@@ -0,0 +1,112 @@
+/*
+ * diskio_cache.h
+ *
+ *  Created on: 2026/10/18
+ *      Author: M.Akino
+ */
+
+#ifndef DISKIO_CACHE_H_
+#define DISKIO_CACHE_H_
+
+#include <stdint.h>
+#include "ff.h"
+#include "diskio.h"
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+
+/*! @brief 0 - disk_read/disk_write go straight to the drive; 1 - the volume window sectors go through a set associative LRU sector cache */
+#define DISK_CACHE_ENABLE (1U)
+
+/*! @brief number of sets, must be a power of 2, sector N lives in set N % DISK_CACHE_SETS */
+#define DISK_CACHE_SETS (4U)
+
+/*! @brief lines (ways) per set, RAM use is DISK_CACHE_SETS * DISK_CACHE_WAYS * FF_MAX_SS bytes */
+#define DISK_CACHE_WAYS (4U)
+
+/*! @brief 0 - write-through; 1 - write-back, dirty lines reach the drive on eviction or CTRL_SYNC */
+#define DISK_CACHE_WRITE_BACK (0U)
+
+/*! @brief cache statistics */
+typedef struct _disk_cache_stat
+{
+    uint32_t readHits;      /*!< sectors read from the cache */
+    uint32_t readMisses;    /*!< sectors read from the drive into the cache */
+    uint32_t writeHits;     /*!< sectors written over a cached line */
+    uint32_t writeMisses;   /*!< sectors written into a newly allocated line */
+    uint32_t bypassReads;   /*!< file data read requests passed to the drive */
+    uint32_t bypassWrites;  /*!< file data write requests passed to the drive */
+    uint32_t evictions;     /*!< valid lines replaced */
+    uint32_t writeBacks;    /*!< dirty lines written to the drive */
+    uint32_t invalidations; /*!< DiskCache_Invalidate calls */
+    uint32_t lostDirty;     /*!< dirty lines dropped by invalidation */
+} disk_cache_stat_t;
+
+#if ((defined DISK_CACHE_ENABLE) && (DISK_CACHE_ENABLE))
+
+/*******************************************************************************
+ * API
+ ******************************************************************************/
+
+/*!
+ * @brief create the cache lock, called once before the scheduler starts.
+ */
+extern void DiskCache_Init(void);
+
+/*!
+ * @brief disk_read through the cache.
+ *
+ * @param pdrv    Physical drive number.
+ * @param buff    Read data destination.
+ * @param sector  Start sector number.
+ * @param count   Number of sectors to read.
+ * @param meta    1: a volume window sector (boot, FAT, directory), kept in the cache; 0: file data, passed to the drive.
+ */
+extern DRESULT DiskCache_Read(BYTE pdrv, BYTE *buff, LBA_t sector, UINT count, uint8_t meta);
+
+/*!
+ * @brief disk_write through the cache.
+ *
+ * @param pdrv    Physical drive number.
+ * @param buff    Data to be written.
+ * @param sector  Start sector number.
+ * @param count   Number of sectors to write.
+ * @param meta    1: a volume window sector (boot, FAT, directory), kept in the cache; 0: file data, passed to the drive.
+ */
+extern DRESULT DiskCache_Write(BYTE pdrv, const BYTE *buff, LBA_t sector, UINT count, uint8_t meta);
+
+/*!
+ * @brief write the dirty lines of a drive, called on CTRL_SYNC. Nothing to do in write-through.
+ *
+ * @param pdrv    Physical drive number.
+ */
+extern DRESULT DiskCache_Sync(BYTE pdrv);
+
+/*!
+ * @brief drop all lines of a drive without writing them, called when the media is attached or detached.
+ *
+ * @param pdrv    Physical drive number.
+ */
+extern void DiskCache_Invalidate(BYTE pdrv);
+
+/*!
+ * @brief drop the lines of sectors [start, end] without writing them, called on CTRL_TRIM before the unmap.
+ *
+ * @param pdrv    Physical drive number.
+ * @param start   first freed sector.
+ * @param end     last freed sector.
+ */
+extern void DiskCache_Discard(BYTE pdrv, LBA_t start, LBA_t end);
+
+/*!
+ * @brief take a snapshot of the statistics and optionally clear them.
+ *
+ * @param stat    snapshot destination.
+ * @param reset   1: clear the statistics after the snapshot.
+ */
+extern void DiskCache_GetStat(disk_cache_stat_t *stat, uint8_t reset);
+
+#endif /* DISK_CACHE_ENABLE */
+
+#endif /* DISKIO_CACHE_H_ */
@@ -0,0 +1,441 @@
+/*
+ * fast_mount.c
+ *
+ *  Created on: 2026/10/18
+ *      Author: M.Akino
+ */
+
+#include <string.h>
+#include "fsl_common.h"
+#include "fast_mount.h"
+#include "diskio.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "semphr.h"
+
+#if ((defined FAST_MOUNT_ENABLE) && (FAST_MOUNT_ENABLE))
+
+/*
+ * f_mount reads the boot sector and FSINFO only, the time goes into the first f_getfree: FAT12/16 and
+ * exFAT have no stored free count and a FAT32 count from a stick that was pulled out of a PC is not
+ * worth much. Such a volume is marked unknown and counted here a few sectors at a time, each step under
+ * the volume lock, so file access goes on in between.
+ * FatFs changes the FAT only through its window, every disk_write is reported to FastMount_Written and a
+ * write behind the scan position starts the count over. The result is published only while the window
+ * holds no dirty FAT sector, from then on FatFs keeps free_clst up to date itself.
+ * Lock order: count lock -> volume -> cache -> drive. The FAT12 count is left to f_getfree, it runs after
+ * the count lock is released. The statistics are only touched in critical sections, some updates are made
+ * without the count lock.
+ */
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+
+#if (defined(STATIC_ALLOCATION_ENABLE) && (STATIC_ALLOCATION_ENABLE > 0U))
+#define FAST_MOUNT_MUTEX_CREATE() xSemaphoreCreateMutexStatic(&s_fastMountMutexBuffer)
+#else
+#define FAST_MOUNT_MUTEX_CREATE() xSemaphoreCreateMutex()
+#endif
+/* calls made before FastMount_Init (single task) are not locked */
+#define FAST_MOUNT_LOCK()                                           \
+    do                                                              \
+    {                                                               \
+        if (s_fastMountMutex != NULL)                               \
+        {                                                           \
+            (void)xSemaphoreTake(s_fastMountMutex, portMAX_DELAY);  \
+        }                                                           \
+    } while (0)
+#define FAST_MOUNT_UNLOCK()                                         \
+    do                                                              \
+    {                                                               \
+        if (s_fastMountMutex != NULL)                               \
+        {                                                           \
+            (void)xSemaphoreGive(s_fastMountMutex);                 \
+        }                                                           \
+    } while (0)
+
+#if FF_FS_REENTRANT
+#define FAST_MOUNT_VOLUME_LOCK(fs) ff_mutex_take((fs)->ldrv)
+#define FAST_MOUNT_VOLUME_UNLOCK(fs) ff_mutex_give((fs)->ldrv)
+#else
+#define FAST_MOUNT_VOLUME_LOCK(fs) (1)
+#define FAST_MOUNT_VOLUME_UNLOCK(fs)
+#endif
+
+/* single statistics update, the same critical section as FastMount_GetStat */
+#define FAST_MOUNT_STAT(statement) \
+    do                             \
+    {                              \
+        taskENTER_CRITICAL();      \
+        statement;                 \
+        taskEXIT_CRITICAL();       \
+    } while (0)
+
+/* FAT32 FAT[1]: clean shutdown and no disk error */
+#define FAST_MOUNT_FAT32_CLEAN (0x0C000000U)
+
+typedef struct _fast_mount_count
+{
+    FATFS *fs;           /*!< NULL: nothing to count */
+    WORD id;             /*!< mount ID of the counted volume */
+    uint8_t changed;     /*!< the scanned part was written, start over */
+    LBA_t base;          /*!< first FAT or allocation bitmap sector */
+    DWORD sectors;       /*!< sectors to scan */
+    volatile DWORD next; /*!< sectors scanned */
+    DWORD nfree;         /*!< free clusters in the scanned part */
+    TickType_t start;    /*!< mount time */
+} fast_mount_count_t;
+
+/*******************************************************************************
+ * Variables
+ ******************************************************************************/
+
+static fast_mount_count_t s_fastMountCount[FF_VOLUMES];
+static uint8_t s_fastMountBuffer[FAST_MOUNT_COUNT_SECTORS][FF_MAX_SS] __ALIGNED(4);
+static fast_mount_stat_t s_fastMountStat;
+static SemaphoreHandle_t s_fastMountMutex;
+#if (defined(STATIC_ALLOCATION_ENABLE) && (STATIC_ALLOCATION_ENABLE > 0U))
+static StaticSemaphore_t s_fastMountMutexBuffer;
+#endif
+
+/*******************************************************************************
+ * Code
+ ******************************************************************************/
+
+static inline DWORD FastMount_LoadWord(const BYTE *p)
+{
+    return (DWORD)p[0] | ((DWORD)p[1] << 8);
+}
+
+static inline DWORD FastMount_LoadDword(const BYTE *p)
+{
+    return (DWORD)p[0] | ((DWORD)p[1] << 8) | ((DWORD)p[2] << 16) | ((DWORD)p[3] << 24);
+}
+
+/* the free entries of sectors [first, first + n) of the FAT or the bitmap */
+static DWORD FastMount_CountFree(FATFS *fs, const BYTE *buff, DWORD first, UINT n)
+{
+    DWORD nfree = 0U;
+    DWORD index;
+    DWORD end;
+
+    if (fs->fs_type == FS_EXFAT)
+    {
+        /* one bit per cluster from cluster 2 */
+        index = first * FF_MAX_SS * 8U;
+        end   = fs->n_fatent - 2U;
+        for (UINT i = 0U; (i < (n * FF_MAX_SS)) && (index < end); i++)
+        {
+            BYTE bm = (BYTE)~buff[i];
+
+            for (UINT b = 0U; (b < 8U) && (index < end); b++, index++)
+            {
+                nfree += bm & 1U;
+                bm >>= 1;
+            }
+        }
+    }
+    else if (fs->fs_type == FS_FAT16)
+    {
+        index = first * (FF_MAX_SS / 2U);
+        for (UINT i = 0U; (i < (n * FF_MAX_SS)) && (index < fs->n_fatent); i += 2U, index++)
+        {
+            nfree += (FastMount_LoadWord(&buff[i]) == 0U);
+        }
+    }
+    else
+    {
+        index = first * (FF_MAX_SS / 4U);
+        for (UINT i = 0U; (i < (n * FF_MAX_SS)) && (index < fs->n_fatent); i += 4U, index++)
+        {
+            nfree += ((FastMount_LoadDword(&buff[i]) & 0x0FFFFFFFU) == 0U);
+        }
+    }
+    return nfree;
+}
+
+static void FastMount_CountDone(TickType_t start)
+{
+    TickType_t ms = (xTaskGetTickCount() - start) * portTICK_PERIOD_MS;
+
+    taskENTER_CRITICAL();
+    s_fastMountStat.counts++;
+    s_fastMountStat.countMs = ms;
+    taskEXIT_CRITICAL();
+}
+
+static void FastMount_Drop(fast_mount_count_t *count)
+{
+    taskENTER_CRITICAL();
+    count->fs = NULL;
+    taskEXIT_CRITICAL();
+}
+
+/* queue the count, called with the volume locked */
+static void FastMount_Queue(FATFS *fs)
+{
+    fast_mount_count_t *count = &s_fastMountCount[fs->ldrv];
+
+    count->id      = fs->id;
+    count->changed = 0U;
+    count->next    = 0U;
+    count->nfree   = 0U;
+    count->start   = xTaskGetTickCount();
+    if (fs->fs_type == FS_EXFAT)
+    {
+        count->base    = fs->bitbase;
+        count->sectors = (fs->n_fatent - 2U + (FF_MAX_SS * 8U) - 1U) / (FF_MAX_SS * 8U);
+    }
+    else
+    {
+        count->base    = fs->fatbase;
+        count->sectors = fs->fsize;
+    }
+    taskENTER_CRITICAL();
+    count->fs = fs;
+    taskEXIT_CRITICAL();
+}
+
+void FastMount_Init(void)
+{
+    if (s_fastMountMutex == NULL)
+    {
+        s_fastMountMutex = FAST_MOUNT_MUTEX_CREATE();
+    }
+}
+
+FRESULT FastMount_Mount(FATFS *fs, const TCHAR *path)
+{
+    uint32_t cycles = DWT->CYCCNT;
+    uint8_t queued  = 0U;
+    FRESULT res;
+
+    FAST_MOUNT_LOCK();
+    res = f_mount(fs, path, 1);
+    if ((res == FR_OK) && FAST_MOUNT_VOLUME_LOCK(fs))
+    {
+        if ((fs->fs_type == FS_FAT32) && (fs->free_clst <= (fs->n_fatent - 2U)))
+        {
+            /* the FSINFO count is as good as the last unmount */
+            if ((disk_read(fs->pdrv, s_fastMountBuffer[0], fs->fatbase, 1U) == RES_OK) &&
+                ((FastMount_LoadDword(&s_fastMountBuffer[0][4]) & FAST_MOUNT_FAT32_CLEAN) == FAST_MOUNT_FAT32_CLEAN))
+            {
+                FAST_MOUNT_STAT(s_fastMountStat.trusted++);
+            }
+            else
+            {
+                fs->free_clst = 0xFFFFFFFFU;
+                FAST_MOUNT_STAT(s_fastMountStat.untrusted++);
+            }
+        }
+        if (fs->free_clst > (fs->n_fatent - 2U))
+        {
+            FastMount_Queue(fs);
+            queued = 1U;
+        }
+        FAST_MOUNT_VOLUME_UNLOCK(fs);
+        cycles = DWT->CYCCNT - cycles;
+        taskENTER_CRITICAL();
+        s_fastMountStat.mounts++;
+        s_fastMountStat.mountUs = cycles / (SystemCoreClock / 1000000U);
+        taskEXIT_CRITICAL();
+    }
+    FAST_MOUNT_UNLOCK();
+    if (queued)
+    {
+        FastMount_CountRequest();
+    }
+    return res;
+}
+
+/* volume number of a "N:" path, FF_STR_VOLUME_ID is 0 */
+static int FastMount_Volume(const TCHAR *path)
+{
+    return ((path[0] >= '0') && (path[0] <= '9') && (path[1] == ':')) ? (path[0] - '0') : 0;
+}
+
+void FastMount_Cancel(const TCHAR *path)
+{
+    int vol = FastMount_Volume(path);
+
+    if (vol < FF_VOLUMES)
+    {
+        /* waits for a step in progress */
+        FAST_MOUNT_LOCK();
+        FastMount_Drop(&s_fastMountCount[vol]);
+        FAST_MOUNT_UNLOCK();
+    }
+}
+
+/* one step of a count, called with the count lock, a FAT12 volume is dropped and *getfree set for the caller */
+static uint8_t FastMount_Step(fast_mount_count_t *count, uint8_t *getfree)
+{
+    FATFS *fs = count->fs;
+    uint8_t more = 1U;
+    DWORD first;
+    UINT n;
+
+    if ((fs->fs_type == 0U) || (fs->id != count->id))
+    {
+        /* unmounted without FastMount_Cancel */
+        FastMount_Drop(count);
+        return 0U;
+    }
+    if (fs->fs_type == FS_FAT12)
+    {
+        /* a few sectors at most, f_getfree counts the 12 bit entries in one go */
+        FastMount_Drop(count);
+        *getfree = 1U;
+        return 0U;
+    }
+    if (!FAST_MOUNT_VOLUME_LOCK(fs))
+    {
+        return 0U;
+    }
+
+    if (fs->free_clst <= (fs->n_fatent - 2U))
+    {
+        /* f_getfree has scanned it meanwhile */
+        FastMount_Drop(count);
+        more = 0U;
+    }
+    else if (count->next < count->sectors)
+    {
+        first = count->next;
+        n     = ((count->sectors - first) < FAST_MOUNT_COUNT_SECTORS) ? (UINT)(count->sectors - first) :
+                                                                      FAST_MOUNT_COUNT_SECTORS;
+        if (disk_read(fs->pdrv, s_fastMountBuffer[0], count->base + first, n) != RES_OK)
+        {
+            FAST_MOUNT_STAT(s_fastMountStat.errors++);
+            FastMount_Drop(count);
+            more = 0U;
+        }
+        else
+        {
+            /* the window is newer than the drive */
+            if (fs->wflag && (fs->winsect >= (count->base + first)) && (fs->winsect < (count->base + first + n)))
+            {
+                memcpy(s_fastMountBuffer[fs->winsect - count->base - first], fs->win, FF_MAX_SS);
+            }
+            count->nfree += FastMount_CountFree(fs, s_fastMountBuffer[0], first, n);
+            taskENTER_CRITICAL();
+            count->next = first + n;
+            taskEXIT_CRITICAL();
+        }
+    }
+    else if (count->changed)
+    {
+        FAST_MOUNT_STAT(s_fastMountStat.restarts++);
+        taskENTER_CRITICAL();
+        count->changed = 0U;
+        count->next    = 0U;
+        taskEXIT_CRITICAL();
+        count->nfree = 0U;
+    }
+    else if (fs->wflag && (fs->winsect >= count->base) && ((fs->winsect - count->base) < count->sectors))
+    {
+        /* a scanned sector may change in the window without a write, wait for the flush */
+        more = 0U;
+    }
+    else
+    {
+        fs->free_clst = count->nfree;
+        fs->fsi_flag |= 1U; /* FAT32: FSINFO is to be updated */
+        FastMount_CountDone(count->start);
+        FastMount_Drop(count);
+        more = 0U;
+    }
+    FAST_MOUNT_VOLUME_UNLOCK(fs);
+    return more;
+}
+
+uint8_t FastMount_Count(void)
+{
+    TickType_t start[FF_VOLUMES];
+    uint8_t getfree[FF_VOLUMES] = {0U};
+    uint8_t more = 0U;
+
+    FAST_MOUNT_LOCK();
+    for (uint32_t i = 0U; i < FF_VOLUMES; i++)
+    {
+        if (s_fastMountCount[i].fs != NULL)
+        {
+            start[i] = s_fastMountCount[i].start;
+            more |= FastMount_Step(&s_fastMountCount[i], &getfree[i]);
+        }
+    }
+    FAST_MOUNT_UNLOCK();
+    /* f_getfree takes the volume lock itself, not under the count lock */
+    for (uint32_t i = 0U; i < FF_VOLUMES; i++)
+    {
+        if (getfree[i])
+        {
+            TCHAR path[3] = {(TCHAR)('0' + i), ':', 0};
+            DWORD nclst;
+            FATFS *dummy;
+
+            if (f_getfree(path, &nclst, &dummy) == FR_OK)
+            {
+                FastMount_CountDone(start[i]);
+            }
+        }
+    }
+    return more;
+}
+
+uint8_t FastMount_Pending(void)
+{
+    for (uint32_t i = 0U; i < FF_VOLUMES; i++)
+    {
+        if (s_fastMountCount[i].fs != NULL)
+        {
+            return 1U;
+        }
+    }
+    return 0U;
+}
+
+__attribute__((weak)) void FastMount_CountRequest(void)
+{
+}
+
+FRESULT FastMount_GetFree(const TCHAR *path, DWORD *nclst, FATFS **fatfs)
+{
+    int vol = FastMount_Volume(path);
+
+    if ((vol < FF_VOLUMES) && (s_fastMountCount[vol].fs != NULL))
+    {
+        return FR_NOT_READY;
+    }
+    return f_getfree(path, nclst, fatfs);
+}
+
+void FastMount_Written(BYTE pdrv, LBA_t sector, UINT count)
+{
+    taskENTER_CRITICAL();
+    for (uint32_t i = 0U; i < FF_VOLUMES; i++)
+    {
+        fast_mount_count_t *c = &s_fastMountCount[i];
+
+        if ((c->fs != NULL) && (c->fs->pdrv == pdrv) && ((sector + count) > c->base) &&
+            (sector < (c->base + c->next)))
+        {
+            c->changed = 1U;
+        }
+    }
+    taskEXIT_CRITICAL();
+}
+
+void FastMount_GetStat(fast_mount_stat_t *stat, uint8_t reset)
+{
+    taskENTER_CRITICAL();
+    *stat = s_fastMountStat;
+    if (reset)
+    {
+        memset(&s_fastMountStat, 0, sizeof(s_fastMountStat));
+    }
+    taskEXIT_CRITICAL();
+}
+
+#endif /* FAST_MOUNT_ENABLE */
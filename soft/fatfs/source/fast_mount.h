@@ -0,0 +1,118 @@
+/*
+ * fast_mount.h
+ *
+ *  Created on: 2026/10/18
+ *      Author: M.Akino
+ */
+
+#ifndef FAST_MOUNT_H_
+#define FAST_MOUNT_H_
+
+#include <stdint.h>
+#include "ff.h"
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+
+/*! @brief 0 - FastMount_Mount is f_mount; 1 - the free clusters of an unknown volume are counted in the background */
+#define FAST_MOUNT_ENABLE (1U)
+
+/*! @brief FAT or bitmap sectors read per count step, the volume is locked for one step */
+#define FAST_MOUNT_COUNT_SECTORS (8U)
+
+/*! @brief retry interval while the FAT window of a counted volume is dirty */
+#define FAST_MOUNT_RETRY_MS (100U)
+
+/*! @brief fast mount statistics */
+typedef struct _fast_mount_stat
+{
+    uint32_t mounts;      /*!< FastMount_Mount calls that mounted a volume */
+    uint32_t trusted;     /*!< FAT32 volumes with a clean FSINFO free count, nothing to count */
+    uint32_t untrusted;   /*!< FSINFO free count dropped, the volume was not unmounted cleanly */
+    uint32_t counts;      /*!< background counts finished */
+    uint32_t restarts;    /*!< counts started over, the counted part of the FAT was written */
+    uint32_t errors;      /*!< counts given up on a disk error */
+    uint32_t mountUs;     /*!< last f_mount including the FSINFO check */
+    uint32_t countMs;     /*!< last background count, from the mount to the result */
+} fast_mount_stat_t;
+
+#if ((defined FAST_MOUNT_ENABLE) && (FAST_MOUNT_ENABLE))
+
+/*******************************************************************************
+ * API
+ ******************************************************************************/
+
+/*!
+ * @brief create the count lock, called once before the scheduler starts.
+ */
+extern void FastMount_Init(void);
+
+/*!
+ * @brief mount a volume now without scanning the FAT.
+ *
+ * A FAT32 FSINFO free count is kept when FAT[1] has the clean shutdown and no error bits set. Otherwise,
+ * and on FAT12/16 and exFAT, the free clusters are counted by FastMount_Count in the background.
+ *
+ * @param fs      filesystem object.
+ * @param path    logical drive, e.g. "1:".
+ * @return f_mount result.
+ */
+extern FRESULT FastMount_Mount(FATFS *fs, const TCHAR *path);
+
+/*!
+ * @brief stop the background count of a volume, call it before f_unmount.
+ *
+ * @param path    logical drive.
+ */
+extern void FastMount_Cancel(const TCHAR *path);
+
+/*!
+ * @brief run one step of a background count.
+ *
+ * @return 1: call again, 0: nothing to do now.
+ */
+extern uint8_t FastMount_Count(void);
+
+/*!
+ * @brief check for unfinished counts.
+ *
+ * @return 1: a count is waiting, call FastMount_Count again after FAST_MOUNT_RETRY_MS at the latest.
+ */
+extern uint8_t FastMount_Pending(void);
+
+/*!
+ * @brief weak, called when a count is queued. The application should run FastMount_Count in a low priority task.
+ */
+extern void FastMount_CountRequest(void);
+
+/*!
+ * @brief f_getfree that does not scan the FAT while the background count of the volume runs.
+ *
+ * @param path    logical drive.
+ * @param nclst   number of free clusters.
+ * @param fatfs   filesystem object of the drive.
+ * @return FR_NOT_READY while the count runs, else the f_getfree result.
+ */
+extern FRESULT FastMount_GetFree(const TCHAR *path, DWORD *nclst, FATFS **fatfs);
+
+/*!
+ * @brief called by disk_write, a write into the counted part of the FAT restarts the count.
+ *
+ * @param pdrv    physical drive.
+ * @param sector  first sector written.
+ * @param count   number of sectors.
+ */
+extern void FastMount_Written(BYTE pdrv, LBA_t sector, UINT count);
+
+/*!
+ * @brief take a snapshot of the statistics and optionally clear them.
+ *
+ * @param stat    snapshot destination.
+ * @param reset   1: clear the statistics after the snapshot.
+ */
+extern void FastMount_GetStat(fast_mount_stat_t *stat, uint8_t reset);
+
+#endif /* FAST_MOUNT_ENABLE */
+
+#endif /* FAST_MOUNT_H_ */
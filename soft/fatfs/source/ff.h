@@ -380,6 +380,8 @@ int ff_mutex_create (int vol);		/* Create a sync object */
 void ff_mutex_delete (int vol);		/* Delete a sync object */
 int ff_mutex_take (int vol);		/* Lock sync object */
 void ff_mutex_give (int vol);		/* Unlock sync object */
+void ff_volume_close (int vol);		/* Block new calls and wait for the users before f_unmount */
+void ff_volume_open (int vol);		/* Let calls in again after f_unmount */
 #endif
 
 
@@ -11,14 +11,14 @@
 /* Allocate/Free a Memory Block                                           */
 /*------------------------------------------------------------------------*/
 
-#include <stdlib.h>		/* with POSIX API */
+#include "FreeRTOS.h"	/* heap_4, the newlib heap is only 1KB and not thread-safe */
 
 
 void* ff_memalloc (	/* Returns pointer to the allocated memory block (null if not enough core) */
 	UINT msize		/* Number of bytes to allocate */
 )
 {
-	return malloc((size_t)msize);	/* Allocate a new memory block */
+	return pvPortMalloc((size_t)msize);	/* Allocate a new memory block */
 }
 
 
@@ -26,7 +26,7 @@ void ff_memfree (
 	void* mblock	/* Pointer to the memory block to free (no effect if null) */
 )
 {
-	free(mblock);	/* Free the memory block */
+	vPortFree(mblock);	/* Free the memory block */
 }
 
 #endif
@@ -57,8 +57,14 @@ static OS_EVENT *Mutex[FF_VOLUMES + 1];	/* Table of mutex pinter */
 
 #elif OS_TYPE == 3	/* FreeRTOS */
 #include "FreeRTOS.h"
+#include "task.h"
 #include "semphr.h"
 static SemaphoreHandle_t Mutex[FF_VOLUMES + 1];	/* Table of mutex handle */
+static volatile UINT Users[FF_VOLUMES + 1];		/* Tasks holding or waiting for the mutex */
+static volatile BYTE Closed[FF_VOLUMES + 1];	/* Set by ff_volume_close, takes fail until ff_volume_open */
+#if (defined(STATIC_ALLOCATION_ENABLE) && (STATIC_ALLOCATION_ENABLE > 0U))
+static StaticSemaphore_t MutexBuffer[FF_VOLUMES + 1];	/* Mutex control blocks, f_mount re-creates them in place */
+#endif
 
 #elif OS_TYPE == 4	/* CMSIS-RTOS */
 #include "cmsis_os.h"
@@ -97,7 +103,12 @@ int ff_mutex_create (	/* Returns 1:Function succeeded or 0:Could not create the
 	return (int)(err == OS_NO_ERR);
 
 #elif OS_TYPE == 3	/* FreeRTOS */
+	/* a mutex, not a semaphore: priority inheritance lifts a low priority task holding the volume */
+#if (defined(STATIC_ALLOCATION_ENABLE) && (STATIC_ALLOCATION_ENABLE > 0U))
+	Mutex[vol] = xSemaphoreCreateMutexStatic(&MutexBuffer[vol]);
+#else
 	Mutex[vol] = xSemaphoreCreateMutex();
+#endif
 	return (int)(Mutex[vol] != NULL);
 
 #elif OS_TYPE == 4	/* CMSIS-RTOS */
@@ -166,7 +177,26 @@ int ff_mutex_take (	/* Returns 1:Succeeded or 0:Timeout */
 	return (int)(err == OS_NO_ERR);
 
 #elif OS_TYPE == 3	/* FreeRTOS */
-	return (int)(xSemaphoreTake(Mutex[vol], FF_FS_TIMEOUT) == pdTRUE);
+	int rv;
+
+	taskENTER_CRITICAL();
+	if (Closed[vol]) {		/* The volume is being unmounted */
+		taskEXIT_CRITICAL();
+		return 0;
+	}
+	Users[vol]++;
+	taskEXIT_CRITICAL();
+	rv = (int)(xSemaphoreTake(Mutex[vol], FF_FS_TIMEOUT) == pdTRUE);
+	if (rv && Closed[vol]) {	/* Closed while waiting, leave it to the unmount */
+		xSemaphoreGive(Mutex[vol]);
+		rv = 0;
+	}
+	if (!rv) {
+		taskENTER_CRITICAL();
+		Users[vol]--;
+		taskEXIT_CRITICAL();
+	}
+	return rv;
 
 #elif OS_TYPE == 4	/* CMSIS-RTOS */
 	return (int)(osMutexWait(Mutex[vol], FF_FS_TIMEOUT) == osOK);
@@ -197,6 +227,9 @@ void ff_mutex_give (
 
 #elif OS_TYPE == 3	/* FreeRTOS */
 	xSemaphoreGive(Mutex[vol]);
+	taskENTER_CRITICAL();
+	Users[vol]--;
+	taskEXIT_CRITICAL();
 
 #elif OS_TYPE == 4	/* CMSIS-RTOS */
 	osMutexRelease(Mutex[vol]);
@@ -204,5 +237,44 @@ void ff_mutex_give (
 #endif
 }
 
+
+#if OS_TYPE == 3	/* FreeRTOS */
+/*------------------------------------------------------------------------*/
+/* Close a Volume for Unmount                                             */
+/*------------------------------------------------------------------------*/
+/* f_unmount deletes the volume mutex without taking it. Call this before
+/  f_unmount: new file functions fail with FR_TIMEOUT, and it returns when
+/  no task holds or waits for the mutex. Each of them leaves within
+/  FF_FS_TIMEOUT, a disk function on a detached device fails at once.
+*/
+
+void ff_volume_close (
+	int vol			/* Volume ID (0 to FF_VOLUMES - 1) */
+)
+{
+	taskENTER_CRITICAL();
+	Closed[vol] = 1;
+	taskEXIT_CRITICAL();
+	while (Users[vol] != 0) {
+		vTaskDelay(1);
+	}
+}
+
+
+/*------------------------------------------------------------------------*/
+/* Reopen a Volume after Unmount                                          */
+/*------------------------------------------------------------------------*/
+/* An unmounted volume returns FR_NOT_ENABLED without the mutex, so the
+/  file functions may come in again right after f_unmount.
+*/
+
+void ff_volume_open (
+	int vol			/* Volume ID (0 to FF_VOLUMES - 1) */
+)
+{
+	Closed[vol] = 0;
+}
+#endif
+
 #endif	/* FF_FS_REENTRANT */
 
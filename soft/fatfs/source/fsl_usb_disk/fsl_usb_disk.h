@@ -23,10 +23,124 @@
 /*! @brief mass storage read/write retry time */
 #define USB_HOST_FATFS_RW_RETRY_TIMES                   (2U)
 
+/*! @brief logical units served as drives USBDISK, USBDISK2, e.g. the slots of a card reader, each takes a bounce buffer */
+#ifndef USB_HOST_FATFS_LUNS
+#define USB_HOST_FATFS_LUNS                             (2U)
+#endif
+#if (USB_HOST_FATFS_LUNS > 2U) || ((USBDISK + USB_HOST_FATFS_LUNS) > FF_VOLUMES)
+#error "USB_HOST_FATFS_LUNS: one FatFs volume per logical unit, drives USBDISK and USBDISK2"
+#endif
+
+/*! @brief sectors of the bounce buffer used for cacheable or unaligned buffers, one read10/write10 moves up to this many */
+#ifndef USB_HOST_FATFS_BOUNCE_SECTORS
+#define USB_HOST_FATFS_BOUNCE_SECTORS                   (8U)
+#endif
+
+/*! @brief 0 - each read10 covers the request only; 1 - sequential reads prefetch up to the bounce buffer size */
+#ifndef USB_HOST_FATFS_READ_AHEAD_ENABLE
+#define USB_HOST_FATFS_READ_AHEAD_ENABLE                (1U)
+#endif
+
+/*! @brief 0 - CTRL_TRIM is ignored; 1 - READ CAPACITY(16) is sent at the mount and CTRL_TRIM becomes UNMAP on units
+ * with the LBPME bit set, a unit that rejects either command is not asked again until the next mount */
+#ifndef USB_HOST_FATFS_UNMAP_ENABLE
+#define USB_HOST_FATFS_UNMAP_ENABLE                     (1U)
+#endif
+
+/*! @brief blocks per UNMAP command, a large trim (f_mkfs, a big file) is split to bound the time of one command */
+#ifndef USB_HOST_FATFS_UNMAP_MAX_SECTORS
+#define USB_HOST_FATFS_UNMAP_MAX_SECTORS                (0x10000U)
+#endif
+
+/*! @brief read-ahead statistics */
+typedef struct _usb_host_fatfs_read_ahead_stat
+{
+    uint32_t requests;      /*!< read requests */
+    uint32_t sectors;       /*!< sectors requested */
+    uint32_t hits;          /*!< sectors served from the prefetch buffer without a command */
+    uint32_t commands;      /*!< read10 commands issued */
+    uint32_t driveSectors;  /*!< sectors transferred by read10 */
+    uint32_t window;        /*!< current read-ahead window in sectors, the widest of the logical units */
+} usb_host_fatfs_read_ahead_stat_t;
+
+/*! @brief 0 - each write goes to the disk at once; 1 - adjacent sector writes are merged in the bounce buffer */
+#ifndef USB_HOST_FATFS_WRITE_COALESCE_ENABLE
+#define USB_HOST_FATFS_WRITE_COALESCE_ENABLE            (1U)
+#endif
+
+/*! @brief longest time a merged write waits for more sectors before USB_HostMsdFlushRequest is called */
+#ifndef USB_HOST_FATFS_WRITE_FLUSH_MS
+#define USB_HOST_FATFS_WRITE_FLUSH_MS                   (200U)
+#endif
+
+/*! @brief why the merged writes were sent */
+typedef enum _usb_host_fatfs_flush_reason
+{
+    kUSB_HostFatfsFlushFull = 0U, /*!< bounce buffer full */
+    kUSB_HostFatfsFlushGap,       /*!< next write not adjacent */
+    kUSB_HostFatfsFlushRead,      /*!< read needs the bounce buffer */
+    kUSB_HostFatfsFlushSync,      /*!< CTRL_SYNC, f_sync or f_close */
+    kUSB_HostFatfsFlushTimer,     /*!< USB_HOST_FATFS_WRITE_FLUSH_MS elapsed */
+    kUSB_HostFatfsFlushIoctl,     /*!< CTRL_TRIM or a capacity query */
+
+    kUSB_HostFatfsFlushNumOf,
+} usb_host_fatfs_flush_reason_t;
+
+/*! @brief write coalescing statistics */
+typedef struct _usb_host_fatfs_write_stat
+{
+    uint32_t requests;                        /*!< write requests */
+    uint32_t sectors;                         /*!< sectors requested */
+    uint32_t commands;                        /*!< write10 commands issued */
+    uint32_t dropped;                         /*!< merged sectors lost by a failed write10 or a remount */
+    uint32_t flush[kUSB_HostFatfsFlushNumOf]; /*!< write10 commands by reason */
+} usb_host_fatfs_write_stat_t;
+
+/*! @brief read10/write10 time in the class driver, the rest of a disk_read/disk_write is FatFs and cache overhead
+ *
+ * read16/write16, used above block 0xFFFFFFFF, are counted as read10/write10.
+ */
+typedef struct _usb_host_fatfs_transfer_stat
+{
+    uint32_t readCommands;  /*!< read10 commands completed or failed */
+    uint32_t readSectors;   /*!< sectors read */
+    uint64_t readCycles;    /*!< DWT cycles from read10 submit to completion, retries included */
+    uint32_t writeCommands; /*!< write10 commands completed or failed */
+    uint32_t writeSectors;  /*!< sectors written */
+    uint64_t writeCycles;   /*!< DWT cycles from write10 submit to completion, retries included */
+    uint32_t unmapCommands; /*!< UNMAP commands completed or failed */
+    uint32_t unmapSectors;  /*!< sectors unmapped */
+    uint64_t unmapCycles;   /*!< DWT cycles from UNMAP submit to completion */
+} usb_host_fatfs_transfer_stat_t;
+
+/*! @brief completion of USB_HostMsdSubmitDisk, runs in the USB host task */
+typedef void (*usb_host_fatfs_callback_t)(void *param, DRESULT result);
+
+/*! @brief one asynchronous sector transfer, owned by the MSD class until it completes */
+typedef struct _usb_host_fatfs_request
+{
+    usb_host_fatfs_callback_t callbackFn; /*!< completion callback, may be NULL */
+    void *callbackParam;                  /*!< completion callback parameter */
+    volatile DRESULT result;              /*!< transfer result, valid when busy is 0 */
+    volatile uint8_t busy;                /*!< 1 while queued or executing */
+} usb_host_fatfs_request_t;
+
 /*******************************************************************************
  * API
  ******************************************************************************/
 
+/*!
+ * @brief set the logical units of the attached device, call it before the drives are mounted.
+ *
+ * @param count          GET MAX LUN + 1, clipped to USB_HOST_FATFS_LUNS; 1 for a device that stalls GET MAX LUN.
+ */
+extern void USB_HostMsdSetLunCount(uint8_t count);
+
+/*!
+ * @brief get the logical units served, drives USBDISK to USBDISK + count - 1.
+ */
+extern uint8_t USB_HostMsdGetLunCount(void);
+
 /*!
  * @brief fatfs call this function to initialize physical disk.
  *
@@ -76,6 +190,10 @@ extern DRESULT USB_HostMsdWriteDisk(BYTE pdrv, const BYTE *buff, LBA_t sector, U
 /*!
  * @brief fatfs call this function to write data to physical disk.
  *
+ * CTRL_TRIM (FF_USE_TRIM) sends UNMAP for the inclusive sector range buff[0] - buff[1] when the unit supports it,
+ * so a flash device does not copy the freed sectors in its garbage collection. It succeeds without a command
+ * on other units.
+ *
  * @param pdrv           Physical drive number.
  * @param cmd            ioctl command, please reference to diskio.h
  * @param buff           Parameter or data buffer.
@@ -86,5 +204,70 @@ extern DRESULT USB_HostMsdWriteDisk(BYTE pdrv, const BYTE *buff, LBA_t sector, U
  */
 extern DRESULT USB_HostMsdIoctlDisk(BYTE pdrv, BYTE cmd, void *buff);
 
+/*!
+ * @brief take a snapshot of the read-ahead statistics of all logical units and optionally clear them.
+ *
+ * @param stat           snapshot destination.
+ * @param reset          1: clear the statistics after the snapshot.
+ */
+extern void USB_HostMsdReadAheadGetStat(usb_host_fatfs_read_ahead_stat_t *stat, uint8_t reset);
+
+/*!
+ * @brief write the merged sectors, called in task context after USB_HostMsdFlushRequest for every logical unit.
+ *
+ * Returns at once when a FatFs call holds the disk, that call flushes or re-arms the timer itself.
+ * A failed write10 is also kept for the logical unit, the next CTRL_SYNC or disk_write returns it to FatFs.
+ *
+ * @param pdrv           Physical drive number.
+ */
+extern DRESULT USB_HostMsdFlushDisk(BYTE pdrv);
+
+/*!
+ * @brief weak, called from the timer service task when merged writes have waited USB_HOST_FATFS_WRITE_FLUSH_MS.
+ *
+ * The application should call USB_HostMsdFlushDisk for each logical unit from a task with enough stack for a write10.
+ */
+extern void USB_HostMsdFlushRequest(void);
+
+/*!
+ * @brief take a snapshot of the write coalescing statistics of all logical units and optionally clear them.
+ *
+ * @param stat           snapshot destination.
+ * @param reset          1: clear the statistics after the snapshot.
+ */
+extern void USB_HostMsdWriteGetStat(usb_host_fatfs_write_stat_t *stat, uint8_t reset);
+
+/*!
+ * @brief take a snapshot of the read10/write10 time statistics of all logical units and optionally clear them.
+ *
+ * @param stat           snapshot destination.
+ * @param reset          1: clear the statistics after the snapshot.
+ */
+extern void USB_HostMsdTransferGetStat(usb_host_fatfs_transfer_stat_t *stat, uint8_t reset);
+
+/*!
+ * @brief queue one read10/write10 and return without waiting for it.
+ *
+ * Up to USB_HOST_MSD_COMMAND_QUEUE_LENGTH commands wait behind the executing one and each CBW goes out from the
+ * CSW callback of the previous command, so a player or recorder can keep the next buffer in flight while it
+ * processes the current one. The transfer bypasses the sector cache and the bounce buffer: use it for the data
+ * sectors of a file FatFs is not writing at the same time (e.g. preallocated with f_expand), and place buff in
+ * the DMA capable non-cacheable section when the data section is cacheable.
+ *
+ * @param pdrv           Physical drive number.
+ * @param request        request context, must stay valid until busy is 0.
+ * @param write          0: read10, 1: write10.
+ * @param buff           data buffer.
+ * @param sector         Start sector number.
+ * @param count          Number of sectors.
+ *
+ * @retval RES_OK        queued, request->callbackFn reports the result.
+ * @retval RES_PARERR    parameter error.
+ * @retval RES_NOTRDY    no disk or the command queue is full.
+ * @retval RES_ERROR     usb stack driver error.
+ */
+extern DRESULT USB_HostMsdSubmitDisk(
+    BYTE pdrv, usb_host_fatfs_request_t *request, uint8_t write, BYTE *buff, LBA_t sector, UINT count);
+
 #endif /* _MSD_DISKIO_H_ */
 
@@ -13,11 +13,127 @@
 #ifdef USB_DISK_ENABLE
 
 #include "fsl_usb_disk.h" /* FatFs lower layer API */
+#if (defined(STATIC_ALLOCATION_ENABLE) && (STATIC_ALLOCATION_ENABLE > 0U))
+#include <cr_section_macros.h>
+#endif
+#include "timers.h"
 
 /*******************************************************************************
  * Definitons
  ******************************************************************************/
 
+#if (defined(STATIC_ALLOCATION_ENABLE) && (STATIC_ALLOCATION_ENABLE > 0U))
+#define USB_DISK_COMMAND_SEMAPHORE_CREATE(lun) \
+    xSemaphoreCreateCountingStatic(0x01U, 0x00U, &s_CommandSemaphoreBuffer[(lun)->number])
+#else
+#define USB_DISK_COMMAND_SEMAPHORE_CREATE(lun) xSemaphoreCreateCounting(0x01U, 0x00U)
+#endif
+
+/* read-ahead needs the bounce buffer, it is the prefetch buffer */
+#if ((defined(USB_HOST_CONFIG_BUFFER_PROPERTY_CACHEABLE) && (USB_HOST_CONFIG_BUFFER_PROPERTY_CACHEABLE)) ||\
+     (defined(DATA_SECTION_IS_CACHEABLE) && (DATA_SECTION_IS_CACHEABLE))) &&\
+    (defined(USB_HOST_FATFS_READ_AHEAD_ENABLE) && (USB_HOST_FATFS_READ_AHEAD_ENABLE))
+#define USB_DISK_READ_AHEAD (1U)
+#else
+#define USB_DISK_READ_AHEAD (0U)
+#endif
+
+/* write coalescing keeps the merged sectors in the bounce buffer */
+#if ((defined(USB_HOST_CONFIG_BUFFER_PROPERTY_CACHEABLE) && (USB_HOST_CONFIG_BUFFER_PROPERTY_CACHEABLE)) ||\
+     (defined(DATA_SECTION_IS_CACHEABLE) && (DATA_SECTION_IS_CACHEABLE))) &&\
+    (defined(USB_HOST_FATFS_WRITE_COALESCE_ENABLE) && (USB_HOST_FATFS_WRITE_COALESCE_ENABLE))
+#define USB_DISK_WRITE_COALESCE (1U)
+#else
+#define USB_DISK_WRITE_COALESCE (0U)
+#endif
+
+/* bounce buffer of one logical unit, without the bounce paths it only takes the READ CAPACITY, sense and UNMAP data */
+#if (defined(USB_HOST_CONFIG_BUFFER_PROPERTY_CACHEABLE) && (USB_HOST_CONFIG_BUFFER_PROPERTY_CACHEABLE)) ||\
+    (defined(DATA_SECTION_IS_CACHEABLE) && (DATA_SECTION_IS_CACHEABLE))
+#define USB_DISK_TRANSFER_BUFFER_SIZE (FF_MAX_SS * USB_HOST_FATFS_BOUNCE_SECTORS)
+#else
+#define USB_DISK_TRANSFER_BUFFER_SIZE \
+    (((sizeof(usb_host_ufi_read_capacity16_t) + USB_DATA_ALIGN_SIZE - 1U) / USB_DATA_ALIGN_SIZE) * USB_DATA_ALIGN_SIZE)
+#endif
+
+#if USB_DISK_WRITE_COALESCE
+#if (defined(STATIC_ALLOCATION_ENABLE) && (STATIC_ALLOCATION_ENABLE > 0U))
+#define USB_DISK_MUTEX_CREATE(lun) xSemaphoreCreateMutexStatic(&s_DiskMutexBuffer[(lun)->number])
+#define USB_DISK_FLUSH_TIMER_CREATE(lun)                                                        \
+    xTimerCreateStatic("usb disk", pdMS_TO_TICKS(USB_HOST_FATFS_WRITE_FLUSH_MS), pdFALSE, (lun), \
+                       USB_HostMsdFlushTimerCallback, &s_WriteFlushTimerBuffer[(lun)->number])
+#else
+#define USB_DISK_MUTEX_CREATE(lun) xSemaphoreCreateMutex()
+#define USB_DISK_FLUSH_TIMER_CREATE(lun) \
+    xTimerCreate("usb disk", pdMS_TO_TICKS(USB_HOST_FATFS_WRITE_FLUSH_MS), pdFALSE, (lun), USB_HostMsdFlushTimerCallback)
+#endif
+/* the flush runs from another task, every user of the bounce buffer holds the disk mutex (created by the first mount) */
+#define USB_DISK_LOCK(lun)                                          \
+    do                                                              \
+    {                                                               \
+        if ((lun)->diskMutex != NULL)                               \
+        {                                                           \
+            (void)xSemaphoreTake((lun)->diskMutex, portMAX_DELAY);  \
+        }                                                           \
+    } while (0)
+#define USB_DISK_UNLOCK(lun)                                        \
+    do                                                              \
+    {                                                               \
+        if ((lun)->diskMutex != NULL)                               \
+        {                                                           \
+            (void)xSemaphoreGive((lun)->diskMutex);                 \
+        }                                                           \
+    } while (0)
+#define USB_DISK_WRITE_FLUSH(lun, reason) USB_HostMsdWriteFlush((lun), (reason))
+#else
+#define USB_DISK_LOCK(lun)
+#define USB_DISK_UNLOCK(lun)
+#define USB_DISK_WRITE_FLUSH(lun, reason) RES_OK
+#endif
+
+#if USB_DISK_READ_AHEAD
+#define USB_DISK_READ_AHEAD_INVALIDATE(lun) ((lun)->readAheadCount = 0U)
+#else
+#define USB_DISK_READ_AHEAD_INVALIDATE(lun)
+#endif
+
+/* READ(10)/WRITE(10) carry a 32bit LBA, the sectors above 2TB (512B) take READ(16)/WRITE(16) */
+#define USB_DISK_LBA32(sector, count) (((uint64_t)(sector) + (count)) <= 0x100000000ULL)
+/* within the capacity, a unit without one is limited to the READ(10) range */
+#define USB_DISK_LBA_VALID(lun, sector, count) \
+    (((uint64_t)(sector) + (count)) <= (((lun)->sectorCount != 0U) ? (lun)->sectorCount : 0x100000000ULL))
+
+/*! @brief one logical unit of the attached device, served as drive USBDISK + number */
+typedef struct _usb_disk_lun
+{
+    uint8_t number;                     /* LUN in the CBW */
+    uint8_t *buffer;                    /* bounce buffer, s_UsbTransferBuffer[number] */
+    uint32_t sectorSize;
+    uint64_t sectorCount;               /* 0: unknown */
+    uint8_t capacity16;                 /* READ CAPACITY(16) succeeded */
+    uint8_t unmap;                      /* LBPME set and no UNMAP failed */
+    SemaphoreHandle_t commandSemaphore; /* given by the command callback */
+    volatile usb_status_t ufiStatus;    /* command callback status */
+#if USB_DISK_READ_AHEAD
+    /* sectors held in the bounce buffer, any other use of the buffer clears readAheadCount */
+    LBA_t readAheadSector;
+    uint32_t readAheadCount;
+    LBA_t readAheadNext;      /* sector following the last request */
+    uint32_t readAheadWindow; /* sectors per read10 on a miss */
+#endif
+#if USB_DISK_WRITE_COALESCE
+    SemaphoreHandle_t diskMutex;
+    TimerHandle_t writeFlushTimer;
+    /* sectors waiting in the bounce buffer, writeCount != 0 excludes read-ahead data */
+    LBA_t writeSector;
+    uint32_t writeCount;
+    DRESULT writeError; /* failed flush, returned and cleared by the next CTRL_SYNC or disk_write */
+#endif
+    usb_host_fatfs_transfer_stat_t transferStat;
+    usb_host_fatfs_read_ahead_stat_t readAheadStat;
+    usb_host_fatfs_write_stat_t writeStat;
+} usb_disk_lun_t;
+
 /*******************************************************************************
  * Prototypes
  ******************************************************************************/
@@ -27,30 +143,115 @@
  *
  * This function is used as callback function for ufi command .
  *
- * @param param      NULL.
+ * @param param      usb_disk_lun_t of the command.
  * @param data       data buffer pointer.
  * @param dataLength data length.
  * @status           transfer result status.
  */
 static void USB_HostMsdUfiCallback(void *param, uint8_t *data, uint32_t dataLength, usb_status_t status);
 
+/*!
+ * @brief USB_HostMsdSubmitDisk command callback.
+ *
+ * @param param      usb_host_fatfs_request_t.
+ * @param data       data buffer pointer.
+ * @param dataLength data length.
+ * @status           transfer result status.
+ */
+static void USB_HostMsdSubmitCallback(void *param, uint8_t *data, uint32_t dataLength, usb_status_t status);
+
+/*!
+ * @brief issue one read10/write10 command and wait for it, with retry.
+ *
+ * read16/write16 are used when the sectors end above block 0xFFFFFFFF.
+ *
+ * @param lun         logical unit.
+ * @param write       0: read10, 1: write10.
+ * @param transferBuf data buffer, must be usable by the USB DMA.
+ * @param sectorIndex start sector number.
+ * @param sectorCount number of sectors.
+ */
+static DRESULT USB_HostMsdTransferDisk(
+    usb_disk_lun_t *lun, uint8_t write, uint8_t *transferBuf, LBA_t sectorIndex, uint32_t sectorCount);
+
+/*!
+ * @brief READ CAPACITY(16), sets the capacity and the UNMAP support of the unit.
+ *
+ * A unit that rejects it keeps the READ CAPACITY(10) values, its sense data is cleared.
+ *
+ * @param lun         logical unit.
+ */
+static DRESULT USB_HostMsdReadCapacity16Unit(usb_disk_lun_t *lun);
+
+#if FF_USE_TRIM
+/*!
+ * @brief unmap the sectors with one UNMAP per USB_HOST_FATFS_UNMAP_MAX_SECTORS.
+ *
+ * @param lun         logical unit.
+ * @param start       first sector.
+ * @param end         last sector, inclusive as CTRL_TRIM.
+ */
+static DRESULT USB_HostMsdUnmapSectors(usb_disk_lun_t *lun, LBA_t start, LBA_t end);
+#endif
+
+#if USB_DISK_READ_AHEAD
+/*!
+ * @brief read through the prefetch buffer, a miss reads the request plus the read-ahead window.
+ *
+ * @param lun         logical unit.
+ * @param buff        read data destination.
+ * @param sector      start sector number.
+ * @param count       number of sectors.
+ */
+static DRESULT USB_HostMsdReadAhead(usb_disk_lun_t *lun, BYTE *buff, LBA_t sector, uint32_t count);
+#endif
+
+#if USB_DISK_WRITE_COALESCE
+/*!
+ * @brief send the merged sectors with one write10, they are dropped and writeError is set if it fails.
+ *
+ * @param lun         logical unit.
+ * @param reason      usb_host_fatfs_flush_reason_t for the statistics.
+ */
+static DRESULT USB_HostMsdWriteFlush(usb_disk_lun_t *lun, uint8_t reason);
+
+/*!
+ * @brief return and clear the error of a failed flush not yet reported to FatFs.
+ *
+ * @param lun         logical unit.
+ */
+static DRESULT USB_HostMsdTakeWriteError(usb_disk_lun_t *lun);
+
+/*!
+ * @brief flush timer expired, runs in the timer service task.
+ *
+ * @param timer       writeFlushTimer of a logical unit.
+ */
+static void USB_HostMsdFlushTimerCallback(TimerHandle_t timer);
+#endif
+
 /*******************************************************************************
  * Variables
  ******************************************************************************/
 
 extern usb_host_handle g_HostHandle;
-
 usb_host_class_handle g_UsbFatfsClassHandle;
-static uint32_t s_FatfsSectorSize;
-static SemaphoreHandle_t s_CommandSemaphore;
-/* command callback status */
-static volatile usb_status_t ufiStatus;
+/* logical units of the attached device, set from GET MAX LUN before the drives are mounted */
+static uint8_t s_LunCount = 1U;
+static usb_disk_lun_t s_DiskLun[USB_HOST_FATFS_LUNS];
+#if (defined(STATIC_ALLOCATION_ENABLE) && (STATIC_ALLOCATION_ENABLE > 0U))
+__BSS(SRAM_DTC) static StaticSemaphore_t s_CommandSemaphoreBuffer[USB_HOST_FATFS_LUNS];
+#endif
 
-#if (defined(USB_HOST_CONFIG_BUFFER_PROPERTY_CACHEABLE) && (USB_HOST_CONFIG_BUFFER_PROPERTY_CACHEABLE)) ||\
-    (defined(DATA_SECTION_IS_CACHEABLE) && (DATA_SECTION_IS_CACHEABLE))
-USB_DMA_NONINIT_DATA_ALIGN(USB_DATA_ALIGN_SIZE) static uint8_t s_UsbTransferBuffer[FF_MAX_SS];
-#else
-USB_DMA_NONINIT_DATA_ALIGN(USB_DATA_ALIGN_SIZE) static uint8_t s_UsbTransferBuffer[20];
+/* one per logical unit, the units run their commands from different tasks */
+USB_DMA_NONINIT_DATA_ALIGN(USB_DATA_ALIGN_SIZE)
+static uint8_t s_UsbTransferBuffer[USB_HOST_FATFS_LUNS][USB_DISK_TRANSFER_BUFFER_SIZE];
+
+#if USB_DISK_WRITE_COALESCE
+#if (defined(STATIC_ALLOCATION_ENABLE) && (STATIC_ALLOCATION_ENABLE > 0U))
+__BSS(SRAM_DTC) static StaticSemaphore_t s_DiskMutexBuffer[USB_HOST_FATFS_LUNS];
+__BSS(SRAM_DTC) static StaticTimer_t s_WriteFlushTimerBuffer[USB_HOST_FATFS_LUNS];
+#endif
 #endif
 
 /*******************************************************************************
@@ -59,24 +260,104 @@ USB_DMA_NONINIT_DATA_ALIGN(USB_DATA_ALIGN_SIZE) static uint8_t s_UsbTransferBuff
 
 static void USB_HostMsdUfiCallback(void *param, uint8_t *data, uint32_t dataLength, usb_status_t status)
 {
-    xSemaphoreGive(s_CommandSemaphore);
-    ufiStatus = status;
+    usb_disk_lun_t *lun = (usb_disk_lun_t *)param;
+
+    lun->ufiStatus = status;
+    xSemaphoreGive(lun->commandSemaphore);
+}
+
+static void USB_HostMsdSubmitCallback(void *param, uint8_t *data, uint32_t dataLength, usb_status_t status)
+{
+    usb_host_fatfs_request_t *request = (usb_host_fatfs_request_t *)param;
+
+    if (status == kStatus_USB_Success)
+    {
+        request->result = RES_OK;
+    }
+    else if (status == kStatus_USB_MSDStatusFail)
+    {
+        request->result = RES_NOTRDY;
+    }
+    else
+    {
+        request->result = RES_ERROR;
+    }
+    request->busy = 0U;
+    if (request->callbackFn != NULL)
+    {
+        request->callbackFn(request->callbackParam, request->result);
+    }
+}
+
+/* NULL for a drive that is not a logical unit of the attached device */
+static usb_disk_lun_t *USB_HostMsdGetLun(BYTE pdrv)
+{
+    uint8_t number = (uint8_t)(pdrv - USBDISK);
+
+    if ((pdrv < USBDISK) || (number >= s_LunCount))
+    {
+        return NULL;
+    }
+    /* the table is zero-initialised, bind the unit to its buffer on the way */
+    s_DiskLun[number].number = number;
+    s_DiskLun[number].buffer = s_UsbTransferBuffer[number];
+    return &s_DiskLun[number];
+}
+
+void USB_HostMsdSetLunCount(uint8_t count)
+{
+    s_LunCount = (count == 0U) ? 1U : ((count > USB_HOST_FATFS_LUNS) ? USB_HOST_FATFS_LUNS : count);
+}
+
+uint8_t USB_HostMsdGetLunCount(void)
+{
+    return s_LunCount;
 }
 
 DSTATUS USB_HostMsdInitializeDisk(BYTE pdrv)
 {
-    uint32_t address;
+    usb_disk_lun_t *lun = USB_HostMsdGetLun(pdrv);
+    usb_host_ufi_read_capacity_t *capacity;
 
-    if (s_CommandSemaphore == NULL)
+    if (lun == NULL)
+    {
+        return STA_NOINIT;
+    }
+    capacity = (usb_host_ufi_read_capacity_t *)lun->buffer;
+#if USB_DISK_WRITE_COALESCE
+    if (lun->diskMutex == NULL)
+    {
+        lun->diskMutex       = USB_DISK_MUTEX_CREATE(lun);
+        lun->writeFlushTimer = USB_DISK_FLUSH_TIMER_CREATE(lun);
+        if ((lun->diskMutex == NULL) || (lun->writeFlushTimer == NULL))
+        {
+            return STA_NOINIT;
+        }
+    }
+    /* merged sectors of a previous mount must not reach this media */
+    USB_DISK_LOCK(lun);
+    lun->writeStat.dropped += lun->writeCount;
+    lun->writeCount = 0U;
+    lun->writeError = RES_OK;
+    USB_DISK_UNLOCK(lun);
+#endif
+    USB_DISK_READ_AHEAD_INVALIDATE(lun);
+#if USB_DISK_READ_AHEAD
+    if (lun->readAheadWindow == 0U)
     {
-        s_CommandSemaphore = xSemaphoreCreateCounting(0x01U, 0x00U);
+        lun->readAheadWindow = 1U;
+    }
+#endif
+    if (lun->commandSemaphore == NULL)
+    {
+        lun->commandSemaphore = USB_DISK_COMMAND_SEMAPHORE_CREATE(lun);
     }
     else
     {
-        vSemaphoreDelete(s_CommandSemaphore);
-        s_CommandSemaphore = xSemaphoreCreateCounting(0x01U, 0x00U);
+        vSemaphoreDelete(lun->commandSemaphore);
+        lun->commandSemaphore = USB_DISK_COMMAND_SEMAPHORE_CREATE(lun);
     }
-    if (NULL == s_CommandSemaphore)
+    if (NULL == lun->commandSemaphore)
     {
         return RES_ERROR;
     }
@@ -86,11 +367,12 @@ DSTATUS USB_HostMsdInitializeDisk(BYTE pdrv)
     {
         return RES_ERROR;
     }
-    if (USB_HostMsdTestUnitReady(g_UsbFatfsClassHandle, 0, USB_HostMsdUfiCallback, NULL) != kStatus_USB_Success)
+    if (USB_HostMsdTestUnitReady(g_UsbFatfsClassHandle, lun->number, USB_HostMsdUfiCallback, lun) !=
+        kStatus_USB_Success)
     {
         return STA_NOINIT;
     }
-    if (pdTRUE != xSemaphoreTake(s_CommandSemaphore, portMAX_DELAY)) /* wait the command */
+    if (pdTRUE != xSemaphoreTake(lun->commandSemaphore, portMAX_DELAY)) /* wait the command */
     {
         return RES_ERROR;
     }
@@ -100,12 +382,12 @@ DSTATUS USB_HostMsdInitializeDisk(BYTE pdrv)
     {
         return RES_ERROR;
     }
-    if (USB_HostMsdRequestSense(g_UsbFatfsClassHandle, 0, s_UsbTransferBuffer, sizeof(usb_host_ufi_sense_data_t),
-                                USB_HostMsdUfiCallback, NULL) != kStatus_USB_Success)
+    if (USB_HostMsdRequestSense(g_UsbFatfsClassHandle, lun->number, lun->buffer, sizeof(usb_host_ufi_sense_data_t),
+                                USB_HostMsdUfiCallback, lun) != kStatus_USB_Success)
     {
         return STA_NOINIT;
     }
-    if (pdTRUE != xSemaphoreTake(s_CommandSemaphore, portMAX_DELAY)) /* wait the command */
+    if (pdTRUE != xSemaphoreTake(lun->commandSemaphore, portMAX_DELAY)) /* wait the command */
     {
         return RES_ERROR;
     }
@@ -115,132 +397,349 @@ DSTATUS USB_HostMsdInitializeDisk(BYTE pdrv)
     {
         return RES_ERROR;
     }
-    if (USB_HostMsdReadCapacity(g_UsbFatfsClassHandle, 0, s_UsbTransferBuffer, sizeof(usb_host_ufi_read_capacity_t),
-                                USB_HostMsdUfiCallback, NULL) != kStatus_USB_Success)
+    if (USB_HostMsdReadCapacity(g_UsbFatfsClassHandle, lun->number, lun->buffer, sizeof(usb_host_ufi_read_capacity_t),
+                                USB_HostMsdUfiCallback, lun) != kStatus_USB_Success)
     {
         return STA_NOINIT;
     }
     else
     {
-        if (pdTRUE != xSemaphoreTake(s_CommandSemaphore, portMAX_DELAY)) /* wait the command */
+        if (pdTRUE != xSemaphoreTake(lun->commandSemaphore, portMAX_DELAY)) /* wait the command */
         {
             return RES_ERROR;
         }
-        if (ufiStatus == kStatus_USB_Success)
+        lun->capacity16 = 0U;
+        lun->unmap      = 0U;
+        if (lun->ufiStatus == kStatus_USB_Success)
         {
-            address = (uint32_t)&s_UsbTransferBuffer[0];
-            address = (uint32_t)((usb_host_ufi_read_capacity_t *)(address))->blockLengthInBytes;
-            s_FatfsSectorSize = USB_LONG_FROM_BIG_ENDIAN_ADDRESS(((uint8_t *)address));
+            lun->sectorSize  = USB_LONG_FROM_BIG_ENDIAN_ADDRESS(capacity->blockLengthInBytes);
+            lun->sectorCount = (uint64_t)USB_LONG_FROM_BIG_ENDIAN_ADDRESS(capacity->lastLogicalBlockAddress) + 1U;
+            /* 0xFFFFFFFF: the unit is larger, READ CAPACITY(16) has the size and the LBPME bit */
+            if ((lun->sectorCount > 0xFFFFFFFFU) || (USB_HOST_FATFS_UNMAP_ENABLE && FF_USE_TRIM))
+            {
+                (void)USB_HostMsdReadCapacity16Unit(lun);
+            }
         }
         else
         {
-            s_FatfsSectorSize = 512;
+            lun->sectorSize  = 512;
+            lun->sectorCount = 0U;
         }
     }
 
     return 0x00;
 }
 
+static DRESULT USB_HostMsdReadCapacity16Unit(usb_disk_lun_t *lun)
+{
+    usb_host_ufi_read_capacity16_t *capacity = (usb_host_ufi_read_capacity16_t *)lun->buffer;
+    uint8_t *value;
+
+    if (g_UsbFatfsClassHandle == NULL)
+    {
+        return RES_ERROR;
+    }
+    USB_DISK_READ_AHEAD_INVALIDATE(lun);
+    if (USB_HostMsdReadCapacity16(g_UsbFatfsClassHandle, lun->number, lun->buffer,
+                                  sizeof(usb_host_ufi_read_capacity16_t), USB_HostMsdUfiCallback,
+                                  lun) != kStatus_USB_Success)
+    {
+        return RES_ERROR;
+    }
+    if (pdTRUE != xSemaphoreTake(lun->commandSemaphore, portMAX_DELAY)) /* wait the command */
+    {
+        return RES_ERROR;
+    }
+    if (lun->ufiStatus != kStatus_USB_Success)
+    {
+        lun->capacity16 = 0U;
+        lun->unmap      = 0U;
+        /* the ILLEGAL REQUEST sense data would fail the next command */
+        if ((g_UsbFatfsClassHandle != NULL) &&
+            (USB_HostMsdRequestSense(g_UsbFatfsClassHandle, lun->number, lun->buffer,
+                                     sizeof(usb_host_ufi_sense_data_t), USB_HostMsdUfiCallback,
+                                     lun) == kStatus_USB_Success))
+        {
+            (void)xSemaphoreTake(lun->commandSemaphore, portMAX_DELAY);
+        }
+        return RES_NOTRDY;
+    }
+    value            = capacity->lastLogicalBlockAddress;
+    lun->sectorCount = ((uint64_t)USB_LONG_FROM_BIG_ENDIAN_ADDRESS(value) << 32U);
+    value            = &capacity->lastLogicalBlockAddress[4];
+    lun->sectorCount |= USB_LONG_FROM_BIG_ENDIAN_ADDRESS(value);
+    lun->sectorCount += 1U;
+    lun->sectorSize = USB_LONG_FROM_BIG_ENDIAN_ADDRESS(capacity->blockLengthInBytes);
+    lun->capacity16 = 1U;
+    lun->unmap      = (USB_HOST_FATFS_UNMAP_ENABLE &&
+                  ((capacity->lowestAlignedLba[0] & USB_HOST_UFI_READ_CAPACITY16_LBPME) != 0U)) ? 1U : 0U;
+    return RES_OK;
+}
+
+#if FF_USE_TRIM
+static DRESULT USB_HostMsdUnmapSectors(usb_disk_lun_t *lun, LBA_t start, LBA_t end)
+{
+    DRESULT fatfs_code = RES_OK;
+    usb_status_t status;
+    uint32_t count;
+    uint32_t cycles;
+
+    /* a hint, the unit keeps the data without UNMAP */
+    if ((!lun->unmap) || (end < start))
+    {
+        return RES_OK;
+    }
+    if ((uint64_t)end >= lun->sectorCount)
+    {
+        return RES_PARERR;
+    }
+    /* the parameter list goes in the bounce buffer */
+    USB_DISK_READ_AHEAD_INVALIDATE(lun);
+    while (fatfs_code == RES_OK)
+    {
+        if (g_UsbFatfsClassHandle == NULL)
+        {
+            return RES_ERROR;
+        }
+        count  = ((end - start) >= USB_HOST_FATFS_UNMAP_MAX_SECTORS) ? USB_HOST_FATFS_UNMAP_MAX_SECTORS :
+                                                                       (uint32_t)(end - start + 1U);
+        cycles = DWT->CYCCNT;
+        status = USB_HostMsdUnmap(g_UsbFatfsClassHandle, lun->number, start, count, lun->buffer,
+                                  USB_HostMsdUfiCallback, lun);
+        if (status != kStatus_USB_Success)
+        {
+            fatfs_code = RES_ERROR;
+        }
+        else if (pdTRUE != xSemaphoreTake(lun->commandSemaphore, portMAX_DELAY)) /* wait the command */
+        {
+            fatfs_code = RES_ERROR;
+        }
+        else if (lun->ufiStatus != kStatus_USB_Success)
+        {
+            /* LBPME set but UNMAP rejected, e.g. by a bridge: not asked again until the next mount */
+            lun->unmap = 0U;
+            fatfs_code = RES_NOTRDY;
+            if ((g_UsbFatfsClassHandle != NULL) &&
+                (USB_HostMsdRequestSense(g_UsbFatfsClassHandle, lun->number, lun->buffer,
+                                         sizeof(usb_host_ufi_sense_data_t), USB_HostMsdUfiCallback,
+                                         lun) == kStatus_USB_Success))
+            {
+                (void)xSemaphoreTake(lun->commandSemaphore, portMAX_DELAY);
+            }
+        }
+        lun->transferStat.unmapCommands++;
+        lun->transferStat.unmapSectors += (fatfs_code == RES_OK) ? count : 0U;
+        lun->transferStat.unmapCycles += DWT->CYCCNT - cycles;
+        if ((end - start) < count)
+        {
+            break;
+        }
+        start += count;
+    }
+    return fatfs_code;
+}
+#endif
+
 DSTATUS USB_HostMsdGetDiskStatus(BYTE pdrv)
 {
-    return 0x00;
+    return (USB_HostMsdGetLun(pdrv) != NULL) ? 0x00 : STA_NOINIT;
 }
 
-DRESULT USB_HostMsdReadDisk(BYTE pdrv, BYTE *buff, LBA_t sector, UINT count)
+static DRESULT USB_HostMsdTransferDisk(
+    usb_disk_lun_t *lun, uint8_t write, uint8_t *transferBuf, LBA_t sectorIndex, uint32_t sectorCount)
 {
     DRESULT fatfs_code = RES_ERROR;
     usb_status_t status = kStatus_USB_Success;
     uint32_t retry = USB_HOST_FATFS_RW_RETRY_TIMES;
-    uint8_t *transferBuf;
-    uint32_t sectorCount;
-    uint32_t sectorIndex;
-#if (defined(USB_HOST_CONFIG_BUFFER_PROPERTY_CACHEABLE) && (USB_HOST_CONFIG_BUFFER_PROPERTY_CACHEABLE)) ||\
-    (defined(DATA_SECTION_IS_CACHEABLE) && (DATA_SECTION_IS_CACHEABLE))
-    uint32_t index;
-#endif
+    uint32_t cycles = DWT->CYCCNT;
 
-    if (!count)
+    while (retry--)
     {
-        return RES_PARERR;
+        if (g_UsbFatfsClassHandle == NULL)
+        {
+            fatfs_code = RES_ERROR;
+            break;
+        }
+        if (!USB_DISK_LBA32(sectorIndex, sectorCount))
+        {
+            status = write ? USB_HostMsdWrite16(g_UsbFatfsClassHandle, lun->number, sectorIndex, transferBuf,
+                                                (uint32_t)(lun->sectorSize * sectorCount), sectorCount,
+                                                USB_HostMsdUfiCallback, lun) :
+                             USB_HostMsdRead16(g_UsbFatfsClassHandle, lun->number, sectorIndex, transferBuf,
+                                               (uint32_t)(lun->sectorSize * sectorCount), sectorCount,
+                                               USB_HostMsdUfiCallback, lun);
+        }
+        else if (write)
+        {
+            status = USB_HostMsdWrite10(g_UsbFatfsClassHandle, lun->number, sectorIndex, transferBuf,
+                                        (uint32_t)(lun->sectorSize * sectorCount), sectorCount, USB_HostMsdUfiCallback,
+                                        lun);
+        }
+        else
+        {
+            status = USB_HostMsdRead10(g_UsbFatfsClassHandle, lun->number, sectorIndex, transferBuf,
+                                       (uint32_t)(lun->sectorSize * sectorCount), sectorCount, USB_HostMsdUfiCallback,
+                                       lun);
+        }
+        if (status != kStatus_USB_Success)
+        {
+            fatfs_code = RES_ERROR;
+        }
+        else
+        {
+            if (pdTRUE != xSemaphoreTake(lun->commandSemaphore, portMAX_DELAY)) /* wait the command */
+            {
+                fatfs_code = RES_ERROR;
+                break;
+            }
+            if (lun->ufiStatus == kStatus_USB_Success)
+            {
+                fatfs_code = RES_OK;
+                break;
+            }
+            else
+            {
+                fatfs_code = RES_NOTRDY;
+            }
+        }
     }
 
-#if (defined(USB_HOST_CONFIG_BUFFER_PROPERTY_CACHEABLE) && (USB_HOST_CONFIG_BUFFER_PROPERTY_CACHEABLE)) ||\
-    (defined(DATA_SECTION_IS_CACHEABLE) && (DATA_SECTION_IS_CACHEABLE))
-#if (defined(USB_HOST_CONFIG_BUFFER_PROPERTY_CACHEABLE) && (USB_HOST_CONFIG_BUFFER_PROPERTY_CACHEABLE))
-    if (((uint32_t)buff % USB_CACHE_LINESIZE == 0U) && (count * s_FatfsSectorSize % USB_CACHE_LINESIZE == 0U))
+    cycles = DWT->CYCCNT - cycles;
+    if (write)
     {
-        transferBuf = buff;
-        sectorCount = count;
-        count       = 1;
+        lun->transferStat.writeCommands++;
+        lun->transferStat.writeSectors += (fatfs_code == RES_OK) ? sectorCount : 0U;
+        lun->transferStat.writeCycles += cycles;
     }
     else
-#endif
     {
-        transferBuf = &s_UsbTransferBuffer[0];
-        sectorCount = 1;
+        lun->transferStat.readCommands++;
+        lun->transferStat.readSectors += (fatfs_code == RES_OK) ? sectorCount : 0U;
+        lun->transferStat.readCycles += cycles;
     }
-    for (index = 0; index < count; ++index)
+    return fatfs_code;
+}
+
+#if USB_DISK_READ_AHEAD
+static DRESULT USB_HostMsdReadAhead(usb_disk_lun_t *lun, BYTE *buff, LBA_t sector, uint32_t count)
+{
+    DRESULT fatfs_code;
+    uint32_t maxSectors = USB_DISK_TRANSFER_BUFFER_SIZE / lun->sectorSize;
+    uint32_t offset;
+    uint32_t num;
+
+    /* double the window while the reads stay sequential, halve it on every jump */
+    if (sector == lun->readAheadNext)
     {
-        sectorIndex = sector + index;
-#else
-        transferBuf = buff;
-        sectorCount = count;
-        sectorIndex = sector;
-#endif
-        retry = USB_HOST_FATFS_RW_RETRY_TIMES;
-        while (retry--)
+        lun->readAheadWindow =
+            ((lun->readAheadWindow << 1U) > maxSectors) ? maxSectors : (lun->readAheadWindow << 1U);
+    }
+    else if (lun->readAheadWindow > 1U)
+    {
+        lun->readAheadWindow >>= 1U;
+    }
+    lun->readAheadNext = sector + count;
+    lun->readAheadStat.requests++;
+    lun->readAheadStat.sectors += count;
+
+    while (count > 0U)
+    {
+        if ((lun->readAheadCount == 0U) || (sector < lun->readAheadSector) ||
+            ((sector - lun->readAheadSector) >= lun->readAheadCount))
         {
-            if (g_UsbFatfsClassHandle == NULL)
+            num = (count > lun->readAheadWindow) ? count : lun->readAheadWindow;
+            if (num > maxSectors)
             {
-                return RES_ERROR;
+                num = maxSectors;
             }
-            status = USB_HostMsdRead10(g_UsbFatfsClassHandle, 0, sectorIndex, (uint8_t *)transferBuf,
-                                       (uint32_t)(s_FatfsSectorSize * sectorCount), sectorCount, USB_HostMsdUfiCallback, NULL);
-            if (status != kStatus_USB_Success)
+            /* do not prefetch past the last sector */
+            if ((lun->sectorCount != 0U) && (sector < lun->sectorCount) && (num > (lun->sectorCount - sector)))
             {
-                fatfs_code = RES_ERROR;
+                num = (count < (lun->sectorCount - sector)) ? count : (uint32_t)(lun->sectorCount - sector);
             }
-            else
+            lun->readAheadCount = 0U;
+            fatfs_code          = USB_HostMsdTransferDisk(lun, 0U, lun->buffer, sector, num);
+            if (fatfs_code != RES_OK)
             {
-                if (pdTRUE != xSemaphoreTake(s_CommandSemaphore, portMAX_DELAY)) /* wait the command */
-                {
-                    return RES_ERROR;
-                }
-                if (ufiStatus == kStatus_USB_Success)
-                {
-                    fatfs_code = RES_OK;
-                    break;
-                }
-                else
-                {
-                    fatfs_code = RES_NOTRDY;
-                }
+                return fatfs_code;
             }
+            lun->readAheadSector = sector;
+            lun->readAheadCount  = num;
+            lun->readAheadStat.commands++;
+            lun->readAheadStat.driveSectors += num;
+            offset = 0U;
+            num    = (count < num) ? count : num;
         }
+        else
+        {
+            offset = (uint32_t)(sector - lun->readAheadSector);
+            num    = ((lun->readAheadCount - offset) < count) ? (lun->readAheadCount - offset) : count;
+            lun->readAheadStat.hits += num;
+        }
+        memcpy(buff, &lun->buffer[offset * lun->sectorSize], lun->sectorSize * num);
+        buff += lun->sectorSize * num;
+        sector += num;
+        count -= num;
+    }
+    return RES_OK;
+}
+#endif
+
+static DRESULT USB_HostMsdReadSectors(usb_disk_lun_t *lun, BYTE *buff, LBA_t sector, uint32_t count)
+{
+    DRESULT fatfs_code = RES_ERROR;
+#if ((defined(USB_HOST_CONFIG_BUFFER_PROPERTY_CACHEABLE) && (USB_HOST_CONFIG_BUFFER_PROPERTY_CACHEABLE)) ||\
+     (defined(DATA_SECTION_IS_CACHEABLE) && (DATA_SECTION_IS_CACHEABLE))) && !USB_DISK_READ_AHEAD
+    uint32_t bounceSectors;
+    uint32_t sectorCount;
+#endif
+
+    if (!count)
+    {
+        return RES_PARERR;
+    }
+
 #if (defined(USB_HOST_CONFIG_BUFFER_PROPERTY_CACHEABLE) && (USB_HOST_CONFIG_BUFFER_PROPERTY_CACHEABLE)) ||\
     (defined(DATA_SECTION_IS_CACHEABLE) && (DATA_SECTION_IS_CACHEABLE))
 #if (defined(USB_HOST_CONFIG_BUFFER_PROPERTY_CACHEABLE) && (USB_HOST_CONFIG_BUFFER_PROPERTY_CACHEABLE))
-        if ((uint32_t)transferBuf == (uint32_t)&s_UsbTransferBuffer[0])
+    if (((uintptr_t)buff % USB_CACHE_LINESIZE == 0U) && (count * lun->sectorSize % USB_CACHE_LINESIZE == 0U))
+    {
+        return USB_HostMsdTransferDisk(lun, 0U, buff, sector, count);
+    }
 #endif
+#if USB_DISK_READ_AHEAD
+    fatfs_code = USB_HostMsdReadAhead(lun, buff, sector, count);
+#else
+    /* bounce as many sectors per command as the buffer holds */
+    bounceSectors = USB_DISK_TRANSFER_BUFFER_SIZE / lun->sectorSize;
+    while (count > 0U)
+    {
+        sectorCount = (count > bounceSectors) ? bounceSectors : count;
+        fatfs_code  = USB_HostMsdTransferDisk(lun, 0U, lun->buffer, sector, sectorCount);
+        if (fatfs_code != RES_OK)
         {
-            memcpy(buff + index * s_FatfsSectorSize, s_UsbTransferBuffer, s_FatfsSectorSize);
+            break;
         }
+        memcpy(buff, lun->buffer, lun->sectorSize * sectorCount);
+        buff += lun->sectorSize * sectorCount;
+        sector += sectorCount;
+        count -= sectorCount;
     }
+#endif
+#else
+    fatfs_code = USB_HostMsdTransferDisk(lun, 0U, buff, sector, count);
 #endif
     return fatfs_code;
 }
 
-DRESULT USB_HostMsdWriteDisk(BYTE pdrv, const BYTE *buff, LBA_t sector, UINT count)
+#if !USB_DISK_WRITE_COALESCE
+static DRESULT USB_HostMsdWriteSectors(usb_disk_lun_t *lun, const BYTE *buff, LBA_t sector, uint32_t count)
 {
     DRESULT fatfs_code = RES_ERROR;
-    usb_status_t status = kStatus_USB_Success;
-    uint32_t retry = USB_HOST_FATFS_RW_RETRY_TIMES;
-    const uint8_t *transferBuf;
-    uint32_t sectorCount;
-    uint32_t sectorIndex;
 #if (defined(USB_HOST_CONFIG_BUFFER_PROPERTY_CACHEABLE) && (USB_HOST_CONFIG_BUFFER_PROPERTY_CACHEABLE)) ||\
     (defined(DATA_SECTION_IS_CACHEABLE) && (DATA_SECTION_IS_CACHEABLE))
-    uint32_t index;
+    uint32_t bounceSectors;
+    uint32_t sectorCount;
 #endif
 
     if (!count)
@@ -251,72 +750,243 @@ DRESULT USB_HostMsdWriteDisk(BYTE pdrv, const BYTE *buff, LBA_t sector, UINT cou
 #if (defined(USB_HOST_CONFIG_BUFFER_PROPERTY_CACHEABLE) && (USB_HOST_CONFIG_BUFFER_PROPERTY_CACHEABLE)) ||\
     (defined(DATA_SECTION_IS_CACHEABLE) && (DATA_SECTION_IS_CACHEABLE))
 #if (defined(USB_HOST_CONFIG_BUFFER_PROPERTY_CACHEABLE) && (USB_HOST_CONFIG_BUFFER_PROPERTY_CACHEABLE))
-    if (((uint32_t)buff % USB_CACHE_LINESIZE == 0U) && (count * s_FatfsSectorSize % USB_CACHE_LINESIZE == 0U))
+    if (((uintptr_t)buff % USB_CACHE_LINESIZE == 0U) && (count * lun->sectorSize % USB_CACHE_LINESIZE == 0U))
     {
-        transferBuf = buff;
-        sectorCount = count;
-        count       = 1;
+        return USB_HostMsdTransferDisk(lun, 1U, (uint8_t *)buff, sector, count);
     }
-    else
 #endif
+    /* bounce as many sectors per command as the buffer holds */
+    bounceSectors = USB_DISK_TRANSFER_BUFFER_SIZE / lun->sectorSize;
+    while (count > 0U)
     {
-        transferBuf = (const uint8_t *)&s_UsbTransferBuffer[0];
-        sectorCount = 1;
-    }
-    for (index = 0; index < count; ++index)
-    {
-        sectorIndex = sector + index;
-#if (defined(USB_HOST_CONFIG_BUFFER_PROPERTY_CACHEABLE) && (USB_HOST_CONFIG_BUFFER_PROPERTY_CACHEABLE))
-        if ((uint32_t)transferBuf == (uint32_t)&s_UsbTransferBuffer[0])
-#endif
+        sectorCount = (count > bounceSectors) ? bounceSectors : count;
+        memcpy(lun->buffer, buff, lun->sectorSize * sectorCount);
+        fatfs_code = USB_HostMsdTransferDisk(lun, 1U, lun->buffer, sector, sectorCount);
+        if (fatfs_code != RES_OK)
         {
-            memcpy(s_UsbTransferBuffer, buff + index * s_FatfsSectorSize, s_FatfsSectorSize);
+            break;
         }
+        buff += lun->sectorSize * sectorCount;
+        sector += sectorCount;
+        count -= sectorCount;
+    }
 #else
-        transferBuf = buff;
-        sectorCount = count;
-        sectorIndex = sector;
+    fatfs_code = USB_HostMsdTransferDisk(lun, 1U, (uint8_t *)buff, sector, count);
 #endif
-        retry = USB_HOST_FATFS_RW_RETRY_TIMES;
-        while (retry--)
+    return fatfs_code;
+}
+#endif
+
+#if USB_DISK_WRITE_COALESCE
+static DRESULT USB_HostMsdWriteFlush(usb_disk_lun_t *lun, uint8_t reason)
+{
+    DRESULT fatfs_code;
+
+    if (lun->writeCount == 0U)
+    {
+        return RES_OK;
+    }
+    fatfs_code = USB_HostMsdTransferDisk(lun, 1U, lun->buffer, lun->writeSector, lun->writeCount);
+    lun->writeStat.commands++;
+    lun->writeStat.flush[reason]++;
+    if (fatfs_code != RES_OK)
+    {
+        lun->writeStat.dropped += lun->writeCount;
+        lun->writeError = fatfs_code;
+    }
+    lun->writeCount = 0U;
+    return fatfs_code;
+}
+
+static DRESULT USB_HostMsdTakeWriteError(usb_disk_lun_t *lun)
+{
+    DRESULT fatfs_code = lun->writeError;
+
+    lun->writeError = RES_OK;
+    return fatfs_code;
+}
+
+static void USB_HostMsdFlushTimerCallback(TimerHandle_t timer)
+{
+    USB_HostMsdFlushRequest();
+}
+
+__attribute__((weak)) void USB_HostMsdFlushRequest(void)
+{
+    return;
+}
+#endif
+
+DRESULT USB_HostMsdReadDisk(BYTE pdrv, BYTE *buff, LBA_t sector, UINT count)
+{
+    usb_disk_lun_t *lun = USB_HostMsdGetLun(pdrv);
+    DRESULT fatfs_code;
+
+    if ((lun == NULL) || (!count) || (!USB_DISK_LBA_VALID(lun, sector, count)))
+    {
+        return RES_PARERR;
+    }
+
+    USB_DISK_LOCK(lun);
+    /* a failed flush frees the bounce buffer too, its error waits for the next sync or write */
+    (void)USB_DISK_WRITE_FLUSH(lun, kUSB_HostFatfsFlushRead);
+    fatfs_code = USB_HostMsdReadSectors(lun, buff, sector, count);
+    USB_DISK_UNLOCK(lun);
+    return fatfs_code;
+}
+
+DRESULT USB_HostMsdWriteDisk(BYTE pdrv, const BYTE *buff, LBA_t sector, UINT count)
+{
+    usb_disk_lun_t *lun = USB_HostMsdGetLun(pdrv);
+#if USB_DISK_WRITE_COALESCE
+    DRESULT fatfs_code = RES_OK;
+    uint32_t maxSectors;
+    uint32_t num;
+#endif
+
+    if ((lun == NULL) || (!count) || (!USB_DISK_LBA_VALID(lun, sector, count)))
+    {
+        return RES_PARERR;
+    }
+
+#if USB_DISK_WRITE_COALESCE
+    USB_DISK_LOCK(lun);
+    USB_DISK_READ_AHEAD_INVALIDATE(lun);
+    maxSectors = USB_DISK_TRANSFER_BUFFER_SIZE / lun->sectorSize;
+    lun->writeStat.requests++;
+    lun->writeStat.sectors += count;
+    /* an earlier merged run was lost, FatFs learns it here rather than from an unrelated read */
+    fatfs_code = USB_HostMsdTakeWriteError(lun);
+    while ((fatfs_code == RES_OK) && (count > 0U))
+    {
+        /* only a write continuing the merged run joins it, anything else sends the run first */
+        if ((lun->writeCount != 0U) && (sector != (lun->writeSector + lun->writeCount)))
         {
-            if (g_UsbFatfsClassHandle == NULL)
+            fatfs_code = USB_HostMsdWriteFlush(lun, kUSB_HostFatfsFlushGap);
+            if (fatfs_code != RES_OK)
             {
-                return RES_ERROR;
+                break;
             }
-            status = USB_HostMsdWrite10(g_UsbFatfsClassHandle, 0, sectorIndex, (uint8_t *)transferBuf,
-                                        (uint32_t)(s_FatfsSectorSize * sectorCount), sectorCount, USB_HostMsdUfiCallback, NULL);
-            if (status != kStatus_USB_Success)
+        }
+        if (lun->writeCount == 0U)
+        {
+            lun->writeSector = sector;
+        }
+        num = ((maxSectors - lun->writeCount) < count) ? (maxSectors - lun->writeCount) : count;
+        memcpy(&lun->buffer[lun->writeCount * lun->sectorSize], buff, lun->sectorSize * num);
+        lun->writeCount += num;
+        buff += lun->sectorSize * num;
+        sector += num;
+        count -= num;
+        if (lun->writeCount == maxSectors)
+        {
+            fatfs_code = USB_HostMsdWriteFlush(lun, kUSB_HostFatfsFlushFull);
+            if (fatfs_code != RES_OK)
             {
-                fatfs_code = RES_ERROR;
-            }
-            else
-            {
-                if (pdTRUE != xSemaphoreTake(s_CommandSemaphore, portMAX_DELAY)) /* wait the command */
-                {
-                    return RES_ERROR;
-                }
-                if (ufiStatus == kStatus_USB_Success)
-                {
-                    fatfs_code = RES_OK;
-                    break;
-                }
-                else
-                {
-                    fatfs_code = RES_NOTRDY;
-                }
+                break;
             }
         }
-#if (defined(USB_HOST_CONFIG_BUFFER_PROPERTY_CACHEABLE) && (USB_HOST_CONFIG_BUFFER_PROPERTY_CACHEABLE)) ||\
-    (defined(DATA_SECTION_IS_CACHEABLE) && (DATA_SECTION_IS_CACHEABLE))
     }
+    /* bound the time the oldest merged sector waits */
+    if ((lun->writeCount != 0U) && (lun->writeFlushTimer != NULL) &&
+        (xTimerIsTimerActive(lun->writeFlushTimer) == pdFALSE))
+    {
+        (void)xTimerReset(lun->writeFlushTimer, 0U);
+    }
+    /* a flush failing in this call is reported by it */
+    lun->writeError = RES_OK;
+    USB_DISK_UNLOCK(lun);
+    return fatfs_code;
+#else
+    /* the prefetched sectors may be overwritten, and the bounce buffer is reused */
+    USB_DISK_READ_AHEAD_INVALIDATE(lun);
+    return USB_HostMsdWriteSectors(lun, buff, sector, count);
+#endif
+}
+
+DRESULT USB_HostMsdFlushDisk(BYTE pdrv)
+{
+    DRESULT fatfs_code = RES_OK;
+#if USB_DISK_WRITE_COALESCE
+    usb_disk_lun_t *lun = USB_HostMsdGetLun(pdrv);
+
+    if ((lun == NULL) || (lun->diskMutex == NULL) || (lun->writeCount == 0U))
+    {
+        return RES_OK;
+    }
+    if (pdTRUE != xSemaphoreTake(lun->diskMutex, 0U))
+    {
+        return RES_OK;
+    }
+    fatfs_code = USB_HostMsdWriteFlush(lun, kUSB_HostFatfsFlushTimer);
+    USB_DISK_UNLOCK(lun);
 #endif
     return fatfs_code;
 }
 
-DRESULT USB_HostMsdIoctlDisk(BYTE pdrv, BYTE cmd, void *buff)
+DRESULT USB_HostMsdSubmitDisk(
+    BYTE pdrv, usb_host_fatfs_request_t *request, uint8_t write, BYTE *buff, LBA_t sector, UINT count)
 {
-    uint32_t address;
+    usb_disk_lun_t *lun = USB_HostMsdGetLun(pdrv);
+    DRESULT fatfs_code;
+    usb_status_t status;
+
+    if ((lun == NULL) || (!count) || (request == NULL) || (buff == NULL) ||
+        (!USB_DISK_LBA_VALID(lun, sector, count)))
+    {
+        return RES_PARERR;
+    }
+
+    USB_DISK_LOCK(lun);
+    /* keep the order with the merged writes, and the prefetched sectors may be overwritten */
+    (void)USB_DISK_WRITE_FLUSH(lun, kUSB_HostFatfsFlushRead);
+    fatfs_code = RES_OK;
+    if (write)
+    {
+        USB_DISK_READ_AHEAD_INVALIDATE(lun);
+#if USB_DISK_WRITE_COALESCE
+        fatfs_code = USB_HostMsdTakeWriteError(lun);
+#endif
+    }
+    if ((fatfs_code == RES_OK) && (g_UsbFatfsClassHandle == NULL))
+    {
+        fatfs_code = RES_NOTRDY;
+    }
+    if (fatfs_code == RES_OK)
+    {
+        request->busy = 1U;
+        if (!USB_DISK_LBA32(sector, count))
+        {
+            status = write ? USB_HostMsdWrite16(g_UsbFatfsClassHandle, lun->number, sector, buff,
+                                                (uint32_t)(lun->sectorSize * count), count, USB_HostMsdSubmitCallback,
+                                                request) :
+                             USB_HostMsdRead16(g_UsbFatfsClassHandle, lun->number, sector, buff,
+                                               (uint32_t)(lun->sectorSize * count), count, USB_HostMsdSubmitCallback,
+                                               request);
+        }
+        else if (write)
+        {
+            status = USB_HostMsdWrite10(g_UsbFatfsClassHandle, lun->number, sector, buff,
+                                        (uint32_t)(lun->sectorSize * count), count, USB_HostMsdSubmitCallback, request);
+        }
+        else
+        {
+            status = USB_HostMsdRead10(g_UsbFatfsClassHandle, lun->number, sector, buff,
+                                       (uint32_t)(lun->sectorSize * count), count, USB_HostMsdSubmitCallback, request);
+        }
+        if (status != kStatus_USB_Success)
+        {
+            request->busy = 0U;
+            fatfs_code    = (status == kStatus_USB_Busy) ? RES_NOTRDY : RES_ERROR;
+        }
+    }
+    USB_DISK_UNLOCK(lun);
+    return fatfs_code;
+}
+
+static DRESULT USB_HostMsdIoctlUnit(usb_disk_lun_t *lun, BYTE cmd, void *buff)
+{
+    usb_host_ufi_read_capacity_t *capacity = (usb_host_ufi_read_capacity_t *)lun->buffer;
     DRESULT fatfs_code = RES_ERROR;
     usb_status_t status = kStatus_USB_Success;
     uint32_t value;
@@ -334,19 +1004,39 @@ DRESULT USB_HostMsdIoctlDisk(BYTE pdrv, BYTE cmd, void *buff)
             {
                 return RES_ERROR;
             }
-            status = USB_HostMsdReadCapacity(g_UsbFatfsClassHandle, 0, s_UsbTransferBuffer,
-                                             sizeof(usb_host_ufi_read_capacity_t), USB_HostMsdUfiCallback, NULL);
+            /* READ CAPACITY(10) reports 0xFFFFFFFF for the last block of a unit above 2TB */
+            if (lun->capacity16)
+            {
+                fatfs_code = USB_HostMsdReadCapacity16Unit(lun);
+                if (fatfs_code == RES_OK)
+                {
+                    if (GET_SECTOR_COUNT == cmd)
+                    {
+                        LBA_t sectorCount = (LBA_t)lun->sectorCount;
+
+                        (void)memcpy(buff, &sectorCount, sizeof(sectorCount));
+                    }
+                    else
+                    {
+                        (void)memcpy(buff, &lun->sectorSize, sizeof(WORD));
+                    }
+                }
+                break;
+            }
+            USB_DISK_READ_AHEAD_INVALIDATE(lun);
+            status = USB_HostMsdReadCapacity(g_UsbFatfsClassHandle, lun->number, lun->buffer,
+                                             sizeof(usb_host_ufi_read_capacity_t), USB_HostMsdUfiCallback, lun);
             if (status != kStatus_USB_Success)
             {
                 fatfs_code = RES_ERROR;
             }
             else
             {
-                if (pdTRUE != xSemaphoreTake(s_CommandSemaphore, portMAX_DELAY)) /* wait the command */
+                if (pdTRUE != xSemaphoreTake(lun->commandSemaphore, portMAX_DELAY)) /* wait the command */
                 {
                     return RES_ERROR;
                 }
-                if (ufiStatus == kStatus_USB_Success)
+                if (lun->ufiStatus == kStatus_USB_Success)
                 {
                     fatfs_code = RES_OK;
                 }
@@ -358,21 +1048,18 @@ DRESULT USB_HostMsdIoctlDisk(BYTE pdrv, BYTE cmd, void *buff)
 
             if (fatfs_code == RES_OK)
             {
-                if (GET_SECTOR_COUNT == cmd) /* Get number of sectors on the disk (DWORD) */
+                if (GET_SECTOR_COUNT == cmd) /* Get number of sectors on the disk (LBA_t) */
                 {
-                    address = (uint32_t)&s_UsbTransferBuffer[0];
-                    address = (uint32_t)((usb_host_ufi_read_capacity_t *)(address))->lastLogicalBlockAddress;
-                    value = USB_LONG_FROM_BIG_ENDIAN_ADDRESS(((uint8_t *)address));
-                    ((uint8_t *)buff)[0] = ((uint8_t*)&value)[0];
-                    ((uint8_t *)buff)[1] = ((uint8_t*)&value)[1];
-                    ((uint8_t *)buff)[2] = ((uint8_t*)&value)[2];
-                    ((uint8_t *)buff)[3] = ((uint8_t*)&value)[3];
+                    LBA_t sectorCount;
+
+                    /* the last block address, the count is one more */
+                    value = USB_LONG_FROM_BIG_ENDIAN_ADDRESS(capacity->lastLogicalBlockAddress);
+                    sectorCount = (LBA_t)value + 1U;
+                    (void)memcpy(buff, &sectorCount, sizeof(sectorCount));
                 }
                 else /* Get the sector size in byte */
                 {
-                    address = (uint32_t)&s_UsbTransferBuffer[0];
-                    address = (uint32_t)((usb_host_ufi_read_capacity_t *)(address))->blockLengthInBytes;
-                    value = USB_LONG_FROM_BIG_ENDIAN_ADDRESS(((uint8_t *)address));
+                    value = USB_LONG_FROM_BIG_ENDIAN_ADDRESS(capacity->blockLengthInBytes);
                     ((uint8_t *)buff)[0] = ((uint8_t*)&value)[0];
                     ((uint8_t *)buff)[1] = ((uint8_t*)&value)[1];
                     ((uint8_t *)buff)[2] = ((uint8_t*)&value)[2];
@@ -394,10 +1081,126 @@ DRESULT USB_HostMsdIoctlDisk(BYTE pdrv, BYTE cmd, void *buff)
             fatfs_code = RES_OK;
             break;
 
+#if FF_USE_TRIM
+        case CTRL_TRIM:
+            if (!buff)
+            {
+                return RES_PARERR;
+            }
+            fatfs_code = USB_HostMsdUnmapSectors(lun, ((LBA_t *)buff)[0], ((LBA_t *)buff)[1]);
+            break;
+#endif
+
         default:
             fatfs_code = RES_PARERR;
             break;
     }
     return fatfs_code;
 }
+
+DRESULT USB_HostMsdIoctlDisk(BYTE pdrv, BYTE cmd, void *buff)
+{
+    usb_disk_lun_t *lun = USB_HostMsdGetLun(pdrv);
+    DRESULT fatfs_code;
+
+    if (lun == NULL)
+    {
+        return RES_PARERR;
+    }
+    USB_DISK_LOCK(lun);
+    /* CTRL_SYNC is the explicit sync point and reports any lost merged run, READ CAPACITY reuses the bounce
+     * buffer and CTRL_TRIM must not overtake the merged writes */
+    if (cmd == CTRL_SYNC)
+    {
+        (void)USB_DISK_WRITE_FLUSH(lun, kUSB_HostFatfsFlushSync);
+#if USB_DISK_WRITE_COALESCE
+        fatfs_code = USB_HostMsdTakeWriteError(lun);
+#else
+        fatfs_code = RES_OK;
+#endif
+    }
+    else
+    {
+        (void)USB_DISK_WRITE_FLUSH(lun, kUSB_HostFatfsFlushIoctl);
+        fatfs_code = RES_OK;
+    }
+    if (fatfs_code == RES_OK)
+    {
+        fatfs_code = USB_HostMsdIoctlUnit(lun, cmd, buff);
+    }
+    USB_DISK_UNLOCK(lun);
+    return fatfs_code;
+}
+
+/* the statistics cover all logical units */
+void USB_HostMsdReadAheadGetStat(usb_host_fatfs_read_ahead_stat_t *stat, uint8_t reset)
+{
+    memset(stat, 0, sizeof(*stat));
+    for (uint32_t i = 0U; i < USB_HOST_FATFS_LUNS; ++i)
+    {
+        usb_host_fatfs_read_ahead_stat_t *lun = &s_DiskLun[i].readAheadStat;
+
+        stat->requests += lun->requests;
+        stat->sectors += lun->sectors;
+        stat->hits += lun->hits;
+        stat->commands += lun->commands;
+        stat->driveSectors += lun->driveSectors;
+#if USB_DISK_READ_AHEAD
+        if (s_DiskLun[i].readAheadWindow > stat->window)
+        {
+            stat->window = s_DiskLun[i].readAheadWindow;
+        }
+#endif
+        if (reset)
+        {
+            memset(lun, 0, sizeof(*lun));
+        }
+    }
+}
+
+void USB_HostMsdWriteGetStat(usb_host_fatfs_write_stat_t *stat, uint8_t reset)
+{
+    memset(stat, 0, sizeof(*stat));
+    for (uint32_t i = 0U; i < USB_HOST_FATFS_LUNS; ++i)
+    {
+        usb_host_fatfs_write_stat_t *lun = &s_DiskLun[i].writeStat;
+
+        stat->requests += lun->requests;
+        stat->sectors += lun->sectors;
+        stat->commands += lun->commands;
+        stat->dropped += lun->dropped;
+        for (uint32_t reason = 0U; reason < kUSB_HostFatfsFlushNumOf; ++reason)
+        {
+            stat->flush[reason] += lun->flush[reason];
+        }
+        if (reset)
+        {
+            memset(lun, 0, sizeof(*lun));
+        }
+    }
+}
+
+void USB_HostMsdTransferGetStat(usb_host_fatfs_transfer_stat_t *stat, uint8_t reset)
+{
+    memset(stat, 0, sizeof(*stat));
+    for (uint32_t i = 0U; i < USB_HOST_FATFS_LUNS; ++i)
+    {
+        usb_host_fatfs_transfer_stat_t *lun = &s_DiskLun[i].transferStat;
+
+        stat->readCommands += lun->readCommands;
+        stat->readSectors += lun->readSectors;
+        stat->readCycles += lun->readCycles;
+        stat->writeCommands += lun->writeCommands;
+        stat->writeSectors += lun->writeSectors;
+        stat->writeCycles += lun->writeCycles;
+        stat->unmapCommands += lun->unmapCommands;
+        stat->unmapSectors += lun->unmapSectors;
+        stat->unmapCycles += lun->unmapCycles;
+        if (reset)
+        {
+            memset(lun, 0, sizeof(*lun));
+        }
+    }
+}
+
 #endif /* USB_DISK_ENABLE */
@@ -18,6 +18,21 @@
 
 #define MEMORYDUMP
 #define DIRECTORY
+#define COPY
+#define MIDILATENCY
+#define LOGSTAT
+#define APPSTAT
+#define XFERPOOL
+#define TOP
+#define TRACESAVE
+#define LOWPOWER
+#define DISKCACHE
+#define FASTMOUNT
+#define DIRINDEX
+#define FASTSEEK
+#define FSBENCH
+#define RECORD
+#define MSDBENCH
 
 /*
  * Debug Monitor Phase
@@ -519,6 +534,8 @@ static eResult MemoryDump(eDebugMonitorInterface d, uint8_t *cmd, uint8_t ofs)
 #ifdef DIRECTORY
 
 #include "ff.h"
+#include "fast_mount.h"
+#include "dir_index.h"
 
 static void DispDateTime(eDebugMonitorInterface d, uint16_t date, uint16_t time)
 {
@@ -576,6 +593,11 @@ static void DispSize(eDebugMonitorInterface d, uint64_t size, int wide)
 	return;
 }
 
+static FILINFO dirInfo;	// too large for the monitor task stack with long file names
+#if ((defined DIR_INDEX_ENABLE) && (DIR_INDEX_ENABLE))
+static dir_index_t dirIndex;	// sector buffer
+#endif
+
 static eResult DisplayDirectory(eDebugMonitorInterface d, uint8_t *path)
 {
 	eResult result = eResult_OK;
@@ -588,29 +610,53 @@ static eResult DisplayDirectory(eDebugMonitorInterface d, uint8_t *path)
 		int nfile = 0;
 		int ndir = 0;
 		uint64_t total = 0;
+#if ((defined DIR_INDEX_ENABLE) && (DIR_INDEX_ENABLE))
+		/* listed sorted from an up to date index, a listing never writes the medium (Find builds the index) */
+		uint8_t indexed = (DirIndex_OpenExisting(&dirIndex, path) == FR_OK);
+		uint32_t n = 0;
 
+		dmprintf(d, " Directory of %s%s\n\n", path, indexed ? " (indexed)" : "");
+#else
 		dmprintf(d, " Directory of %s\n\n", path);
+#endif
 		while (1)
 		{
-			FILINFO fno;
+			FILINFO *fno = &dirInfo;
 
-			res = f_readdir(&dir, &fno);					/* Read a directory item */
-			if (res != FR_OK || fno.fname[0] == 0) break;	/* Error or end of dir */
-			DispDateTime(d, fno.fdate, fno.ftime);
-            if (fno.fattrib & AM_DIR)
+#if ((defined DIR_INDEX_ENABLE) && (DIR_INDEX_ENABLE))
+			if (indexed)
+			{
+				res = DirIndex_Read(&dirIndex, n++, fno);
+			}
+			else
+#endif
+			res = f_readdir(&dir, fno);					/* Read a directory item */
+			if (res != FR_OK || fno->fname[0] == 0) break;	/* Error or end of dir */
+			DispDateTime(d, fno->fdate, fno->ftime);
+            if (fno->fattrib & AM_DIR)
             {	/* Directory */
-                dmprintf(d, "  <DIR>          %s\n", fno.fname);
+                dmputs(d, "  <DIR>          ");
+                dmputs(d, fno->fname);	/* long names do not fit the printf buffer */
+                dmputc(d, '\n');
                 ndir++;
             }
             else
             {	/* File */
-            	DispSize(d, fno.fsize, 16);
-                dmprintf(d, " %s\n", fno.fname);
-                total += fno.fsize;
+            	DispSize(d, fno->fsize, 16);
+                dmputc(d, ' ');
+                dmputs(d, fno->fname);
+                dmputc(d, '\n');
+                total += fno->fsize;
                 nfile++;
             }
  		}
 
+#if ((defined DIR_INDEX_ENABLE) && (DIR_INDEX_ENABLE))
+		if (indexed)
+		{
+			DirIndex_Close(&dirIndex);
+		}
+#endif
 		f_closedir(&dir);
 		dmprintf(d, "%16d File(s) ", nfile);
 		DispSize(d, total, 17);
@@ -624,15 +670,23 @@ static eResult DisplayDirectory(eDebugMonitorInterface d, uint8_t *path)
 			dirpath[0] = path[0];
 			dirpath[1] = path[1];
 			dirpath[2] = 0;
+#if ((defined FAST_MOUNT_ENABLE) && (FAST_MOUNT_ENABLE))
+			res = FastMount_GetFree(dirpath, &fre_clust, &fs);
+#else
 			res = f_getfree(dirpath, &fre_clust, &fs);
+#endif
 			if (res == FR_OK)
 			{
-				uint64_t free = fre_clust * fs->csize;
+				uint64_t free = (uint64_t)fre_clust * fs->csize;
 
 				free *= 512;
 				DispSize(d, free, 18);
 				dmprintf(d, " bytes");
 			}
+			else if (res == FR_NOT_READY)
+			{
+				dmprintf(d, " (free space being counted)");
+			}
 		}
 	}
 	else
@@ -668,6 +722,1273 @@ static eResult Directory(eDebugMonitorInterface d, uint8_t *cmd, uint8_t ofs)
 #define DIRCMD
 #endif	//DIRECTORY
 
+#if (defined(COPY) && defined(DIRECTORY)) || defined(RECORD) || defined(MSDBENCH)
+// Copy, Record and MsdBench all run in the monitor task, one at a time, and share this buffer
+#define WORKBUFSIZE 6144	// MsdBench: BENCHMAXBLOCK + BENCHSAMPLES * 4
+static uint32_t workBuf[WORKBUFSIZE / sizeof(uint32_t)];
+#endif
+
+#if defined(COPY) && defined(DIRECTORY)	// uses DispSize()
+
+#include "ff.h"
+#include "FreeRTOS.h"
+#include "task.h"
+
+#define COPYBUFSIZE 4096
+
+#if COPYBUFSIZE > WORKBUFSIZE
+#error "COPYBUFSIZE exceeds WORKBUFSIZE"
+#endif
+
+static FIL copySrc, copyDst;	// too large for the monitor task stack
+static uint8_t *const copyBuf = (uint8_t *)workBuf;
+
+static eResult CopyFile(eDebugMonitorInterface d, uint8_t *cmd, uint8_t ofs)
+{
+	eResult result = eResult_OK;
+	char *src = (char *)&cmd[ofs];
+	char *dst;
+	FRESULT res;
+
+	while (*src == ' ') src++;
+	dst = strchr(src, ' ');
+	if ((*src == 0) || (dst == NULL)) {
+		dmputs(d, " usage>Copy drive:src-path drive:dst-path");
+		return eResult_NG;
+	}
+	*dst++ = 0;
+	while (*dst == ' ') dst++;
+
+	res = f_open(&copySrc, src, FA_READ);
+	if (res != FR_OK) {
+		dmprintf(d, " %s open error (%d)", src, res);
+		return eResult_NG;
+	}
+	res = f_open(&copyDst, dst, FA_WRITE | FA_CREATE_ALWAYS);
+	if (res != FR_OK) {
+		dmprintf(d, " %s open error (%d)", dst, res);
+		f_close(&copySrc);
+		return eResult_NG;
+	}
+
+	TickType_t tick = xTaskGetTickCount();
+	uint64_t total = 0;
+
+	while (1) {
+		UINT rlen, wlen;
+
+		res = f_read(&copySrc, copyBuf, COPYBUFSIZE, &rlen);
+		if ((res != FR_OK) || (rlen == 0)) break;
+		res = f_write(&copyDst, copyBuf, rlen, &wlen);
+		if ((res != FR_OK) || (wlen != rlen)) {
+			if (res == FR_OK) res = FR_DENIED;	// disk full
+			break;
+		}
+		total += wlen;
+	}
+	f_close(&copySrc);
+	if (f_close(&copyDst) != FR_OK) {
+		res = res == FR_OK ? FR_DISK_ERR : res;
+	}
+	tick = xTaskGetTickCount() - tick;
+
+	if (res == FR_OK) {
+		uint32_t ms = tick * portTICK_PERIOD_MS;
+
+		DispSize(d, total, 1);
+		dmprintf(d, " bytes %dms", ms);
+		if (ms) {
+			dmprintf(d, " %dKB/s", (uint32_t)(total / ms * 1000 / 1024));
+		}
+	}
+	else {
+		dmprintf(d, " copy error (%d)", res);
+		result = eResult_NG;
+	}
+
+	return result;
+}
+
+#define COPYCMD	{"Copy src dst", CopyFile},
+#else	//COPY
+#define COPYCMD
+#endif	//COPY
+
+#ifdef MIDILATENCY
+
+#include "host_midi_latency.h"
+
+#if !((defined MIDI_LATENCY_ENABLE) && (MIDI_LATENCY_ENABLE))
+#undef MIDILATENCY
+#endif
+
+#endif	//MIDILATENCY
+
+#ifdef MIDILATENCY
+
+extern uint32_t SystemCoreClock;
+
+static void DispCycles(eDebugMonitorInterface d, uint32_t cycles)
+{
+	uint32_t perUs = SystemCoreClock / 1000000;
+	uint32_t tenth = (uint32_t)(((uint64_t)cycles * 10) / perUs);
+
+	dmprintf(d, "%6d.%01dus", tenth / 10, tenth % 10);
+
+	return;
+}
+
+static eResult MidiLatency(eDebugMonitorInterface d, uint8_t *cmd, uint8_t ofs)
+{
+	eResult result = eResult_OK;
+	uint8_t reset = 0;
+
+	if (cmd[ofs] == ' ') {
+		if ((cmd[ofs+1] == 'R') || (cmd[ofs+1] == 'r')) {
+			reset = 1;
+		}
+		else {
+			dmputs(d, " usage>Latency (R:reset after display)");
+			return eResult_NG;
+		}
+	}
+	dmprintf(d, " --- MIDI Latency (%dMHz) ---", SystemCoreClock / 1000000);
+	for (int i = 0; i < kUSB_HostMidiLatencyNumOf; ++i) {
+		usb_host_midi_latency_hist_t hist;
+
+		USB_HostMidiLatencyGet(i, &hist, reset);
+		dmprintf(d, "\n %-10s n=%d", USB_HostMidiLatencyName(i), hist.count);
+		if (hist.count == 0) {
+			continue;
+		}
+		dmputs(d, " min=");
+		DispCycles(d, hist.min);
+		dmputs(d, " avg=");
+		DispCycles(d, (uint32_t)(hist.total / hist.count));
+		dmputs(d, " max=");
+		DispCycles(d, hist.max);
+		for (int b = 0; b < MIDI_LATENCY_BUCKETS; ++b) {
+			if (hist.bucket[b] == 0) {
+				continue;
+			}
+			if (b < (MIDI_LATENCY_BUCKETS - 1)) {
+				dmputs(d, "\n    <");
+				DispCycles(d, 1U << b);
+			}
+			else {
+				dmputs(d, "\n   >=");
+				DispCycles(d, 1U << (b - 1));
+			}
+			dmprintf(d, " %10d", hist.bucket[b]);
+		}
+	}
+	if (reset) {
+		dmputs(d, "\n (reset)");
+	}
+
+	return result;
+}
+
+#define MIDILATENCYCMD	{"Latency (R)", MidiLatency},
+#else	//MIDILATENCY
+#define MIDILATENCYCMD
+#endif	//MIDILATENCY
+
+#ifdef LOGSTAT
+
+#include "FreeRTOS.h"
+
+static eResult LogStat(eDebugMonitorInterface d, uint8_t *cmd, uint8_t ofs)
+{
+	eResult result = eResult_OK;
+	DebugMonitorLogStat_t stat;
+	uint8_t reset = 0;
+
+	if (cmd[ofs] == ' ') {
+		if ((cmd[ofs+1] == 'R') || (cmd[ofs+1] == 'r')) {
+			reset = 1;
+		}
+		else {
+			dmputs(d, " usage>LogStat (R:reset after display)");
+			return eResult_NG;
+		}
+	}
+	DebugMonitor_statLog(&stat, reset);
+	dmprintf(d, " --- Log Tx Queue ---\n");
+	dmprintf(d, " chunks  %10d\n", stat.chunks);
+	dmprintf(d, " bytes   %10d\n", stat.bytes);
+	dmprintf(d, " stalls  %10d (total %dms, max %dms)\n", stat.stalls,
+			stat.stallTicks * portTICK_PERIOD_MS, stat.maxStallTicks * portTICK_PERIOD_MS);
+	dmprintf(d, " lost    %10d\n", stat.errors);
+	dmprintf(d, " dmlog dropped %4d", dmlog_dropped());
+
+	return result;
+}
+
+#define LOGSTATCMD	{"LogStat (R)", LogStat},
+#else	//LOGSTAT
+#define LOGSTATCMD
+#endif	//LOGSTAT
+
+#ifdef APPSTAT
+
+#include "app.h"
+
+static eResult AppStat(eDebugMonitorInterface d, uint8_t *cmd, uint8_t ofs)
+{
+	eResult result = eResult_OK;
+	uint32_t perUs = SystemCoreClock / 1000000;
+	uint8_t reset = 0;
+
+	if (cmd[ofs] == ' ') {
+		if ((cmd[ofs+1] == 'R') || (cmd[ofs+1] == 'r')) {
+			reset = 1;
+		}
+		else {
+			dmputs(d, " usage>AppStat (R:reset after display)");
+			return eResult_NG;
+		}
+	}
+	dmputs(d, " --- App Task Class Service ---\n");
+	dmputs(d, " class          runs   total[us]     avg[us]     max[us]");
+	for (int i = 0; i < kUSB_HostAppClassNumOf; ++i) {
+		usb_host_app_class_stat_t stat;
+
+		USB_HostAppGetClassStat(i, &stat, reset);
+		dmprintf(d, "\n %-10s %8d %11d %11d %11d", stat.name, stat.runs,
+				(uint32_t)(stat.totalCycles / perUs),
+				stat.runs ? (uint32_t)(stat.totalCycles / stat.runs / perUs) : 0,
+				stat.maxCycles / perUs);
+	}
+
+	return result;
+}
+
+#define APPSTATCMD	{"AppStat (R)", AppStat},
+#else	//APPSTAT
+#define APPSTATCMD
+#endif	//APPSTAT
+
+#ifdef XFERPOOL
+
+#include "app.h"
+
+static const char *const xferPoolName[kUSB_HostTransferPoolNumOf] = {"shared", "msd", "midi"};
+
+static eResult XferPool(eDebugMonitorInterface d, uint8_t *cmd, uint8_t ofs)
+{
+	eResult result = eResult_OK;
+	uint8_t reset = 0;
+
+	if (cmd[ofs] == ' ') {
+		if ((cmd[ofs+1] == 'R') || (cmd[ofs+1] == 'r')) {
+			reset = 1;
+		}
+		else {
+			dmputs(d, " usage>Xfer (R:reset after display)");
+			return eResult_NG;
+		}
+	}
+	dmprintf(d, " --- USB Host Transfer Pools (%d) ---\n", USB_HOST_CONFIG_MAX_TRANSFERS);
+	dmputs(d, " pool   size inuse  high     allocs   borrowed   failures");
+	for (int i = 0; i < kUSB_HostTransferPoolNumOf; ++i) {
+		usb_host_transfer_pool_stat_t stat;
+
+		if (USB_HostGetTransferPoolStat(g_HostHandle, i, &stat, reset) != kStatus_USB_Success) {
+			return eResult_NG;
+		}
+		dmprintf(d, "\n %-6s %4d %5d %5d %10d %10d %10d", xferPoolName[i], stat.size, stat.inUse, stat.highWater,
+				stat.allocs, stat.borrowed, stat.failures);
+	}
+
+	return result;
+}
+
+#define XFERPOOLCMD	{"Xfer (R)", XferPool},
+#else	//XFERPOOL
+#define XFERPOOLCMD
+#endif	//XFERPOOL
+
+#ifdef TOP
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#if !((configGENERATE_RUN_TIME_STATS == 1) && (configUSE_TRACE_FACILITY == 1))
+#undef TOP
+#endif
+
+#endif	//TOP
+
+#ifdef TOP
+
+#define TOPTASKS 12
+#define TOPWINDOWMS 1000
+#define TOPWINDOWMAXMS 5000	// run time counter (CYCCNT) wraps every 8.6s at 500MHz
+
+static TaskStatus_t topTask[2][TOPTASKS];	// too large for the monitor task stack
+
+static eResult Top(eDebugMonitorInterface d, uint8_t *cmd, uint8_t ofs)
+{
+	eResult result = eResult_OK;
+	uint32_t window = TOPWINDOWMS;
+	uint32_t total[2];
+	UBaseType_t num[2];
+
+	if (cmd[ofs] == ' ') {
+		window = strtoul(&cmd[ofs+1], NULL, 10);
+		if ((window == 0) || (window > TOPWINDOWMAXMS)) {
+			dmprintf(d, " usage>Top (window ms:1-%d)", TOPWINDOWMAXMS);
+			return eResult_NG;
+		}
+	}
+	num[0] = uxTaskGetSystemState(topTask[0], TOPTASKS, &total[0]);
+	vTaskDelay(pdMS_TO_TICKS(window));
+	num[1] = uxTaskGetSystemState(topTask[1], TOPTASKS, &total[1]);
+	if ((num[0] == 0) || (num[1] == 0)) {
+		dmprintf(d, " more than %d tasks", TOPTASKS);
+		return eResult_NG;
+	}
+	total[1] -= total[0];
+	if (total[1] == 0) {
+		total[1] = 1;
+	}
+
+	dmprintf(d, " --- Task Load (%dms) ---\n", window);
+	dmputs(d, " task       pri    cpu  stack free[words]");
+	for (int i = 0; i < num[1]; ++i) {
+		TaskStatus_t *now = &topTask[1][i];
+		uint32_t run = now->ulRunTimeCounter;
+		uint32_t permil;
+
+		for (int j = 0; j < num[0]; ++j) {
+			if (topTask[0][j].xHandle == now->xHandle) {
+				run -= topTask[0][j].ulRunTimeCounter;
+				break;
+			}
+		}
+		permil = (uint32_t)(((uint64_t)run * 1000) / total[1]);
+		dmprintf(d, "\n %-10s %3d %3d.%01d%% %6d", now->pcTaskName, now->uxCurrentPriority,
+				permil / 10, permil % 10, now->usStackHighWaterMark);
+	}
+	dmprintf(d, "\n heap free %d min ever %d (total %d)",
+			xPortGetFreeHeapSize(), xPortGetMinimumEverFreeHeapSize(), configTOTAL_HEAP_SIZE);
+
+	return result;
+}
+
+#define TOPCMD	{"Top (ms)", Top},
+#else	//TOP
+#define TOPCMD
+#endif	//TOP
+
+#ifdef TRACESAVE
+
+#include "trace_recorder.h"
+
+#if !((defined TRACE_RECORDER_ENABLE) && (TRACE_RECORDER_ENABLE))
+#undef TRACESAVE
+#endif
+
+#endif	//TRACESAVE
+
+#ifdef TRACESAVE
+
+#include "ff.h"
+#include "FreeRTOS.h"
+#include "task.h"
+
+#define TRACETASKS 12
+#define TRACECHUNK 64
+
+static FIL traceFile;	// too large for the monitor task stack
+static TaskStatus_t traceTask[TRACETASKS];
+static trace_record_t traceBuf[TRACECHUNK];
+
+static FRESULT TraceWrite(const void *buf, UINT len)
+{
+	UINT wlen;
+	FRESULT res = f_write(&traceFile, buf, len, &wlen);
+
+	if ((res == FR_OK) && (wlen != len)) {
+		res = FR_DENIED;	// disk full
+	}
+
+	return res;
+}
+
+static eResult TraceSave(eDebugMonitorInterface d, uint8_t *cmd, uint8_t ofs)
+{
+	eResult result = eResult_OK;
+	uint8_t *path = &cmd[ofs];
+	trace_file_header_t header = {{'R', 'T', 'R', 'C'}, TRACE_FILE_VERSION, sizeof(trace_record_t)};
+	FRESULT res;
+
+	while (*path == ' ') path++;
+	if (*path == 0) {
+		dmputs(d, " usage>TraceSave drive:path");
+		return eResult_NG;
+	}
+	res = f_open(&traceFile, path, FA_WRITE | FA_CREATE_ALWAYS);
+	if (res != FR_OK) {
+		dmprintf(d, " %s open error (%d)", path, res);
+		return eResult_NG;
+	}
+
+	TraceRecorderEnable(0);	// freeze the ring, the file write itself is not recorded
+	header.coreClock = SystemCoreClock;
+	header.records = TraceRecorderCount(&header.dropped);
+	header.tasks = uxTaskGetSystemState(traceTask, TRACETASKS, NULL);
+
+	res = TraceWrite(&header, sizeof(header));
+	for (int i = 0; (res == FR_OK) && (i < header.tasks); ++i) {
+		trace_file_task_t task = {traceTask[i].xTaskNumber};
+
+		strncpy(task.name, traceTask[i].pcTaskName, sizeof(task.name) - 1);
+		res = TraceWrite(&task, sizeof(task));
+	}
+	for (uint32_t pos = 0; (res == FR_OK) && (pos < header.records); pos += TRACECHUNK) {
+		uint32_t num = TraceRecorderCopy(pos, traceBuf, TRACECHUNK);
+
+		res = TraceWrite(traceBuf, num * sizeof(trace_record_t));
+	}
+	if (f_close(&traceFile) != FR_OK) {
+		res = res == FR_OK ? FR_DISK_ERR : res;
+	}
+	TraceRecorderClear();
+	TraceRecorderEnable(1);
+
+	if (res == FR_OK) {
+		dmprintf(d, " %d records (%d dropped) %d tasks -> %s", header.records, header.dropped, header.tasks, path);
+	}
+	else {
+		dmprintf(d, " write error (%d)", res);
+		result = eResult_NG;
+	}
+
+	return result;
+}
+
+#define TRACESAVECMD	{"TraceSave path", TraceSave},
+#else	//TRACESAVE
+#define TRACESAVECMD
+#endif	//TRACESAVE
+
+#ifdef LOWPOWER
+
+#include "low_power.h"
+
+#if !((defined LOW_POWER_TICKLESS_ENABLE) && (LOW_POWER_TICKLESS_ENABLE))
+#undef LOWPOWER
+#endif
+
+#endif	//LOWPOWER
+
+#ifdef LOWPOWER
+
+#include "FreeRTOS.h"
+
+static eResult LowPower(eDebugMonitorInterface d, uint8_t *cmd, uint8_t ofs)
+{
+	eResult result = eResult_OK;
+	uint32_t perUs = SystemCoreClock / 1000000;
+	low_power_stat_t stat;
+	uint32_t permil;
+	uint8_t reset = 0;
+
+	if (cmd[ofs] == ' ') {
+		if ((cmd[ofs+1] == 'R') || (cmd[ofs+1] == 'r')) {
+			reset = 1;
+		}
+		else {
+			dmputs(d, " usage>Sleep (R:reset after display)");
+			return eResult_NG;
+		}
+	}
+	LowPowerGetStat(&stat, reset);
+	permil = stat.elapsedTicks ? (uint32_t)(((uint64_t)stat.sleptTicks * 1000) / stat.elapsedTicks) : 0;
+	dmputs(d, " --- Tickless Idle ---\n");
+	dmprintf(d, " sleeps  %10d\n", stat.sleeps);
+	dmprintf(d, " slept   %10dms of %dms (%d.%01d%%)\n", stat.sleptTicks * portTICK_PERIOD_MS,
+			stat.elapsedTicks * portTICK_PERIOD_MS, permil / 10, permil % 10);
+	dmputs(d, " wakeup      wakes    to task  avg[us]  max[us]");
+	for (int i = 0; i < kLowPowerWakeNumOf; ++i) {
+		low_power_wake_stat_t *wake = &stat.wake[i];
+		uint32_t avg = wake->activations ? (uint32_t)((wake->totalCycles * 10) / wake->activations / perUs) : 0;
+		uint32_t max = (uint32_t)(((uint64_t)wake->maxCycles * 10) / perUs);
+
+		dmprintf(d, "\n %-8s %8d %10d %6d.%01d %6d.%01d", LowPowerWakeName(i), wake->wakes, wake->activations,
+				avg / 10, avg % 10, max / 10, max % 10);
+	}
+
+	return result;
+}
+
+#define LOWPOWERCMD	{"Sleep (R)", LowPower},
+#else	//LOWPOWER
+#define LOWPOWERCMD
+#endif	//LOWPOWER
+
+#ifdef DISKCACHE
+
+#include "diskio_cache.h"
+#include "fsl_usb_disk.h"
+
+#if !((defined DISK_CACHE_ENABLE) && (DISK_CACHE_ENABLE))
+#undef DISKCACHE
+#endif
+
+#endif	//DISKCACHE
+
+#ifdef DISKCACHE
+
+static eResult DiskCache(eDebugMonitorInterface d, uint8_t *cmd, uint8_t ofs)
+{
+	eResult result = eResult_OK;
+	disk_cache_stat_t stat;
+	usb_host_fatfs_read_ahead_stat_t ra;
+	usb_host_fatfs_write_stat_t wr;
+	usb_host_fatfs_transfer_stat_t usb;
+	uint32_t reads;
+	uint32_t permil;
+	uint8_t reset = 0;
+
+	if (cmd[ofs] == ' ') {
+		if ((cmd[ofs+1] == 'R') || (cmd[ofs+1] == 'r')) {
+			reset = 1;
+		}
+		else {
+			dmputs(d, " usage>Cache (R:reset after display)");
+			return eResult_NG;
+		}
+	}
+	DiskCache_GetStat(&stat, reset);
+	USB_HostMsdReadAheadGetStat(&ra, reset);
+	USB_HostMsdWriteGetStat(&wr, reset);
+	USB_HostMsdTransferGetStat(&usb, reset);
+	reads = stat.readHits + stat.readMisses;
+	permil = reads ? (uint32_t)(((uint64_t)stat.readHits * 1000) / reads) : 0;
+	dmprintf(d, " --- Sector Cache %dx%d %s ---\n", DISK_CACHE_SETS, DISK_CACHE_WAYS,
+			DISK_CACHE_WRITE_BACK ? "write-back" : "write-through");
+	dmprintf(d, " read   hit %10d miss %10d (%d.%01d%%)\n", stat.readHits, stat.readMisses, permil / 10, permil % 10);
+	dmprintf(d, " write  hit %10d miss %10d\n", stat.writeHits, stat.writeMisses);
+	dmprintf(d, " bypass rd  %10d wr   %10d\n", stat.bypassReads, stat.bypassWrites);
+	dmprintf(d, " evict      %10d wb   %10d\n", stat.evictions, stat.writeBacks);
+	dmprintf(d, " invalidate %10d lost %10d\n", stat.invalidations, stat.lostDirty);
+	permil = ra.sectors ? (uint32_t)(((uint64_t)ra.hits * 1000) / ra.sectors) : 0;
+	dmputs(d, " --- USB Disk Read-ahead ---\n");
+	dmprintf(d, " request    %10d sect %10d window %d\n", ra.requests, ra.sectors, ra.window);
+	dmprintf(d, " read10     %10d sect %10d\n", ra.commands, ra.driveSectors);
+	dmprintf(d, " prefetched %10d (%d.%01d%%)\n", ra.hits, permil / 10, permil % 10);
+	dmputs(d, " --- USB Disk Write Coalescing ---\n");
+	dmprintf(d, " request    %10d sect %10d\n", wr.requests, wr.sectors);
+	dmprintf(d, " write10    %10d lost %10d\n", wr.commands, wr.dropped);
+	dmprintf(d, " flush full %d gap %d read %d sync %d timer %d ioctl %d", wr.flush[kUSB_HostFatfsFlushFull],
+			wr.flush[kUSB_HostFatfsFlushGap], wr.flush[kUSB_HostFatfsFlushRead], wr.flush[kUSB_HostFatfsFlushSync],
+			wr.flush[kUSB_HostFatfsFlushTimer], wr.flush[kUSB_HostFatfsFlushIoctl]);
+	/* CTRL_TRIM of the freed clusters, nothing on a device without UNMAP */
+	dmputs(d, "\n --- USB Disk Unmap ---\n");
+	dmprintf(d, " unmap      %10d sect %10d %dms", usb.unmapCommands, usb.unmapSectors,
+			(uint32_t)(usb.unmapCycles / (SystemCoreClock / 1000)));
+
+	return result;
+}
+
+#define DISKCACHECMD	{"Cache (R)", DiskCache},
+#else	//DISKCACHE
+#define DISKCACHECMD
+#endif	//DISKCACHE
+
+#ifdef FASTMOUNT
+
+#include "fast_mount.h"
+
+#if !((defined FAST_MOUNT_ENABLE) && (FAST_MOUNT_ENABLE))
+#undef FASTMOUNT
+#endif
+
+#endif	//FASTMOUNT
+
+#ifdef FASTMOUNT
+
+static eResult FastMountStat(eDebugMonitorInterface d, uint8_t *cmd, uint8_t ofs)
+{
+	eResult result = eResult_OK;
+	fast_mount_stat_t stat;
+	uint8_t reset = 0;
+
+	if (cmd[ofs] == ' ') {
+		if ((cmd[ofs+1] == 'R') || (cmd[ofs+1] == 'r')) {
+			reset = 1;
+		}
+		else {
+			dmputs(d, " usage>Mount (R:reset after display)");
+			return eResult_NG;
+		}
+	}
+	FastMount_GetStat(&stat, reset);
+	dmputs(d, " --- Fast Mount ---\n");
+	dmprintf(d, " mount      %10d last %dus\n", stat.mounts, stat.mountUs);
+	dmprintf(d, " fsinfo ok  %10d dirty %10d\n", stat.trusted, stat.untrusted);
+	dmprintf(d, " counted    %10d last %dms\n", stat.counts, stat.countMs);
+	dmprintf(d, " restart    %10d error %10d%s", stat.restarts, stat.errors, FastMount_Pending() ? " (counting)" : "");
+
+	return result;
+}
+
+#define FASTMOUNTCMD	{"Mount (R)", FastMountStat},
+#else	//FASTMOUNT
+#define FASTMOUNTCMD
+#endif	//FASTMOUNT
+
+#ifdef DIRINDEX
+
+#include "dir_index.h"
+
+#if !((defined DIR_INDEX_ENABLE) && (DIR_INDEX_ENABLE)) || !defined(DIRECTORY)	// uses dirIndex and DispSize()
+#undef DIRINDEX
+#endif
+
+#endif	//DIRINDEX
+
+#ifdef DIRINDEX
+
+static eResult FindFile(eDebugMonitorInterface d, uint8_t *cmd, uint8_t ofs)
+{
+	eResult result = eResult_OK;
+	uint32_t perUs = SystemCoreClock / 1000000;
+	uint8_t *path = &cmd[ofs];
+	uint8_t *name;
+	dir_index_entry_t entry;
+	uint32_t cycles;
+	FRESULT res;
+
+	while (*path == ' ') path++;
+	name = strchr(path, ' ');
+	if (name != NULL) {
+		*name++ = 0;
+		while (*name == ' ') name++;
+	}
+	if ((*path == 0) || (name == NULL) || (*name == 0)) {
+		dmputs(d, " usage>Find drive:directory name");
+		return eResult_NG;
+	}
+	cycles = DWT->CYCCNT;
+	res = DirIndex_Open(&dirIndex, path);
+	cycles = DWT->CYCCNT - cycles;
+	if (res == FR_NO_FILE) {
+		dmprintf(d, " %s has fewer than %d files, no index", path, DIR_INDEX_MIN_ENTRIES);
+		return eResult_NG;
+	}
+	if (res == FR_EXIST) {
+		dmprintf(d, " %s has a %s that is not an index, left alone", path, DIR_INDEX_FILE_NAME);
+		return eResult_NG;
+	}
+	if (res != FR_OK) {
+		dmprintf(d, " %s index error (%d)", path, res);
+		return eResult_NG;
+	}
+	dmprintf(d, " open   %8dus %d files\n", cycles / perUs, dirIndex.header.count);
+	cycles = DWT->CYCCNT;
+	res = DirIndex_Find(&dirIndex, name, &entry);
+	cycles = DWT->CYCCNT - cycles;
+	DirIndex_Close(&dirIndex);
+	dmprintf(d, " lookup %8dus\n", cycles / perUs);
+	if (res == FR_OK) {
+		dmputs(d, (entry.fattrib & AM_DIR) ? "  <DIR>          " : "");
+		if (!(entry.fattrib & AM_DIR)) {
+			DispSize(d, entry.fsize, 16);
+			dmputc(d, ' ');
+		}
+		dmputs(d, name);	/* long names do not fit the printf buffer */
+		dmprintf(d, "\n cluster %d", entry.sclust);
+	}
+	else if (res == FR_NO_FILE) {
+		dmputs(d, " not found");
+	}
+	else {
+		dmprintf(d, " lookup error (%d)", res);
+		result = eResult_NG;
+	}
+
+	return result;
+}
+
+static eResult DirIndexStat(eDebugMonitorInterface d, uint8_t *cmd, uint8_t ofs)
+{
+	eResult result = eResult_OK;
+	dir_index_stat_t stat;
+	uint8_t reset = 0;
+
+	if (cmd[ofs] == ' ') {
+		if ((cmd[ofs+1] == 'R') || (cmd[ofs+1] == 'r')) {
+			reset = 1;
+		}
+		else {
+			dmputs(d, " usage>Index (R:reset after display)");
+			return eResult_NG;
+		}
+	}
+	DirIndex_GetStat(&stat, reset);
+	dmputs(d, " --- Directory Index ---\n");
+	dmprintf(d, " open       %10d up to date %10d\n", stat.opens, stat.valid);
+	dmprintf(d, " build      %10d last %dms\n", stat.builds, stat.buildMs);
+	dmprintf(d, " small dir  %10d error %10d\n", stat.small, stat.errors);
+	dmprintf(d, " lookup     %10d check %dus", stat.lookups, stat.checkUs);
+
+	return result;
+}
+
+#define DIRINDEXCMD	{"Find path name", FindFile},{"Index (R)", DirIndexStat},
+#else	//DIRINDEX
+#define DIRINDEXCMD
+#endif	//DIRINDEX
+
+#ifdef FASTSEEK
+
+#include "ff.h"
+#include "media_file.h"
+#include "diskio_cache.h"
+
+#define SEEKCOUNT 100
+#define SEEKMAXCOUNT 10000
+
+static media_file_t seekFile;	// too large for the monitor task stack
+
+static eResult SeekTest(eDebugMonitorInterface d, uint8_t *cmd, uint8_t ofs)
+{
+	eResult result = eResult_OK;
+	uint32_t perUs = SystemCoreClock / 1000000;
+	uint8_t *path = &cmd[ofs];
+	uint8_t *arg;
+	uint32_t count = SEEKCOUNT;
+	FSIZE_t size;
+	FRESULT res = FR_OK;
+
+	while (*path == ' ') path++;
+	arg = strchr(path, ' ');
+	if (arg != NULL) {
+		*arg++ = 0;
+		count = strtoul(arg, NULL, 10);
+	}
+	if ((*path == 0) || (count == 0) || (count > SEEKMAXCOUNT)) {
+		dmprintf(d, " usage>Seek drive:path (count:1-%d)", SEEKMAXCOUNT);
+		return eResult_NG;
+	}
+	res = MediaFileOpen(&seekFile, path);
+	if (res != FR_OK) {
+		dmprintf(d, " %s open error (%d)", path, res);
+		return eResult_NG;
+	}
+	size = f_size(&seekFile.fil);
+	dmprintf(d, " size %d fragments %d\n", (uint32_t)size, MediaFileFragments(&seekFile));
+	if (size == 0) {
+		MediaFileClose(&seekFile);
+		return result;
+	}
+
+	/* same random offsets for the FAT chain walk and the link map */
+	for (int mode = 0; (mode < 2) && (res == FR_OK); ++mode) {
+		uint32_t seed = 1;
+		uint64_t total = 0;
+		uint32_t max = 0;
+
+		if ((mode == 1) && (seekFile.clmt == NULL)) {
+			dmputs(d, " fast seek  no link map (pool empty or too fragmented)");
+			break;
+		}
+		seekFile.fil.cltbl = mode ? seekFile.clmt : NULL;
+#if ((defined DISK_CACHE_ENABLE) && (DISK_CACHE_ENABLE))
+		/* start both runs with a cold sector cache */
+		DiskCache_Sync(seekFile.fil.obj.fs->pdrv);
+		DiskCache_Invalidate(seekFile.fil.obj.fs->pdrv);
+#endif
+		for (uint32_t i = 0; i < count; ++i) {
+			uint32_t cycles;
+
+			seed = seed * 1103515245 + 12345;
+			cycles = DWT->CYCCNT;
+			res = f_lseek(&seekFile.fil, (FSIZE_t)(seed % size));
+			cycles = DWT->CYCCNT - cycles;
+			if (res != FR_OK) {
+				break;
+			}
+			total += cycles;
+			if (cycles > max) {
+				max = cycles;
+			}
+		}
+		if (res == FR_OK) {
+			uint32_t avg = (uint32_t)((total * 10) / count / perUs);
+
+			max = (uint32_t)(((uint64_t)max * 10) / perUs);
+			dmprintf(d, " %s avg %6d.%01dus max %6d.%01dus\n", mode ? "fast seek " : "chain walk",
+					avg / 10, avg % 10, max / 10, max % 10);
+		}
+	}
+	seekFile.fil.cltbl = seekFile.clmt;
+	MediaFileClose(&seekFile);
+	if (res != FR_OK) {
+		dmprintf(d, " seek error (%d)", res);
+		result = eResult_NG;
+	}
+
+	return result;
+}
+
+#define FASTSEEKCMD	{"Seek path (count)", SeekTest},
+#else	//FASTSEEK
+#define FASTSEEKCMD
+#endif	//FASTSEEK
+
+#ifdef FSBENCH
+
+#include "ff.h"
+#include "diskio.h"
+#include "diskio_cache.h"
+#include "fast_mount.h"
+
+#define FSBENCHCOUNT 4
+#define FSBENCHMAXCOUNT 100
+
+static DIR benchDir;
+static FILINFO benchInfo;	// too large for the monitor task stack with long file names
+static char benchPath[INPUTBUFSIZE + FF_LFN_BUF + 2];
+
+static const char *FsTypeName(BYTE type)
+{
+	switch (type) {
+	case FS_FAT12:
+		return "FAT12";
+	case FS_FAT16:
+		return "FAT16";
+	case FS_FAT32:
+		return "FAT32";
+	case FS_EXFAT:
+		return "exFAT";
+	default:
+		break;
+	}
+	return "?";
+}
+
+/* every step starts from the drive, not from the sector cache */
+static void FsBenchColdCache(BYTE pdrv)
+{
+	disk_ioctl(pdrv, CTRL_SYNC, NULL);
+#if ((defined DISK_CACHE_ENABLE) && (DISK_CACHE_ENABLE))
+	DiskCache_Invalidate(pdrv);
+#endif
+}
+
+static void FsBenchPrint(eDebugMonitorInterface d, uint8_t *name, uint64_t total, uint32_t max, uint32_t count)
+{
+	uint32_t perUs = SystemCoreClock / 1000000;
+	uint32_t avg = (uint32_t)((total * 10) / count / perUs);
+
+	max = (uint32_t)(((uint64_t)max * 10) / perUs);
+	dmprintf(d, "\n %s avg %8d.%01dus max %8d.%01dus", name, avg / 10, avg % 10, max / 10, max % 10);
+}
+
+static eResult FsBench(eDebugMonitorInterface d, uint8_t *cmd, uint8_t ofs)
+{
+	uint8_t *path = &cmd[ofs];
+	uint8_t *arg;
+	uint8_t drive[3];
+	uint32_t count = FSBENCHCOUNT;
+	uint32_t entries = 0;
+	uint64_t total[3] = {0};
+	uint32_t max[3] = {0};
+	FATFS *fs;
+	FRESULT res;
+
+	while (*path == ' ') path++;
+	arg = strchr(path, ' ');
+	if (arg != NULL) {
+		*arg++ = 0;
+		count = strtoul(arg, NULL, 10);
+	}
+	if ((path[0] < '0') || (path[0] >= ('0' + FF_VOLUMES)) || (path[1] != ':') || (count == 0) ||
+		(count > FSBENCHMAXCOUNT)) {
+		dmprintf(d, " usage>FsBench drive:path (count:1-%d), the volume is remounted", FSBENCHMAXCOUNT);
+		return eResult_NG;
+	}
+	drive[0] = path[0];
+	drive[1] = ':';
+	drive[2] = 0;
+
+	/* the registered file system object, it is mounted again in place */
+	res = f_opendir(&benchDir, drive);
+	if (res != FR_OK) {
+		dmprintf(d, " %s mount error (%d)", drive, res);
+		return eResult_NG;
+	}
+	fs = benchDir.obj.fs;
+	f_closedir(&benchDir);
+
+	for (uint32_t i = 0; (i < count) && (res == FR_OK); ++i) {
+		uint32_t cycles[3] = {0};
+
+		/* mount: boot sector, FSINFO or the exFAT allocation bitmap and up-case table entries */
+		FsBenchColdCache(fs->pdrv);
+		cycles[0] = DWT->CYCCNT;
+#if ((defined FAST_MOUNT_ENABLE) && (FAST_MOUNT_ENABLE))
+		res = FastMount_Mount(fs, drive);	// with the FSINFO check, a new background count if needed
+#else
+		res = f_mount(fs, drive, 1);
+#endif
+		cycles[0] = DWT->CYCCNT - cycles[0];
+		if (res != FR_OK) {
+			break;
+		}
+
+		/* scan: every entry of the directory, the last name is looked up below */
+		FsBenchColdCache(fs->pdrv);
+		entries = 0;
+		benchPath[0] = 0;
+		cycles[1] = DWT->CYCCNT;
+		res = f_opendir(&benchDir, path);
+		while (res == FR_OK) {
+			res = f_readdir(&benchDir, &benchInfo);
+			if ((res != FR_OK) || (benchInfo.fname[0] == 0)) {
+				break;
+			}
+			entries++;
+			snprintf(benchPath, sizeof(benchPath), "%s/%s", path, benchInfo.fname);
+		}
+		f_closedir(&benchDir);
+		cycles[1] = DWT->CYCCNT - cycles[1];
+		if (res != FR_OK) {
+			break;
+		}
+
+		/* lookup: name compare over the whole directory */
+		if (entries != 0) {
+			FsBenchColdCache(fs->pdrv);
+			cycles[2] = DWT->CYCCNT;
+			res = f_stat(benchPath, &benchInfo);
+			cycles[2] = DWT->CYCCNT - cycles[2];
+		}
+
+		for (int j = 0; j < 3; ++j) {
+			total[j] += cycles[j];
+			if (cycles[j] > max[j]) {
+				max[j] = cycles[j];
+			}
+		}
+	}
+	if (res != FR_OK) {
+		dmprintf(d, " %s error (%d)", path, res);
+		return eResult_NG;
+	}
+
+	dmprintf(d, " %s cluster %dB, %d entries in %s", FsTypeName(fs->fs_type), fs->csize * FF_MAX_SS, entries, path);
+	FsBenchPrint(d, "mount ", total[0], max[0], count);
+	FsBenchPrint(d, "scan  ", total[1], max[1], count);
+	if (entries != 0) {
+		FsBenchPrint(d, "lookup", total[2], max[2], count);
+	}
+
+	return eResult_OK;
+}
+
+#define FSBENCHCMD	{"FsBench path (count)", FsBench},
+#else	//FSBENCH
+#define FSBENCHCMD
+#endif	//FSBENCH
+
+#ifdef RECORD
+
+#include "ff.h"
+#include "diskio.h"
+#include "diskio_cache.h"
+#include "record_file.h"
+
+#define RECORDCHUNK 2048
+#define RECORDDEFCHUNK 512
+#define RECORDMAXKB 65536
+
+#if RECORDCHUNK > WORKBUFSIZE
+#error "RECORDCHUNK exceeds WORKBUFSIZE"
+#endif
+
+static record_file_t recordFile;	// too large for the monitor task stack
+static uint8_t *const recordBuf = (uint8_t *)workBuf;
+
+static eResult RecordTest(eDebugMonitorInterface d, uint8_t *cmd, uint8_t ofs)
+{
+	uint32_t perUs = SystemCoreClock / 1000000;
+	uint8_t *path = &cmd[ofs];
+	uint8_t *arg;
+	uint32_t kbytes = 0;
+	uint32_t chunk = RECORDDEFCHUNK;
+	FRESULT res = FR_OK;
+
+	while (*path == ' ') path++;
+	arg = strchr(path, ' ');
+	if (arg != NULL) {
+		*arg++ = 0;
+		kbytes = strtoul(arg, (char **)&arg, 10);
+		chunk = strtoul(arg, NULL, 10);
+		if (chunk == 0) {
+			chunk = RECORDDEFCHUNK;
+		}
+	}
+	if ((path[0] < '0') || (path[0] >= ('0' + FF_VOLUMES)) || (path[1] != ':') || (kbytes == 0) ||
+		(kbytes > RECORDMAXKB) || (chunk > RECORDCHUNK)) {
+		dmprintf(d, " usage>Record drive:path KB(1-%d) (chunk:1-%d), the file is overwritten", RECORDMAXKB, RECORDCHUNK);
+		return eResult_NG;
+	}
+	for (uint32_t i = 0; i < chunk; ++i) {
+		recordBuf[i] = (uint8_t)i;
+	}
+
+	/* the same capture grown cluster by cluster, then into a preallocated region */
+	for (int mode = 0; (mode < 2) && (res == FR_OK); ++mode) {
+		uint64_t remain = (uint64_t)kbytes * 1024;
+		uint64_t total = 0;
+		uint32_t max = 0;
+		uint32_t open, close;
+
+		f_unlink(path);
+		disk_ioctl(path[0] - '0', CTRL_SYNC, NULL);
+#if ((defined DISK_CACHE_ENABLE) && (DISK_CACHE_ENABLE))
+		DiskCache_Invalidate(path[0] - '0');
+#endif
+		open = DWT->CYCCNT;
+		res = RecordFileOpen(&recordFile, path, mode ? (FSIZE_t)remain : 0);
+		open = DWT->CYCCNT - open;
+		if (res != FR_OK) {
+			break;
+		}
+		if (mode && (recordFile.sector == 0)) {
+			dmputs(d, " preallocated  no contiguous region\n");
+		}
+		while ((remain != 0) && (res == FR_OK)) {
+			UINT len = (remain < chunk) ? (UINT)remain : chunk;
+			UINT wlen;
+			uint32_t cycles;
+
+			cycles = DWT->CYCCNT;
+			res = RecordFileWrite(&recordFile, recordBuf, len, &wlen);
+			cycles = DWT->CYCCNT - cycles;
+			if ((res == FR_OK) && (wlen != len)) {
+				res = FR_DENIED;	// disk full
+			}
+			total += cycles;
+			if (cycles > max) {
+				max = cycles;
+			}
+			remain -= len;
+		}
+		close = DWT->CYCCNT;
+		if (res == FR_OK) {
+			res = RecordFileClose(&recordFile);
+		} else {
+			RecordFileClose(&recordFile);
+		}
+		close = DWT->CYCCNT - close;
+		if (res == FR_OK) {
+			uint32_t rate = (uint32_t)(((uint64_t)kbytes * 1000000 * perUs) / (total + open + close));
+
+			max = (uint32_t)(((uint64_t)max * 10) / perUs);
+			dmprintf(d, " %s %6dKB/s max %6d.%01dus open %6dus close %6dus\n", mode ? "preallocated" : "f_write     ",
+					rate, max / 10, max % 10, open / perUs, close / perUs);
+		}
+	}
+	if (res != FR_OK) {
+		dmprintf(d, " %s write error (%d)", path, res);
+		return eResult_NG;
+	}
+
+	return eResult_OK;
+}
+
+#define RECORDCMD	{"Record path KB (chunk)", RecordTest},
+#else	//RECORD
+#define RECORDCMD
+#endif	//RECORD
+
+#ifdef MSDBENCH
+
+#include "ffconf.h"
+
+#ifndef USB_DISK_ENABLE
+#undef MSDBENCH
+#endif
+
+#endif	//MSDBENCH
+
+#ifdef MSDBENCH
+
+#include "ff.h"
+#include "diskio.h"
+#include "diskio_cache.h"
+#include "fsl_usb_disk.h"
+
+#define BENCHMAXBLOCK 4096
+#define BENCHMAXKB 65536
+#define BENCHSAMPLES 512
+
+#if (BENCHMAXBLOCK + BENCHSAMPLES * 4) > WORKBUFSIZE
+#error "BENCHMAXBLOCK and BENCHSAMPLES exceed WORKBUFSIZE"
+#endif
+
+static FIL benchFile;	// too large for the monitor task stack
+static uint8_t *const benchBuf = (uint8_t *)workBuf;
+static uint32_t *const benchSample = &workBuf[BENCHMAXBLOCK / sizeof(uint32_t)];
+
+static int BenchCompare(const void *a, const void *b)
+{
+	uint32_t x = *(const uint32_t *)a;
+	uint32_t y = *(const uint32_t *)b;
+
+	return (x > y) - (x < y);
+}
+
+/* timed f_read/f_write calls of one block, random: f_lseek to a block boundary first (timed too) */
+static FRESULT BenchPhase(eDebugMonitorInterface d, uint8_t *name, int write, int random, uint32_t block, uint32_t blocks)
+{
+	uint32_t perUs = SystemCoreClock / 1000000;
+	uint32_t seed = 1;
+	uint32_t pick = 7;
+	uint64_t total = 0;
+	uint32_t max = 0;
+	uint32_t n;
+	usb_host_fatfs_transfer_stat_t usb;
+	FRESULT res;
+
+	/* from the drive, nothing left over from the previous phase */
+	disk_ioctl(benchFile.obj.fs->pdrv, CTRL_SYNC, NULL);
+#if ((defined DISK_CACHE_ENABLE) && (DISK_CACHE_ENABLE))
+	DiskCache_Invalidate(benchFile.obj.fs->pdrv);
+#endif
+	res = f_lseek(&benchFile, 0);
+	USB_HostMsdTransferGetStat(&usb, 1);
+	for (uint32_t i = 0; (i < blocks) && (res == FR_OK); ++i) {
+		uint32_t cycles;
+		UINT len = 0;
+
+		cycles = DWT->CYCCNT;
+		if (random) {
+			seed = seed * 1103515245 + 12345;
+			res = f_lseek(&benchFile, (FSIZE_t)((seed >> 8) % blocks) * block);
+		}
+		if (res == FR_OK) {
+			res = write ? f_write(&benchFile, benchBuf, block, &len) : f_read(&benchFile, benchBuf, block, &len);
+		}
+		cycles = DWT->CYCCNT - cycles;
+		if ((res == FR_OK) && (len != block)) {
+			res = FR_DENIED;	// disk full
+		}
+		total += cycles;
+		if (cycles > max) {
+			max = cycles;
+		}
+		/* reservoir sampling, any number of calls is represented by BENCHSAMPLES */
+		if (i < BENCHSAMPLES) {
+			benchSample[i] = cycles;
+		} else {
+			pick = pick * 1103515245 + 12345;
+			if (((pick >> 8) % (i + 1)) < BENCHSAMPLES) {
+				benchSample[(pick >> 8) % BENCHSAMPLES] = cycles;
+			}
+		}
+	}
+	if (write && (res == FR_OK)) {
+		/* the merged writes still in the bounce buffer belong to this phase */
+		uint32_t cycles = DWT->CYCCNT;
+
+		res = f_sync(&benchFile);
+		total += DWT->CYCCNT - cycles;
+	}
+	if (res != FR_OK) {
+		return res;
+	}
+	USB_HostMsdTransferGetStat(&usb, 0);
+
+	n = (blocks < BENCHSAMPLES) ? blocks : BENCHSAMPLES;
+	qsort(benchSample, n, sizeof(benchSample[0]), BenchCompare);
+	{
+		uint32_t rate = (uint32_t)(((uint64_t)blocks * block * 1000000 / 1024 * perUs) / total);
+		uint32_t p50 = (uint32_t)(((uint64_t)benchSample[(n - 1) * 50 / 100] * 10) / perUs);
+		uint32_t p99 = (uint32_t)(((uint64_t)benchSample[(n - 1) * 99 / 100] * 10) / perUs);
+		uint64_t usbCycles = usb.readCycles + usb.writeCycles;
+		uint32_t usbCall, fsCall;
+
+		max = (uint32_t)(((uint64_t)max * 10) / perUs);
+		dmprintf(d, "\n %s %6dKB/s p50 %6d.%01dus p99 %6d.%01dus max %7d.%01dus", name, rate,
+				p50 / 10, p50 % 10, p99 / 10, p99 % 10, max / 10, max % 10);
+		/* read10/write10 time against what FatFs, the cache and the bounce copies add */
+		usbCall = (uint32_t)((usbCycles * 10) / blocks / perUs);
+		fsCall = (uint32_t)(((total - ((usbCycles < total) ? usbCycles : total)) * 10) / blocks / perUs);
+		dmprintf(d, "\n             usb %6d.%01dus/call fatfs %6d.%01dus/call %d read10 %d write10",
+				usbCall / 10, usbCall % 10, fsCall / 10, fsCall % 10, usb.readCommands, usb.writeCommands);
+	}
+
+	return FR_OK;
+}
+
+static eResult MsdBench(eDebugMonitorInterface d, uint8_t *cmd, uint8_t ofs)
+{
+	uint8_t *path = &cmd[ofs];
+	uint8_t *arg;
+	uint32_t kbytes = 0;
+	uint32_t block = 0;
+	uint32_t blocks;
+	FRESULT res;
+
+	while (*path == ' ') path++;
+	arg = strchr(path, ' ');
+	if (arg != NULL) {
+		*arg++ = 0;
+		kbytes = strtoul(arg, (char **)&arg, 10);
+		block = strtoul(arg, NULL, 10);
+	}
+	/* one drive per lun of the device */
+	if ((path[0] < ('0' + USBDISK)) || (path[0] >= ('0' + USBDISK + USB_HostMsdGetLunCount())) || (path[1] != ':') ||
+		(kbytes == 0) || (kbytes > BENCHMAXKB) ||
+		(block == 0) || (block > BENCHMAXBLOCK) || (((uint64_t)kbytes * 1024) < block)) {
+		dmprintf(d, " usage>Bench %c-%c:path KB(1-%d) block(1-%d), the file is overwritten", '0' + USBDISK,
+				'0' + USBDISK + USB_HostMsdGetLunCount() - 1, BENCHMAXKB, BENCHMAXBLOCK);
+		return eResult_NG;
+	}
+	blocks = (uint32_t)(((uint64_t)kbytes * 1024) / block);
+	for (uint32_t i = 0; i < block; ++i) {
+		benchBuf[i] = (uint8_t)i;
+	}
+
+	res = f_open(&benchFile, path, FA_READ | FA_WRITE | FA_CREATE_ALWAYS);
+	if (res != FR_OK) {
+		dmprintf(d, " %s open error (%d)", path, res);
+		return eResult_NG;
+	}
+	dmprintf(d, " %d x %dB", blocks, block);
+	/* the sequential write grows the file, the random phases work inside it */
+	res = BenchPhase(d, "seq  write", 1, 0, block, blocks);
+	if (res == FR_OK) {
+		res = BenchPhase(d, "seq  read ", 0, 0, block, blocks);
+	}
+	if (res == FR_OK) {
+		res = BenchPhase(d, "rand write", 1, 1, block, blocks);
+	}
+	if (res == FR_OK) {
+		res = BenchPhase(d, "rand read ", 0, 1, block, blocks);
+	}
+	f_close(&benchFile);
+	if (res != FR_OK) {
+		dmprintf(d, "\n %s error (%d)", path, res);
+		return eResult_NG;
+	}
+
+	return eResult_OK;
+}
+
+#define MSDBENCHCMD	{"Bench path KB block", MsdBench},
+#else	//MSDBENCH
+#define MSDBENCHCMD
+#endif	//MSDBENCH
+
 static eResult Help(eDebugMonitorInterface d, uint8_t *cmd, uint8_t ofs);
 
 #define HELPCMD	{"Help", Help},{"?", Help}
@@ -681,6 +2002,21 @@ static CommandList_t commandList[] = {
 	MEMORYDUMPCMD
 	DIRECTORYCMD
 	DIRCMD
+	COPYCMD
+	MIDILATENCYCMD
+	LOGSTATCMD
+	APPSTATCMD
+	XFERPOOLCMD
+	TOPCMD
+	TRACESAVECMD
+	LOWPOWERCMD
+	DISKCACHECMD
+	FASTMOUNTCMD
+	DIRINDEXCMD
+	FASTSEEKCMD
+	FSBENCHCMD
+	RECORDCMD
+	MSDBENCHCMD
 	HELPCMD
 };
 
@@ -25,5 +25,6 @@ int dmcheck(eDebugMonitorInterface d);		// 1:monitor active, 0:monitor un-active
 void DebugMonitor_entry(eDebugMonitorInterface d, uint8_t c, uint8_t echo);
 
 #include "DebugMonitorLog.h"
+#include "DebugMonitorBinLog.h"
 
 #endif /* DEBUGMONITOR_H_ */
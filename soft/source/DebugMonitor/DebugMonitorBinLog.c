@@ -0,0 +1,96 @@
+/*
+ * DebugMonitorBinLog.c
+ *
+ *  Created on: 2026/10/18
+ *      Author: M.Akino
+ */
+
+#include <stddef.h>
+#include "DebugMonitor.h"
+#include "DebugMonitorBinLog.h"
+
+/*
+ * Deferred log record
+ */
+typedef struct {
+	const uint8_t *fmt;		// NULL:free or not yet committed
+	uint32_t arg[DMLOG_ARGS];
+	uint8_t d;
+} dmlog_t;
+
+static dmlog_t dmlogRing[DMLOG_RECORDS];
+static uint32_t dmlogWpos = 0;	// reserved by producers
+static uint32_t dmlogRpos = 0;	// consumed by DebugMonitor_idleBinLog()
+static uint32_t dmlogDrop = 0;
+
+int dmlog_put(eDebugMonitorInterface d, const uint8_t *fmt, uint32_t a0, uint32_t a1, uint32_t a2, uint32_t a3)
+{
+	uint32_t w = __atomic_load_n(&dmlogWpos, __ATOMIC_RELAXED);
+	uint32_t r;
+	dmlog_t *p;
+
+	do {
+		r = __atomic_load_n(&dmlogRpos, __ATOMIC_ACQUIRE);
+		if ((w - r) >= DMLOG_RECORDS) {
+			__atomic_fetch_add(&dmlogDrop, 1, __ATOMIC_RELAXED);
+			return 0;
+		}
+	} while (!__atomic_compare_exchange_n(&dmlogWpos, &w, w + 1, 1, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED));
+
+	p = &dmlogRing[w & (DMLOG_RECORDS - 1)];
+	p->arg[0] = a0;
+	p->arg[1] = a1;
+	p->arg[2] = a2;
+	p->arg[3] = a3;
+	p->d = d;
+	__atomic_store_n(&p->fmt, fmt, __ATOMIC_RELEASE);	// commit
+	// the consumer may have caught up with this record after the reservation and stopped at it (or found the
+	// ring empty): decide on its position after the commit, r from before the CAS would lose that wakeup
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);	// the commit before the reload, against the consumer's rpos-then-fmt
+	if (__atomic_load_n(&dmlogRpos, __ATOMIC_ACQUIRE) == w) {
+		dmlog_wakeup();
+	}
+
+	return 1;
+}
+
+__attribute__((weak)) void dmlog_wakeup(void)
+{
+	return;
+}
+
+uint32_t dmlog_dropped(void)
+{
+	return __atomic_load_n(&dmlogDrop, __ATOMIC_RELAXED);
+}
+
+int DebugMonitor_pendingBinLog(void)
+{
+	return __atomic_load_n(&dmlogWpos, __ATOMIC_ACQUIRE) != dmlogRpos;
+}
+
+void DebugMonitor_idleBinLog(void)
+{
+	uint32_t r = dmlogRpos;	// single consumer
+
+	while (r != __atomic_load_n(&dmlogWpos, __ATOMIC_ACQUIRE)) {
+		dmlog_t *p = &dmlogRing[r & (DMLOG_RECORDS - 1)];
+		const uint8_t *fmt = __atomic_load_n(&p->fmt, __ATOMIC_ACQUIRE);
+		uint32_t arg[DMLOG_ARGS];
+		uint8_t d;
+
+		if (fmt == NULL) {
+			break;	// reserved, not yet committed
+		}
+		for (int i = 0; i < DMLOG_ARGS; ++i) {
+			arg[i] = p->arg[i];
+		}
+		d = p->d;
+		__atomic_store_n(&p->fmt, NULL, __ATOMIC_RELAXED);
+		__atomic_store_n(&dmlogRpos, ++r, __ATOMIC_RELEASE);	// free the slot before slow output
+
+		dmprintf(d, (uint8_t *)fmt, arg[0], arg[1], arg[2], arg[3]);
+	}
+
+	return;
+}
@@ -0,0 +1,33 @@
+/*
+ * DebugMonitorBinLog.h
+ *
+ *  Created on: 2026/10/18
+ *      Author: M.Akino
+ */
+
+#ifndef DEBUGMONITORBINLOG_H_
+#define DEBUGMONITORBINLOG_H_
+
+#include <stdint.h>
+
+#define DMLOG_RECORDS (64)	// power of 2
+#define DMLOG_ARGS (4)
+#define DMLOG_FLUSH_INTERVAL_MS (5)
+
+/*
+ * Deferred log
+ *  record fmt pointer and up to 4 integer arguments, formatted later by DebugMonitor_idleBinLog().
+ *  fmt must be a string literal (it is referenced, not copied) and
+ *  arguments must be int sized (no %s of temporary buffer, no 64bit, no float).
+ */
+#define dmlog(d, fmt, ...) dmlog_(d, fmt, ##__VA_ARGS__, 0, 0, 0, 0)
+#define dmlog_(d, fmt, a0, a1, a2, a3, ...) \
+	dmlog_put((d), (const uint8_t *)(fmt), (uint32_t)(a0), (uint32_t)(a1), (uint32_t)(a2), (uint32_t)(a3))
+
+int dmlog_put(eDebugMonitorInterface d, const uint8_t *fmt, uint32_t a0, uint32_t a1, uint32_t a2, uint32_t a3);	// lock-free, 1:recorded, 0:dropped
+uint32_t dmlog_dropped(void);	// number of dropped records
+void dmlog_wakeup(void);	// weak, called from dmlog_put() when the ring was empty, wake the consumer task
+int DebugMonitor_pendingBinLog(void);	// 1:records waiting for DebugMonitor_idleBinLog()
+void DebugMonitor_idleBinLog(void);	// format and output recorded logs
+
+#endif /* DEBUGMONITORBINLOG_H_ */
@@ -5,7 +5,10 @@
  *      Author: M.Akino
  */
 
+#include <string.h>
 #include "fsl_debug_console.h"
+#include "FreeRTOS.h"
+#include "task.h"
 #include "DebugMonitor.h"
 #include "DebugMonitorLog.h"
 #include "../mylib/circure.h"
@@ -15,11 +18,45 @@
 static uint8_t rxbuf[BUFFERSIZE] = {0};
 static circure_t rxccr = {0,0,BUFFERSIZE,rxbuf};
 
+static DebugMonitorLogStat_t txstat = {0};
+
+/* fsl_debug_console.c, queue to the interrupt driven serial manager tx ring buffer */
+extern int DbgConsole_SendDataReliable(uint8_t *ch, size_t size);
+
 void DebugMonitor_putsLog(uint8_t *str, uint8_t n)
 {
-	while (n--) {
-		PUTCHAR(*str++);	// blocking !
+	TickType_t tick = xTaskGetTickCount();
+	int ret = DbgConsole_SendDataReliable(str, n);	// waits only while tx buffer is full
+
+	tick = xTaskGetTickCount() - tick;
+	taskENTER_CRITICAL();
+	txstat.chunks++;
+	if (ret > 0) {
+		txstat.bytes += ret;
+	}
+	if (ret != n) {
+		txstat.errors += n - (ret > 0 ? ret : 0);
+	}
+	if (tick) {
+		txstat.stalls++;
+		txstat.stallTicks += tick;
+		if (tick > txstat.maxStallTicks) {
+			txstat.maxStallTicks = tick;
+		}
+	}
+	taskEXIT_CRITICAL();
+
+	return;
+}
+
+void DebugMonitor_statLog(DebugMonitorLogStat_t *stat, uint8_t reset)
+{
+	taskENTER_CRITICAL();
+	*stat = txstat;
+	if (reset) {
+		memset(&txstat, 0, sizeof(txstat));
 	}
+	taskEXIT_CRITICAL();
 
 	return;
 }
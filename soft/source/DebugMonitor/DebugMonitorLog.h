@@ -10,7 +10,17 @@
 
 #include <stdint.h>
 
-void DebugMonitor_putsLog(uint8_t *str, uint8_t n);	// blocking
+typedef struct {
+	uint32_t chunks;		// DebugMonitor_putsLog() calls
+	uint32_t bytes;			// queued bytes
+	uint32_t stalls;		// calls blocked by tx buffer full
+	uint32_t stallTicks;	// total blocked time [tick]
+	uint32_t maxStallTicks;	// worst blocked time [tick]
+	uint32_t errors;		// bytes not queued
+} DebugMonitorLogStat_t;
+
+void DebugMonitor_putsLog(uint8_t *str, uint8_t n);	// non-blocking (blocking while tx buffer full)
+void DebugMonitor_statLog(DebugMonitorLogStat_t *stat, uint8_t reset);
 int DebugMonitor_getcLog(void);	// blocking
 void DebugMonitor_entryLog(uint8_t c);	// blocking
 void DebugMonitor_idleLog(void);	// blocking
@@ -48,7 +48,7 @@
 #endif
 
 #define configUSE_PREEMPTION 1
-#define configUSE_TICKLESS_IDLE 0
+/* configUSE_TICKLESS_IDLE is selected by low_power.h, see the end of this file */
 #define configCPU_CLOCK_HZ (SystemCoreClock)
 #define configTICK_RATE_HZ ((TickType_t)1000)
 #define configMAX_PRIORITIES (18)
@@ -75,10 +75,60 @@
 #define configINCLUDE_FREERTOS_TASK_C_ADDITIONS_H 1
 
 /* Memory allocation related definitions. */
+#if (defined(STATIC_ALLOCATION_ENABLE) && (STATIC_ALLOCATION_ENABLE > 0U))
+/* Task control blocks, the application kernel objects and the USB stack OSA objects are statically allocated
+(project define STATIC_ALLOCATION_ENABLE=1). heap_4 still serves the USB device and class instances. */
+#define configSUPPORT_STATIC_ALLOCATION 1
+#define configKERNEL_PROVIDED_STATIC_MEMORY 1
+#else
 #define configSUPPORT_STATIC_ALLOCATION 0
+#endif
 #define configSUPPORT_DYNAMIC_ALLOCATION 1
+/* Task stacks come from the stack area in SRAM_ITC (pvPortMallocStack in app.c), in both builds. The heap sits in
+NonCacheable SRAM_DTC for the USB stack, the stacks never see DMA and SRAM_ITC is otherwise unused. */
+#define configSTACK_ALLOCATION_FROM_SEPARATE_HEAP 1
+
+/* task stack sizes in bytes, check the high-water marks with the DebugMonitor Top command */
+#define USB_HOST_TASK_STACK_SIZE (2000U)
+#define USB_HOST_APP_TASK_STACK_SIZE (2300U)
+#define USB_HOST_MIDI_TASK_STACK_SIZE (1500U)
+#define DEBUG_MONITOR_TASK_STACK_SIZE (2000U)
+#define STDIN_TASK_STACK_SIZE (2000U)
+#define FAST_MOUNT_TASK_STACK_SIZE (1200U)
+#define TASK_STACK_ALIGN(size) (((size) + 7U) & ~7U)
+#define APP_TASK_STACKS_SIZE                                                                                   \
+    (TASK_STACK_ALIGN(USB_HOST_TASK_STACK_SIZE) + TASK_STACK_ALIGN(USB_HOST_APP_TASK_STACK_SIZE) +             \
+     TASK_STACK_ALIGN(USB_HOST_MIDI_TASK_STACK_SIZE) + TASK_STACK_ALIGN(DEBUG_MONITOR_TASK_STACK_SIZE) +       \
+     TASK_STACK_ALIGN(STDIN_TASK_STACK_SIZE) + TASK_STACK_ALIGN(FAST_MOUNT_TASK_STACK_SIZE))
+#define APP_TASK_NUM (6U)
+/* idle and timer task stacks, the static build takes them from the kernel provided memory instead */
+#define KERNEL_TASK_STACKS_SIZE \
+    (TASK_STACK_ALIGN(configMINIMAL_STACK_SIZE * 4U) + TASK_STACK_ALIGN(configTIMER_TASK_STACK_DEPTH * 4U))
+/* the first 8 bytes sit at address 0 and are never handed out, no stack may look like NULL */
+#if (defined(STATIC_ALLOCATION_ENABLE) && (STATIC_ALLOCATION_ENABLE > 0U))
+#define TASK_STACK_AREA_SIZE (8U + APP_TASK_STACKS_SIZE)
+#else
+#define TASK_STACK_AREA_SIZE (8U + APP_TASK_STACKS_SIZE + KERNEL_TASK_STACKS_SIZE)
+#endif
+
+/* USB_STACK_FREERTOS_HEAP_SIZE is the heap this project ran with while heap_4 still held every task stack. The
+stacks moved out, so the heap shrinks by exactly those blocks (size plus the 8 byte heap_4 header) and keeps the
+free margin it had. The static build also drops the TCB blocks of the application, idle and timer tasks
+(sizeof(TCB_t) 112 + 8). The USB stack and kernel objects that moved into static memory stay as extra margin,
+compare with the minimum ever free heap of the DebugMonitor Top command before shrinking further. */
+#define TASK_STACK_HEAP_SIZE (APP_TASK_STACKS_SIZE + KERNEL_TASK_STACKS_SIZE + (APP_TASK_NUM + 2U) * 8U)
+#if (defined(STATIC_ALLOCATION_ENABLE) && (STATIC_ALLOCATION_ENABLE > 0U))
+#define TASK_TCB_HEAP_SIZE ((APP_TASK_NUM + 2U) * (112U + 8U))
+#else
+#define TASK_TCB_HEAP_SIZE (0U)
+#endif
+/* FatFs FF_USE_LFN 3 takes its LFN work buffer from the heap while a path is parsed, under the volume lock, so
+at most one per volume: FF_VOLUMES (3) * ((FF_MAX_LFN + 1) * 2 + MAXDIRB(FF_MAX_LFN) + heap_4 block header).
+The exFAT directory clear also tries a cluster buffer but falls back to the window buffer when the heap is short. */
+#define FATFS_LFN_HEAP_SIZE (3U * (1120U + 16U))
 #if defined(USB_STACK_FREERTOS_HEAP_SIZE) && (USB_STACK_FREERTOS_HEAP_SIZE > 0)
-#define configTOTAL_HEAP_SIZE ((size_t)(USB_STACK_FREERTOS_HEAP_SIZE))
+#define configTOTAL_HEAP_SIZE \
+    ((size_t)(USB_STACK_FREERTOS_HEAP_SIZE + FATFS_LFN_HEAP_SIZE - TASK_STACK_HEAP_SIZE - TASK_TCB_HEAP_SIZE))
 #else
 #define configTOTAL_HEAP_SIZE ((size_t)(30 * 1024))
 #endif
@@ -94,9 +144,12 @@
 #define configUSE_DAEMON_TASK_STARTUP_HOOK 0
 
 /* Run time and task stats gathering related definitions. */
-#define configGENERATE_RUN_TIME_STATS 0
+#define configGENERATE_RUN_TIME_STATS 1
 #define configUSE_TRACE_FACILITY 1
 #define configUSE_STATS_FORMATTING_FUNCTIONS 1
+/* Run time counter is the DWT cycle counter (core clock, 32bit wraps every 2^32 / SystemCoreClock sec) */
+#define portCONFIGURE_TIMER_FOR_RUN_TIME_STATS() CycleCounter_Init()
+#define portGET_RUN_TIME_COUNTER_VALUE() (DWT->CYCCNT)
 
 /* Co-routine related definitions. */
 #define configUSE_CO_ROUTINES 0
@@ -127,7 +180,7 @@
 #define INCLUDE_vTaskDelay 1
 #define INCLUDE_xTaskGetSchedulerState 1
 #define INCLUDE_xTaskGetCurrentTaskHandle 1
-#define INCLUDE_uxTaskGetStackHighWaterMark 0
+#define INCLUDE_uxTaskGetStackHighWaterMark 1
 #define INCLUDE_xTaskGetIdleTaskHandle 0
 #define INCLUDE_eTaskGetState 0
 #define INCLUDE_xEventGroupSetBitFromISR 1
@@ -143,6 +196,7 @@
     /* Clock manager provides in this variable system core clock frequency */
     #include <stdint.h>
     extern uint32_t SystemCoreClock;
+    #include "cycle_counter.h"
 #endif
 
 /* Interrupt nesting behaviour configuration. Cortex-M specific. */
@@ -176,4 +230,26 @@ standard names. */
 #define xPortPendSVHandler PendSV_Handler
 #define xPortSysTickHandler SysTick_Handler
 
+/* RAM trace recorder and tickless idle hooks (traceTASK_xxx) */
+#if defined(__ICCARM__)||defined(__CC_ARM)||defined(__GNUC__)
+#include "trace_recorder.h"
+#include "low_power.h"
+#endif
+#define traceTASK_SWITCHED_IN()          \
+    do                                   \
+    {                                    \
+        TRACE_TASK_SWITCHED_IN();        \
+        LOW_POWER_TASK_SWITCHED_IN();    \
+    } while (0)
+
+#if ((defined LOW_POWER_TICKLESS_ENABLE) && (LOW_POWER_TICKLESS_ENABLE))
+#define configUSE_TICKLESS_IDLE 1
+#define configEXPECTED_IDLE_TIME_BEFORE_SLEEP 2
+#define portSUPPRESS_TICKS_AND_SLEEP(xExpectedIdleTime) LowPowerSuppressTicksAndSleep(xExpectedIdleTime)
+#define configPRE_SLEEP_PROCESSING(xExpectedIdleTime) LowPowerPreSleep()
+#define configPOST_SLEEP_PROCESSING(xExpectedIdleTime) LowPowerPostSleep()
+#else
+#define configUSE_TICKLESS_IDLE 0
+#endif
+
 #endif /* FREERTOS_CONFIG_H */
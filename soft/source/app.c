@@ -9,11 +9,16 @@
 #include "usb_host_config.h"
 #include "usb_host.h"
 #include "fsl_device_registers.h"
+#include "cycle_counter.h"
 #include "usb_host_msd.h"
 #include "host_msd_fatfs.h"
 #include "host_keyboard_mouse.h"
 #include "host_keyboard.h"
 #include "host_midi.h"
+#include "host_midi_latency.h"
+#include "diskio_cache.h"
+#include "fast_mount.h"
+#include "dir_index.h"
 #include "fsl_common.h"
 #include "pin_mux.h"
 #include "clock_config.h"
@@ -29,9 +34,28 @@
 #endif
 
 #include "usb_phy.h"
+#include <cr_section_macros.h>
 /*******************************************************************************
  * Definitions
  ******************************************************************************/
+
+#if (defined(STATIC_ALLOCATION_ENABLE) && (STATIC_ALLOCATION_ENABLE > 0U))
+/*! @brief task control block in DTCM, the stack comes from the ITCM stack area */
+#define APP_TASK_MEMORY(name) __BSS(SRAM_DTC) static StaticTask_t name##Tcb
+#define APP_TASK_TCB(name)    (&name##Tcb)
+#else
+#define APP_TASK_TCB(name) (NULL)
+#endif
+
+/*! @brief app task dispatch entry, one per class instance */
+typedef struct _usb_host_app_dispatch
+{
+    void (*task)(void *param);      /*!< class task function */
+    void *param;                    /*!< class instance */
+    TaskHandle_t *owner;            /*!< task serving the class */
+    usb_host_app_class_stat_t stat; /*!< service statistics */
+} usb_host_app_dispatch_t;
+
 /*******************************************************************************
  * Prototypes
  ******************************************************************************/
@@ -59,8 +83,28 @@ static void USB_HostApplicationInit(void);
 
 static void USB_HostTask(void *param);
 
+/*!
+ * @brief class service task.
+ *
+ * Used for the app task and the midi task, each one receives only the event bits of the classes it owns.
+ */
 static void USB_HostApplicationTask(void *param);
 
+/*!
+ * @brief create a task from the static task memory or from the heap.
+ *
+ * @param handle  created task, may be NULL.
+ * @param stack   stack, NULL when dynamically allocated.
+ * @param tcb     task control block, NULL when dynamically allocated.
+ */
+static BaseType_t USB_HostAppTaskCreate(TaskFunction_t task,
+                                        const char *name,
+                                        uint32_t stackSize,
+                                        void *param,
+                                        UBaseType_t priority,
+                                        TaskHandle_t *handle,
+                                        StaticTask_t *tcb);
+
 extern void USB_HostClockInit(void);
 extern void USB_HostIsrEnable(void);
 extern void USB_HostTaskFn(void *param);
@@ -79,7 +123,33 @@ extern usb_host_keyboard_instance_t g_HostHidKeyboard;
 extern host_midi_instance_t g_HostMidi;
 usb_host_handle g_HostHandle;
 static TaskHandle_t g_HostAppHandle;
+static TaskHandle_t g_HostMidiHandle;
 static TaskHandle_t g_DebugHandle;
+#if ((defined FAST_MOUNT_ENABLE) && (FAST_MOUNT_ENABLE))
+static TaskHandle_t g_FastMountHandle;
+#endif
+
+#if (defined(STATIC_ALLOCATION_ENABLE) && (STATIC_ALLOCATION_ENABLE > 0U))
+APP_TASK_MEMORY(s_HostTask);
+APP_TASK_MEMORY(s_HostAppTask);
+APP_TASK_MEMORY(s_HostMidiTask);
+APP_TASK_MEMORY(s_DebugTask);
+APP_TASK_MEMORY(s_StdInTask);
+#if ((defined FAST_MOUNT_ENABLE) && (FAST_MOUNT_ENABLE))
+APP_TASK_MEMORY(s_FastMountTask);
+#endif
+#endif
+
+/*! @brief task stacks, sized in FreeRTOSConfig.h. SRAM_ITC is a TCM like SRAM_DTC and holds nothing else */
+__BSS(SRAM_ITC) static uint64_t s_TaskStackArea[TASK_STACK_AREA_SIZE / sizeof(uint64_t)];
+static uint32_t s_TaskStackUsed = 1U; /* in uint64_t, s_TaskStackArea[0] is at address 0 */
+
+/*! @brief class tasks and their serving task, indexed by usb_host_app_class_t */
+static usb_host_app_dispatch_t s_AppDispatch[kUSB_HostAppClassNumOf] = {
+    [kUSB_HostAppClassMsd]      = {USB_HostMsdTask, &g_MsdFatfsInstance, &g_HostAppHandle, {"msd"}},
+    [kUSB_HostAppClassKeyboard] = {USB_HostHidKeyboardTask, &g_HostHidKeyboard, &g_HostAppHandle, {"keyboard"}},
+    [kUSB_HostAppClassMidi]     = {USB_HostMidiTask, &g_HostMidi, &g_HostMidiHandle, {"midi"}},
+};
 
 /*******************************************************************************
  * Code
@@ -87,7 +157,9 @@ static TaskHandle_t g_DebugHandle;
 
 void USB_OTG1_IRQHandler(void)
 {
+    TRACE_ISR_ENTER(USB_OTG1_IRQn);
     USB_HostEhciIsrFunction(g_HostHandle);
+    TRACE_ISR_EXIT(USB_OTG1_IRQn);
 }
 
 void USB_HostClockInit(void)
@@ -207,9 +279,71 @@ static void USB_HostApplicationInit(void)
     }
     USB_HostIsrEnable();
 
+    /* cycle counter for the class service statistics */
+    CycleCounter_Init();
+
     usb_echo("host init done\r\n");
 }
 
+/*! @brief task stack allocation of the kernel (configSTACK_ALLOCATION_FROM_SEPARATE_HEAP) and the static build.
+ *  every task is created before the scheduler starts and none is ever deleted, so the area is handed out in order */
+void *pvPortMallocStack(size_t xSize)
+{
+    uint32_t words = (uint32_t)((xSize + sizeof(uint64_t) - 1U) / sizeof(uint64_t));
+    void *stack    = NULL;
+
+    vTaskSuspendAll();
+    if (words <= ((sizeof(s_TaskStackArea) / sizeof(uint64_t)) - s_TaskStackUsed))
+    {
+        stack = &s_TaskStackArea[s_TaskStackUsed];
+        s_TaskStackUsed += words;
+    }
+    (void)xTaskResumeAll();
+    return stack;
+}
+
+/*! @brief only reached when a task creation fails after its stack was taken, the stack is not reused */
+void vPortFreeStack(void *pv)
+{
+    (void)pv;
+}
+
+static BaseType_t USB_HostAppTaskCreate(TaskFunction_t task,
+                                        const char *name,
+                                        uint32_t stackSize,
+                                        void *param,
+                                        UBaseType_t priority,
+                                        TaskHandle_t *handle,
+                                        StaticTask_t *tcb)
+{
+    TaskHandle_t created;
+
+#if (defined(STATIC_ALLOCATION_ENABLE) && (STATIC_ALLOCATION_ENABLE > 0U))
+    StackType_t *stack = (StackType_t *)pvPortMallocStack(stackSize);
+
+    if (stack == NULL)
+    {
+        return pdFAIL;
+    }
+    created = xTaskCreateStatic(task, name, stackSize / sizeof(StackType_t), param, priority, stack, tcb);
+    if (created == NULL)
+    {
+        return pdFAIL;
+    }
+#else
+    (void)tcb;
+    if (xTaskCreate(task, name, stackSize / sizeof(StackType_t), param, priority, &created) != pdPASS)
+    {
+        return pdFAIL;
+    }
+#endif
+    if (handle != NULL)
+    {
+        *handle = created;
+    }
+    return pdPASS;
+}
+
 static void USB_HostTask(void *param)
 {
     while (1)
@@ -220,29 +354,108 @@ static void USB_HostTask(void *param)
 
 static void USB_HostApplicationTask(void *param)
 {
+    uint32_t events;
+
     while (1)
     {
-		ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
-        USB_HostMsdTask(&g_MsdFatfsInstance);
-        USB_HostHidKeyboardTask(&g_HostHidKeyboard);
-        USB_HostMidiTask(&g_HostMidi);
+        xTaskNotifyWait(0U, 0xFFFFFFFFU, &events, portMAX_DELAY);
+        for (uint32_t index = 0; index < kUSB_HostAppClassNumOf; ++index)
+        {
+            usb_host_app_dispatch_t *dispatch = &s_AppDispatch[index];
+            uint32_t cycles;
+
+            if (!(events & (1U << index)))
+            {
+                continue; /* only the classes with pending work */
+            }
+            cycles = DWT->CYCCNT;
+            dispatch->task(dispatch->param);
+            cycles = DWT->CYCCNT - cycles;
+
+            taskENTER_CRITICAL();
+            dispatch->stat.runs++;
+            dispatch->stat.totalCycles += cycles;
+            if (cycles > dispatch->stat.maxCycles)
+            {
+                dispatch->stat.maxCycles = cycles;
+            }
+            taskEXIT_CRITICAL();
+        }
     }
 }
 
-void USB_HostAppWakeUp(void)
+void USB_HostAppWakeUp(usb_host_app_class_t appClass)
+{
+	xTaskNotify(*s_AppDispatch[appClass].owner, 1U << appClass, eSetBits);
+}
+
+void USB_HostAppGetClassStat(usb_host_app_class_t appClass, usb_host_app_class_stat_t *stat, uint8_t reset)
 {
-	xTaskNotifyGive(g_HostAppHandle);
+    usb_host_app_dispatch_t *dispatch = &s_AppDispatch[appClass];
+
+    taskENTER_CRITICAL();
+    *stat = dispatch->stat;
+    if (reset)
+    {
+        dispatch->stat.runs        = 0;
+        dispatch->stat.totalCycles = 0;
+        dispatch->stat.maxCycles   = 0;
+    }
+    taskEXIT_CRITICAL();
 }
 
 static void DebugMonitorTask(void *param)
 {
 	while (1)
 	{
-		ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+		/* sleep until notified, poll only while a deferred log record is still being written */
+		ulTaskNotifyTake(pdTRUE, DebugMonitor_pendingBinLog() ? pdMS_TO_TICKS(DMLOG_FLUSH_INTERVAL_MS) : portMAX_DELAY);
 		DebugMonitor_idleLog();
+		DebugMonitor_idleBinLog();
 	}
 }
 
+void dmlog_wakeup(void)
+{
+	if (g_DebugHandle == NULL)
+	{
+		return;
+	}
+	if (__get_IPSR())
+	{
+		BaseType_t woken = pdFALSE;
+
+		vTaskNotifyGiveFromISR(g_DebugHandle, &woken);
+		portYIELD_FROM_ISR(woken);
+	}
+	else
+	{
+		xTaskNotifyGive(g_DebugHandle);
+	}
+}
+
+#if ((defined FAST_MOUNT_ENABLE) && (FAST_MOUNT_ENABLE))
+static void FastMountTask(void *param)
+{
+	while (1)
+	{
+		/* the free cluster counts of new volumes, below everything but the stdin task */
+		ulTaskNotifyTake(pdTRUE, FastMount_Pending() ? pdMS_TO_TICKS(FAST_MOUNT_RETRY_MS) : portMAX_DELAY);
+		while (FastMount_Count())
+		{
+		}
+	}
+}
+
+void FastMount_CountRequest(void)
+{
+	if (g_FastMountHandle != NULL)
+	{
+		xTaskNotifyGive(g_FastMountHandle);
+	}
+}
+#endif
+
 static void StdInTask(void *param)
 {
 	while (1)
@@ -299,22 +512,50 @@ int main(void)
     BOARD_InitBootPins();
     BOARD_InitBootClocks();
     BOARD_InitDebugConsole();
+#if ((defined MIDI_LATENCY_ENABLE) && (MIDI_LATENCY_ENABLE))
+    USB_HostMidiLatencyInit();
+#endif
+#if ((defined DISK_CACHE_ENABLE) && (DISK_CACHE_ENABLE))
+    DiskCache_Init();
+#endif
+#if ((defined FAST_MOUNT_ENABLE) && (FAST_MOUNT_ENABLE))
+    FastMount_Init();
+#endif
+#if ((defined DIR_INDEX_ENABLE) && (DIR_INDEX_ENABLE))
+    DirIndex_Init();
+#endif
 
     USB_HostApplicationInit();
 
-    if (xTaskCreate(USB_HostTask, "usb host task", 2000L / sizeof(portSTACK_TYPE), g_HostHandle, 4, NULL) != pdPASS)
+    if (USB_HostAppTaskCreate(USB_HostTask, "usb host task", USB_HOST_TASK_STACK_SIZE, g_HostHandle,
+                              USB_HOST_TASK_PRIORITY, NULL, APP_TASK_TCB(s_HostTask)) != pdPASS)
     {
         usb_echo("create host task error\r\n");
     }
-    if (xTaskCreate(USB_HostApplicationTask, "app task", 2300L / sizeof(portSTACK_TYPE), NULL, 3, &g_HostAppHandle) != pdPASS)
+    if (USB_HostAppTaskCreate(USB_HostApplicationTask, "app task", USB_HOST_APP_TASK_STACK_SIZE, NULL,
+                              USB_HOST_APP_TASK_PRIORITY, &g_HostAppHandle, APP_TASK_TCB(s_HostAppTask)) != pdPASS)
     {
         usb_echo("create app task error\r\n");
     }
-    if (xTaskCreate(DebugMonitorTask, "debug monitor task", 2000L / sizeof(portSTACK_TYPE), NULL, 1, &g_DebugHandle) != pdPASS)
+    if (USB_HostAppTaskCreate(USB_HostApplicationTask, "midi task", USB_HOST_MIDI_TASK_STACK_SIZE, NULL,
+                              USB_HOST_MIDI_TASK_PRIORITY, &g_HostMidiHandle, APP_TASK_TCB(s_HostMidiTask)) != pdPASS)
+    {
+        usb_echo("create midi task error\r\n");
+    }
+    if (USB_HostAppTaskCreate(DebugMonitorTask, "debug monitor task", DEBUG_MONITOR_TASK_STACK_SIZE, NULL, 1,
+                              &g_DebugHandle, APP_TASK_TCB(s_DebugTask)) != pdPASS)
     {
     	usb_echo("create debug task error\r\n");
     }
-    if (xTaskCreate(StdInTask, "stdin task", 2000L / sizeof(portSTACK_TYPE), NULL, 0, NULL) != pdPASS)
+#if ((defined FAST_MOUNT_ENABLE) && (FAST_MOUNT_ENABLE))
+    if (USB_HostAppTaskCreate(FastMountTask, "fast mount task", FAST_MOUNT_TASK_STACK_SIZE, NULL, 1,
+                              &g_FastMountHandle, APP_TASK_TCB(s_FastMountTask)) != pdPASS)
+    {
+    	usb_echo("create fast mount task error\r\n");
+    }
+#endif
+    if (USB_HostAppTaskCreate(StdInTask, "stdin task", STDIN_TASK_STACK_SIZE, NULL, 0, NULL,
+                              APP_TASK_TCB(s_StdInTask)) != pdPASS)
     {
     	usb_echo("create stdin task error\r\n");
     }
@@ -46,6 +46,44 @@
 #define USB_HOST_INTERRUPT_PRIORITY (3U)
 #endif
 
+/*! @brief priority of the app task serving msd and keyboard */
+#ifndef USB_HOST_APP_TASK_PRIORITY
+#define USB_HOST_APP_TASK_PRIORITY (3U)
+#endif
+
+/*! @brief priority of the usb host task, it completes the transfers of all classes */
+#ifndef USB_HOST_TASK_PRIORITY
+#define USB_HOST_TASK_PRIORITY (4U)
+#endif
+
+/*! @brief priority of the midi service task, above the app task so that disk and keyboard never delay midi.
+ *  not above the usb host task, a busy midi task must not starve the transfers that feed it */
+#ifndef USB_HOST_MIDI_TASK_PRIORITY
+#define USB_HOST_MIDI_TASK_PRIORITY (USB_HOST_TASK_PRIORITY)
+#endif
+#if (USB_HOST_MIDI_TASK_PRIORITY > USB_HOST_TASK_PRIORITY) || (USB_HOST_MIDI_TASK_PRIORITY <= USB_HOST_APP_TASK_PRIORITY)
+#error "USB_HOST_MIDI_TASK_PRIORITY must be above the app task and not above the usb host task"
+#endif
+
+/*! @brief host app class instances, each one owns one wake up event bit of its serving task */
+typedef enum _usb_host_app_class
+{
+    kUSB_HostAppClassMsd = 0,  /*!< mass storage */
+    kUSB_HostAppClassKeyboard, /*!< hid keyboard */
+    kUSB_HostAppClassMidi,     /*!< midi */
+
+    kUSB_HostAppClassNumOf,
+} usb_host_app_class_t;
+
+/*! @brief host app class service statistics */
+typedef struct _usb_host_app_class_stat
+{
+    const char *name;     /*!< class name */
+    uint32_t runs;        /*!< number of class task calls */
+    uint64_t totalCycles; /*!< total class task time */
+    uint32_t maxCycles;   /*!< worst class task time */
+} usb_host_app_class_stat_t;
+
 /*! @brief host app device attach/detach status */
 typedef enum _usb_host_app_state
 {
@@ -54,4 +92,29 @@ typedef enum _usb_host_app_state
     kStatus_DEV_Detached, /*!< device is detached */
 } usb_host_app_state_t;
 
+/*! @brief host handle, e.g. for USB_HostGetTransferPoolStat */
+extern usb_host_handle g_HostHandle;
+
+/*******************************************************************************
+ * API
+ ******************************************************************************/
+
+/*!
+ * @brief wake up the app task for one class.
+ *
+ * This function should be called from the class callbacks when the class task has work to do.
+ *
+ * @param appClass   the class instance, please reference to enumeration usb_host_app_class_t.
+ */
+extern void USB_HostAppWakeUp(usb_host_app_class_t appClass);
+
+/*!
+ * @brief get the class service statistics.
+ *
+ * @param appClass   the class instance.
+ * @param stat       statistics destination.
+ * @param reset      1: clear the statistics after the copy.
+ */
+extern void USB_HostAppGetClassStat(usb_host_app_class_t appClass, usb_host_app_class_stat_t *stat, uint8_t reset);
+
 #endif /* __APP_H__ */
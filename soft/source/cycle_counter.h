@@ -0,0 +1,30 @@
+/*
+ * cycle_counter.h
+ *
+ *  Created on: 2026/10/18
+ *      Author: M.Akino
+ */
+
+#ifndef CYCLE_COUNTER_H_
+#define CYCLE_COUNTER_H_
+
+#include "fsl_device_registers.h"
+
+/*******************************************************************************
+ * API
+ ******************************************************************************/
+
+/*!
+ * @brief start the DWT cycle counter, called by each user before its first DWT->CYCCNT read.
+ *
+ * The counter is free running and shared by the run time stats, the trace, the MIDI latency and the monitor,
+ * the users take differences only and never write it. The tickless idle (low_power.c) is the one writer, it adds
+ * the cycles the counter missed while WFI gated the core clock so the differences stay wall clock time.
+ */
+static inline void CycleCounter_Init(void)
+{
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+
+#endif /* CYCLE_COUNTER_H_ */
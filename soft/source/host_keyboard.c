@@ -22,8 +22,6 @@
  * Prototypes
  ******************************************************************************/
 
-void USB_HostAppWakeUp(void);
-
 /*!
  * @brief print key to uart.
  *
@@ -234,7 +232,7 @@ static void USB_HostHidInCallback(void *param, uint8_t *data, uint32_t dataLengt
             {
                 keyboardInstance->runState = kUSB_HostHidRunPrimeDataReceive; /* go to prime next receiving */
             }
-            USB_HostAppWakeUp();
+            USB_HostAppWakeUp(kUSB_HostAppClassKeyboard);
         }
     }
 }
@@ -271,7 +269,7 @@ static void USB_HostHidControlCallback(void *param, uint8_t *data, uint32_t data
 
     if (req)
     {
-        USB_HostAppWakeUp();
+        USB_HostAppWakeUp(kUSB_HostAppClassKeyboard);
     }
 }
 
@@ -538,7 +536,7 @@ usb_status_t USB_HostHidKeyboardEvent(usb_device_handle deviceHandle,
                         usb_echo("vid=0x%x ", infoValue);
                         USB_HostHelperGetPeripheralInformation(deviceHandle, kUSB_HostGetDeviceAddress, &infoValue);
                         usb_echo("address=%d\r\n", infoValue);
-                        USB_HostAppWakeUp();
+                        USB_HostAppWakeUp(kUSB_HostAppClassKeyboard);
                     }
                     else
                     {
@@ -557,7 +555,7 @@ usb_status_t USB_HostHidKeyboardEvent(usb_device_handle deviceHandle,
                 if (g_HostHidKeyboard.deviceState != kStatus_DEV_Idle)
                 {
                     g_HostHidKeyboard.deviceState = kStatus_DEV_Detached;
-                    USB_HostAppWakeUp();
+                    USB_HostAppWakeUp(kUSB_HostAppClassKeyboard);
                 }
             }
             break;
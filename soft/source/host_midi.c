@@ -23,8 +23,6 @@
  * Prototypes
  ******************************************************************************/
 
-void USB_HostAppWakeUp(void);
-
 /*******************************************************************************
  * Variables
  ******************************************************************************/
@@ -53,8 +51,14 @@ bool USB_HostMidiSendShortMessage(uint8_t cn, uint8_t sts, uint8_t dt1, uint8_t
 	sUsbMidi.sPacket.MIDI_1 = dt1;
 	sUsbMidi.sPacket.MIDI_2 = dt2;
 
+#if ((defined MIDI_LATENCY_ENABLE) && (MIDI_LATENCY_ENABLE))
+	if (!circure_remain(&ccrtxpacket))
+	{
+		MIDI_LATENCY_STAMP(g_HostMidi.outQueueStamp);
+	}
+#endif
 	ret = circure_putl(&ccrtxpacket, sUsbMidi.ulData);
-	USB_HostAppWakeUp();
+	USB_HostAppWakeUp(kUSB_HostAppClassMidi);
 
 	return ret;
 }
@@ -79,7 +83,7 @@ static void USB_HostMidiProcessBuffer(host_midi_instance_t *midiInstance)
 //			}
 			if (sUsbMidi.ulData && (sUsbMidi.sPacket.MIDI_0 < 0xf0))
 			{
-				dmprintf(eDebugMonitorInterface_Log, "\n%02x:%02x:%02x:%02x",
+				dmlog(eDebugMonitorInterface_Log, "\n%02x:%02x:%02x:%02x",
 						 sUsbMidi.sPacket.CN_CIN,
 						 sUsbMidi.sPacket.MIDI_0,
 						 sUsbMidi.sPacket.MIDI_1,
@@ -109,6 +113,7 @@ static void USB_HostMidiInCallback(void *param, uint8_t *data, uint32_t dataLeng
         {
             if (status == kStatus_USB_Success)
             {
+                MIDI_LATENCY_STAMP(midiInstance->inStamp);
                 midiInstance->runState = kUSB_HostMidiRunDataReceived; /* go to process data */
                 midiInstance->receiveCount = dataLength;
             }
@@ -117,7 +122,7 @@ static void USB_HostMidiInCallback(void *param, uint8_t *data, uint32_t dataLeng
                 midiInstance->runState = kUSB_HostMidiRunPrimeDataReceive; /* go to prime next receiving */
                 midiInstance->receiveCount = 0;
             }
-            USB_HostAppWakeUp();
+            USB_HostAppWakeUp(kUSB_HostAppClassMidi);
         }
     }
 }
@@ -138,8 +143,9 @@ static void USB_HostMidiOutCallback(void *param, uint8_t *data, uint32_t dataLen
 
     if (midiInstance->sendBusy)
     {
+        MIDI_LATENCY_ADD(kUSB_HostMidiLatencyOutComplete, midiInstance->outStamp);
     	midiInstance->sendBusy = 0;
-        USB_HostAppWakeUp();
+        USB_HostAppWakeUp(kUSB_HostAppClassMidi);
     }
 }
 
@@ -159,7 +165,7 @@ static void USB_HostMidiControlCallback(void *param, uint8_t *data, uint32_t dat
 
     if (req)
     {
-        USB_HostAppWakeUp();
+        USB_HostAppWakeUp(kUSB_HostAppClassMidi);
     }
 }
 
@@ -228,6 +234,9 @@ void USB_HostMidiTask(void *param)
             				*p++ = circure_getl(&ccrtxpacket);
             			}
             			midiInstance->sendBusy = 1;
+            			MIDI_LATENCY_ADD(kUSB_HostMidiLatencyOutQueue, midiInstance->outQueueStamp);
+            			MIDI_LATENCY_STAMP(midiInstance->outStamp);
+            			MIDI_LATENCY_STAMP(midiInstance->outQueueStamp); /* the rest waits from now on */
                         USB_HostMidiSend(midiInstance->classHandle, midiInstance->midiTxBuffer,
                                          count * 4, USB_HostMidiOutCallback, midiInstance);
         			}
@@ -272,7 +281,18 @@ void USB_HostMidiTask(void *param)
             break;
 
         case kUSB_HostMidiRunDataReceived: /* process received data and receive next data */
+#if ((defined MIDI_LATENCY_ENABLE) && (MIDI_LATENCY_ENABLE))
+        {
+            uint32_t stamp;
+
+            MIDI_LATENCY_ADD(kUSB_HostMidiLatencyInToTask, midiInstance->inStamp);
+            MIDI_LATENCY_STAMP(stamp);
+            USB_HostMidiProcessBuffer(midiInstance);
+            MIDI_LATENCY_ADD(kUSB_HostMidiLatencyProcess, stamp);
+        }
+#else
             USB_HostMidiProcessBuffer(midiInstance);
+#endif
 
             midiInstance->runWaitState = kUSB_HostMidiRunWaitDataReceived;
             midiInstance->runState     = kUSB_HostMidiRunIdle;
@@ -374,7 +394,7 @@ usb_status_t USB_HostMidiEvent(usb_device_handle deviceHandle,
                         usb_echo("vid=0x%x ", infoValue);
                         USB_HostHelperGetPeripheralInformation(deviceHandle, kUSB_HostGetDeviceAddress, &infoValue);
                         usb_echo("address=%d\r\n", infoValue);
-                        USB_HostAppWakeUp();
+                        USB_HostAppWakeUp(kUSB_HostAppClassMidi);
                     }
                     else
                     {
@@ -394,7 +414,7 @@ usb_status_t USB_HostMidiEvent(usb_device_handle deviceHandle,
                 {
                     g_HostMidi.deviceState = kStatus_DEV_Detached;
                     g_HostMidi.attachFlag = 0;
-                    USB_HostAppWakeUp();
+                    USB_HostAppWakeUp(kUSB_HostAppClassMidi);
                 }
             }
             break;
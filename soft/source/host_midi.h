@@ -8,6 +8,8 @@
 #ifndef HOST_MIDI_H_
 #define HOST_MIDI_H_
 
+#include "host_midi_latency.h"
+
 /*******************************************************************************
  * Definitions
  ******************************************************************************/
@@ -45,6 +47,11 @@ typedef struct _host_midi_instance
     uint8_t *midiTxBuffer;                      /*!< use to transfer data */
     uint8_t attachFlag;                         /*!< for send enable */
     uint8_t sendBusy;                           /*!< send busy */
+#if ((defined MIDI_LATENCY_ENABLE) && (MIDI_LATENCY_ENABLE))
+    uint32_t inStamp;                           /*!< cycle stamp of the last IN completion */
+    uint32_t outQueueStamp;                     /*!< cycle stamp of the oldest queued OUT packet */
+    uint32_t outStamp;                          /*!< cycle stamp of the last OUT submit */
+#endif
 } host_midi_instance_t;
 
 /*******************************************************************************
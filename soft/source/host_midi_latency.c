@@ -0,0 +1,92 @@
+/*
+ * host_midi_latency.c
+ *
+ *  Created on: 2026/10/18
+ *      Author: M.Akino
+ */
+
+#include <string.h>
+#include "fsl_common.h"
+#include "host_midi_latency.h"
+#include "cycle_counter.h"
+
+#if ((defined MIDI_LATENCY_ENABLE) && (MIDI_LATENCY_ENABLE))
+
+/*******************************************************************************
+ * Variables
+ ******************************************************************************/
+
+static usb_host_midi_latency_hist_t s_midiLatency[kUSB_HostMidiLatencyNumOf];
+
+static const char *s_midiLatencyName[kUSB_HostMidiLatencyNumOf] = {
+    "in->task",
+    "process",
+    "out queue",
+    "out done",
+};
+
+/*******************************************************************************
+ * Code
+ ******************************************************************************/
+
+static void USB_HostMidiLatencyClear(usb_host_midi_latency_hist_t *hist)
+{
+    memset(hist, 0, sizeof(*hist));
+    hist->min = 0xFFFFFFFFU;
+}
+
+void USB_HostMidiLatencyInit(void)
+{
+    CycleCounter_Init();
+
+    for (int i = 0; i < kUSB_HostMidiLatencyNumOf; i++)
+    {
+        USB_HostMidiLatencyClear(&s_midiLatency[i]);
+    }
+}
+
+void USB_HostMidiLatencyAdd(usb_host_midi_latency_stage_t stage, uint32_t cycles)
+{
+    usb_host_midi_latency_hist_t *hist = &s_midiLatency[stage];
+    uint32_t bucket = 32U - __CLZ(cycles); /* 0:0, 1:1, 2:2-3, 3:4-7, ... */
+    uint32_t primask;
+
+    if (bucket >= MIDI_LATENCY_BUCKETS)
+    {
+        bucket = MIDI_LATENCY_BUCKETS - 1U;
+    }
+
+    primask = DisableGlobalIRQ();
+    hist->count++;
+    hist->total += cycles;
+    if (cycles < hist->min)
+    {
+        hist->min = cycles;
+    }
+    if (cycles > hist->max)
+    {
+        hist->max = cycles;
+    }
+    hist->bucket[bucket]++;
+    EnableGlobalIRQ(primask);
+}
+
+void USB_HostMidiLatencyGet(usb_host_midi_latency_stage_t stage, usb_host_midi_latency_hist_t *hist, uint8_t reset)
+{
+    uint32_t primask;
+
+    primask = DisableGlobalIRQ();
+    *hist = s_midiLatency[stage];
+    if (reset)
+    {
+        USB_HostMidiLatencyClear(&s_midiLatency[stage]);
+    }
+    EnableGlobalIRQ(primask);
+}
+
+const char *USB_HostMidiLatencyName(usb_host_midi_latency_stage_t stage)
+{
+    return s_midiLatencyName[stage];
+}
+
+#endif /* MIDI_LATENCY_ENABLE */
@@ -0,0 +1,93 @@
+/*
+ * host_midi_latency.h
+ *
+ *  Created on: 2026/10/18
+ *      Author: M.Akino
+ */
+
+#ifndef HOST_MIDI_LATENCY_H_
+#define HOST_MIDI_LATENCY_H_
+
+#include <stdint.h>
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+
+/*! @brief 0 - latency instrumentation is compiled out; 1 - cycle stamps and histograms are collected */
+#define MIDI_LATENCY_ENABLE (1U)
+
+/*! @brief number of log2 buckets, bucket n counts [2^(n-1), 2^n) cycles, the last one collects the rest */
+#define MIDI_LATENCY_BUCKETS (24U)
+
+/*! @brief measured stages of the midi path */
+typedef enum _usb_host_midi_latency_stage
+{
+    kUSB_HostMidiLatencyInToTask = 0, /*!< IN completion callback -> midi task picks up the data */
+    kUSB_HostMidiLatencyProcess,      /*!< USB_HostMidiProcessBuffer execution time */
+    kUSB_HostMidiLatencyOutQueue,     /*!< first packet queued -> OUT transfer submitted */
+    kUSB_HostMidiLatencyOutComplete,  /*!< OUT transfer submitted -> OUT completion callback */
+
+    kUSB_HostMidiLatencyNumOf,
+} usb_host_midi_latency_stage_t;
+
+/*! @brief histogram of one stage, all values in core clock cycles */
+typedef struct _usb_host_midi_latency_hist
+{
+    uint32_t count;                          /*!< number of samples */
+    uint32_t min;                            /*!< minimum */
+    uint32_t max;                            /*!< maximum */
+    uint64_t total;                          /*!< sum, for average */
+    uint32_t bucket[MIDI_LATENCY_BUCKETS];   /*!< log2 buckets */
+} usb_host_midi_latency_hist_t;
+
+#if ((defined MIDI_LATENCY_ENABLE) && (MIDI_LATENCY_ENABLE))
+
+#include "fsl_device_registers.h"
+
+/*! @brief take a cycle stamp */
+#define MIDI_LATENCY_STAMP(var) ((var) = DWT->CYCCNT)
+/*! @brief add the cycles elapsed since the stamp to the stage histogram */
+#define MIDI_LATENCY_ADD(stage, var) USB_HostMidiLatencyAdd((stage), DWT->CYCCNT - (var))
+
+/*******************************************************************************
+ * API
+ ******************************************************************************/
+
+/*!
+ * @brief start the cycle counter and clear all histograms.
+ */
+extern void USB_HostMidiLatencyInit(void);
+
+/*!
+ * @brief add one sample.
+ *
+ * @param stage   measured stage.
+ * @param cycles  elapsed core clock cycles.
+ */
+extern void USB_HostMidiLatencyAdd(usb_host_midi_latency_stage_t stage, uint32_t cycles);
+
+/*!
+ * @brief take a snapshot of one histogram and optionally clear it.
+ *
+ * @param stage   measured stage.
+ * @param hist    snapshot destination.
+ * @param reset   1: clear the histogram after the snapshot.
+ */
+extern void USB_HostMidiLatencyGet(usb_host_midi_latency_stage_t stage, usb_host_midi_latency_hist_t *hist, uint8_t reset);
+
+/*!
+ * @brief get the stage name for display.
+ *
+ * @param stage   measured stage.
+ */
+extern const char *USB_HostMidiLatencyName(usb_host_midi_latency_stage_t stage);
+
+#else
+
+#define MIDI_LATENCY_STAMP(var)
+#define MIDI_LATENCY_ADD(stage, var)
+
+#endif /* MIDI_LATENCY_ENABLE */
+
+#endif /* HOST_MIDI_LATENCY_H_ */
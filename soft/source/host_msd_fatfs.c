@@ -13,7 +13,11 @@
 #include "host_msd_fatfs.h"
 #include "ff.h"
 #include "diskio.h"
+#include "diskio_cache.h"
+#include "fast_mount.h"
+#include "fsl_usb_disk.h"
 #include "fsl_device_registers.h"
+#include "cycle_counter.h"
 #include "app.h"
 
 /*******************************************************************************
@@ -23,15 +27,12 @@
 #if MSD_FATFS_THROUGHPUT_TEST_ENABLE
 #include "fsl_device_registers.h"
 #define THROUGHPUT_BUFFER_SIZE (64 * 1024) /* throughput test buffer */
-#define MCU_CORE_CLOCK         (120000000) /* mcu core clock, user need to configure it. */
 #endif                                     /* MSD_FATFS_THROUGHPUT_TEST_ENABLE */
 
 /*******************************************************************************
  * Prototypes
  ******************************************************************************/
 
-void USB_HostAppWakeUp(void);
-
 /*!
  * @brief host msd control transfer callback.
  *
@@ -98,12 +99,14 @@ static void USB_HostMsdFatfsTest(usb_host_msd_fatfs_instance_t *msdFatfsInstance
 extern usb_host_class_handle g_UsbFatfsClassHandle;
 
 usb_host_msd_fatfs_instance_t g_MsdFatfsInstance; /* global msd fatfs instance */
-static FATFS fatfs;
+static FATFS fatfs[USB_HOST_FATFS_LUNS]; /* drive USBDISK + n for lun n */
 /* control transfer on-going state. It should set to 1 when start control transfer, it is set to 0 in the callback */
 volatile uint8_t controlIng;
 /* control transfer callback status */
 volatile usb_status_t controlStatus;
 
+USB_DMA_NONINIT_DATA_ALIGN(USB_DATA_ALIGN_SIZE)
+static uint8_t maxLunBuffer[USB_DATA_ALIGN_SIZE]; /* get max lun response */
 #if MSD_FATFS_THROUGHPUT_TEST_ENABLE
 USB_DMA_NONINIT_DATA_ALIGN(USB_DATA_ALIGN_SIZE)
 static uint32_t testThroughputBuffer[THROUGHPUT_BUFFER_SIZE / 4]; /* the buffer for throughput test */
@@ -123,9 +126,17 @@ void USB_HostMsdControlCallback(void *param, uint8_t *data, uint32_t dataLength,
 
     if (msdFatfsInstance->runWaitState == kUSB_HostMsdRunWaitSetInterface) /* set interface finish */
     {
+        msdFatfsInstance->runWaitState = kUSB_HostMsdRunIdle;
+        msdFatfsInstance->runState     = kUSB_HostMsdRunGetMaxLun;
+        USB_HostAppWakeUp(kUSB_HostAppClassMsd);
+    }
+    else if (msdFatfsInstance->runWaitState == kUSB_HostMsdRunWaitGetMaxLun) /* get max lun finish */
+    {
+        /* a single lun device may stall the request */
+        USB_HostMsdSetLunCount((status == kStatus_USB_Success) ? (uint8_t)(maxLunBuffer[0] + 1U) : 1U);
         msdFatfsInstance->runWaitState = kUSB_HostMsdRunIdle;
         msdFatfsInstance->runState     = kUSB_HostMsdRunMassStorageTest;
-        USB_HostAppWakeUp();
+        USB_HostAppWakeUp(kUSB_HostAppClassMsd);
     }
     controlIng    = 0;
     controlStatus = status;
@@ -141,6 +152,7 @@ static void USB_HostMsdFatfsTestDone(void)
 static void USB_HostMsdFatfsThroughputTest(usb_host_msd_fatfs_instance_t *msdFatfsInstance)
 {
     uint64_t totalTime;
+    uint32_t startTime;
     FRESULT fatfsCode;
     FIL file;
     uint32_t resultSize;
@@ -155,7 +167,8 @@ static void USB_HostMsdFatfsThroughputTest(usb_host_msd_fatfs_instance_t *msdFat
     }
 
     usb_echo("............................fatfs test.....................\r\n");
-    CoreDebug->DEMCR |= (1 << CoreDebug_DEMCR_TRCENA_Pos);
+    /* CYCCNT is free running and shared (trace, latency, monitor), only differences are taken */
+    CycleCounter_Init();
 
     for (testSize = 0; testSize < (THROUGHPUT_BUFFER_SIZE / 4); ++testSize)
     {
@@ -163,7 +176,11 @@ static void USB_HostMsdFatfsThroughputTest(usb_host_msd_fatfs_instance_t *msdFat
     }
 
     sprintf(test_file_name, "%c:", USBDISK + '0');
-    fatfsCode = f_mount(&fatfs, test_file_name, 1);
+#if ((defined FAST_MOUNT_ENABLE) && (FAST_MOUNT_ENABLE))
+    fatfsCode = FastMount_Mount(&fatfs[0], test_file_name);
+#else
+    fatfsCode = f_mount(&fatfs[0], test_file_name, 1);
+#endif
     if (fatfsCode)
     {
         usb_echo("fatfs mount error\r\n");
@@ -198,8 +215,7 @@ static void USB_HostMsdFatfsThroughputTest(usb_host_msd_fatfs_instance_t *msdFat
                 USB_HostMsdFatfsTestDone();
                 return;
             }
-            DWT->CYCCNT = 0;
-            DWT->CTRL |= (1 << DWT_CTRL_CYCCNTENA_Pos);
+            startTime = DWT->CYCCNT;
             fatfsCode = f_write(&file, testThroughputBuffer, THROUGHPUT_BUFFER_SIZE, &resultSize);
             if (fatfsCode)
             {
@@ -208,13 +224,12 @@ static void USB_HostMsdFatfsThroughputTest(usb_host_msd_fatfs_instance_t *msdFat
                 USB_HostMsdFatfsTestDone();
                 return;
             }
-            totalTime += DWT->CYCCNT;
-            DWT->CTRL &= ~(1 << DWT_CTRL_CYCCNTENA_Pos);
+            totalTime += DWT->CYCCNT - startTime;
             testSize -= THROUGHPUT_BUFFER_SIZE;
         }
         testSize = testSizeArray[testIndex];
         usb_echo("    write %dKB data the speed is %d KB/s\r\n", testSize,
-                 (uint32_t)((uint64_t)testSize * (uint64_t)MCU_CORE_CLOCK / (uint64_t)totalTime));
+                 (uint32_t)((uint64_t)testSize * (uint64_t)SystemCoreClock / (uint64_t)totalTime));
 
         fatfsCode = f_lseek(&file, 0);
         if (fatfsCode)
@@ -231,8 +246,7 @@ static void USB_HostMsdFatfsThroughputTest(usb_host_msd_fatfs_instance_t *msdFat
                 USB_HostMsdFatfsTestDone();
                 return;
             }
-            DWT->CYCCNT = 0;
-            DWT->CTRL |= (1 << DWT_CTRL_CYCCNTENA_Pos);
+            startTime = DWT->CYCCNT;
             fatfsCode = f_read(&file, testThroughputBuffer, THROUGHPUT_BUFFER_SIZE, &resultSize);
             if (fatfsCode)
             {
@@ -241,13 +255,12 @@ static void USB_HostMsdFatfsThroughputTest(usb_host_msd_fatfs_instance_t *msdFat
                 USB_HostMsdFatfsTestDone();
                 return;
             }
-            totalTime += DWT->CYCCNT;
-            DWT->CTRL &= ~(1 << DWT_CTRL_CYCCNTENA_Pos);
+            totalTime += DWT->CYCCNT - startTime;
             testSize -= THROUGHPUT_BUFFER_SIZE;
         }
         testSize = testSizeArray[testIndex];
         usb_echo("    read %dKB data the speed is %d KB/s\r\n", testSize,
-                 (uint32_t)((uint64_t)testSize * (uint64_t)MCU_CORE_CLOCK / (uint64_t)totalTime));
+                 (uint32_t)((uint64_t)testSize * (uint64_t)SystemCoreClock / (uint64_t)totalTime));
 
         fatfsCode = f_close(&file);
         if (fatfsCode)
@@ -270,7 +283,7 @@ static void USB_HostMsdFatfsDisplayFileInfo(FILINFO *fileInfo)
      * hide, 'S' - system) */
     usb_echo("    %s - %c%c%c - %s - %dBytes - %d-%d-%d %d:%d:%d\r\n", (fileInfo->fattrib & AM_DIR) ? "dir" : "fil",
              (fileInfo->fattrib & AM_RDO) ? 'R' : '_', (fileInfo->fattrib & AM_HID) ? 'H' : '_',
-             (fileInfo->fattrib & AM_SYS) ? 'S' : '_', fileName, (fileInfo->fsize),
+             (fileInfo->fattrib & AM_SYS) ? 'S' : '_', fileName, (uint32_t)(fileInfo->fsize),
              (uint32_t)((fileInfo->fdate >> 9) + 1980) /* year */,
              (uint32_t)((fileInfo->fdate >> 5) & 0x000Fu) /* month */, (uint32_t)(fileInfo->fdate & 0x001Fu) /* day */,
              (uint32_t)((fileInfo->ftime >> 11) & 0x0000001Fu) /* hour */,
@@ -351,16 +364,48 @@ static void USB_HostMsdFatfsTest(usb_host_msd_fatfs_instance_t *msdFatfsInstance
 
     usb_echo("............................fatfs test.....................\r\n");
 
-    usb_echo("fatfs mount as logiacal driver %d......", USBDISK);
-    sprintf((char *)&driverNumberBuffer[0], "%c:", USBDISK + '0');
-    fatfsCode = f_mount(&fatfs, (char const *)&driverNumberBuffer[0], 0);
-    if (fatfsCode)
+    /* every logical unit is its own volume, a card reader slot without media must not hide the others */
+    driverNumberBuffer[0] = 0U;
+    for (index = 0U; index < USB_HostMsdGetLunCount(); index++)
+    {
+        uint8_t lunDriverBuffer[3];
+        uint32_t perUs = SystemCoreClock / 1000000U;
+        uint32_t mountUs;
+        DIR dir;
+
+        usb_echo("fatfs mount lun %d as logiacal driver %d......", index, USBDISK + index);
+        sprintf((char *)&lunDriverBuffer[0], "%c:", (int)(USBDISK + index + '0'));
+#if ((defined FAST_MOUNT_ENABLE) && (FAST_MOUNT_ENABLE))
+        fatfsCode = FastMount_Mount(&fatfs[index], (char const *)&lunDriverBuffer[0]);
+#else
+        fatfsCode = f_mount(&fatfs[index], (char const *)&lunDriverBuffer[0], 0);
+#endif
+        if (fatfsCode)
+        {
+            usb_echo("error %d\r\n", fatfsCode);
+            continue;
+        }
+        mountUs = (DWT->CYCCNT - msdFatfsInstance->attachCycles) / perUs;
+        /* the volume is usable once the root directory can be read, the free space may still be counted */
+        fatfsCode = f_opendir(&dir, (char const *)&lunDriverBuffer[0]);
+        if (fatfsCode == FR_OK)
+        {
+            fatfsCode = f_readdir(&dir, &fileInfo);
+            f_closedir(&dir);
+        }
+        usb_echo("mounted %uus, first file access %uus after enumeration%s\r\n", mountUs,
+                 (DWT->CYCCNT - msdFatfsInstance->attachCycles) / perUs, (fatfsCode == FR_OK) ? "" : " (error)");
+        if ((fatfsCode == FR_OK) && (driverNumberBuffer[0] == 0U))
+        {
+            /* the first readable volume becomes the current drive */
+            memcpy(driverNumberBuffer, lunDriverBuffer, sizeof(driverNumberBuffer));
+        }
+    }
+    if (driverNumberBuffer[0] == 0U)
     {
-        usb_echo("error\r\n");
         USB_HostMsdFatfsTestDone();
         return;
     }
-    usb_echo("success\r\n");
 
 #if (FF_FS_RPATH >= 2)
     fatfsCode = f_chdrive((char const *)&driverNumberBuffer[0]);
@@ -401,10 +446,14 @@ static void USB_HostMsdFatfsTest(usb_host_msd_fatfs_instance_t *msdFatfsInstance
     {
         usb_echo("    FAT type = FAT16\r\n");
     }
-    else
+    else if (fs->fs_type == FS_FAT32)
     {
         usb_echo("    FAT type = FAT32\r\n");
     }
+    else
+    {
+        usb_echo("    FAT type = exFAT\r\n");
+    }
     usb_echo("    bytes per cluster = %d; number of clusters=%lu \r\n", fs->csize * 512, fs->n_fatent - 2);
     usb_echo("    The free size: %dKB, the total size:%dKB\r\n", (freeClusterNumber * (fs->csize) / 2),
              ((fs->n_fatent - 2) * (fs->csize) / 2));
@@ -819,11 +868,26 @@ static void USB_HostMsdFatfsTest(usb_host_msd_fatfs_instance_t *msdFatfsInstance
 
 #endif /* MSD_FATFS_THROUGHPUT_TEST_ENABLE */
 
+#if ((defined USB_HOST_FATFS_WRITE_COALESCE_ENABLE) && (USB_HOST_FATFS_WRITE_COALESCE_ENABLE))
+void USB_HostMsdFlushRequest(void)
+{
+    /* the timer service task stack is too small for a write10, flush in the msd task */
+    USB_HostAppWakeUp(kUSB_HostAppClassMsd);
+}
+#endif
+
 void USB_HostMsdTask(void *arg)
 {
     usb_status_t status;
     usb_host_msd_fatfs_instance_t *msdFatfsInstance = (usb_host_msd_fatfs_instance_t *)arg;
 
+#if ((defined USB_HOST_FATFS_WRITE_COALESCE_ENABLE) && (USB_HOST_FATFS_WRITE_COALESCE_ENABLE))
+    /* a failed flush is kept per logical unit and returned by the next f_sync or write on it */
+    for (uint8_t lun = 0U; lun < USB_HostMsdGetLunCount(); lun++)
+    {
+        (void)USB_HostMsdFlushDisk(USBDISK + lun);
+    }
+#endif
     if (msdFatfsInstance->deviceState != msdFatfsInstance->prevDeviceState)
     {
         msdFatfsInstance->prevDeviceState = msdFatfsInstance->deviceState;
@@ -836,6 +900,14 @@ void USB_HostMsdTask(void *arg)
                 status                = USB_HostMsdInit(msdFatfsInstance->deviceHandle,
                                          &msdFatfsInstance->classHandle); /* msd class initialization */
                 g_UsbFatfsClassHandle = msdFatfsInstance->classHandle;
+                msdFatfsInstance->attachCycles = DWT->CYCCNT;
+                USB_HostMsdSetLunCount(1U); /* until get max lun answers */
+#if ((defined DISK_CACHE_ENABLE) && (DISK_CACHE_ENABLE))
+                for (uint8_t lun = 0U; lun < USB_HOST_FATFS_LUNS; lun++)
+                {
+                    DiskCache_Invalidate(USBDISK + lun); /* nothing cached belongs to the new media */
+                }
+#endif
                 if (status != kStatus_USB_Success)
                 {
                     usb_echo("usb host msd init fail\r\n");
@@ -851,11 +923,21 @@ void USB_HostMsdTask(void *arg)
                                   msdFatfsInstance->classHandle); /* msd class de-initialization */
                 msdFatfsInstance->classHandle = NULL;
 
+                for (uint8_t lun = 0U; lun < USB_HOST_FATFS_LUNS; lun++)
                 {
                     uint8_t driverNumberBuffer[3];
 
-                    sprintf((char *)&driverNumberBuffer[0], "%c:", USBDISK + '0');
-                	f_unmount((char const *)&driverNumberBuffer[0]);
+                    sprintf((char *)&driverNumberBuffer[0], "%c:", USBDISK + lun + '0');
+#if ((defined FAST_MOUNT_ENABLE) && (FAST_MOUNT_ENABLE))
+                    FastMount_Cancel((char const *)&driverNumberBuffer[0]);
+#endif
+                    /* the monitor or a recorder may be inside FatFs, f_unmount deletes the mutex they hold */
+                    ff_volume_close(USBDISK + lun);
+                    f_unmount((char const *)&driverNumberBuffer[0]);
+                    ff_volume_open(USBDISK + lun);
+#if ((defined DISK_CACHE_ENABLE) && (DISK_CACHE_ENABLE))
+                    DiskCache_Invalidate(USBDISK + lun);
+#endif
                 }
 
                 usb_echo("mass storage device detached\r\n");
@@ -883,6 +965,20 @@ void USB_HostMsdTask(void *arg)
             }
             break;
 
+        case kUSB_HostMsdRunGetMaxLun: /* get the number of logical units */
+            msdFatfsInstance->runState     = kUSB_HostMsdRunIdle;
+            msdFatfsInstance->runWaitState = kUSB_HostMsdRunWaitGetMaxLun;
+            status = USB_HostMsdGetMaxLun(msdFatfsInstance->classHandle, maxLunBuffer, USB_HostMsdControlCallback,
+                                          msdFatfsInstance);
+            if (status != kStatus_USB_Success)
+            {
+                usb_echo("get max lun fail\r\n");
+                msdFatfsInstance->runWaitState = kUSB_HostMsdRunIdle;
+                msdFatfsInstance->runState     = kUSB_HostMsdRunMassStorageTest;
+                USB_HostAppWakeUp(kUSB_HostAppClassMsd);
+            }
+            break;
+
         case kUSB_HostMsdRunMassStorageTest: /* set interface succeed */
 #if ((defined MSD_FATFS_THROUGHPUT_TEST_ENABLE) && (MSD_FATFS_THROUGHPUT_TEST_ENABLE))
             USB_HostMsdFatfsThroughputTest(msdFatfsInstance); /* test throughput */
@@ -969,7 +1065,7 @@ usb_status_t USB_HostMsdEvent(usb_device_handle deviceHandle,
                         usb_echo("vid=0x%x ", infoValue);
                         USB_HostHelperGetPeripheralInformation(deviceHandle, kUSB_HostGetDeviceAddress, &infoValue);
                         usb_echo("address=%d\r\n", infoValue);
-                        USB_HostAppWakeUp();
+                        USB_HostAppWakeUp(kUSB_HostAppClassMsd);
                     }
                     else
                     {
@@ -989,7 +1085,7 @@ usb_status_t USB_HostMsdEvent(usb_device_handle deviceHandle,
                 if (g_MsdFatfsInstance.deviceState != kStatus_DEV_Idle)
                 {
                     g_MsdFatfsInstance.deviceState = kStatus_DEV_Detached;
-                    USB_HostAppWakeUp();
+                    USB_HostAppWakeUp(kUSB_HostAppClassMsd);
                 }
             }
             break;
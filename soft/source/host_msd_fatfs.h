@@ -25,6 +25,8 @@ typedef enum _usb_host_msd_run_state
     kUSB_HostMsdRunIdle = 0,         /*!< idle */
     kUSB_HostMsdRunSetInterface,     /*!< execute set interface code */
     kUSB_HostMsdRunWaitSetInterface, /*!< wait set interface done */
+    kUSB_HostMsdRunGetMaxLun,        /*!< execute get max lun code */
+    kUSB_HostMsdRunWaitGetMaxLun,    /*!< wait get max lun done */
     kUSB_HostMsdRunMassStorageTest   /*!< execute mass storage test code */
 } usb_host_msd_run_state_t;
 
@@ -39,6 +41,7 @@ typedef struct _usb_host_msd_fatfs_instance
     uint8_t deviceState;                        /*!< device attach/detach status */
     uint8_t runWaitState; /*!< application wait status, go to next run status when the wait status success */
     uint8_t runState;     /*!< application run status */
+    uint32_t attachCycles; /*!< DWT->CYCCNT when the enumeration was done */
 } usb_host_msd_fatfs_instance_t;
 
 /*******************************************************************************
@@ -0,0 +1,162 @@
+/*
+ * low_power.c
+ *
+ *  Created on: 2026/10/18
+ *      Author: M.Akino
+ */
+
+#include <string.h>
+#include "fsl_common.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "low_power.h"
+
+#if ((defined LOW_POWER_TICKLESS_ENABLE) && (LOW_POWER_TICKLESS_ENABLE))
+
+/*
+ * The sleep is a plain WFI in RUN mode (CCM CLPCR LPM=RUN), clocks and PLLs keep running,
+ * so an interrupt resumes the core within a few cycles and the MIDI path sees no extra latency
+ * beyond the tick restore in vPortSuppressTicksAndSleep. One sleep lasts at most
+ * 0xFFFFFF / (SystemCoreClock / configTICK_RATE_HZ) ticks (33ms at 500MHz) because of the 24bit SysTick.
+ *
+ * DWT->CYCCNT stops while WFI gates the core clock, SysTick does not. The run time stats, the trace
+ * timestamps and the MIDI latency all difference DWT->CYCCNT, so LowPowerPostSleep adds the SysTick
+ * decrements (core clock, see portNVIC_SYSTICK_CLK_BIT_CONFIG) the counter missed. One sleep ends at
+ * the first SysTick underflow, so at most one reload is between the two samples.
+ */
+
+/*******************************************************************************
+ * Prototypes
+ ******************************************************************************/
+
+/* FreeRTOS port implementation, wrapped by portSUPPRESS_TICKS_AND_SLEEP */
+extern void vPortSuppressTicksAndSleep(TickType_t xExpectedIdleTime);
+
+/*******************************************************************************
+ * Variables
+ ******************************************************************************/
+
+static low_power_stat_t s_lowPowerStat;
+static TickType_t s_lowPowerResetTick;
+static volatile uint8_t s_lowPowerWakePending;
+static uint8_t s_lowPowerWakeSource;
+static uint32_t s_lowPowerWakeCycles;
+static uint32_t s_lowPowerSleepCycles;
+static uint32_t s_lowPowerSleepSysTick;
+
+static const char *s_lowPowerWakeName[kLowPowerWakeNumOf] = {
+    "tick",
+    "usb",
+    "uart",
+    "other",
+};
+
+/*******************************************************************************
+ * Code
+ ******************************************************************************/
+
+void LowPowerSuppressTicksAndSleep(uint32_t expectedIdleTime)
+{
+    TickType_t tick = xTaskGetTickCount();
+
+    /* a wakeup that did not lead to a task switch, e.g. a tick with nothing to do */
+    s_lowPowerWakePending = 0U;
+
+    vPortSuppressTicksAndSleep(expectedIdleTime);
+
+    /* vPortSuppressTicksAndSleep steps the tick count by the whole periods slept */
+    s_lowPowerStat.sleeps++;
+    s_lowPowerStat.sleptTicks += xTaskGetTickCount() - tick;
+}
+
+void LowPowerPreSleep(void)
+{
+    /* vPortSuppressTicksAndSleep has loaded and started SysTick for the whole idle time */
+    s_lowPowerSleepSysTick = SysTick->VAL;
+    s_lowPowerSleepCycles  = DWT->CYCCNT;
+}
+
+void LowPowerPostSleep(void)
+{
+    /* interrupts are still masked, the one that ended WFI is pending */
+    uint32_t icsr    = SCB->ICSR;
+    uint32_t sysTick = SysTick->VAL;
+    uint32_t cycles  = DWT->CYCCNT - s_lowPowerSleepCycles;
+    uint32_t elapsed;
+    int32_t irq = (int32_t)((icsr & SCB_ICSR_VECTPENDING_Msk) >> SCB_ICSR_VECTPENDING_Pos) - 16;
+    uint8_t source;
+
+    /* SysTick->CTRL COUNTFLAG clears on read and the port still needs it, PENDSTSET tells the underflow */
+    if (icsr & SCB_ICSR_PENDSTSET_Msk)
+    {
+        elapsed = s_lowPowerSleepSysTick + (SysTick->LOAD + 1U) - sysTick;
+    }
+    else
+    {
+        elapsed = s_lowPowerSleepSysTick - sysTick;
+    }
+    if (elapsed > cycles)
+    {
+        DWT->CYCCNT += elapsed - cycles;
+    }
+
+    if (irq == SysTick_IRQn)
+    {
+        source = kLowPowerWakeTick;
+    }
+    else if (irq == USB_OTG1_IRQn)
+    {
+        source = kLowPowerWakeUsb;
+    }
+    else if (irq == LPUART1_IRQn)
+    {
+        source = kLowPowerWakeUart;
+    }
+    else
+    {
+        source = kLowPowerWakeOther;
+    }
+    s_lowPowerStat.wake[source].wakes++;
+    s_lowPowerWakeSource  = source;
+    s_lowPowerWakeCycles  = DWT->CYCCNT;
+    s_lowPowerWakePending = 1U;
+}
+
+void LowPowerTaskSwitchedIn(void)
+{
+    if (s_lowPowerWakePending)
+    {
+        low_power_wake_stat_t *wake = &s_lowPowerStat.wake[s_lowPowerWakeSource];
+        uint32_t cycles             = DWT->CYCCNT - s_lowPowerWakeCycles;
+
+        s_lowPowerWakePending = 0U;
+        wake->activations++;
+        wake->totalCycles += cycles;
+        if (cycles > wake->maxCycles)
+        {
+            wake->maxCycles = cycles;
+        }
+    }
+}
+
+void LowPowerGetStat(low_power_stat_t *stat, uint8_t reset)
+{
+    TickType_t now = xTaskGetTickCount();
+
+    taskENTER_CRITICAL();
+    *stat              = s_lowPowerStat;
+    stat->elapsedTicks = now - s_lowPowerResetTick;
+    if (reset)
+    {
+        memset(&s_lowPowerStat, 0, sizeof(s_lowPowerStat));
+        s_lowPowerResetTick = now;
+    }
+    taskEXIT_CRITICAL();
+}
+
+const char *LowPowerWakeName(low_power_wake_source_t source)
+{
+    return s_lowPowerWakeName[source];
+}
+
+#endif /* LOW_POWER_TICKLESS_ENABLE */
@@ -0,0 +1,102 @@
+/*
+ * low_power.h
+ *
+ *  Created on: 2026/10/18
+ *      Author: M.Akino
+ */
+
+#ifndef LOW_POWER_H_
+#define LOW_POWER_H_
+
+#include <stdint.h>
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+
+/*! @brief 0 - the 1kHz tick always runs; 1 - tickless idle, the core sleeps (WFI) until the next timer or interrupt */
+#define LOW_POWER_TICKLESS_ENABLE (1U)
+
+/*! @brief interrupt that ended a tickless sleep */
+typedef enum _low_power_wake_source
+{
+    kLowPowerWakeTick = 0, /*!< SysTick, next FreeRTOS timer or delay expired */
+    kLowPowerWakeUsb,      /*!< USB_OTG1 */
+    kLowPowerWakeUart,     /*!< LPUART1, debug console byte */
+    kLowPowerWakeOther,    /*!< any other interrupt */
+
+    kLowPowerWakeNumOf,
+} low_power_wake_source_t;
+
+/*! @brief wakeups from one source */
+typedef struct _low_power_wake_stat
+{
+    uint32_t wakes;         /*!< number of wakeups */
+    uint32_t activations;   /*!< wakeups that switched to a task */
+    uint64_t totalCycles;   /*!< sum of wakeup -> task switch cycles */
+    uint32_t maxCycles;     /*!< worst wakeup -> task switch cycles */
+} low_power_wake_stat_t;
+
+/*! @brief tickless idle statistics */
+typedef struct _low_power_stat
+{
+    uint32_t sleeps;        /*!< tickless sleeps entered */
+    uint32_t sleptTicks;    /*!< whole tick periods spent sleeping */
+    uint32_t elapsedTicks;  /*!< ticks since the last reset */
+    low_power_wake_stat_t wake[kLowPowerWakeNumOf];
+} low_power_stat_t;
+
+#if ((defined LOW_POWER_TICKLESS_ENABLE) && (LOW_POWER_TICKLESS_ENABLE))
+
+/* FreeRTOS task switch hook, wired to traceTASK_SWITCHED_IN in FreeRTOSConfig.h */
+#define LOW_POWER_TASK_SWITCHED_IN() LowPowerTaskSwitchedIn()
+
+/*******************************************************************************
+ * API
+ ******************************************************************************/
+
+/*!
+ * @brief idle task tickless sleep, wraps vPortSuppressTicksAndSleep to count the slept ticks.
+ *
+ * @param expectedIdleTime  ticks until the next task is due.
+ */
+extern void LowPowerSuppressTicksAndSleep(uint32_t expectedIdleTime);
+
+/*!
+ * @brief called right before WFI with interrupts masked, records DWT->CYCCNT and SysTick.
+ */
+extern void LowPowerPreSleep(void);
+
+/*!
+ * @brief called right after WFI with interrupts still masked, advances DWT->CYCCNT by the cycles it missed
+ *        while the core clock was gated and records the wakeup source and time.
+ */
+extern void LowPowerPostSleep(void);
+
+/*!
+ * @brief called on every task switch, measures wakeup -> first task switch.
+ */
+extern void LowPowerTaskSwitchedIn(void);
+
+/*!
+ * @brief take a snapshot of the statistics and optionally clear them.
+ *
+ * @param stat    snapshot destination.
+ * @param reset   1: clear the statistics after the snapshot.
+ */
+extern void LowPowerGetStat(low_power_stat_t *stat, uint8_t reset);
+
+/*!
+ * @brief get the wakeup source name for display.
+ *
+ * @param source  wakeup source.
+ */
+extern const char *LowPowerWakeName(low_power_wake_source_t source);
+
+#else
+
+#define LOW_POWER_TASK_SWITCHED_IN()
+
+#endif /* LOW_POWER_TICKLESS_ENABLE */
+
+#endif /* LOW_POWER_H_ */
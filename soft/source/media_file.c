@@ -0,0 +1,144 @@
+/*
+ * media_file.c
+ *
+ *  Created on: 2026/10/18
+ *      Author: M.Akino
+ */
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "media_file.h"
+
+#if !FF_USE_FASTSEEK
+#error "media_file needs FF_USE_FASTSEEK 1 in ffconf.h"
+#endif
+
+/*
+ * f_lseek normally follows the FAT chain from the file top (backward) or the current cluster (forward),
+ * which costs a FAT sector read per 128 clusters passed. With a cluster link map (CLMT) it finds the
+ * cluster from the fragment list without touching the disk. The maps come from a fixed pool so a player
+ * cannot run the heap out, and a file that does not fit just falls back to the chain walk.
+ */
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+
+/* single statistics update, the same critical section as MediaFileGetStat */
+#define MEDIA_FILE_STAT(statement) \
+    do                             \
+    {                              \
+        taskENTER_CRITICAL();      \
+        statement;                 \
+        taskEXIT_CRITICAL();       \
+    } while (0)
+
+/*******************************************************************************
+ * Variables
+ ******************************************************************************/
+
+static DWORD s_mediaFileClmt[MEDIA_FILE_CLMT_SLOTS][MEDIA_FILE_CLMT_SIZE];
+static uint8_t s_mediaFileClmtUsed[MEDIA_FILE_CLMT_SLOTS];
+static media_file_stat_t s_mediaFileStat;
+
+/*******************************************************************************
+ * Code
+ ******************************************************************************/
+
+static DWORD *MediaFileClmtAlloc(void)
+{
+    DWORD *clmt = NULL;
+
+    taskENTER_CRITICAL();
+    for (uint32_t i = 0; i < MEDIA_FILE_CLMT_SLOTS; i++)
+    {
+        if (!s_mediaFileClmtUsed[i])
+        {
+            s_mediaFileClmtUsed[i] = 1U;
+            s_mediaFileStat.inUse++;
+            clmt = s_mediaFileClmt[i];
+            break;
+        }
+    }
+    taskEXIT_CRITICAL();
+    return clmt;
+}
+
+static void MediaFileClmtFree(DWORD *clmt)
+{
+    uint32_t i = (uint32_t)(clmt - &s_mediaFileClmt[0][0]) / MEDIA_FILE_CLMT_SIZE;
+
+    taskENTER_CRITICAL();
+    s_mediaFileClmtUsed[i] = 0U;
+    s_mediaFileStat.inUse--;
+    taskEXIT_CRITICAL();
+}
+
+FRESULT MediaFileOpen(media_file_t *file, const TCHAR *path)
+{
+    FRESULT res;
+
+    file->clmt = NULL;
+    res        = f_open(&file->fil, path, FA_READ);
+    if (res != FR_OK)
+    {
+        return res;
+    }
+    MEDIA_FILE_STAT(s_mediaFileStat.opens++);
+
+    file->clmt = MediaFileClmtAlloc();
+    if (file->clmt == NULL)
+    {
+        MEDIA_FILE_STAT(s_mediaFileStat.poolEmpty++);
+        return FR_OK;
+    }
+    file->clmt[0]   = MEDIA_FILE_CLMT_SIZE;
+    file->fil.cltbl = file->clmt;
+    res             = f_lseek(&file->fil, CREATE_LINKMAP);
+    if (res == FR_OK)
+    {
+        MEDIA_FILE_STAT(s_mediaFileStat.fastSeek++);
+    }
+    else
+    {
+        /* FR_NOT_ENOUGH_CORE: too many fragments, keep the file open without fast seek */
+        if (res == FR_NOT_ENOUGH_CORE)
+        {
+            MEDIA_FILE_STAT(s_mediaFileStat.tooSmall++);
+        }
+        file->fil.cltbl = NULL;
+        MediaFileClmtFree(file->clmt);
+        file->clmt = NULL;
+        if (res != FR_NOT_ENOUGH_CORE)
+        {
+            f_close(&file->fil);
+            return res;
+        }
+    }
+    return FR_OK;
+}
+
+FRESULT MediaFileClose(media_file_t *file)
+{
+    FRESULT res = f_close(&file->fil);
+
+    if (file->clmt != NULL)
+    {
+        MediaFileClmtFree(file->clmt);
+        file->clmt = NULL;
+    }
+    return res;
+}
+
+uint32_t MediaFileFragments(const media_file_t *file)
+{
+    /* clmt[0] is the number of items used: 1 (size) + 2 per fragment + 1 (terminator) */
+    return (file->clmt != NULL) ? ((file->clmt[0] - 2U) / 2U) : 0U;
+}
+
+void MediaFileGetStat(media_file_stat_t *stat)
+{
+    taskENTER_CRITICAL();
+    *stat = s_mediaFileStat;
+    taskEXIT_CRITICAL();
+}
@@ -0,0 +1,78 @@
+/*
+ * media_file.h
+ *
+ *  Created on: 2026/10/18
+ *      Author: M.Akino
+ */
+
+#ifndef MEDIA_FILE_H_
+#define MEDIA_FILE_H_
+
+#include <stdint.h>
+#include "ff.h"
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+
+/*! @brief number of files that can hold a cluster link map at the same time */
+#define MEDIA_FILE_CLMT_SLOTS (4U)
+
+/*! @brief DWORDs per cluster link map, a file of up to (MEDIA_FILE_CLMT_SIZE - 2) / 2 fragments gets fast seek */
+#define MEDIA_FILE_CLMT_SIZE (64U)
+
+/*! @brief read-only media file (SMF, samples) opened with fast seek when a link map slot is free */
+typedef struct _media_file
+{
+    FIL fil;     /*!< use with f_read / f_lseek / f_tell */
+    DWORD *clmt; /*!< cluster link map, NULL: f_lseek walks the FAT chain */
+} media_file_t;
+
+/*! @brief link map pool statistics */
+typedef struct _media_file_stat
+{
+    uint32_t opens;     /*!< files opened */
+    uint32_t fastSeek;  /*!< opens that got a link map */
+    uint32_t poolEmpty; /*!< opens without a free slot */
+    uint32_t tooSmall;  /*!< opens with more fragments than MEDIA_FILE_CLMT_SIZE holds */
+    uint32_t inUse;     /*!< slots in use now */
+} media_file_stat_t;
+
+/*******************************************************************************
+ * API
+ ******************************************************************************/
+
+/*!
+ * @brief open a file for reading and build its cluster link map once.
+ *
+ * Without a free slot or with a too fragmented file the open still succeeds without fast seek.
+ *
+ * @param file    media file.
+ * @param path    file path.
+ * @return f_open result.
+ */
+extern FRESULT MediaFileOpen(media_file_t *file, const TCHAR *path);
+
+/*!
+ * @brief close the file and return its link map slot.
+ *
+ * @param file    media file.
+ * @return f_close result.
+ */
+extern FRESULT MediaFileClose(media_file_t *file);
+
+/*!
+ * @brief number of fragments of the file, 0 when it has no link map.
+ *
+ * @param file    media file.
+ */
+extern uint32_t MediaFileFragments(const media_file_t *file);
+
+/*!
+ * @brief take a snapshot of the pool statistics.
+ *
+ * @param stat    snapshot destination.
+ */
+extern void MediaFileGetStat(media_file_stat_t *stat);
+
+#endif /* MEDIA_FILE_H_ */
@@ -0,0 +1,215 @@
+/*
+ * record_file.c
+ *
+ *  Created on: 2026/10/18
+ *      Author: M.Akino
+ */
+
+#include <string.h>
+#include "FreeRTOS.h"
+#include "task.h"
+#include "record_file.h"
+#include "diskio.h"
+
+#if !FF_USE_EXPAND
+#error "record_file needs FF_USE_EXPAND 1 in ffconf.h"
+#endif
+#if FF_FS_TINY
+#error "record_file collects partial sectors in the FIL buffer, FF_FS_TINY must be 0"
+#endif
+
+/*
+ * A growing file costs a FAT walk and update for every new cluster and lands wherever the free space
+ * is. f_expand allocates the whole region at open, so the data sectors are known up front and the
+ * recording goes to them with disk_write like a raw partition. FatFs sees the file again only when the
+ * region is full or at close, where f_truncate gives the unused tail back. Until then the directory
+ * entry holds the preallocated size, after a power cut the file ends with the stale tail.
+ */
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+
+#if FF_FS_REENTRANT
+/* the raw writes are serialised with the FatFs calls on the same volume */
+#define RECORD_FILE_LOCK(fs) ff_mutex_take((fs)->ldrv)
+#define RECORD_FILE_UNLOCK(fs) ff_mutex_give((fs)->ldrv)
+#else
+#define RECORD_FILE_LOCK(fs) (1)
+#define RECORD_FILE_UNLOCK(fs)
+#endif
+
+/*******************************************************************************
+ * Variables
+ ******************************************************************************/
+
+static record_file_stat_t s_recordFileStat;
+
+/*******************************************************************************
+ * Code
+ ******************************************************************************/
+
+static FRESULT RecordFileRawWrite(record_file_t *file, const BYTE *buff, LBA_t sector, UINT count)
+{
+    FATFS *fs = file->fil.obj.fs;
+    DRESULT res;
+
+    if (!RECORD_FILE_LOCK(fs))
+    {
+        return FR_TIMEOUT;
+    }
+    res = disk_write(fs->pdrv, buff, file->sector + sector, count);
+    RECORD_FILE_UNLOCK(fs);
+    return (res == RES_OK) ? FR_OK : FR_DISK_ERR;
+}
+
+/* leave the raw path, FatFs takes over at the recorded length */
+static FRESULT RecordFileFinishRaw(record_file_t *file)
+{
+    UINT ofs    = (UINT)(file->written % FF_MAX_SS);
+    FRESULT res = FR_OK;
+
+    if (ofs != 0U)
+    {
+        memset(&file->fil.buf[ofs], 0, FF_MAX_SS - ofs);
+        res = RecordFileRawWrite(file, file->fil.buf, (LBA_t)(file->written / FF_MAX_SS), 1U);
+    }
+    file->sector = 0U;
+    if (res == FR_OK)
+    {
+        /* reloads the partial sector into the FIL buffer for f_write */
+        res = f_lseek(&file->fil, file->written);
+    }
+    return res;
+}
+
+FRESULT RecordFileOpen(record_file_t *file, const TCHAR *path, FSIZE_t size)
+{
+    FATFS *fs;
+    FRESULT res;
+
+    file->sector  = 0U;
+    file->size    = 0U;
+    file->written = 0U;
+    res           = f_open(&file->fil, path, FA_WRITE | FA_CREATE_ALWAYS);
+    if (res != FR_OK)
+    {
+        return res;
+    }
+    s_recordFileStat.opens++;
+
+    res = (size != 0U) ? f_expand(&file->fil, size, 1) : FR_DENIED;
+    if (res == FR_OK)
+    {
+        fs           = file->fil.obj.fs;
+        file->sector = fs->database + (LBA_t)fs->csize * (file->fil.obj.sclust - 2U);
+        file->size   = size;
+        s_recordFileStat.expanded++;
+    }
+    else if (res == FR_DENIED)
+    {
+        /* no contiguous region that large, record cluster by cluster */
+        s_recordFileStat.fallbacks++;
+    }
+    else
+    {
+        f_close(&file->fil);
+        return res;
+    }
+    return FR_OK;
+}
+
+FRESULT RecordFileWrite(record_file_t *file, const void *buff, UINT btw, UINT *bw)
+{
+    const BYTE *data = (const BYTE *)buff;
+    FRESULT res      = FR_OK;
+    UINT done        = 0U;
+
+    while ((res == FR_OK) && (done < btw))
+    {
+        UINT ofs = (UINT)(file->written % FF_MAX_SS);
+        FSIZE_t room;
+        UINT n;
+
+        if (file->sector == 0U)
+        {
+            res = f_write(&file->fil, &data[done], btw - done, &n);
+            file->written += n;
+            done += n;
+            break;
+        }
+        if (file->written >= file->size)
+        {
+            s_recordFileStat.overruns++;
+            res = RecordFileFinishRaw(file);
+            continue;
+        }
+
+        room = file->size - file->written;
+        if ((ofs == 0U) && ((btw - done) >= FF_MAX_SS) && (room >= FF_MAX_SS))
+        {
+            /* whole sectors straight from the caller's buffer */
+            UINT count = (btw - done) / FF_MAX_SS;
+
+            if (count > (room / FF_MAX_SS))
+            {
+                count = (UINT)(room / FF_MAX_SS);
+            }
+            n   = count * FF_MAX_SS;
+            res = RecordFileRawWrite(file, &data[done], (LBA_t)(file->written / FF_MAX_SS), count);
+        }
+        else
+        {
+            /* collect a partial sector in the FIL buffer, it is idle on the raw path */
+            n = FF_MAX_SS - ofs;
+            if (n > (btw - done))
+            {
+                n = btw - done;
+            }
+            if (n > room)
+            {
+                n = (UINT)room;
+            }
+            memcpy(&file->fil.buf[ofs], &data[done], n);
+            if ((ofs + n) == FF_MAX_SS)
+            {
+                res = RecordFileRawWrite(file, file->fil.buf, (LBA_t)(file->written / FF_MAX_SS), 1U);
+            }
+        }
+        if (res == FR_OK)
+        {
+            file->written += n;
+            done += n;
+        }
+    }
+    if (bw != NULL)
+    {
+        *bw = done;
+    }
+    return res;
+}
+
+FRESULT RecordFileClose(record_file_t *file)
+{
+    FRESULT res = FR_OK;
+    FRESULT closeRes;
+
+    if (file->sector != 0U)
+    {
+        res = RecordFileFinishRaw(file);
+        if (res == FR_OK)
+        {
+            /* give the unused part of the region back */
+            res = f_truncate(&file->fil);
+        }
+    }
+    closeRes = f_close(&file->fil);
+    return (res != FR_OK) ? res : closeRes;
+}
+
+void RecordFileGetStat(record_file_stat_t *stat)
+{
+    taskENTER_CRITICAL();
+    *stat = s_recordFileStat;
+    taskEXIT_CRITICAL();
+}
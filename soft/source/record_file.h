@@ -0,0 +1,78 @@
+/*
+ * record_file.h
+ *
+ *  Created on: 2026/10/18
+ *      Author: M.Akino
+ */
+
+#ifndef RECORD_FILE_H_
+#define RECORD_FILE_H_
+
+#include <stdint.h>
+#include "ff.h"
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+
+/*! @brief recording file (MIDI or audio capture) written into a preallocated contiguous region */
+typedef struct _record_file
+{
+    FIL fil;         /*!< do not use f_write while sector != 0 */
+    LBA_t sector;    /*!< first sector of the contiguous region, 0: f_write fallback */
+    FSIZE_t size;    /*!< preallocated bytes */
+    FSIZE_t written; /*!< bytes recorded */
+} record_file_t;
+
+/*! @brief recorder statistics */
+typedef struct _record_file_stat
+{
+    uint32_t opens;     /*!< files created */
+    uint32_t expanded;  /*!< creates that got a contiguous region */
+    uint32_t fallbacks; /*!< creates without a contiguous region, written with f_write */
+    uint32_t overruns;  /*!< files that outgrew the region and continued with f_write */
+} record_file_stat_t;
+
+/*******************************************************************************
+ * API
+ ******************************************************************************/
+
+/*!
+ * @brief create a file and allocate a contiguous region for it.
+ *
+ * Without a free contiguous region the create still succeeds and the data goes through f_write.
+ *
+ * @param file    recording file.
+ * @param path    file path.
+ * @param size    bytes to preallocate, the expected length of the recording.
+ * @return f_open result.
+ */
+extern FRESULT RecordFileOpen(record_file_t *file, const TCHAR *path, FSIZE_t size);
+
+/*!
+ * @brief append data. Whole sectors go straight to the drive, no FAT or directory update.
+ *
+ * @param file    recording file.
+ * @param buff    data to be written.
+ * @param btw     number of bytes to write.
+ * @param bw      number of bytes written, may be NULL.
+ * @return FR_OK or the disk error.
+ */
+extern FRESULT RecordFileWrite(record_file_t *file, const void *buff, UINT btw, UINT *bw);
+
+/*!
+ * @brief write the last partial sector, trim the file to the recorded length and close it.
+ *
+ * @param file    recording file.
+ * @return f_close result or the first error.
+ */
+extern FRESULT RecordFileClose(record_file_t *file);
+
+/*!
+ * @brief take a snapshot of the statistics.
+ *
+ * @param stat    snapshot destination.
+ */
+extern void RecordFileGetStat(record_file_stat_t *stat);
+
+#endif /* RECORD_FILE_H_ */
@@ -0,0 +1,89 @@
+/*
+ * trace_recorder.c
+ *
+ *  Created on: 2026/10/18
+ *      Author: M.Akino
+ */
+
+#include <string.h>
+#include "fsl_common.h"
+#include "trace_recorder.h"
+
+#if ((defined TRACE_RECORDER_ENABLE) && (TRACE_RECORDER_ENABLE))
+
+/*******************************************************************************
+ * Variables
+ ******************************************************************************/
+
+static trace_record_t s_traceRing[TRACE_RECORDS];
+static uint32_t s_traceWpos;          /* total records written */
+static volatile uint8_t s_traceEnable = 1U;
+
+/*******************************************************************************
+ * Code
+ ******************************************************************************/
+
+void TraceRecorderPut(uint8_t event, uint8_t arg8, uint16_t arg16)
+{
+    trace_record_t *rec;
+    uint32_t primask;
+
+    if (!s_traceEnable)
+    {
+        return;
+    }
+    primask = DisableGlobalIRQ();
+    rec         = &s_traceRing[s_traceWpos++ & (TRACE_RECORDS - 1U)];
+    rec->cycles = DWT->CYCCNT;
+    rec->event  = event;
+    rec->arg8   = arg8;
+    rec->arg16  = arg16;
+    EnableGlobalIRQ(primask);
+}
+
+void TraceRecorderEnable(uint8_t enable)
+{
+    s_traceEnable = enable;
+}
+
+uint32_t TraceRecorderCount(uint32_t *dropped)
+{
+    uint32_t wpos = s_traceWpos;
+
+    if (dropped != NULL)
+    {
+        *dropped = (wpos > TRACE_RECORDS) ? (wpos - TRACE_RECORDS) : 0U;
+    }
+    return (wpos > TRACE_RECORDS) ? TRACE_RECORDS : wpos;
+}
+
+uint32_t TraceRecorderCopy(uint32_t pos, trace_record_t *buf, uint32_t num)
+{
+    uint32_t count = TraceRecorderCount(NULL);
+    uint32_t oldest = s_traceWpos - count;
+
+    if (pos >= count)
+    {
+        return 0U;
+    }
+    if (num > (count - pos))
+    {
+        num = count - pos;
+    }
+    for (uint32_t i = 0; i < num; i++)
+    {
+        buf[i] = s_traceRing[(oldest + pos + i) & (TRACE_RECORDS - 1U)];
+    }
+    return num;
+}
+
+void TraceRecorderClear(void)
+{
+    uint32_t primask;
+
+    primask     = DisableGlobalIRQ();
+    s_traceWpos = 0U;
+    EnableGlobalIRQ(primask);
+}
+
+#endif /* TRACE_RECORDER_ENABLE */
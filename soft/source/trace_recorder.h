@@ -0,0 +1,148 @@
+/*
+ * trace_recorder.h
+ *
+ *  Created on: 2026/10/18
+ *      Author: M.Akino
+ */
+
+#ifndef TRACE_RECORDER_H_
+#define TRACE_RECORDER_H_
+
+#include <stdint.h>
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+
+/*! @brief 0 - trace hooks are compiled out; 1 - scheduler, ISR and USB transfer events are recorded */
+#define TRACE_RECORDER_ENABLE (1U)
+
+/*! @brief number of records in the ring, must be a power of 2 (8 bytes each) */
+#define TRACE_RECORDS (1024U)
+
+/*! @brief trace file format version, see tools/trace2json.py */
+#define TRACE_FILE_VERSION (1U)
+
+/*! @brief recorded events */
+typedef enum _trace_event
+{
+    kTRACE_TaskSwitchIn = 1,   /*!< arg16: task number */
+    kTRACE_IsrEnter,           /*!< arg8: IRQ number */
+    kTRACE_IsrExit,            /*!< arg8: IRQ number */
+    kTRACE_Notify,             /*!< arg16: notified task number, arg8: index */
+    kTRACE_NotifyFromIsr,      /*!< arg16: notified task number, arg8: index */
+    kTRACE_NotifyGiveFromIsr,  /*!< arg16: notified task number, arg8: index */
+    kTRACE_NotifyTake,         /*!< arg16: current task number, arg8: index */
+    kTRACE_NotifyWait,         /*!< arg16: current task number, arg8: index */
+    kTRACE_UsbSubmit,          /*!< arg8: endpoint address (bit7: IN), arg16: length */
+    kTRACE_UsbDone,            /*!< arg8: endpoint address (bit7: IN), arg16: length transferred */
+    kTRACE_UsbError,           /*!< arg8: endpoint address (bit7: IN), arg16: usb_status_t */
+    kTRACE_User,               /*!< free for temporary instrumentation */
+} trace_event_t;
+
+/*! @brief one record */
+typedef struct _trace_record
+{
+    uint32_t cycles; /*!< DWT->CYCCNT */
+    uint8_t event;   /*!< trace_event_t */
+    uint8_t arg8;
+    uint16_t arg16;
+} trace_record_t;
+
+/*! @brief file header, followed by trace_file_task_t[tasks] and trace_record_t[records] oldest first */
+typedef struct _trace_file_header
+{
+    char magic[4];       /*!< "RTRC" */
+    uint16_t version;    /*!< TRACE_FILE_VERSION */
+    uint16_t recordSize; /*!< sizeof(trace_record_t) */
+    uint32_t coreClock;  /*!< cycles per second */
+    uint32_t records;    /*!< number of records */
+    uint32_t tasks;      /*!< number of task names */
+    uint32_t dropped;    /*!< records overwritten before the dump */
+} trace_file_header_t;
+
+/*! @brief task number to name */
+typedef struct _trace_file_task
+{
+    uint32_t number;
+    char name[12];
+} trace_file_task_t;
+
+/*! @brief USB transfer event arguments, dir is USB_IN or USB_OUT */
+#define TRACE_USB_EP(ep, dir) ((uint8_t)(((ep) & 0x0FU) | (((dir) == USB_IN) ? 0x80U : 0x00U)))
+#define TRACE_LEN16(len) ((uint16_t)(((len) > 0xFFFFU) ? 0xFFFFU : (len)))
+
+#if ((defined TRACE_RECORDER_ENABLE) && (TRACE_RECORDER_ENABLE))
+
+/* FreeRTOS trace hooks, only expanded inside tasks.c where pxCurrentTCB and pxTCB exist.
+   The task switch hook is wired to traceTASK_SWITCHED_IN in FreeRTOSConfig.h */
+#define TRACE_TASK_SWITCHED_IN() TraceRecorderPut(kTRACE_TaskSwitchIn, 0U, (uint16_t)pxCurrentTCB->uxTCBNumber)
+#define traceTASK_NOTIFY(uxIndexToNotify) \
+    TraceRecorderPut(kTRACE_Notify, (uint8_t)(uxIndexToNotify), (uint16_t)pxTCB->uxTCBNumber)
+#define traceTASK_NOTIFY_FROM_ISR(uxIndexToNotify) \
+    TraceRecorderPut(kTRACE_NotifyFromIsr, (uint8_t)(uxIndexToNotify), (uint16_t)pxTCB->uxTCBNumber)
+#define traceTASK_NOTIFY_GIVE_FROM_ISR(uxIndexToNotify) \
+    TraceRecorderPut(kTRACE_NotifyGiveFromIsr, (uint8_t)(uxIndexToNotify), (uint16_t)pxTCB->uxTCBNumber)
+#define traceTASK_NOTIFY_TAKE(uxIndexToWait) \
+    TraceRecorderPut(kTRACE_NotifyTake, (uint8_t)(uxIndexToWait), (uint16_t)pxCurrentTCB->uxTCBNumber)
+#define traceTASK_NOTIFY_WAIT(uxIndexToWait) \
+    TraceRecorderPut(kTRACE_NotifyWait, (uint8_t)(uxIndexToWait), (uint16_t)pxCurrentTCB->uxTCBNumber)
+
+/*! @brief ISR hooks */
+#define TRACE_ISR_ENTER(irq) TraceRecorderPut(kTRACE_IsrEnter, (uint8_t)(irq), 0U)
+#define TRACE_ISR_EXIT(irq) TraceRecorderPut(kTRACE_IsrExit, (uint8_t)(irq), 0U)
+/*! @brief custom event */
+#define TRACE_EVENT(event, arg8, arg16) TraceRecorderPut((event), (uint8_t)(arg8), (uint16_t)(arg16))
+
+/*******************************************************************************
+ * API
+ ******************************************************************************/
+
+/*!
+ * @brief add one record, callable from tasks, ISRs and the scheduler.
+ *
+ * @param event   trace_event_t.
+ * @param arg8    8bit argument.
+ * @param arg16   16bit argument.
+ */
+extern void TraceRecorderPut(uint8_t event, uint8_t arg8, uint16_t arg16);
+
+/*!
+ * @brief stop or restart recording.
+ *
+ * @param enable  0: stop, records are kept for TraceRecorderCopy. 1: start.
+ */
+extern void TraceRecorderEnable(uint8_t enable);
+
+/*!
+ * @brief number of records held in the ring and number of overwritten records.
+ *
+ * @param dropped  overwritten records, may be NULL.
+ */
+extern uint32_t TraceRecorderCount(uint32_t *dropped);
+
+/*!
+ * @brief copy records oldest first, recording must be stopped.
+ *
+ * @param pos     index from the oldest record.
+ * @param buf     copy destination.
+ * @param num     number of records to copy.
+ * @return number of records copied.
+ */
+extern uint32_t TraceRecorderCopy(uint32_t pos, trace_record_t *buf, uint32_t num);
+
+/*!
+ * @brief discard all records.
+ */
+extern void TraceRecorderClear(void);
+
+#else
+
+#define TRACE_TASK_SWITCHED_IN()
+#define TRACE_ISR_ENTER(irq)
+#define TRACE_ISR_EXIT(irq)
+#define TRACE_EVENT(event, arg8, arg16)
+
+#endif /* TRACE_RECORDER_ENABLE */
+
+#endif /* TRACE_RECORDER_H_ */
@@ -256,4 +256,16 @@
  */
 #define USB_HOST_CONFIG_MIDI (1U)
 
+/*!
+ * @brief transfers of USB_HOST_CONFIG_MAX_TRANSFERS reserved for the MSD class.
+ * a class takes a transfer from its reservation first and from the shared rest when the reservation is empty.
+ * enumeration, hub and the other classes use the shared rest only, see USB_HostGetTransferPoolStat to size them.
+ */
+#define USB_HOST_CONFIG_MSD_TRANSFERS (3U)
+
+/*!
+ * @brief transfers of USB_HOST_CONFIG_MAX_TRANSFERS reserved for the MIDI class, the in pipe and the out pipe.
+ */
+#define USB_HOST_CONFIG_MIDI_TRANSFERS (4U)
+
 #endif /* _USB_HOST_CONFIG_H_ */
@@ -295,7 +295,8 @@ usb_status_t USB_HostMidiSetInterface(usb_host_class_handle classHandle,
     else /* send setup transfer */
     {
         /* malloc one transfer */
-        if (USB_HostMallocTransfer(midiInstance->hostHandle, &transfer) != kStatus_USB_Success)
+        if (USB_HostMallocTransferFrom(midiInstance->hostHandle, kUSB_HostTransferPoolMidi,
+                                       &transfer) != kStatus_USB_Success)
         {
 #ifdef HOST_ECHO
             usb_echo("error to get transfer\r\n");
@@ -449,7 +450,8 @@ usb_status_t USB_HostMidiRecv(usb_host_class_handle classHandle,
     }
 
     /* malloc one transfer */
-    if (USB_HostMallocTransfer(midiInstance->hostHandle, &transfer) != kStatus_USB_Success)
+    if (USB_HostMallocTransferFrom(midiInstance->hostHandle, kUSB_HostTransferPoolMidi,
+                                   &transfer) != kStatus_USB_Success)
     {
 #ifdef HOST_ECHO
         usb_echo("error to get transfer\r\n");
@@ -498,7 +500,8 @@ usb_status_t USB_HostMidiSend(usb_host_class_handle classHandle,
     }
 
     /* malloc one transfer */
-    if (USB_HostMallocTransfer(midiInstance->hostHandle, &transfer) != kStatus_USB_Success)
+    if (USB_HostMallocTransferFrom(midiInstance->hostHandle, kUSB_HostTransferPoolMidi,
+                                   &transfer) != kStatus_USB_Success)
     {
 #ifdef HOST_ECHO
         usb_echo("error to get transfer\r\n");
@@ -172,6 +172,41 @@ static usb_status_t USB_HostMsdControl(usb_host_msd_instance_t *msdInstance,
  */
 static usb_status_t USB_HostMsdProcessCommand(usb_host_msd_instance_t *msdInstance);
 
+/*!
+ * @brief fill the CBW and start the command, the instance must be idle.
+ *
+ * @param msdInstance   the msd class instance.
+ * @param buffer        buffer pointer.
+ * @param bufferLength  buffer length.
+ * @param callbackFn    callback function.
+ * @param callbackParam callback parameter.
+ * @param direction     command direction.
+ * @param logicalUnit   CBW LUN.
+ * @param byteValues    command block.
+ * @param length        command block length, 1 - 16.
+ */
+static usb_status_t USB_HostMsdStartCommand(usb_host_msd_instance_t *msdInstance,
+                                            uint8_t *buffer,
+                                            uint32_t bufferLength,
+                                            transfer_callback_t callbackFn,
+                                            void *callbackParam,
+                                            uint8_t direction,
+                                            uint8_t logicalUnit,
+                                            uint8_t *byteValues,
+                                            uint8_t length);
+
+#if (defined(USB_HOST_MSD_COMMAND_QUEUE_LENGTH) && (USB_HOST_MSD_COMMAND_QUEUE_LENGTH > 0U))
+/*!
+ * @brief start a queued command if the instance is idle, a command that cannot start completes with error.
+ *
+ * The oldest command for another logical unit than the previous one goes first, so the LUNs of a card reader
+ * take turns on the bulk pipes. The commands of one LUN keep their order.
+ *
+ * @param msdInstance   the msd class instance.
+ */
+static void USB_HostMsdStartQueuedCommand(usb_host_msd_instance_t *msdInstance);
+#endif
+
 /*******************************************************************************
  * Variables
  ******************************************************************************/
@@ -207,7 +242,7 @@ static usb_status_t USB_HostMsdClearHalt(usb_host_msd_instance_t *msdInstance,
     usb_host_transfer_t *transfer;
 
     /* malloc one transfer */
-    status = USB_HostMallocTransfer(msdInstance->hostHandle, &transfer);
+    status = USB_HostMallocTransferFrom(msdInstance->hostHandle, kUSB_HostTransferPoolMsd, &transfer);
     if (status != kStatus_USB_Success)
     {
 #ifdef HOST_ECHO
@@ -333,6 +368,64 @@ static void USB_HostMsdControlCallback(void *param, usb_host_transfer_t *transfe
     (void)USB_HostFreeTransfer(msdInstance->hostHandle, transfer);
 }
 
+#if (defined(USB_HOST_MSD_COMMAND_QUEUE_LENGTH) && (USB_HOST_MSD_COMMAND_QUEUE_LENGTH > 0U))
+static void USB_HostMsdStartQueuedCommand(usb_host_msd_instance_t *msdInstance)
+{
+    usb_host_msd_queued_command_t command;
+    uint8_t lastLun;
+    uint8_t pick;
+    uint8_t index;
+    OSA_SR_ALLOC();
+
+    while (1)
+    {
+        OSA_ENTER_CRITICAL();
+        if ((msdInstance->commandQueueCount == 0U) || (msdInstance->commandStatus != (uint8_t)kMSD_CommandIdle))
+        {
+            OSA_EXIT_CRITICAL();
+            break;
+        }
+        lastLun = msdInstance->msdCommand.cbwBlock->CBWLun;
+        for (pick = 0U; pick < msdInstance->commandQueueCount; pick++)
+        {
+            index = (uint8_t)((msdInstance->commandQueueHead + pick) % USB_HOST_MSD_COMMAND_QUEUE_LENGTH);
+            if (msdInstance->commandQueue[index].logicalUnit != lastLun)
+            {
+                break;
+            }
+        }
+        if (pick >= msdInstance->commandQueueCount)
+        {
+            pick = 0U; /* all for the same LUN */
+        }
+        command = msdInstance->commandQueue[(msdInstance->commandQueueHead + pick) % USB_HOST_MSD_COMMAND_QUEUE_LENGTH];
+        /* the older commands move up one slot into the gap */
+        for (; pick > 0U; pick--)
+        {
+            msdInstance->commandQueue[(msdInstance->commandQueueHead + pick) % USB_HOST_MSD_COMMAND_QUEUE_LENGTH] =
+                msdInstance->commandQueue[(msdInstance->commandQueueHead + pick - 1U) %
+                                          USB_HOST_MSD_COMMAND_QUEUE_LENGTH];
+        }
+        msdInstance->commandQueueHead = (uint8_t)((msdInstance->commandQueueHead + 1U) % USB_HOST_MSD_COMMAND_QUEUE_LENGTH);
+        msdInstance->commandQueueCount--;
+        msdInstance->commandStatus = (uint8_t)kMSD_CommandTransferCBW;
+        OSA_EXIT_CRITICAL();
+
+        if (USB_HostMsdStartCommand(msdInstance, command.buffer, command.bufferLength, command.callbackFn,
+                                    command.callbackParam, command.direction, command.logicalUnit, command.byteValues,
+                                    command.length) == kStatus_USB_Success)
+        {
+            break;
+        }
+        msdInstance->commandStatus = (uint8_t)kMSD_CommandIdle;
+        if (command.callbackFn != NULL)
+        {
+            command.callbackFn(command.callbackParam, command.buffer, 0U, kStatus_USB_Error);
+        }
+    }
+}
+#endif
+
 static void USB_HostMsdCommandDone(usb_host_msd_instance_t *msdInstance, usb_status_t status)
 {
     msdInstance->commandStatus = (uint8_t)kMSD_CommandIdle;
@@ -342,6 +435,10 @@ static void USB_HostMsdCommandDone(usb_host_msd_instance_t *msdInstance, usb_sta
         msdInstance->commandCallbackFn(msdInstance->commandCallbackParam, msdInstance->msdCommand.dataBuffer,
                                        msdInstance->msdCommand.dataSofar, status);
     }
+#if (defined(USB_HOST_MSD_COMMAND_QUEUE_LENGTH) && (USB_HOST_MSD_COMMAND_QUEUE_LENGTH > 0U))
+    /* send the next CBW right away so the bulk pipes stay busy */
+    USB_HostMsdStartQueuedCommand(msdInstance);
+#endif
 }
 
 static void USB_HostMsdCswCallback(void *param, usb_host_transfer_t *transfer, usb_status_t status)
@@ -618,7 +715,8 @@ static usb_status_t USB_HostMsdProcessCommand(usb_host_msd_instance_t *msdInstan
     if (msdInstance->msdCommand.transfer == NULL)
     {
         /* malloc one transfer */
-        status = USB_HostMallocTransfer(msdInstance->hostHandle, &(msdInstance->msdCommand.transfer));
+        status = USB_HostMallocTransferFrom(msdInstance->hostHandle, kUSB_HostTransferPoolMsd,
+                                            &(msdInstance->msdCommand.transfer));
         if (status != kStatus_USB_Success)
         {
             msdInstance->msdCommand.transfer = NULL;
@@ -734,36 +832,116 @@ usb_status_t USB_HostMsdCommand(usb_host_class_handle classHandle,
                                 void *callbackParam,
                                 uint8_t direction,
                                 uint8_t byteValues[10])
+{
+    /* UFI carries the LUN in the upper bits of the second byte */
+    return USB_HostMsdCommandBlock(classHandle, (uint8_t)(byteValues[1] >> USB_HOST_UFI_LOGICAL_UNIT_POSITION), buffer,
+                                   bufferLength, callbackFn, callbackParam, direction, byteValues,
+                                   USB_HOST_UFI_BLOCK_DATA_VALID_LENGTH);
+}
+
+usb_status_t USB_HostMsdCommandBlock(usb_host_class_handle classHandle,
+                                     uint8_t logicalUnit,
+                                     uint8_t *buffer,
+                                     uint32_t bufferLength,
+                                     transfer_callback_t callbackFn,
+                                     void *callbackParam,
+                                     uint8_t direction,
+                                     uint8_t *commandBlock,
+                                     uint8_t commandLength)
 {
     usb_host_msd_instance_t *msdInstance = (usb_host_msd_instance_t *)classHandle;
-    usb_host_cbw_t *cbwPointer           = msdInstance->msdCommand.cbwBlock;
-    uint8_t index                        = 0;
+#if (defined(USB_HOST_MSD_COMMAND_QUEUE_LENGTH) && (USB_HOST_MSD_COMMAND_QUEUE_LENGTH > 0U))
+    usb_host_msd_queued_command_t *command;
+    uint8_t index;
+    usb_status_t status;
+    OSA_SR_ALLOC();
+#endif
 
     if (classHandle == NULL)
     {
         return kStatus_USB_InvalidHandle;
     }
+    if ((commandLength == 0U) || (commandLength > USB_HOST_UFI_BLOCK_DATA_MAX_LENGTH))
+    {
+        return kStatus_USB_InvalidParameter;
+    }
 
+#if (defined(USB_HOST_MSD_COMMAND_QUEUE_LENGTH) && (USB_HOST_MSD_COMMAND_QUEUE_LENGTH > 0U))
+    OSA_ENTER_CRITICAL();
+    if ((msdInstance->commandStatus == (uint8_t)kMSD_CommandIdle) && (msdInstance->commandQueueCount == 0U))
+    {
+        msdInstance->commandStatus = (uint8_t)kMSD_CommandTransferCBW; /* claim the instance */
+        OSA_EXIT_CRITICAL();
+        status = USB_HostMsdStartCommand(msdInstance, buffer, bufferLength, callbackFn, callbackParam, direction,
+                                         logicalUnit, commandBlock, commandLength);
+        if (status != kStatus_USB_Success)
+        {
+            msdInstance->commandStatus = (uint8_t)kMSD_CommandIdle;
+            USB_HostMsdStartQueuedCommand(msdInstance); /* queued meanwhile by another task */
+        }
+        return status;
+    }
+    if (msdInstance->commandQueueCount >= USB_HOST_MSD_COMMAND_QUEUE_LENGTH)
+    {
+        OSA_EXIT_CRITICAL();
+        return kStatus_USB_Busy;
+    }
+    /* started by USB_HostMsdCommandDone of the commands ahead */
+    command = &msdInstance->commandQueue[(msdInstance->commandQueueHead + msdInstance->commandQueueCount) %
+                                         USB_HOST_MSD_COMMAND_QUEUE_LENGTH];
+    command->buffer        = buffer;
+    command->bufferLength  = bufferLength;
+    command->callbackFn    = callbackFn;
+    command->callbackParam = callbackParam;
+    command->direction     = direction;
+    command->logicalUnit   = logicalUnit;
+    command->length        = commandLength;
+    for (index = 0; index < commandLength; ++index)
+    {
+        command->byteValues[index] = commandBlock[index];
+    }
+    msdInstance->commandQueueCount++;
+    OSA_EXIT_CRITICAL();
+    return kStatus_USB_Success;
+#else
     if (msdInstance->commandStatus != (uint8_t)kMSD_CommandIdle)
     {
         return kStatus_USB_Busy;
     }
 
+    return USB_HostMsdStartCommand(msdInstance, buffer, bufferLength, callbackFn, callbackParam, direction,
+                                   logicalUnit, commandBlock, commandLength);
+#endif
+}
+
+static usb_status_t USB_HostMsdStartCommand(usb_host_msd_instance_t *msdInstance,
+                                            uint8_t *buffer,
+                                            uint32_t bufferLength,
+                                            transfer_callback_t callbackFn,
+                                            void *callbackParam,
+                                            uint8_t direction,
+                                            uint8_t logicalUnit,
+                                            uint8_t *byteValues,
+                                            uint8_t length)
+{
+    usb_host_cbw_t *cbwPointer = msdInstance->msdCommand.cbwBlock;
+    uint8_t index              = 0;
+
     /* save the application callback function */
     msdInstance->commandCallbackFn    = callbackFn;
     msdInstance->commandCallbackParam = callbackParam;
 
-    /* initialize CBWCB fields */
-    for (index = 0; index < USB_HOST_UFI_BLOCK_DATA_VALID_LENGTH; ++index)
+    /* initialize CBWCB fields, the bytes after the command block are zero */
+    for (index = 0; index < USB_HOST_UFI_BLOCK_DATA_MAX_LENGTH; ++index)
     {
-        cbwPointer->CBWCB[index] = byteValues[index];
+        cbwPointer->CBWCB[index] = (index < length) ? byteValues[index] : 0U;
     }
 
     /* initialize CBW fields */
     cbwPointer->CBWDataTransferLength = USB_LONG_TO_LITTLE_ENDIAN(bufferLength);
     cbwPointer->CBWFlags              = direction;
-    cbwPointer->CBWLun                = (byteValues[1] >> USB_HOST_UFI_LOGICAL_UNIT_POSITION);
-    cbwPointer->CBWCBLength           = USB_HOST_UFI_BLOCK_DATA_VALID_LENGTH;
+    cbwPointer->CBWLun                = logicalUnit;
+    cbwPointer->CBWCBLength           = length;
 
     msdInstance->commandStatus = (uint8_t)kMSD_CommandTransferCBW;
     if (direction == USB_HOST_MSD_CBW_FLAGS_DIRECTION_IN)
@@ -928,7 +1106,8 @@ usb_status_t USB_HostMsdInit(usb_device_handle deviceHandle, usb_host_class_hand
     temp                                          = (uint32_t *)infoValue;
     msdInstance->controlPipe                      = (usb_host_pipe_handle)temp;
     msdInstance->msdCommand.cbwBlock->CBWSignature = USB_LONG_TO_LITTLE_ENDIAN(USB_HOST_MSD_CBW_SIGNATURE);
-    status = USB_HostMallocTransfer(msdInstance->hostHandle, &(msdInstance->msdCommand.transfer));
+    status = USB_HostMallocTransferFrom(msdInstance->hostHandle, kUSB_HostTransferPoolMsd,
+                                        &(msdInstance->msdCommand.transfer));
     if (status != kStatus_USB_Success)
     {
         msdInstance->msdCommand.transfer = NULL;
@@ -997,7 +1176,8 @@ usb_status_t USB_HostMsdSetInterface(usb_host_class_handle classHandle,
     else /* send setup transfer */
     {
         /* malloc one transfer */
-        if (USB_HostMallocTransfer(msdInstance->hostHandle, &transfer) != kStatus_USB_Success)
+        if (USB_HostMallocTransferFrom(msdInstance->hostHandle, kUSB_HostTransferPoolMsd,
+                                       &transfer) != kStatus_USB_Success)
         {
 #ifdef HOST_ECHO
             usb_echo("error to get transfer\r\n");
@@ -1037,9 +1217,34 @@ usb_status_t USB_HostMsdDeinit(usb_device_handle deviceHandle, usb_host_class_ha
 {
     usb_host_msd_instance_t *msdInstance = (usb_host_msd_instance_t *)classHandle;
     usb_status_t status;
+#if (defined(USB_HOST_MSD_COMMAND_QUEUE_LENGTH) && (USB_HOST_MSD_COMMAND_QUEUE_LENGTH > 0U))
+    usb_host_msd_queued_command_t command;
+    OSA_SR_ALLOC();
+#endif
 
     if (classHandle != NULL)
     {
+#if (defined(USB_HOST_MSD_COMMAND_QUEUE_LENGTH) && (USB_HOST_MSD_COMMAND_QUEUE_LENGTH > 0U))
+        /* the queued commands never start, the executing one is cancelled below */
+        while (1)
+        {
+            OSA_ENTER_CRITICAL();
+            if (msdInstance->commandQueueCount == 0U)
+            {
+                OSA_EXIT_CRITICAL();
+                break;
+            }
+            /* copied out, the slot may be reused by USB_HostMsdCommand once the critical section ends */
+            command                       = msdInstance->commandQueue[msdInstance->commandQueueHead];
+            msdInstance->commandQueueHead = (uint8_t)((msdInstance->commandQueueHead + 1U) % USB_HOST_MSD_COMMAND_QUEUE_LENGTH);
+            msdInstance->commandQueueCount--;
+            OSA_EXIT_CRITICAL();
+            if (command.callbackFn != NULL)
+            {
+                command.callbackFn(command.callbackParam, command.buffer, 0U, kStatus_USB_TransferCancel);
+            }
+        }
+#endif
         if (msdInstance->inPipe != NULL)
         {
             status = USB_HostCancelTransfer(msdInstance->hostHandle, msdInstance->inPipe, NULL); /* cancel pipe */
@@ -1126,7 +1331,7 @@ static usb_status_t USB_HostMsdControl(usb_host_msd_instance_t *msdInstance,
     }
 
     /* malloc one transfer */
-    if (USB_HostMallocTransfer(msdInstance->hostHandle, &transfer) != kStatus_USB_Success)
+    if (USB_HostMallocTransferFrom(msdInstance->hostHandle, kUSB_HostTransferPoolMsd, &transfer) != kStatus_USB_Success)
     {
 #ifdef HOST_ECHO
         usb_echo("allocate transfer error\r\n");
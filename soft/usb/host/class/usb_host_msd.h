@@ -25,6 +25,7 @@
 
 /* UFI data bit macro */
 #define USB_HOST_UFI_BLOCK_DATA_VALID_LENGTH (10U)
+#define USB_HOST_UFI_BLOCK_DATA_MAX_LENGTH (16U)
 #define USB_HOST_UFI_LOGICAL_UNIT_POSITION (5U)
 #define USB_HOST_UFI_CBW_LENGTH (31U)
 #define USB_HOST_UFI_CSW_LENGTH (13U)
@@ -44,6 +45,10 @@
 
 /*! @brief retry time when transfer fail, when all the retries fail the transfer callback with error status */
 #define USB_HOST_MSD_RETRY_MAX_TIME (1U)
+/*! @brief commands queued behind the executing one, 0 - a second command returns kStatus_USB_Busy */
+#ifndef USB_HOST_MSD_COMMAND_QUEUE_LENGTH
+#define USB_HOST_MSD_COMMAND_QUEUE_LENGTH (4U)
+#endif
 /*! @brief mass storage block size */
 #define USB_HOST_MSD_BLOCK_SIZE (512U)
 
@@ -126,6 +131,21 @@ typedef struct _usb_host_msd_command
     uint8_t dataDirection; /*!< The data direction, its value is USB_OUT or USB_IN*/
 } usb_host_msd_command_t;
 
+#if (defined(USB_HOST_MSD_COMMAND_QUEUE_LENGTH) && (USB_HOST_MSD_COMMAND_QUEUE_LENGTH > 0U))
+/*! @brief MSC UFI command waiting for the executing one to finish */
+typedef struct _usb_host_msd_queued_command
+{
+    uint8_t *buffer;                                         /*!< Data buffer pointer*/
+    uint32_t bufferLength;                                   /*!< Data buffer length*/
+    transfer_callback_t callbackFn;                          /*!< Command callback function pointer*/
+    void *callbackParam;                                     /*!< Command callback parameter*/
+    uint8_t direction;                                     /*!< CBW flags direction*/
+    uint8_t logicalUnit;                                   /*!< CBW LUN*/
+    uint8_t length;                                        /*!< Command block length*/
+    uint8_t byteValues[USB_HOST_UFI_BLOCK_DATA_MAX_LENGTH]; /*!< Command block*/
+} usb_host_msd_queued_command_t;
+#endif
+
 /*! @brief MSD instance structure, MSD usb_host_class_handle pointer to this structure */
 typedef struct _usb_host_msd_instance
 {
@@ -144,6 +164,12 @@ typedef struct _usb_host_msd_instance
     uint8_t commandStatus;                     /*!< UFI command process status, see command_status_t*/
     uint8_t internalResetRecovery; /*!< 1 - class driver internal mass storage reset recovery is on-going; 0 -
                                       application call USB_HostMsdMassStorageReset to reset or there is no reset*/
+#if (defined(USB_HOST_MSD_COMMAND_QUEUE_LENGTH) && (USB_HOST_MSD_COMMAND_QUEUE_LENGTH > 0U))
+    usb_host_msd_queued_command_t commandQueue[USB_HOST_MSD_COMMAND_QUEUE_LENGTH]; /*!< Commands started by the
+                                                                                      completion of the previous one*/
+    uint8_t commandQueueHead;  /*!< Index of the oldest queued command*/
+    uint8_t commandQueueCount; /*!< Number of queued commands*/
+#endif
 } usb_host_msd_instance_t;
 
 /*! @brief UFI standard sense data structure */
@@ -183,6 +209,31 @@ typedef struct _usb_host_ufi_read_capacity
     uint8_t blockLengthInBytes[4];      /*!< Block size*/
 } usb_host_ufi_read_capacity_t;
 
+/*! @brief SBC read capacity (16) data structure */
+typedef struct _usb_host_ufi_read_capacity16
+{
+    uint8_t lastLogicalBlockAddress[8]; /*!< The logical block number*/
+    uint8_t blockLengthInBytes[4];      /*!< Block size*/
+    uint8_t protection;                 /*!< P_TYPE and PROT_EN*/
+    uint8_t exponents;                  /*!< Logical blocks per physical block exponent*/
+    uint8_t lowestAlignedLba[2];        /*!< LBPME (bit 7 of the first byte), LBPRZ and the lowest aligned LBA*/
+    uint8_t reserved[16];               /*!< Reserved field*/
+} usb_host_ufi_read_capacity16_t;
+
+/*! @brief LBPME bit in lowestAlignedLba[0], the unit supports UNMAP */
+#define USB_HOST_UFI_READ_CAPACITY16_LBPME (0x80U)
+
+/*! @brief SBC UNMAP parameter list with one block descriptor */
+typedef struct _usb_host_ufi_unmap_parameter
+{
+    uint8_t dataLength[2];                /*!< Bytes after this field*/
+    uint8_t blockDescriptorDataLength[2]; /*!< Bytes of the block descriptors*/
+    uint8_t reserved[4];                  /*!< Reserved field*/
+    uint8_t logicalBlockAddress[8];       /*!< First block to unmap*/
+    uint8_t numberOfLogicalBlocks[4];     /*!< Blocks to unmap*/
+    uint8_t reserved1[4];                 /*!< Reserved field*/
+} usb_host_ufi_unmap_parameter_t;
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -444,6 +495,128 @@ extern usb_status_t USB_HostMsdReadCapacity(usb_host_class_handle classHandle,
                                             transfer_callback_t callbackFn,
                                             void *callbackParam);
 
+/*!
+ * @brief Mass storage read capacity (16).
+ *
+ * This function implements the SBC READ CAPACITY(16) command, the SERVICE ACTION IN(16) with the
+ * service action 10h. It returns the 64 bit last block address of units above 2 TiB and the LBPME bit,
+ * see usb_host_ufi_read_capacity16_t.
+ *
+ * @param[in] classHandle    The class MSD handle.
+ * @param[in] logicalUnit    Logical unit number.
+ * @param[out] buffer        Buffer pointer.
+ * @param[in] bufferLength   The buffer length.
+ * @param[in] callbackFn     This callback is called after this command completes.
+ * @param[in] callbackParam  The first parameter in the callback function.
+ *
+ * @retval kStatus_USB_Success        The device is initialized successfully.
+ * @retval kStatus_USB_InvalidHandle  The classHandle is NULL pointer.
+ * @retval kStatus_USB_Busy           The previous command is executing or there is no idle transfer.
+ * @retval kStatus_USB_Error          Send transfer fail. See the USB_HostSend/USB_HostRecv.
+ * @retval kStatus_USB_Success        Callback return status, the command succeed.
+ * @retval kStatus_USB_MSDStatusFail  Callback return status, the CSW status indicate this command fail.
+ * @retval kStatus_USB_Error          Callback return status, the command fail.
+ */
+extern usb_status_t USB_HostMsdReadCapacity16(usb_host_class_handle classHandle,
+                                              uint8_t logicalUnit,
+                                              uint8_t *buffer,
+                                              uint32_t bufferLength,
+                                              transfer_callback_t callbackFn,
+                                              void *callbackParam);
+
+/*!
+ * @brief Mass storage read (16).
+ *
+ * This function implements the SBC READ(16) command, READ(10) with a 64 bit block address.
+ *
+ * @param[in] classHandle    The class MSD handle.
+ * @param[in] logicalUnit    Logical unit number.
+ * @param[in] blockAddress   The start block address.
+ * @param[out] buffer        Buffer pointer.
+ * @param[in] bufferLength   The buffer length.
+ * @param[in] blockNumber    Read block number.
+ * @param[in] callbackFn     This callback is called after this command completes.
+ * @param[in] callbackParam  The first parameter in the callback function.
+ *
+ * @retval kStatus_USB_Success        The device is initialized successfully.
+ * @retval kStatus_USB_InvalidHandle  The classHandle is NULL pointer.
+ * @retval kStatus_USB_Busy           The previous command is executing or there is no idle transfer.
+ * @retval kStatus_USB_Error          Send transfer fail. See the USB_HostSend/USB_HostRecv.
+ * @retval kStatus_USB_Success        Callback return status, the command succeed.
+ * @retval kStatus_USB_MSDStatusFail  Callback return status, the CSW status indicate this command fail.
+ * @retval kStatus_USB_Error          Callback return status, the command fail.
+ */
+extern usb_status_t USB_HostMsdRead16(usb_host_class_handle classHandle,
+                                      uint8_t logicalUnit,
+                                      uint64_t blockAddress,
+                                      uint8_t *buffer,
+                                      uint32_t bufferLength,
+                                      uint32_t blockNumber,
+                                      transfer_callback_t callbackFn,
+                                      void *callbackParam);
+
+/*!
+ * @brief Mass storage write (16).
+ *
+ * This function implements the SBC WRITE(16) command, WRITE(10) with a 64 bit block address.
+ *
+ * @param[in] classHandle    The class MSD handle.
+ * @param[in] logicalUnit    Logical unit number.
+ * @param[in] blockAddress   The start block address.
+ * @param[in] buffer         Buffer pointer.
+ * @param[in] bufferLength   The buffer length.
+ * @param[in] blockNumber    Write block number.
+ * @param[in] callbackFn     This callback is called after this command completes.
+ * @param[in] callbackParam  The first parameter in the callback function.
+ *
+ * @retval kStatus_USB_Success        The device is initialized successfully.
+ * @retval kStatus_USB_InvalidHandle  The classHandle is NULL pointer.
+ * @retval kStatus_USB_Busy           The previous command is executing or there is no idle transfer.
+ * @retval kStatus_USB_Error          Send transfer fail. See the USB_HostSend/USB_HostRecv.
+ * @retval kStatus_USB_Success        Callback return status, the command succeed.
+ * @retval kStatus_USB_MSDStatusFail  Callback return status, the CSW status indicate this command fail.
+ * @retval kStatus_USB_Error          Callback return status, the command fail.
+ */
+extern usb_status_t USB_HostMsdWrite16(usb_host_class_handle classHandle,
+                                       uint8_t logicalUnit,
+                                       uint64_t blockAddress,
+                                       uint8_t *buffer,
+                                       uint32_t bufferLength,
+                                       uint32_t blockNumber,
+                                       transfer_callback_t callbackFn,
+                                       void *callbackParam);
+
+/*!
+ * @brief Mass storage unmap.
+ *
+ * This function implements the SBC UNMAP command with one block descriptor. The device may discard
+ * the blocks, a flash device then does not copy them in its garbage collection. The parameter list is
+ * built in the buffer, it is sent from there and has to stay valid until the callback.
+ *
+ * @param[in] classHandle    The class MSD handle.
+ * @param[in] logicalUnit    Logical unit number.
+ * @param[in] blockAddress   The start block address.
+ * @param[in] blockNumber    Unmap block number.
+ * @param[out] buffer        Parameter list buffer, sizeof(usb_host_ufi_unmap_parameter_t) bytes.
+ * @param[in] callbackFn     This callback is called after this command completes.
+ * @param[in] callbackParam  The first parameter in the callback function.
+ *
+ * @retval kStatus_USB_Success        The device is initialized successfully.
+ * @retval kStatus_USB_InvalidHandle  The classHandle is NULL pointer.
+ * @retval kStatus_USB_Busy           The previous command is executing or there is no idle transfer.
+ * @retval kStatus_USB_Error          Send transfer fail. See the USB_HostSend/USB_HostRecv.
+ * @retval kStatus_USB_Success        Callback return status, the command succeed.
+ * @retval kStatus_USB_MSDStatusFail  Callback return status, the CSW status indicate this command fail.
+ * @retval kStatus_USB_Error          Callback return status, the command fail.
+ */
+extern usb_status_t USB_HostMsdUnmap(usb_host_class_handle classHandle,
+                                     uint8_t logicalUnit,
+                                     uint64_t blockAddress,
+                                     uint32_t blockNumber,
+                                     uint8_t *buffer,
+                                     transfer_callback_t callbackFn,
+                                     void *callbackParam);
+
 /*!
  * @brief Mass storage test unit ready.
  *
@@ -843,6 +1016,9 @@ extern usb_status_t USB_HostMsdSendDiagnostic(usb_host_class_handle classHandle,
  * @brief all ufi function calls this api.
  *
  * This function implements the common ufi commands.
+ * When a command is executing the new one is queued (USB_HOST_MSD_COMMAND_QUEUE_LENGTH) and its CBW is sent
+ * from the CSW callback of the previous command, kStatus_USB_Busy is returned only when the queue is full.
+ * Queued commands for different logical units are started alternately, the order within a LUN is kept.
  *
  * @param classHandle   the class msd handle.
  * @param buffer         buffer pointer.
@@ -862,6 +1038,34 @@ usb_status_t USB_HostMsdCommand(usb_host_class_handle classHandle,
                                 uint8_t direction,
                                 uint8_t byteValues[10]);
 
+/*!
+ * @brief send a command block of up to 16 bytes.
+ *
+ * USB_HostMsdCommand with the LUN in the CBW only, the second byte of an SBC command block of 12 or 16
+ * bytes is not a LUN field. The command is queued as USB_HostMsdCommand.
+ *
+ * @param classHandle   the class msd handle.
+ * @param logicalUnit   logical unit number.
+ * @param buffer        buffer pointer.
+ * @param bufferLength  buffer length.
+ * @param callbackFn    callback function.
+ * @param callbackParam callback parameter.
+ * @param direction     command direction.
+ * @param commandBlock  command block.
+ * @param commandLength command block length, 1 - USB_HOST_UFI_BLOCK_DATA_MAX_LENGTH.
+ *
+ * @return An error code or kStatus_USB_Success.
+ */
+usb_status_t USB_HostMsdCommandBlock(usb_host_class_handle classHandle,
+                                     uint8_t logicalUnit,
+                                     uint8_t *buffer,
+                                     uint32_t bufferLength,
+                                     transfer_callback_t callbackFn,
+                                     void *callbackParam,
+                                     uint8_t direction,
+                                     uint8_t *commandBlock,
+                                     uint8_t commandLength);
+
 /*! @}*/
 
 #ifdef __cplusplus
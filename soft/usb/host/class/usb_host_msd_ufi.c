@@ -36,8 +36,27 @@
 #define UFI_WRITE12 (0xAAU)
 #define UFI_WRITE_VERIFY (0x2EU)
 
+/* SBC command code, 16 byte command blocks for 64 bit block addresses */
+#define UFI_READ16 (0x88U)
+#define UFI_WRITE16 (0x8AU)
+#define UFI_SERVICE_ACTION_IN16 (0x9EU)
+#define UFI_UNMAP (0x42U)
+#define UFI_SERVICE_ACTION_READ_CAPACITY16 (0x10U)
+
 #define GET_BYTE_FROM_LE_LONG(b, n) \
     ((uint8_t)((USB_LONG_TO_LITTLE_ENDIAN(b)) >> ((n)*8))) /* get the byte from the long value */
+#define GET_BYTE_FROM_LONG_LONG(b, n) ((uint8_t)(((uint64_t)(b)) >> ((n)*8))) /* get the byte from the 64 bit value */
+
+/* 16 byte command block: operation code, flags, 64 bit block address, 32 bit length, group, control */
+#define UFI_COMMAND16(code, address, length)                                                                     \
+    {                                                                                                            \
+        (code), 0x00, GET_BYTE_FROM_LONG_LONG(address, 7), GET_BYTE_FROM_LONG_LONG(address, 6),                 \
+            GET_BYTE_FROM_LONG_LONG(address, 5), GET_BYTE_FROM_LONG_LONG(address, 4),                            \
+            GET_BYTE_FROM_LONG_LONG(address, 3), GET_BYTE_FROM_LONG_LONG(address, 2),                            \
+            GET_BYTE_FROM_LONG_LONG(address, 1), GET_BYTE_FROM_LONG_LONG(address, 0),                            \
+            GET_BYTE_FROM_LONG_LONG(length, 3), GET_BYTE_FROM_LONG_LONG(length, 2),                              \
+            GET_BYTE_FROM_LONG_LONG(length, 1), GET_BYTE_FROM_LONG_LONG(length, 0), 0x00, 0x00                   \
+    }
 
 /*******************************************************************************
  * Prototypes
@@ -164,6 +183,95 @@ usb_status_t USB_HostMsdReadCapacity(usb_host_class_handle classHandle,
                               USB_HOST_MSD_CBW_FLAGS_DIRECTION_IN, ufiBytes);
 }
 
+usb_status_t USB_HostMsdReadCapacity16(usb_host_class_handle classHandle,
+                                       uint8_t logicalUnit,
+                                       uint8_t *buffer,
+                                       uint32_t bufferLength,
+                                       transfer_callback_t callbackFn,
+                                       void *callbackParam)
+{
+    uint8_t ufiBytes[] = UFI_COMMAND16(UFI_SERVICE_ACTION_IN16, 0U, bufferLength);
+
+    ufiBytes[1] = UFI_SERVICE_ACTION_READ_CAPACITY16; /* allocation length in bytes 10 - 13 */
+    return USB_HostMsdCommandBlock(classHandle, logicalUnit, buffer, bufferLength, callbackFn, callbackParam,
+                                   USB_HOST_MSD_CBW_FLAGS_DIRECTION_IN, ufiBytes, sizeof(ufiBytes));
+}
+
+usb_status_t USB_HostMsdRead16(usb_host_class_handle classHandle,
+                               uint8_t logicalUnit,
+                               uint64_t blockAddress,
+                               uint8_t *buffer,
+                               uint32_t bufferLength,
+                               uint32_t blockNumber,
+                               transfer_callback_t callbackFn,
+                               void *callbackParam)
+{
+    uint8_t ufiBytes[] = UFI_COMMAND16(UFI_READ16, blockAddress, blockNumber);
+
+    return USB_HostMsdCommandBlock(classHandle, logicalUnit, buffer, bufferLength, callbackFn, callbackParam,
+                                   USB_HOST_MSD_CBW_FLAGS_DIRECTION_IN, ufiBytes, sizeof(ufiBytes));
+}
+
+usb_status_t USB_HostMsdWrite16(usb_host_class_handle classHandle,
+                                uint8_t logicalUnit,
+                                uint64_t blockAddress,
+                                uint8_t *buffer,
+                                uint32_t bufferLength,
+                                uint32_t blockNumber,
+                                transfer_callback_t callbackFn,
+                                void *callbackParam)
+{
+    uint8_t ufiBytes[] = UFI_COMMAND16(UFI_WRITE16, blockAddress, blockNumber);
+
+    return USB_HostMsdCommandBlock(classHandle, logicalUnit, buffer, bufferLength, callbackFn, callbackParam,
+                                   USB_HOST_MSD_CBW_FLAGS_DIRECTION_OUT, ufiBytes, sizeof(ufiBytes));
+}
+
+usb_status_t USB_HostMsdUnmap(usb_host_class_handle classHandle,
+                              uint8_t logicalUnit,
+                              uint64_t blockAddress,
+                              uint32_t blockNumber,
+                              uint8_t *buffer,
+                              transfer_callback_t callbackFn,
+                              void *callbackParam)
+{
+    uint8_t ufiBytes[] = {UFI_UNMAP,
+                          0x00,
+                          0x00,
+                          0x00,
+                          0x00,
+                          0x00,
+                          0x00,
+                          GET_BYTE_FROM_LE_LONG(sizeof(usb_host_ufi_unmap_parameter_t), 1),
+                          GET_BYTE_FROM_LE_LONG(sizeof(usb_host_ufi_unmap_parameter_t), 0),
+                          0x00};
+    usb_host_ufi_unmap_parameter_t *parameter = (usb_host_ufi_unmap_parameter_t *)buffer;
+    uint8_t index;
+
+    if (buffer == NULL)
+    {
+        return kStatus_USB_InvalidParameter;
+    }
+    /* the big endian parameter list, fields are bytes so there is no alignment */
+    parameter->dataLength[0]                = 0x00;
+    parameter->dataLength[1]                = (uint8_t)(sizeof(usb_host_ufi_unmap_parameter_t) - 2U);
+    parameter->blockDescriptorDataLength[0] = 0x00;
+    parameter->blockDescriptorDataLength[1] = 16U;
+    for (index = 0; index < 4U; ++index)
+    {
+        parameter->reserved[index]              = 0x00;
+        parameter->reserved1[index]             = 0x00;
+        parameter->numberOfLogicalBlocks[index] = GET_BYTE_FROM_LONG_LONG(blockNumber, 3U - index);
+    }
+    for (index = 0; index < 8U; ++index)
+    {
+        parameter->logicalBlockAddress[index] = GET_BYTE_FROM_LONG_LONG(blockAddress, 7U - index);
+    }
+    return USB_HostMsdCommandBlock(classHandle, logicalUnit, buffer, sizeof(usb_host_ufi_unmap_parameter_t),
+                                   callbackFn, callbackParam, USB_HOST_MSD_CBW_FLAGS_DIRECTION_OUT, ufiBytes,
+                                   sizeof(ufiBytes));
+}
+
 usb_status_t USB_HostMsdTestUnitReady(usb_host_class_handle classHandle,
                                       uint8_t logicalUnit,
                                       transfer_callback_t callbackFn,
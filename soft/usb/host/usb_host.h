@@ -288,6 +288,26 @@ typedef struct _usb_host_cancel_param
     usb_host_transfer_t *transfer;   /*!< Canceling transfer*/
 } usb_host_cancel_param_t;
 
+/*! @brief USB host transfer pools, see USB_HostMallocTransferFrom */
+typedef enum _usb_host_transfer_pool_id
+{
+    kUSB_HostTransferPoolShared = 0U, /*!< Enumeration, hub and the classes without a reservation*/
+    kUSB_HostTransferPoolMsd,         /*!< USB_HOST_CONFIG_MSD_TRANSFERS for the MSD class*/
+    kUSB_HostTransferPoolMidi,        /*!< USB_HOST_CONFIG_MIDI_TRANSFERS for the MIDI class*/
+    kUSB_HostTransferPoolNumOf,
+} usb_host_transfer_pool_id_t;
+
+/*! @brief USB host transfer pool statistics */
+typedef struct _usb_host_transfer_pool_stat
+{
+    uint32_t size;      /*!< Transfers owned by the pool*/
+    uint32_t inUse;     /*!< Transfers allocated now*/
+    uint32_t highWater; /*!< Highest inUse*/
+    uint32_t allocs;    /*!< Allocations served by the pool, including those borrowed by a reserved pool*/
+    uint32_t borrowed;  /*!< Reserved pool: allocations served by the shared pool because this pool was empty*/
+    uint32_t failures;  /*!< Allocations that failed, the caller returned kStatus_USB_Busy or kStatus_USB_Error*/
+} usb_host_transfer_pool_stat_t;
+
 /*******************************************************************************
  * API
  ******************************************************************************/
@@ -595,19 +615,59 @@ extern usb_status_t USB_HostCancelTransfer(usb_host_handle hostHandle,
  */
 extern usb_status_t USB_HostMallocTransfer(usb_host_handle hostHandle, usb_host_transfer_t **transfer);
 
+/*!
+ * @brief Allocates a transfer resource from a reserved pool.
+ *
+ * This function allocates a transfer from the pool first and from the shared pool when the pool is empty, so a
+ * class with a reservation cannot be starved by the other classes. USB_HostFreeTransfer returns the transfer to the
+ * pool that owns it. The pools are lock free, this function can be called by any task.
+ *
+ * @param[in] hostHandle     The host handle.
+ * @param[in] pool           The pool, see usb_host_transfer_pool_id_t.
+ * @param[out] transfer       Return the transfer.
+ *
+ * @retval kStatus_USB_Success              Allocate successfully.
+ * @retval kStatus_USB_InvalidHandle        The hostHandle or transfer is a NULL pointer, or the pool is invalid.
+ * @retval kStatus_USB_Error                There is no idle transfer.
+ */
+extern usb_status_t USB_HostMallocTransferFrom(usb_host_handle hostHandle,
+                                               usb_host_transfer_pool_id_t pool,
+                                               usb_host_transfer_t **transfer);
+
 /*!
  * @brief Frees a transfer resource.
  *
  * This function frees a transfer. This transfer is used to pass data information to a low level stack.
+ * The transfer is returned to the pool that owns it.
  *
  * @param[in] hostHandle     The host handle.
  * @param[in] transfer        Release the transfer.
  *
  * @retval kStatus_USB_Success              Free successfully.
  * @retval kStatus_USB_InvalidHandle        The hostHandle or transfer is a NULL pointer.
+ * @retval kStatus_USB_InvalidParameter     The transfer is not a transfer of the host.
  */
 extern usb_status_t USB_HostFreeTransfer(usb_host_handle hostHandle, usb_host_transfer_t *transfer);
 
+/*!
+ * @brief Gets the transfer pool statistics.
+ *
+ * This function takes a snapshot of the pool usage, the high-water mark and the failure counters, so that
+ * USB_HOST_CONFIG_MAX_TRANSFERS and the class reservations can be sized from data.
+ *
+ * @param[in] hostHandle     The host handle.
+ * @param[in] pool           The pool, see usb_host_transfer_pool_id_t.
+ * @param[out] stat           Return the statistics.
+ * @param[in] reset          1 - clear the counters and set the high-water mark to inUse after the snapshot.
+ *
+ * @retval kStatus_USB_Success              Get successfully.
+ * @retval kStatus_USB_InvalidHandle        The hostHandle or stat is a NULL pointer, or the pool is invalid.
+ */
+extern usb_status_t USB_HostGetTransferPoolStat(usb_host_handle hostHandle,
+                                                usb_host_transfer_pool_id_t pool,
+                                                usb_host_transfer_pool_stat_t *stat,
+                                                uint8_t reset);
+
 /*!
  * @brief Requests the USB standard request.
  *
@@ -14,6 +14,7 @@
 #include "usb_host_framework.h"
 #endif
 #include "fsl_device_registers.h"
+#include "trace_recorder.h"
 #include "usb_host_ehci.h"
 #if ((defined FSL_FEATURE_SOC_USBPHY_COUNT) && (FSL_FEATURE_SOC_USBPHY_COUNT))
 #include "usb_phy.h"
@@ -3931,6 +3932,16 @@ static void USB_HostEhciTransferCallback(usb_host_transfer_t *transfer, usb_stat
         DCACHE_InvalidateByRange((uint32_t)transfer->transferBuffer, transfer->transferSofar);
     }
 #endif
+    if (status == kStatus_USB_Success)
+    {
+        TRACE_EVENT(kTRACE_UsbDone, TRACE_USB_EP(transfer->transferPipe->endpointAddress, transfer->direction),
+                    TRACE_LEN16(transfer->transferSofar));
+    }
+    else
+    {
+        TRACE_EVENT(kTRACE_UsbError, TRACE_USB_EP(transfer->transferPipe->endpointAddress, transfer->direction),
+                    status);
+    }
     transfer->callbackFn(transfer->callbackParam, transfer, status); 
 }
 
@@ -12,6 +12,7 @@
 #include "usb_host_hci.h"
 #include "usb_host_devices.h"
 #include "fsl_device_registers.h"
+#include "trace_recorder.h"
 
 /*******************************************************************************
  * Definitions
@@ -22,6 +23,31 @@
 #define FSL_COMPONENT_ID "middleware.usb.host_stack"
 #endif
 
+/* transfers reserved by a class, none when the class is disabled */
+#if ((defined USB_HOST_CONFIG_MSD) && (USB_HOST_CONFIG_MSD) && (defined USB_HOST_CONFIG_MSD_TRANSFERS))
+#define USB_HOST_MSD_TRANSFERS (USB_HOST_CONFIG_MSD_TRANSFERS)
+#else
+#define USB_HOST_MSD_TRANSFERS (0U)
+#endif
+#if ((defined USB_HOST_CONFIG_MIDI) && (USB_HOST_CONFIG_MIDI) && (defined USB_HOST_CONFIG_MIDI_TRANSFERS))
+#define USB_HOST_MIDI_TRANSFERS (USB_HOST_CONFIG_MIDI_TRANSFERS)
+#else
+#define USB_HOST_MIDI_TRANSFERS (0U)
+#endif
+#if ((USB_HOST_MSD_TRANSFERS + USB_HOST_MIDI_TRANSFERS) >= USB_HOST_CONFIG_MAX_TRANSFERS)
+#error "the class transfer reservations leave no shared transfer for the enumeration"
+#endif
+
+/* the transfer pools use LDREX/STREX where the core has them, a critical section otherwise */
+#if (defined(__CORTEX_M) && (__CORTEX_M >= 3U))
+#define USB_HOST_TRANSFER_LOCK_FREE (1U)
+#else
+#define USB_HOST_TRANSFER_LOCK_FREE (0U)
+#endif
+
+/* added to a pool counter to decrement it */
+#define USB_HOST_TRANSFER_DECREMENT (0xFFFFFFFFU)
+
 /*******************************************************************************
  * Prototypes
  ******************************************************************************/
@@ -54,12 +80,65 @@ static void USB_HostReleaseInstance(usb_host_instance_t *hostInstance);
 static void USB_HostGetControllerInterface(uint8_t controllerId,
                                            const usb_host_controller_interface_t **controllerTable);
 
+/*!
+ * @brief pop an idle transfer from a pool.
+ *
+ * @param pool    transfer pool.
+ *
+ * @return  transfer pointer, NULL when the pool is empty.
+ */
+static usb_host_transfer_t *USB_HostTransferPop(usb_host_transfer_pool_t *pool);
+
+/*!
+ * @brief push an idle transfer to a pool.
+ *
+ * @param pool      transfer pool.
+ * @param transfer  transfer owned by the pool.
+ */
+static void USB_HostTransferPush(usb_host_transfer_pool_t *pool, usb_host_transfer_t *transfer);
+
+/*!
+ * @brief add to a pool counter.
+ *
+ * @param counter  pool counter.
+ * @param delta    added value, USB_HOST_TRANSFER_DECREMENT to decrement.
+ *
+ * @return  the new value.
+ */
+static uint32_t USB_HostTransferCounterAdd(volatile uint32_t *counter, uint32_t delta);
+
+/*!
+ * @brief raise a pool high-water mark.
+ *
+ * @param highWater  pool high-water mark.
+ * @param value      new usage.
+ */
+static void USB_HostTransferHighWater(volatile uint32_t *highWater, uint32_t value);
+
+/*!
+ * @brief get the pool that owns a transfer.
+ *
+ * @param hostInstance  host instance pointer.
+ * @param transfer      transfer pointer.
+ *
+ * @return  pool pointer, NULL when the transfer is not in the instance's transfer list.
+ */
+static usb_host_transfer_pool_t *USB_HostTransferOwner(usb_host_instance_t *hostInstance,
+                                                       usb_host_transfer_t *transfer);
+
 /*******************************************************************************
  * Variables
  ******************************************************************************/
 /*! @brief USB host instance resource */
 usb_host_instance_t g_UsbHostInstance[USB_HOST_CONFIG_MAX_HOST];
 
+/*! @brief transfers owned by each pool, the pools own contiguous parts of the transfer list in this order */
+static const uint8_t s_TransferPoolSize[kUSB_HostTransferPoolNumOf] = {
+    (uint8_t)(USB_HOST_CONFIG_MAX_TRANSFERS - USB_HOST_MSD_TRANSFERS - USB_HOST_MIDI_TRANSFERS),
+    (uint8_t)USB_HOST_MSD_TRANSFERS,
+    (uint8_t)USB_HOST_MIDI_TRANSFERS,
+};
+
 #if ((defined USB_HOST_CONFIG_EHCI) && (USB_HOST_CONFIG_EHCI))
 #include "usb_host_ehci.h"
 static const usb_host_controller_interface_t s_EhciInterface = {
@@ -229,8 +308,10 @@ usb_status_t USB_HostInit(uint8_t controllerId, usb_host_handle *hostHandle, hos
 {
     usb_status_t status               = kStatus_USB_Success;
     usb_host_instance_t *hostInstance = NULL;
-    usb_host_transfer_t *transferPrev = NULL;
+    usb_host_transfer_pool_t *pool    = NULL;
+    uint8_t first                     = 0;
     uint8_t i                         = 0;
+    uint8_t j                         = 0;
 
     hostInstance = USB_HostGetInstance(); /* get one host instance */
     if (hostInstance == NULL)
@@ -272,14 +353,19 @@ usb_status_t USB_HostInit(uint8_t controllerId, usb_host_handle *hostHandle, hos
         return kStatus_USB_Error;
     }
 
-    /* initialize transfer list */
-
-    hostInstance->transferHead = &hostInstance->transferList[0];
-    transferPrev               = hostInstance->transferHead;
-    for (i = 1; i < USB_HOST_CONFIG_MAX_TRANSFERS; ++i)
+    /* initialize transfer pools, each one links its part of the transfer list */
+    for (i = 0; i < (uint8_t)kUSB_HostTransferPoolNumOf; ++i)
     {
-        transferPrev->next = &hostInstance->transferList[i];
-        transferPrev       = transferPrev->next;
+        pool        = &hostInstance->transferPool[i];
+        pool->first = first;
+        pool->size  = s_TransferPoolSize[i];
+        pool->head  = NULL;
+        for (j = s_TransferPoolSize[i]; j > 0U; --j)
+        {
+            hostInstance->transferList[first + j - 1U].next = pool->head;
+            pool->head                                      = &hostInstance->transferList[first + j - 1U];
+        }
+        first += s_TransferPoolSize[i];
     }
 
     /* controller create, the callbackFn is initialized in USB_HostGetControllerInterface */
@@ -399,6 +485,8 @@ usb_status_t USB_HostSend(usb_host_handle hostHandle, usb_host_pipe_handle pipeH
 #endif
 /* call controller write pipe interface */
     /* the callbackFn is initialized in USB_HostGetControllerInterface */
+    TRACE_EVENT(kTRACE_UsbSubmit, TRACE_USB_EP(((usb_host_pipe_t *)pipeHandle)->endpointAddress, transfer->direction),
+                TRACE_LEN16(transfer->transferLength));
     status = hostInstance->controllerTable->controllerWritePipe(hostInstance->controllerHandle, pipeHandle, transfer);
 
     (void)USB_HostUnlock();
@@ -442,6 +530,8 @@ usb_status_t USB_HostSendSetup(usb_host_handle hostHandle,
 #endif
 /* call controller write pipe interface */
     /* the callbackFn is initialized in USB_HostGetControllerInterface */
+    TRACE_EVENT(kTRACE_UsbSubmit, TRACE_USB_EP(((usb_host_pipe_t *)pipeHandle)->endpointAddress, transfer->direction),
+                TRACE_LEN16(transfer->transferLength));
     status = hostInstance->controllerTable->controllerWritePipe(hostInstance->controllerHandle, pipeHandle, transfer);
 
     (void)USB_HostUnlock();
@@ -474,6 +564,8 @@ usb_status_t USB_HostRecv(usb_host_handle hostHandle, usb_host_pipe_handle pipeH
 #endif
 
     /* the callbackFn is initialized in USB_HostGetControllerInterface */
+    TRACE_EVENT(kTRACE_UsbSubmit, TRACE_USB_EP(((usb_host_pipe_t *)pipeHandle)->endpointAddress, transfer->direction),
+                TRACE_LEN16(transfer->transferLength));
     status = hostInstance->controllerTable->controllerReadPipe(hostInstance->controllerHandle, pipeHandle, transfer);
 
     (void)USB_HostUnlock();
@@ -506,35 +598,155 @@ usb_status_t USB_HostCancelTransfer(usb_host_handle hostHandle,
     return status;
 }
 
+static usb_host_transfer_t *USB_HostTransferPop(usb_host_transfer_pool_t *pool)
+{
+    usb_host_transfer_t *transfer;
+#if (defined USB_HOST_TRANSFER_LOCK_FREE) && (USB_HOST_TRANSFER_LOCK_FREE)
+    /* head->next is read inside the exclusive access. A pop or push by an interrupt or another task in between
+       means an exception, which clears the monitor, so the STREX fails and a stale next is never stored */
+    do
+    {
+        transfer = (usb_host_transfer_t *)__LDREXW((volatile uint32_t *)(void *)&pool->head);
+        if (transfer == NULL)
+        {
+            __CLREX();
+            break;
+        }
+    } while (__STREXW((uint32_t)transfer->next, (volatile uint32_t *)(void *)&pool->head) != 0U);
+#else
+    OSA_SR_ALLOC();
+    OSA_ENTER_CRITICAL();
+    transfer = pool->head;
+    if (transfer != NULL)
+    {
+        pool->head = transfer->next;
+    }
+    OSA_EXIT_CRITICAL();
+#endif
+    return transfer;
+}
+
+static void USB_HostTransferPush(usb_host_transfer_pool_t *pool, usb_host_transfer_t *transfer)
+{
+#if (defined USB_HOST_TRANSFER_LOCK_FREE) && (USB_HOST_TRANSFER_LOCK_FREE)
+    do
+    {
+        transfer->next = (usb_host_transfer_t *)__LDREXW((volatile uint32_t *)(void *)&pool->head);
+    } while (__STREXW((uint32_t)transfer, (volatile uint32_t *)(void *)&pool->head) != 0U);
+#else
+    OSA_SR_ALLOC();
+    OSA_ENTER_CRITICAL();
+    transfer->next = pool->head;
+    pool->head     = transfer;
+    OSA_EXIT_CRITICAL();
+#endif
+}
+
+static uint32_t USB_HostTransferCounterAdd(volatile uint32_t *counter, uint32_t delta)
+{
+    uint32_t value;
+#if (defined USB_HOST_TRANSFER_LOCK_FREE) && (USB_HOST_TRANSFER_LOCK_FREE)
+    do
+    {
+        value = __LDREXW(counter) + delta;
+    } while (__STREXW(value, counter) != 0U);
+#else
+    OSA_SR_ALLOC();
+    OSA_ENTER_CRITICAL();
+    value    = *counter + delta;
+    *counter = value;
+    OSA_EXIT_CRITICAL();
+#endif
+    return value;
+}
+
+static void USB_HostTransferHighWater(volatile uint32_t *highWater, uint32_t value)
+{
+#if (defined USB_HOST_TRANSFER_LOCK_FREE) && (USB_HOST_TRANSFER_LOCK_FREE)
+    do
+    {
+        if (__LDREXW(highWater) >= value)
+        {
+            __CLREX();
+            break;
+        }
+    } while (__STREXW(value, highWater) != 0U);
+#else
+    OSA_SR_ALLOC();
+    OSA_ENTER_CRITICAL();
+    if (*highWater < value)
+    {
+        *highWater = value;
+    }
+    OSA_EXIT_CRITICAL();
+#endif
+}
+
+static usb_host_transfer_pool_t *USB_HostTransferOwner(usb_host_instance_t *hostInstance,
+                                                       usb_host_transfer_t *transfer)
+{
+    uint32_t index = (uint32_t)(transfer - &hostInstance->transferList[0]);
+    uint8_t i;
+
+    for (i = 0; i < (uint8_t)kUSB_HostTransferPoolNumOf; ++i)
+    {
+        /* unsigned, an index below first wraps above size */
+        if ((index - hostInstance->transferPool[i].first) < hostInstance->transferPool[i].size)
+        {
+            return &hostInstance->transferPool[i];
+        }
+    }
+    return NULL;
+}
+
 usb_status_t USB_HostMallocTransfer(usb_host_handle hostHandle, usb_host_transfer_t **transfer)
+{
+    return USB_HostMallocTransferFrom(hostHandle, kUSB_HostTransferPoolShared, transfer);
+}
+
+usb_status_t USB_HostMallocTransferFrom(usb_host_handle hostHandle,
+                                        usb_host_transfer_pool_id_t pool,
+                                        usb_host_transfer_t **transfer)
 {
     usb_host_instance_t *hostInstance = (usb_host_instance_t *)hostHandle;
+    usb_host_transfer_pool_t *owner;
+    usb_host_transfer_t *idle;
 
-    if ((hostHandle == NULL) || (transfer == NULL))
+    if ((hostHandle == NULL) || (transfer == NULL) || ((uint32_t)pool >= (uint32_t)kUSB_HostTransferPoolNumOf))
     {
         return kStatus_USB_InvalidHandle;
     }
 
-    /* get one from the transfer_head */
-    (void)USB_HostLock();
-    if (hostInstance->transferHead != NULL)
+    /* get one from the reservation, then from the shared pool */
+    owner = &hostInstance->transferPool[pool];
+    idle  = USB_HostTransferPop(owner);
+    if ((idle == NULL) && (pool != kUSB_HostTransferPoolShared))
     {
-        *transfer                  = hostInstance->transferHead;
-        hostInstance->transferHead = hostInstance->transferHead->next;
-        (void)USB_HostUnlock();
-        return kStatus_USB_Success;
+        owner = &hostInstance->transferPool[kUSB_HostTransferPoolShared];
+        idle  = USB_HostTransferPop(owner);
+        if (idle != NULL)
+        {
+            (void)USB_HostTransferCounterAdd(&hostInstance->transferPool[pool].borrowed, 1U);
+        }
     }
-    else
+    if (idle == NULL)
     {
+        /* counted for the requested pool, the class only returns kStatus_USB_Busy or kStatus_USB_Error */
+        (void)USB_HostTransferCounterAdd(&hostInstance->transferPool[pool].failures, 1U);
         *transfer = NULL;
-        (void)USB_HostUnlock();
         return kStatus_USB_Error;
     }
+
+    (void)USB_HostTransferCounterAdd(&owner->allocs, 1U);
+    USB_HostTransferHighWater(&owner->highWater, USB_HostTransferCounterAdd(&owner->inUse, 1U));
+    *transfer = idle;
+    return kStatus_USB_Success;
 }
 
 usb_status_t USB_HostFreeTransfer(usb_host_handle hostHandle, usb_host_transfer_t *transfer)
 {
     usb_host_instance_t *hostInstance = (usb_host_instance_t *)hostHandle;
+    usb_host_transfer_pool_t *owner;
 
     if (hostHandle == NULL)
     {
@@ -545,11 +757,48 @@ usb_status_t USB_HostFreeTransfer(usb_host_handle hostHandle, usb_host_transfer_
         return kStatus_USB_Success;
     }
 
-    /* release one to the transfer_head */
-    (void)USB_HostLock();
-    transfer->next             = hostInstance->transferHead;
-    hostInstance->transferHead = transfer;
-    (void)USB_HostUnlock();
+    /* release one to the pool that owns it */
+    owner = USB_HostTransferOwner(hostInstance, transfer);
+    if (owner == NULL)
+    {
+        return kStatus_USB_InvalidParameter;
+    }
+    (void)USB_HostTransferCounterAdd(&owner->inUse, USB_HOST_TRANSFER_DECREMENT);
+    USB_HostTransferPush(owner, transfer);
+    return kStatus_USB_Success;
+}
+
+usb_status_t USB_HostGetTransferPoolStat(usb_host_handle hostHandle,
+                                         usb_host_transfer_pool_id_t pool,
+                                         usb_host_transfer_pool_stat_t *stat,
+                                         uint8_t reset)
+{
+    usb_host_instance_t *hostInstance = (usb_host_instance_t *)hostHandle;
+    usb_host_transfer_pool_t *owner;
+    OSA_SR_ALLOC();
+
+    if ((hostHandle == NULL) || (stat == NULL) || ((uint32_t)pool >= (uint32_t)kUSB_HostTransferPoolNumOf))
+    {
+        return kStatus_USB_InvalidHandle;
+    }
+
+    /* an update preempted by the critical section retries its STREX, so the snapshot and the reset are atomic */
+    owner = &hostInstance->transferPool[pool];
+    OSA_ENTER_CRITICAL();
+    stat->size      = owner->size;
+    stat->inUse     = owner->inUse;
+    stat->highWater = owner->highWater;
+    stat->allocs    = owner->allocs;
+    stat->borrowed  = owner->borrowed;
+    stat->failures  = owner->failures;
+    if (reset != 0U)
+    {
+        owner->highWater = owner->inUse;
+        owner->allocs    = 0U;
+        owner->borrowed  = 0U;
+        owner->failures  = 0U;
+    }
+    OSA_EXIT_CRITICAL();
     return kStatus_USB_Success;
 }
 
@@ -89,6 +89,19 @@ usb_status_t USB_HostTestModeInit(usb_device_handle deviceHandle);
  * @{
  */
 
+/*! @brief USB host transfer pool structure, an idle stack of the transfers the pool owns */
+typedef struct _usb_host_transfer_pool
+{
+    usb_host_transfer_t *volatile head; /*!< Idle transfer head, popped and pushed lock free*/
+    volatile uint32_t inUse;            /*!< Transfers allocated now*/
+    volatile uint32_t highWater;        /*!< Highest inUse*/
+    volatile uint32_t allocs;           /*!< Allocations served by the pool*/
+    volatile uint32_t borrowed;         /*!< Allocations served by the shared pool because this pool was empty*/
+    volatile uint32_t failures;         /*!< Allocations that failed*/
+    uint16_t first;                     /*!< First owned transfer in transferList*/
+    uint16_t size;                      /*!< Owned transfers*/
+} usb_host_transfer_pool_t;
+
 /*! @brief USB host instance structure */
 typedef struct _usb_host_instance
 {
@@ -97,7 +110,7 @@ typedef struct _usb_host_instance
     osa_mutex_handle_t hostMutex;                                    /*!< Host layer mutex*/
     uint32_t mutexBuffer[(OSA_MUTEX_HANDLE_SIZE + 3) / 4];           /*!< Host layer mutex*/
     usb_host_transfer_t transferList[USB_HOST_CONFIG_MAX_TRANSFERS]; /*!< Transfer resource*/
-    usb_host_transfer_t *transferHead;                               /*!< Idle transfer head*/
+    usb_host_transfer_pool_t transferPool[kUSB_HostTransferPoolNumOf]; /*!< Idle transfers by owner*/
     const usb_host_controller_interface_t *controllerTable;          /*!< KHCI/EHCI interface*/
     void *deviceList;                                                /*!< Device list*/
 #if ((defined(USB_HOST_CONFIG_LOW_POWER_MODE)) && (USB_HOST_CONFIG_LOW_POWER_MODE > 0U))
@@ -89,6 +89,11 @@ static SemaphoreHandle_t s_debugConsoleReadSemaphore;
 #if configSUPPORT_STATIC_ALLOCATION
 static StaticSemaphore_t s_debugConsoleReadSemaphoreStatic;
 #endif
+/* serializes the writers, a reliable write keeps its bytes together while it waits for ring buffer space */
+static SemaphoreHandle_t s_debugConsoleWriteSemaphore;
+#if configSUPPORT_STATIC_ALLOCATION
+static StaticSemaphore_t s_debugConsoleWriteSemaphoreStatic;
+#endif
 #if (defined(DEBUG_CONSOLE_RX_ENABLE) && (DEBUG_CONSOLE_RX_ENABLE > 0U))
 static SemaphoreHandle_t s_debugConsoleReadWaitSemaphore;
 #if configSUPPORT_STATIC_ALLOCATION
@@ -251,8 +256,10 @@ typedef struct _debug_console_state_struct
  * Variables
  ******************************************************************************/
 
-/*! @brief Debug console state information. */
-#if (defined(DATA_SECTION_IS_CACHEABLE) && (DATA_SECTION_IS_CACHEABLE > 0))
+/*! @brief Debug console state information. Only the UART DMA port needs it in the non-cacheable section, the
+ * interrupt driven port keeps its rings out of SRAM_DTC. */
+#if (defined(DATA_SECTION_IS_CACHEABLE) && (DATA_SECTION_IS_CACHEABLE > 0)) && \
+    (defined(SERIAL_PORT_TYPE_UART_DMA) && (SERIAL_PORT_TYPE_UART_DMA > 0U))
 AT_NONCACHEABLE_SECTION(static debug_console_state_struct_t s_debugConsoleState);
 #else
 static debug_console_state_struct_t s_debugConsoleState;
@@ -279,6 +286,7 @@ static void DbgConsole_PrintCallback(char *buf, int32_t *indicator, char dbgVal,
 status_t DbgConsole_ReadOneCharacter(uint8_t *ch);
 int DbgConsole_SendData(uint8_t *ch, size_t size);
 int DbgConsole_SendDataReliable(uint8_t *ch, size_t size);
+static int DbgConsole_SendDataReliableUnlocked(uint8_t *ch, size_t size);
 int DbgConsole_ReadLine(uint8_t *buf, size_t size);
 int DbgConsole_ReadCharacter(uint8_t *ch);
 
@@ -546,7 +554,49 @@ int DbgConsole_SendData(uint8_t *ch, size_t size)
     return (((status_t)kStatus_Success == dbgConsoleStatus) ? (int)size : -1);
 }
 
+#if defined(DEBUG_CONSOLE_TRANSFER_NON_BLOCKING) && \
+    (defined(DEBUG_CONSOLE_TX_RELIABLE_ENABLE) && (DEBUG_CONSOLE_TX_RELIABLE_ENABLE > 0U))
+/* wait for the tx interrupt to free some ring buffer space, not for the whole ring to drain */
+static status_t DbgConsole_WaitTxSpace(void)
+{
+#if (DEBUG_CONSOLE_SYNCHRONIZATION_MODE == DEBUG_CONSOLE_SYNCHRONIZATION_FREERTOS)
+    if (0U != IS_RUNNING_IN_ISR())
+    {
+        return (status_t)kStatus_Fail;
+    }
+    if (taskSCHEDULER_RUNNING == xTaskGetSchedulerState())
+    {
+        vTaskDelay(1);
+    }
+    return (status_t)kStatus_Success;
+#else
+    return DbgConsole_Flush();
+#endif
+}
+#endif
+
 int DbgConsole_SendDataReliable(uint8_t *ch, size_t size)
+{
+    int result;
+
+    if (NULL == g_serialHandle)
+    {
+        return 0;
+    }
+
+    /* take mutex lock function */
+#if (DEBUG_CONSOLE_SYNCHRONIZATION_MODE == DEBUG_CONSOLE_SYNCHRONIZATION_FREERTOS)
+    DEBUG_CONSOLE_TAKE_MUTEX_SEMAPHORE_BLOCKING(s_debugConsoleWriteSemaphore);
+#endif
+    result = DbgConsole_SendDataReliableUnlocked(ch, size);
+    /* release mutex lock function */
+#if (DEBUG_CONSOLE_SYNCHRONIZATION_MODE == DEBUG_CONSOLE_SYNCHRONIZATION_FREERTOS)
+    DEBUG_CONSOLE_GIVE_MUTEX_SEMAPHORE(s_debugConsoleWriteSemaphore);
+#endif
+    return result;
+}
+
+static int DbgConsole_SendDataReliableUnlocked(uint8_t *ch, size_t size)
 {
 #if defined(DEBUG_CONSOLE_TRANSFER_NON_BLOCKING)
 #if (defined(DEBUG_CONSOLE_TX_RELIABLE_ENABLE) && (DEBUG_CONSOLE_TX_RELIABLE_ENABLE > 0U))
@@ -590,8 +640,8 @@ int DbgConsole_SendDataReliable(uint8_t *ch, size_t size)
         }
         sendDataLength = s_debugConsoleState.writeRingBuffer.ringBufferSize - sendDataLength - 1U;
 
-        if ((sendDataLength > 0U) && ((sendDataLength >= totalLength) ||
-                                      (totalLength >= (s_debugConsoleState.writeRingBuffer.ringBufferSize - 1U))))
+        /* queue what fits, the writer mutex keeps the rest of the data next to it */
+        if (sendDataLength > 0U)
         {
             if (sendDataLength > totalLength)
             {
@@ -608,7 +658,7 @@ int DbgConsole_SendDataReliable(uint8_t *ch, size_t size)
 
         if (totalLength != 0U)
         {
-            serialManagerStatus = (serial_manager_status_t)DbgConsole_Flush();
+            serialManagerStatus = (serial_manager_status_t)DbgConsole_WaitTxSpace();
             if (kStatus_SerialManager_Success != serialManagerStatus)
             {
                 break;
@@ -738,7 +788,8 @@ static void DbgConsole_PrintCallback(char *buf, int32_t *indicator, char dbgVal,
     {
         if (((uint32_t)*indicator + 1UL) >= (uint32_t)DEBUG_CONSOLE_PRINTF_MAX_LOG_LEN)
         {
-            (void)DbgConsole_SendDataReliable((uint8_t *)buf, (size_t)(*indicator));
+            /* called by DbgConsole_Vprintf with the writer mutex held */
+            (void)DbgConsole_SendDataReliableUnlocked((uint8_t *)buf, (size_t)(*indicator));
             *indicator = 0;
         }
 
@@ -890,8 +941,10 @@ status_t DbgConsole_Init(uint8_t instance, uint32_t baudRate, serial_port_type_t
 #if (DEBUG_CONSOLE_SYNCHRONIZATION_MODE == DEBUG_CONSOLE_SYNCHRONIZATION_FREERTOS)
 #if configSUPPORT_STATIC_ALLOCATION
         DEBUG_CONSOLE_CREATE_MUTEX_SEMAPHORE(s_debugConsoleReadSemaphore, &s_debugConsoleReadSemaphoreStatic);
+        DEBUG_CONSOLE_CREATE_MUTEX_SEMAPHORE(s_debugConsoleWriteSemaphore, &s_debugConsoleWriteSemaphoreStatic);
 #else
         DEBUG_CONSOLE_CREATE_MUTEX_SEMAPHORE(s_debugConsoleReadSemaphore);
+        DEBUG_CONSOLE_CREATE_MUTEX_SEMAPHORE(s_debugConsoleWriteSemaphore);
 #endif
 #endif
 #if (defined(DEBUG_CONSOLE_RX_ENABLE) && (DEBUG_CONSOLE_RX_ENABLE > 0U))
@@ -997,6 +1050,7 @@ status_t DbgConsole_Deinit(void)
 #endif
 #if (DEBUG_CONSOLE_SYNCHRONIZATION_MODE == DEBUG_CONSOLE_SYNCHRONIZATION_FREERTOS)
     DEBUG_CONSOLE_DESTROY_MUTEX_SEMAPHORE(s_debugConsoleReadSemaphore);
+    DEBUG_CONSOLE_DESTROY_MUTEX_SEMAPHORE(s_debugConsoleWriteSemaphore);
 #endif
 
     return (status_t)kStatus_Success;
@@ -1065,10 +1119,17 @@ int DbgConsole_Vprintf(const char *fmt_s, va_list formatStringArg)
 
     if (NULL != g_serialHandle)
     {
+        /* one lock for the whole log, the format callback sends the full chunks of a long one */
+#if (DEBUG_CONSOLE_SYNCHRONIZATION_MODE == DEBUG_CONSOLE_SYNCHRONIZATION_FREERTOS)
+        DEBUG_CONSOLE_TAKE_MUTEX_SEMAPHORE_BLOCKING(s_debugConsoleWriteSemaphore);
+#endif
         /* format print log first */
         logLength = StrFormatPrintf(fmt_s, formatStringArg, printBuf, DbgConsole_PrintCallback);
         /* print log */
-        result = DbgConsole_SendDataReliable((uint8_t *)printBuf, (size_t)logLength);
+        result = DbgConsole_SendDataReliableUnlocked((uint8_t *)printBuf, (size_t)logLength);
+#if (DEBUG_CONSOLE_SYNCHRONIZATION_MODE == DEBUG_CONSOLE_SYNCHRONIZATION_FREERTOS)
+        DEBUG_CONSOLE_GIVE_MUTEX_SEMAPHORE(s_debugConsoleWriteSemaphore);
+#endif
     }
     return result;
 }
@@ -44,7 +44,7 @@
  *
  */
 #ifndef DEBUG_CONSOLE_TRANSMIT_BUFFER_LEN
-#define DEBUG_CONSOLE_TRANSMIT_BUFFER_LEN (512U)
+#define DEBUG_CONSOLE_TRANSMIT_BUFFER_LEN (2048U)
 #endif /* DEBUG_CONSOLE_TRANSMIT_BUFFER_LEN */
 
 /*! @brief define the receive buffer length which is used to store the user input, buffer is enabled automatically when
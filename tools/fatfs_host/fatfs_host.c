@@ -0,0 +1,1374 @@
+/*
+ * fatfs_host.c
+ *
+ *  Created on: 2026/10/18
+ *      Author: M.Akino
+ */
+
+/*
+ * Host build of the storage stack: ff.c, the sector cache (diskio_cache.c) and the USB disk glue
+ * (fsl_usb_disk_freertos.c) on top of a simulated USB stick, see usb_msd_sim.c.
+ * The simulated clock only moves with the disk latency model, so the results and the command counts
+ * of a run are the same on every machine.
+ *
+ * usage: fatfs_host [options] [image]
+ *   image       FAT/exFAT image file (e.g. dd of a USB stick), without it a RAM disk is used
+ *   -s MB       RAM disk size, or the size of a new image (default 64)
+ *   -f TYPE     format first, TYPE: fat, fat32 or exfat
+ *   -r CMD,KB   read10 latency, microseconds per command and per KB (default 300,40)
+ *   -w CMD,KB   write10 latency, microseconds per command and per KB (default 500,120)
+ *   -b KB,BLOCK benchmark like the monitor Bench command, file size and f_read/f_write size
+ *   -z OPS      fuzz: random writes, reads, truncates, syncs, closes, unlinks and remounts,
+ *               checked against a model of the file contents
+ *   -e N        fail about one read10/write10 in N, never twice in a row (the driver retries once)
+ *   -S SEED     random seed (default 1)
+ *   -L N        logical units (1-2), LUN n is drive 1+n, the second one is a RAM disk of the same size;
+ *               the fuzz files are spread over the drives
+ *   -d N        directory index: N files in 1:/lib, the sorted listing and the lookups of the index are
+ *               checked against f_readdir and f_stat, then the directory is changed and indexed again
+ *   -t N        trim: drive 1: is formatted on a new stick with the flash model of usb_msd_sim.h, filled
+ *               and then N times half deleted and written again, once with UNMAP and once without
+ *
+ * The volumes are mounted with FastMount_Mount, the main loop runs the background free cluster count a
+ * few steps at a time between the operations and the result is checked against a full f_getfree scan.
+ *
+ * After a run on an image, "fsck.fat -n image" checks the FAT structure.
+ */
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+#include <unistd.h>
+#include "ff.h"
+#include "diskio.h"
+#include "diskio_cache.h"
+#include "dir_index.h"
+#include "fast_mount.h"
+#include "fsl_usb_disk.h"
+#include "host_rtos.h"
+#include "usb_msd_sim.h"
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+
+#define HOST_DRIVE "1:"
+#define HOST_DRIVE_FORMAT "%c:"
+
+#define BENCH_MAX_BLOCK (65536U)
+#define BENCH_SAMPLES (512U)
+
+#define FUZZ_FILES (4U)
+#define FUZZ_MAX_SIZE (256U * 1024U)
+#define FUZZ_MAX_IO (16384U)
+
+#define LIB_DIR HOST_DRIVE "/lib"
+
+#define TRIM_FILES (48U)
+#define TRIM_FILL_PERMIL (850U)
+#define TRIM_MAX_CYCLES (32U)
+#define TRIM_BLOCK (32768U)
+/* spare pages and garbage collection copy time of the simulated stick */
+#define TRIM_SPARE_PERMIL (70U)
+#define TRIM_COPY_KBYTE (60U)
+
+/* background count steps per main loop pass, the low priority task on the target gets the idle time */
+#define COUNT_STEPS (16U)
+
+/*! @brief fuzz file and its expected contents */
+typedef struct _fuzz_file
+{
+    FIL fil;
+    uint8_t open;           /*!< 1: fil is open */
+    uint8_t exists;         /*!< 1: the file was created and not unlinked */
+    uint32_t size;          /*!< expected size */
+    uint8_t data[FUZZ_MAX_SIZE]; /*!< expected contents */
+} fuzz_file_t;
+
+/*******************************************************************************
+ * Variables
+ ******************************************************************************/
+
+static FATFS s_hostFs[USB_HOST_FATFS_LUNS];
+static uint8_t s_hostLuns = 1U;
+static FIL s_benchFile;
+static uint8_t s_benchBuf[BENCH_MAX_BLOCK];
+static uint32_t s_benchSample[BENCH_SAMPLES];
+static fuzz_file_t s_fuzzFile[FUZZ_FILES];
+static uint8_t s_fuzzBuf[FUZZ_MAX_IO];
+static uint8_t s_mkfsWork[FF_MAX_SS * 64U];
+static uint32_t s_hostSeed = 1U;
+#if ((defined DIR_INDEX_ENABLE) && (DIR_INDEX_ENABLE))
+static dir_index_t s_libIndex;
+static dir_index_t s_libBusy; /* a second open of the same index */
+static FILINFO s_libInfo;
+static TCHAR s_libPrev[FF_LFN_BUF + 1];
+#endif
+static volatile uint8_t s_flushRequest;
+
+/*******************************************************************************
+ * Code
+ ******************************************************************************/
+
+/* the timer callback only asks, the flush runs in the main loop as in the msd task */
+void USB_HostMsdFlushRequest(void)
+{
+    s_flushRequest = 1U;
+}
+
+static void HostPoll(void)
+{
+    HostTimerPoll();
+    if (s_flushRequest)
+    {
+        s_flushRequest = 0U;
+        for (uint8_t lun = 0U; lun < s_hostLuns; lun++)
+        {
+            (void)USB_HostMsdFlushDisk(USBDISK + lun);
+        }
+    }
+#if ((defined FAST_MOUNT_ENABLE) && (FAST_MOUNT_ENABLE))
+    for (uint32_t i = 0U; (i < COUNT_STEPS) && FastMount_Count(); i++)
+    {
+    }
+#endif
+}
+
+/* xorshift32 */
+static uint32_t HostRandom(void)
+{
+    s_hostSeed ^= s_hostSeed << 13;
+    s_hostSeed ^= s_hostSeed >> 17;
+    s_hostSeed ^= s_hostSeed << 5;
+    return s_hostSeed;
+}
+
+static uint64_t HostCpuNs(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000U + (uint64_t)ts.tv_nsec;
+}
+
+static int HostParsePair(const char *arg, uint32_t *a, uint32_t *b)
+{
+    char *end;
+
+    *a = (uint32_t)strtoul(arg, &end, 10);
+    if (*end != ',')
+    {
+        return -1;
+    }
+    *b = (uint32_t)strtoul(end + 1, &end, 10);
+    return (*end == '\0') ? 0 : -1;
+}
+
+static const char *HostFsTypeName(BYTE type)
+{
+    switch (type)
+    {
+        case FS_FAT12:
+            return "FAT12";
+        case FS_FAT16:
+            return "FAT16";
+        case FS_FAT32:
+            return "FAT32";
+        case FS_EXFAT:
+            return "exFAT";
+        default:
+            return "?";
+    }
+}
+
+static void HostDrive(TCHAR *drive, uint8_t lun)
+{
+    snprintf(drive, 4, HOST_DRIVE_FORMAT, (char)('0' + USBDISK + lun));
+}
+
+static FRESULT HostMount(uint8_t verbose)
+{
+    DWORD freeClusters;
+    FATFS *fs;
+    FRESULT res = FR_OK;
+    TCHAR drive[4];
+
+    for (uint8_t lun = 0U; (lun < s_hostLuns) && (res == FR_OK); lun++)
+    {
+        HostDrive(drive, lun);
+#if ((defined FAST_MOUNT_ENABLE) && (FAST_MOUNT_ENABLE))
+        res = FastMount_Mount(&s_hostFs[lun], drive);
+        if ((res == FR_OK) && verbose)
+        {
+            fast_mount_stat_t stat;
+
+            FastMount_GetStat(&stat, 0U);
+            printf("%s mounted in %uus%s\n", drive, stat.mountUs,
+                   FastMount_Pending() ? ", counting the free clusters" : "");
+            while (FastMount_Count())
+            {
+            }
+        }
+#else
+        res = f_mount(&s_hostFs[lun], drive, 1);
+#endif
+        if ((res == FR_OK) && verbose)
+        {
+            res = f_getfree(drive, &freeClusters, &fs);
+            if (res == FR_OK)
+            {
+                printf("%s %s %u sectors/cluster, %lu clusters, %lu free\n", drive, HostFsTypeName(fs->fs_type),
+                       fs->csize, (unsigned long)(fs->n_fatent - 2U), (unsigned long)freeClusters);
+            }
+        }
+    }
+    return res;
+}
+
+static FRESULT HostUnmount(void)
+{
+    FRESULT res = FR_OK;
+    TCHAR drive[4];
+
+    for (uint8_t lun = 0U; lun < s_hostLuns; lun++)
+    {
+        HostDrive(drive, lun);
+#if ((defined FAST_MOUNT_ENABLE) && (FAST_MOUNT_ENABLE))
+        FastMount_Cancel(drive);
+#endif
+        if (res == FR_OK)
+        {
+            ff_volume_close(USBDISK + lun);
+            res = f_unmount(drive);
+            ff_volume_open(USBDISK + lun);
+        }
+        (void)disk_ioctl(USBDISK + lun, CTRL_SYNC, NULL);
+#if ((defined DISK_CACHE_ENABLE) && (DISK_CACHE_ENABLE))
+        DiskCache_Invalidate(USBDISK + lun);
+#endif
+    }
+    return res;
+}
+
+/* the free cluster count FatFs keeps (from FSINFO, the background count and the allocations since)
+   against a full FAT scan, drain: finish the running counts first */
+static int HostCheckFree(uint8_t drain)
+{
+    DWORD freeClusters;
+    FATFS *fs;
+    TCHAR drive[4];
+
+#if ((defined FAST_MOUNT_ENABLE) && (FAST_MOUNT_ENABLE))
+    while (drain && FastMount_Count())
+    {
+    }
+#endif
+    for (uint8_t lun = 0U; lun < s_hostLuns; lun++)
+    {
+        DWORD kept = s_hostFs[lun].free_clst;
+        FRESULT res;
+
+        if (kept > (s_hostFs[lun].n_fatent - 2U))
+        {
+            /* not known yet */
+            continue;
+        }
+        HostDrive(drive, lun);
+        s_hostFs[lun].free_clst = 0xFFFFFFFFU;
+        res                     = f_getfree(drive, &freeClusters, &fs);
+        if ((res != FR_OK) || (freeClusters != kept))
+        {
+            printf("%s free clusters %lu, a scan finds %lu (%d)\n", drive, (unsigned long)kept,
+                   (unsigned long)freeClusters, res);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/* the next phase starts from the drive, nothing left in the caches */
+static void HostColdCache(void)
+{
+    (void)disk_ioctl(USBDISK, CTRL_SYNC, NULL);
+#if ((defined DISK_CACHE_ENABLE) && (DISK_CACHE_ENABLE))
+    DiskCache_Invalidate(USBDISK);
+#endif
+}
+
+static int BenchCompare(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a;
+    uint32_t y = *(const uint32_t *)b;
+
+    return (x > y) - (x < y);
+}
+
+/* same phases and figures as BenchPhase of the debug monitor, plus the host CPU time per call */
+static FRESULT BenchPhase(const char *name, int write, int random, uint32_t block, uint32_t blocks)
+{
+    uint32_t perUs = SystemCoreClock / 1000000U;
+    uint32_t seed  = 1U;
+    uint32_t pick  = 7U;
+    uint64_t total = 0U;
+    uint32_t max   = 0U;
+    uint64_t cpu;
+    uint32_t n;
+    usb_host_fatfs_transfer_stat_t usb;
+    FRESULT res;
+
+    HostColdCache();
+    res = f_lseek(&s_benchFile, 0);
+    USB_HostMsdTransferGetStat(&usb, 1U);
+    cpu = HostCpuNs();
+    for (uint32_t i = 0U; (i < blocks) && (res == FR_OK); ++i)
+    {
+        uint32_t cycles;
+        UINT len = 0U;
+
+        cycles = DWT->CYCCNT;
+        if (random)
+        {
+            seed = seed * 1103515245U + 12345U;
+            res  = f_lseek(&s_benchFile, (FSIZE_t)((seed >> 8) % blocks) * block);
+        }
+        if (res == FR_OK)
+        {
+            res = write ? f_write(&s_benchFile, s_benchBuf, block, &len) :
+                          f_read(&s_benchFile, s_benchBuf, block, &len);
+        }
+        cycles = DWT->CYCCNT - cycles;
+        if ((res == FR_OK) && (len != block))
+        {
+            res = FR_DENIED; /* disk full */
+        }
+        HostPoll();
+        total += cycles;
+        if (cycles > max)
+        {
+            max = cycles;
+        }
+        if (i < BENCH_SAMPLES)
+        {
+            s_benchSample[i] = cycles;
+        }
+        else
+        {
+            pick = pick * 1103515245U + 12345U;
+            if (((pick >> 8) % (i + 1U)) < BENCH_SAMPLES)
+            {
+                s_benchSample[(pick >> 8) % BENCH_SAMPLES] = cycles;
+            }
+        }
+    }
+    if (write && (res == FR_OK))
+    {
+        uint32_t cycles = DWT->CYCCNT;
+
+        res = f_sync(&s_benchFile);
+        total += DWT->CYCCNT - cycles;
+    }
+    cpu = HostCpuNs() - cpu;
+    if (res != FR_OK)
+    {
+        return res;
+    }
+    USB_HostMsdTransferGetStat(&usb, 0U);
+
+    n = (blocks < BENCH_SAMPLES) ? blocks : BENCH_SAMPLES;
+    qsort(s_benchSample, n, sizeof(s_benchSample[0]), BenchCompare);
+    printf(" %s %7luKB/s p50 %8.1fus p99 %8.1fus max %8.1fus  %u read10 %u write10 host cpu %.2fus/call\n",
+           name, (unsigned long)((total != 0U) ? ((uint64_t)blocks * block * 1000000U / 1024U * perUs) / total : 0U),
+           (double)s_benchSample[(n - 1U) * 50U / 100U] / perUs, (double)s_benchSample[(n - 1U) * 99U / 100U] / perUs,
+           (double)max / perUs, usb.readCommands, usb.writeCommands, (double)cpu / 1000.0 / blocks);
+    return FR_OK;
+}
+
+static int HostBench(uint32_t kbytes, uint32_t block)
+{
+    uint32_t blocks;
+    FRESULT res;
+
+    if ((kbytes == 0U) || (block == 0U) || (block > BENCH_MAX_BLOCK) || (((uint64_t)kbytes * 1024U) < block))
+    {
+        fprintf(stderr, "bench: KB must be at least one block, block 1-%u\n", BENCH_MAX_BLOCK);
+        return 1;
+    }
+    blocks = (uint32_t)(((uint64_t)kbytes * 1024U) / block);
+    for (uint32_t i = 0U; i < block; ++i)
+    {
+        s_benchBuf[i] = (uint8_t)i;
+    }
+
+    res = f_open(&s_benchFile, HOST_DRIVE "/bench.bin", FA_READ | FA_WRITE | FA_CREATE_ALWAYS);
+    if (res != FR_OK)
+    {
+        fprintf(stderr, "bench: open error (%d)\n", res);
+        return 1;
+    }
+    printf("bench %u x %uB\n", blocks, block);
+    res = BenchPhase("seq  write", 1, 0, block, blocks);
+    if (res == FR_OK)
+    {
+        res = BenchPhase("seq  read ", 0, 0, block, blocks);
+    }
+    if (res == FR_OK)
+    {
+        res = BenchPhase("rand write", 1, 1, block, blocks);
+    }
+    if (res == FR_OK)
+    {
+        res = BenchPhase("rand read ", 0, 1, block, blocks);
+    }
+    f_close(&s_benchFile);
+    if (res != FR_OK)
+    {
+        fprintf(stderr, "bench: error (%d)\n", res);
+        return 1;
+    }
+    return HostCheckFree(1U);
+}
+
+static void FuzzPath(TCHAR *path, uint32_t index)
+{
+    /* long names go through the LFN entries, the files take turns on the drives */
+    snprintf(path, 64, HOST_DRIVE_FORMAT "/fuzz/Long File Name %u.bin", (char)('0' + USBDISK + index % s_hostLuns),
+             index);
+}
+
+static FRESULT FuzzOpen(fuzz_file_t *file, uint32_t index)
+{
+    TCHAR path[64];
+    FRESULT res = FR_OK;
+
+    if (!file->open)
+    {
+        FuzzPath(path, index);
+        res = f_open(&file->fil, path, FA_READ | FA_WRITE | FA_OPEN_ALWAYS);
+        if (res == FR_OK)
+        {
+            file->open   = 1U;
+            file->exists = 1U;
+        }
+    }
+    return res;
+}
+
+static FRESULT FuzzClose(fuzz_file_t *file)
+{
+    FRESULT res = FR_OK;
+
+    if (file->open)
+    {
+        file->open = 0U;
+        res        = f_close(&file->fil);
+    }
+    return res;
+}
+
+/* compare every file on the volume with the model */
+static int FuzzVerify(void)
+{
+    TCHAR path[64];
+    FILINFO info;
+    FIL fil;
+
+    for (uint32_t i = 0U; i < FUZZ_FILES; ++i)
+    {
+        fuzz_file_t *file = &s_fuzzFile[i];
+        FRESULT res;
+        UINT len;
+
+        FuzzPath(path, i);
+        res = f_stat(path, &info);
+        if (!file->exists)
+        {
+            if (res != FR_NO_FILE)
+            {
+                printf("verify: %s should not exist (%d)\n", path, res);
+                return 1;
+            }
+            continue;
+        }
+        if ((res != FR_OK) || (info.fsize != file->size))
+        {
+            printf("verify: %s stat %d size %lu, expected %u\n", path, res, (unsigned long)info.fsize, file->size);
+            return 1;
+        }
+        res = f_open(&fil, path, FA_READ);
+        for (uint32_t ofs = 0U; (res == FR_OK) && (ofs < file->size); ofs += len)
+        {
+            res = f_read(&fil, s_fuzzBuf, sizeof(s_fuzzBuf), &len);
+            if ((res == FR_OK) && ((len == 0U) || (memcmp(s_fuzzBuf, &file->data[ofs], len) != 0)))
+            {
+                printf("verify: %s differs at %u\n", path, ofs);
+                f_close(&fil);
+                return 1;
+            }
+        }
+        if (res != FR_OK)
+        {
+            printf("verify: %s read error (%d)\n", path, res);
+            return 1;
+        }
+        f_close(&fil);
+    }
+    return 0;
+}
+
+static int HostFuzz(uint32_t ops)
+{
+    uint32_t count[8] = {0};
+    FRESULT res;
+
+    for (uint8_t lun = 0U; lun < s_hostLuns; lun++)
+    {
+        TCHAR path[16];
+
+        snprintf(path, sizeof(path), HOST_DRIVE_FORMAT "/fuzz", (char)('0' + USBDISK + lun));
+        res = f_mkdir(path);
+        if ((res != FR_OK) && (res != FR_EXIST))
+        {
+            fprintf(stderr, "fuzz: mkdir error (%d)\n", res);
+            return 1;
+        }
+    }
+    /* start from empty files, the model does not know earlier contents */
+    for (uint32_t i = 0U; i < FUZZ_FILES; ++i)
+    {
+        TCHAR path[64];
+
+        FuzzPath(path, i);
+        res = f_unlink(path);
+        if ((res != FR_OK) && (res != FR_NO_FILE))
+        {
+            fprintf(stderr, "fuzz: unlink error (%d)\n", res);
+            return 1;
+        }
+    }
+
+    for (uint32_t op = 0U; op < ops; ++op)
+    {
+        uint32_t index    = HostRandom() % FUZZ_FILES;
+        fuzz_file_t *file = &s_fuzzFile[index];
+        uint32_t kind     = HostRandom() % 100U;
+        uint32_t ofs, len;
+        UINT done = 0U;
+
+        res = FR_OK;
+        if (kind < 35U)
+        {
+            /* write at or before the end, short writes hit the FIL buffer, long ones go direct */
+            ofs = HostRandom() % (file->size + 1U);
+            len = 1U + HostRandom() % ((HostRandom() & 1U) ? 600U : FUZZ_MAX_IO);
+            if ((ofs + len) > FUZZ_MAX_SIZE)
+            {
+                len = FUZZ_MAX_SIZE - ofs;
+            }
+            for (uint32_t i = 0U; i < len; ++i)
+            {
+                s_fuzzBuf[i] = (uint8_t)HostRandom();
+            }
+            res = FuzzOpen(file, index);
+            if (res == FR_OK)
+            {
+                res = f_lseek(&file->fil, ofs);
+            }
+            if (res == FR_OK)
+            {
+                res = f_write(&file->fil, s_fuzzBuf, len, &done);
+            }
+            if ((res == FR_OK) && (done != len))
+            {
+                res = FR_DENIED;
+            }
+            if (res == FR_OK)
+            {
+                memcpy(&file->data[ofs], s_fuzzBuf, len);
+                if ((ofs + len) > file->size)
+                {
+                    file->size = ofs + len;
+                }
+            }
+            count[0]++;
+        }
+        else if (kind < 60U)
+        {
+            ofs = (file->size != 0U) ? (HostRandom() % file->size) : 0U;
+            len = 1U + HostRandom() % FUZZ_MAX_IO;
+            res = FuzzOpen(file, index);
+            if (res == FR_OK)
+            {
+                res = f_lseek(&file->fil, ofs);
+            }
+            if (res == FR_OK)
+            {
+                res = f_read(&file->fil, s_fuzzBuf, len, &done);
+            }
+            if ((res == FR_OK) &&
+                ((done != (((file->size - ofs) < len) ? (file->size - ofs) : len)) ||
+                 (memcmp(s_fuzzBuf, &file->data[ofs], done) != 0)))
+            {
+                printf("fuzz: op %u read of file %u at %u+%u differs\n", op, index, ofs, len);
+                return 1;
+            }
+            count[1]++;
+        }
+        else if (kind < 65U)
+        {
+            ofs = HostRandom() % (file->size + 1U);
+            res = FuzzOpen(file, index);
+            if (res == FR_OK)
+            {
+                res = f_lseek(&file->fil, ofs);
+            }
+            if (res == FR_OK)
+            {
+                res = f_truncate(&file->fil);
+            }
+            if (res == FR_OK)
+            {
+                file->size = ofs;
+            }
+            count[2]++;
+        }
+        else if (kind < 75U)
+        {
+            if (file->open)
+            {
+                res = f_sync(&file->fil);
+            }
+            count[3]++;
+        }
+        else if (kind < 85U)
+        {
+            res = FuzzClose(file);
+            count[4]++;
+        }
+        else if (kind < 90U)
+        {
+            TCHAR path[64];
+
+            res = FuzzClose(file);
+            if ((res == FR_OK) && file->exists)
+            {
+                FuzzPath(path, index);
+                res          = f_unlink(path);
+                file->exists = 0U;
+                file->size   = 0U;
+            }
+            count[5]++;
+        }
+        else if (kind < 95U)
+        {
+            /* remount from the media, what is not on the simulated disk now is lost */
+            for (uint32_t i = 0U; (i < FUZZ_FILES) && (res == FR_OK); ++i)
+            {
+                res = FuzzClose(&s_fuzzFile[i]);
+            }
+            if ((res == FR_OK) && HostCheckFree(0U))
+            {
+                printf("fuzz: op %u free cluster count\n", op);
+                return 1;
+            }
+            if (res == FR_OK)
+            {
+                res = HostUnmount();
+            }
+            if (res == FR_OK)
+            {
+                res = HostMount(0U);
+            }
+            if ((res == FR_OK) && FuzzVerify())
+            {
+                printf("fuzz: op %u remount lost data\n", op);
+                return 1;
+            }
+            count[6]++;
+        }
+        else
+        {
+            /* idle time, the write flush timer may expire */
+            HostClockAdvance((uint64_t)(HostRandom() % 500U) * 1000U);
+            count[7]++;
+        }
+        HostPoll();
+        if (res != FR_OK)
+        {
+            printf("fuzz: op %u (kind %u) file %u error %d\n", op, kind, index, res);
+            return 1;
+        }
+    }
+
+    for (uint32_t i = 0U; (i < FUZZ_FILES) && (res == FR_OK); ++i)
+    {
+        res = FuzzClose(&s_fuzzFile[i]);
+    }
+    if ((res != FR_OK) || FuzzVerify() || HostCheckFree(1U))
+    {
+        printf("fuzz: final check failed (%d)\n", res);
+        return 1;
+    }
+    printf("fuzz %u ops: %u write %u read %u truncate %u sync %u close %u unlink %u remount %u idle, ok\n", ops,
+           count[0], count[1], count[2], count[3], count[4], count[5], count[6], count[7]);
+    return 0;
+}
+
+#if ((defined DIR_INDEX_ENABLE) && (DIR_INDEX_ENABLE))
+/* name with the case of every letter flipped at random */
+static void LibName(TCHAR *name, uint32_t i, uint32_t salt)
+{
+    static const char *const kind[] = {"Kick", "snare", "HiHat", "Pad", "bass", "Strings"};
+
+    snprintf(name, 64, "%s %05u %c%c.wav", kind[(i ^ salt) % 6U], (i * 7919U) % 100000U,
+             (char)('a' + ((i + salt) % 26U)), (char)('A' + ((i / 26U) % 26U)));
+    for (char *p = name; *p != '\0'; p++)
+    {
+        if ((((*p >= 'a') && (*p <= 'z')) || ((*p >= 'A') && (*p <= 'Z'))) && (HostRandom() & 1U))
+        {
+            *p ^= 0x20;
+        }
+    }
+}
+
+static int LibCompare(const FILINFO *a, const TCHAR *prevName, BYTE prevAttr)
+{
+    if ((a->fattrib ^ prevAttr) & AM_DIR)
+    {
+        return (prevAttr & AM_DIR) ? -1 : 1;
+    }
+    return strcasecmp(prevName, a->fname);
+}
+
+/* every entry in order, each one as f_stat sees it and found again by DirIndex_Find */
+static int LibCheck(uint32_t expected)
+{
+    BYTE prevAttr = 0U;
+    uint32_t n;
+    FRESULT res;
+
+    for (n = 0U;; n++)
+    {
+        TCHAR path[sizeof(LIB_DIR) + FF_LFN_BUF + 1];
+        FILINFO info;
+        dir_index_entry_t entry;
+        FIL fil;
+
+        res = DirIndex_Read(&s_libIndex, n, &s_libInfo);
+        if ((res != FR_OK) || (s_libInfo.fname[0] == 0))
+        {
+            break;
+        }
+        if ((n != 0U) && (LibCompare(&s_libInfo, s_libPrev, prevAttr) >= 0))
+        {
+            printf("dir: %s after %s\n", s_libInfo.fname, s_libPrev);
+            return 1;
+        }
+        strcpy(s_libPrev, s_libInfo.fname);
+        prevAttr = s_libInfo.fattrib;
+
+        snprintf(path, sizeof(path), LIB_DIR "/%s", s_libInfo.fname);
+        res = f_stat(path, &info);
+        if ((res != FR_OK) || (info.fsize != s_libInfo.fsize) || (info.fattrib != s_libInfo.fattrib))
+        {
+            printf("dir: %s differs from f_stat (%d)\n", s_libInfo.fname, res);
+            return 1;
+        }
+        /* the lookup ignores the case as FatFs does */
+        for (char *p = s_libInfo.fname; *p != '\0'; p++)
+        {
+            *p = (HostRandom() & 1U) ? (TCHAR)tolower((unsigned char)*p) : (TCHAR)toupper((unsigned char)*p);
+        }
+        res = DirIndex_Find(&s_libIndex, s_libInfo.fname, &entry);
+        if ((res != FR_OK) || (entry.fsize != info.fsize))
+        {
+            printf("dir: %s not found (%d)\n", s_libInfo.fname, res);
+            return 1;
+        }
+        if (!(info.fattrib & AM_DIR) && (f_open(&fil, path, FA_READ) == FR_OK))
+        {
+            DWORD sclust = fil.obj.sclust;
+
+            f_close(&fil);
+            if (sclust != entry.sclust)
+            {
+                printf("dir: %s cluster %lu, index %lu\n", path, (unsigned long)sclust, (unsigned long)entry.sclust);
+                return 1;
+            }
+        }
+    }
+    if ((res != FR_OK) || (n != expected))
+    {
+        printf("dir: %u of %u entries (%d)\n", n, expected, res);
+        return 1;
+    }
+    if (DirIndex_Find(&s_libIndex, "no such file.wav", &(dir_index_entry_t){0}) != FR_NO_FILE)
+    {
+        printf("dir: found a missing file\n");
+        return 1;
+    }
+    return 0;
+}
+
+/* open the index, build: 1 when it has to be written */
+static int LibOpen(const char *what, uint32_t build)
+{
+    uint64_t us = HostClockUs();
+    dir_index_stat_t before, after;
+    FRESULT res;
+
+    DirIndex_GetStat(&before, 0U);
+    res = DirIndex_Open(&s_libIndex, LIB_DIR);
+    DirIndex_GetStat(&after, 0U);
+    printf("dir index %-8s %6.1fms\n", what, (double)(HostClockUs() - us) / 1e3);
+    if ((res != FR_OK) || ((after.builds - before.builds) != build))
+    {
+        printf("dir: open (%d), %u builds\n", res, after.builds - before.builds);
+        if (res == FR_OK)
+        {
+            DirIndex_Close(&s_libIndex);
+        }
+        return 1;
+    }
+    return 0;
+}
+
+static int HostDirTest(uint32_t files)
+{
+    uint32_t dirs    = files / 32U;
+    uint32_t entries = files + dirs;
+    uint64_t us;
+    TCHAR path[96];
+    DIR dir;
+    FIL fil;
+    UINT bw;
+    FRESULT res;
+
+    res = f_mkdir(LIB_DIR);
+    for (uint32_t i = 0U; (res == FR_OK) && (i < entries); i++)
+    {
+        TCHAR name[64];
+
+        LibName(name, i, 0U);
+        snprintf(path, sizeof(path), LIB_DIR "/%s", name);
+        if (i < dirs)
+        {
+            path[strlen(path) - 4U] = '\0'; /* no .wav */
+            res = f_mkdir(path);
+            continue;
+        }
+        res = f_open(&fil, path, FA_WRITE | FA_CREATE_NEW);
+        if (res == FR_OK)
+        {
+            res = f_write(&fil, s_fuzzBuf, HostRandom() % 3000U, &bw);
+            f_close(&fil);
+        }
+    }
+    if (res != FR_OK)
+    {
+        printf("dir: create error (%d)\n", res);
+        return 1;
+    }
+    HostUnmount();
+    HostMount(0U);
+    HostColdCache();
+
+    /* what the monitor Dir did before: f_readdir over the whole directory */
+    us  = HostClockUs();
+    res = f_opendir(&dir, LIB_DIR);
+    while ((res == FR_OK) && ((res = f_readdir(&dir, &s_libInfo)) == FR_OK) && (s_libInfo.fname[0] != 0))
+    {
+    }
+    f_closedir(&dir);
+    printf("dir %u entries: f_readdir %6.1fms\n", entries, (double)(HostClockUs() - us) / 1e3);
+
+    if (entries < DIR_INDEX_MIN_ENTRIES)
+    {
+        res = DirIndex_Open(&s_libIndex, LIB_DIR);
+        printf("dir index %s\n", (res == FR_NO_FILE) ? "not needed" : "opened");
+        return (res == FR_NO_FILE) ? 0 : 1;
+    }
+    if (LibOpen("build", 1U) || LibCheck(entries) || (DirIndex_Close(&s_libIndex) != FR_OK))
+    {
+        return 1;
+    }
+    HostUnmount();
+    HostMount(0U);
+    HostColdCache();
+    if (LibOpen("check", 0U))
+    {
+        return 1;
+    }
+    us = HostClockUs();
+    for (uint32_t n = 0U; (DirIndex_Read(&s_libIndex, n, &s_libInfo) == FR_OK) && (s_libInfo.fname[0] != 0); n++)
+    {
+    }
+    printf("dir index listing  %6.1fms\n", (double)(HostClockUs() - us) / 1e3);
+    us = HostClockUs();
+    for (uint32_t i = dirs; i < entries; i += 16U)
+    {
+        TCHAR name[64];
+
+        LibName(name, i, 0U);
+        if (DirIndex_Find(&s_libIndex, name, &(dir_index_entry_t){0}) != FR_OK)
+        {
+            printf("dir: %s not found\n", name);
+            return 1;
+        }
+    }
+    printf("dir index lookup   %6.1fms for %u names\n", (double)(HostClockUs() - us) / 1e3, (files + 15U) / 16U);
+    us = HostClockUs();
+    for (uint32_t i = dirs; i < entries; i += 16U)
+    {
+        TCHAR name[64];
+
+        LibName(name, i, 0U);
+        snprintf(path, sizeof(path), LIB_DIR "/%s", name);
+        if (f_stat(path, &s_libInfo) != FR_OK)
+        {
+            printf("dir: %s f_stat failed\n", path);
+            return 1;
+        }
+    }
+    printf("dir f_stat         %6.1fms for %u names\n", (double)(HostClockUs() - us) / 1e3, (files + 15U) / 16U);
+
+    /* a change: one file less, one more and a new size, the index is built again once it is closed */
+    LibName(path, entries - 1U, 0U);
+    {
+        TCHAR full[sizeof(LIB_DIR) + FF_LFN_BUF + 1];
+
+        snprintf(full, sizeof(full), LIB_DIR "/%s", path);
+        res = f_unlink(full);
+    }
+    if (res == FR_OK)
+    {
+        res = f_open(&fil, LIB_DIR "/zz new take.wav", FA_WRITE | FA_CREATE_NEW);
+        if (res == FR_OK)
+        {
+            res = f_write(&fil, s_fuzzBuf, 1234U, &bw);
+            f_close(&fil);
+        }
+    }
+    if (res == FR_OK)
+    {
+        LibName(path, dirs, 0U);
+        {
+            TCHAR full[sizeof(LIB_DIR) + FF_LFN_BUF + 1];
+
+            snprintf(full, sizeof(full), LIB_DIR "/%s", path);
+            res = f_open(&fil, full, FA_WRITE | FA_OPEN_APPEND);
+        }
+        if (res == FR_OK)
+        {
+            res = f_write(&fil, s_fuzzBuf, 100U, &bw);
+            f_close(&fil);
+        }
+    }
+    if (res != FR_OK)
+    {
+        printf("dir: change (%d)\n", res);
+        return 1;
+    }
+    res = DirIndex_Open(&s_libBusy, LIB_DIR);
+    if ((res != FR_LOCKED) || (DirIndex_Close(&s_libIndex) != FR_OK))
+    {
+        printf("dir: open index rebuilt (%d)\n", res);
+        return 1;
+    }
+    /* a listing takes an up to date index only and writes nothing */
+    res = DirIndex_OpenExisting(&s_libIndex, LIB_DIR);
+    if (res != FR_NO_FILE)
+    {
+        printf("dir: out of date index opened for a listing (%d)\n", res);
+        return 1;
+    }
+    if (LibOpen("rebuild", 1U) || LibCheck(entries) || (DirIndex_Close(&s_libIndex) != FR_OK))
+    {
+        return 1;
+    }
+    if (LibOpen("check", 0U) || (DirIndex_Close(&s_libIndex) != FR_OK))
+    {
+        return 1;
+    }
+    /* a user file of the index name is neither rebuilt nor deleted */
+    res = f_unlink(LIB_DIR "/" DIR_INDEX_FILE_NAME);
+    if (res == FR_OK)
+    {
+        res = f_open(&fil, LIB_DIR "/" DIR_INDEX_FILE_NAME, FA_WRITE | FA_CREATE_NEW);
+        if (res == FR_OK)
+        {
+            memset(s_fuzzBuf, 'u', 100U);
+            res = f_write(&fil, s_fuzzBuf, 100U, &bw);
+            f_close(&fil);
+        }
+    }
+    if (res == FR_OK)
+    {
+        res = DirIndex_Open(&s_libIndex, LIB_DIR);
+        if ((res != FR_EXIST) || (f_stat(LIB_DIR "/" DIR_INDEX_FILE_NAME, &s_libInfo) != FR_OK) ||
+            (s_libInfo.fsize != 100U))
+        {
+            printf("dir: user file %s overwritten (%d)\n", DIR_INDEX_FILE_NAME, res);
+            return 1;
+        }
+        res = f_unlink(LIB_DIR "/" DIR_INDEX_FILE_NAME);
+    }
+    if (res != FR_OK)
+    {
+        printf("dir: user file (%d)\n", res);
+        return 1;
+    }
+    printf("dir index ok\n");
+    return 0;
+}
+#endif
+
+/* delete the files of one parity (all with del 2) and write them again, the rate covers the deletes */
+static FRESULT TrimCycle(uint32_t fileBytes, uint32_t del, uint32_t *rate, uint64_t *gc)
+{
+    usb_msd_sim_stat_t sim;
+    uint64_t us = HostClockUs();
+    uint64_t bytes = 0U;
+    TCHAR path[32];
+    FIL fil;
+    UINT bw;
+    FRESULT res = FR_OK;
+
+    UsbMsdSimGetStat(&sim, 0U);
+    *gc = sim.gcSectors;
+    for (uint32_t i = 0U; (res == FR_OK) && (i < TRIM_FILES); i++)
+    {
+        if ((del < 2U) && ((i % 2U) != del))
+        {
+            continue;
+        }
+        snprintf(path, sizeof(path), HOST_DRIVE "/trim%02u.bin", i);
+        if (del < 2U)
+        {
+            res = f_unlink(path);
+            HostPoll();
+        }
+    }
+    for (uint32_t i = 0U; (res == FR_OK) && (i < TRIM_FILES); i++)
+    {
+        if ((del < 2U) && ((i % 2U) != del))
+        {
+            continue;
+        }
+        snprintf(path, sizeof(path), HOST_DRIVE "/trim%02u.bin", i);
+        res = f_open(&fil, path, FA_WRITE | FA_CREATE_NEW);
+        for (uint32_t ofs = 0U; (res == FR_OK) && (ofs < fileBytes); ofs += bw)
+        {
+            res = f_write(&fil, s_benchBuf, (fileBytes - ofs < TRIM_BLOCK) ? (fileBytes - ofs) : TRIM_BLOCK, &bw);
+            if ((res == FR_OK) && (bw == 0U))
+            {
+                res = FR_DENIED; /* disk full */
+            }
+            HostPoll();
+        }
+        if (res == FR_OK)
+        {
+            res = f_close(&fil);
+        }
+        bytes += fileBytes;
+    }
+    if (res == FR_OK)
+    {
+        res = (disk_ioctl(USBDISK, CTRL_SYNC, NULL) == RES_OK) ? FR_OK : FR_DISK_ERR;
+    }
+    us = HostClockUs() - us;
+    UsbMsdSimGetStat(&sim, 0U);
+    *rate = (uint32_t)((us != 0U) ? (bytes * 1000000U / 1024U) / us : 0U);
+    *gc   = sim.gcSectors - *gc;
+    return res;
+}
+
+/* the write rate of a full stick with and without UNMAP of the deleted files */
+static int HostTrimBench(uint32_t cycles, BYTE format)
+{
+    usb_msd_sim_flash_t flash = {TRIM_SPARE_PERMIL, TRIM_COPY_KBYTE, 1U};
+    uint32_t rate[2][TRIM_MAX_CYCLES + 1U];
+    uint64_t gc[2][TRIM_MAX_CYCLES + 1U];
+    uint32_t fileBytes = 0U;
+    MKFS_PARM parm = {(format != 0U) ? format : FM_ANY, 0U, 0U, 0U, 0U};
+    FRESULT res = FR_OK;
+
+    cycles = (cycles > TRIM_MAX_CYCLES) ? TRIM_MAX_CYCLES : cycles;
+    for (uint32_t i = 0U; i < TRIM_BLOCK; ++i)
+    {
+        s_benchBuf[i] = (uint8_t)(i * 7U);
+    }
+    /* the supporting stick first, then the same stick that rejects UNMAP */
+    for (uint32_t mode = 0U; (mode < 2U) && (res == FR_OK); mode++)
+    {
+        flash.unmap = (mode == 0U) ? 1U : 0U;
+        res         = HostUnmount();
+        if ((res == FR_OK) && (UsbMsdSimSetFlash(&flash) != 0))
+        {
+            fprintf(stderr, "trim: no memory for the page map\n");
+            return 1;
+        }
+        if (res == FR_OK)
+        {
+            res = f_mkfs(HOST_DRIVE, &parm, s_mkfsWork, sizeof(s_mkfsWork));
+        }
+        if (res == FR_OK)
+        {
+            res = HostMount(0U);
+        }
+        if ((res == FR_OK) && (fileBytes == 0U))
+        {
+            DWORD freeClusters;
+            FATFS *fs;
+
+            res = f_getfree(HOST_DRIVE, &freeClusters, &fs);
+            /* whole clusters, the files fill TRIM_FILL_PERMIL of the free space */
+            fileBytes = (uint32_t)(((uint64_t)freeClusters * TRIM_FILL_PERMIL / 1000U / TRIM_FILES) * fs->csize *
+                                   FF_MAX_SS);
+        }
+        for (uint32_t c = 0U; (res == FR_OK) && (c <= cycles); c++)
+        {
+            res = TrimCycle(fileBytes, (c == 0U) ? 2U : (c % 2U), &rate[mode][c], &gc[mode][c]);
+        }
+    }
+    if (res != FR_OK)
+    {
+        fprintf(stderr, "trim: error (%d)\n", res);
+        return 1;
+    }
+    printf("trim %u x %uKB files, %u.%u%% spare pages, half of them deleted and written again per cycle\n",
+           TRIM_FILES, fileBytes / 1024U, TRIM_SPARE_PERMIL / 10U, TRIM_SPARE_PERMIL % 10U);
+    printf(" cycle  unmap KB/s   gc pages  no unmap KB/s   gc pages\n");
+    for (uint32_t c = 0U; c <= cycles; c++)
+    {
+        char label[8];
+
+        snprintf(label, sizeof(label), (c == 0U) ? "fill" : "%u", c);
+        printf(" %5s %11u %10llu %14u %10llu\n", label, rate[0][c], (unsigned long long)gc[0][c], rate[1][c],
+               (unsigned long long)gc[1][c]);
+    }
+    return HostCheckFree(1U);
+}
+
+static void HostPrintStat(void)
+{
+    usb_msd_sim_stat_t sim;
+    usb_host_fatfs_transfer_stat_t transfer;
+    usb_host_fatfs_read_ahead_stat_t readAhead;
+    usb_host_fatfs_write_stat_t write;
+
+    UsbMsdSimGetStat(&sim, 0U);
+    printf("disk      %u read10 %u sectors, %u write10 %u sectors, %u unmap %u sectors, %u other, %u failed, "
+           "busy %.3fs of %.3fs\n",
+           sim.readCommands, sim.readSectors, sim.writeCommands, sim.writeSectors, sim.unmapCommands,
+           sim.unmapSectors, sim.otherCommands, sim.failures, (double)sim.busyUs / 1e6, (double)HostClockUs() / 1e6);
+    USB_HostMsdTransferGetStat(&transfer, 0U);
+    printf("transfer  %u read10 %u sectors, %u write10 %u sectors, %u unmap %u sectors\n", transfer.readCommands,
+           transfer.readSectors, transfer.writeCommands, transfer.writeSectors, transfer.unmapCommands,
+           transfer.unmapSectors);
+    USB_HostMsdReadAheadGetStat(&readAhead, 0U);
+    printf("readahead %u requests %u sectors, %u hits, %u read10 %u sectors, window %u\n", readAhead.requests,
+           readAhead.sectors, readAhead.hits, readAhead.commands, readAhead.driveSectors, readAhead.window);
+    USB_HostMsdWriteGetStat(&write, 0U);
+    printf("write     %u requests %u sectors, %u write10, %u dropped, flush full %u gap %u read %u sync %u timer %u "
+           "ioctl %u\n",
+           write.requests, write.sectors, write.commands, write.dropped, write.flush[kUSB_HostFatfsFlushFull],
+           write.flush[kUSB_HostFatfsFlushGap], write.flush[kUSB_HostFatfsFlushRead],
+           write.flush[kUSB_HostFatfsFlushSync], write.flush[kUSB_HostFatfsFlushTimer],
+           write.flush[kUSB_HostFatfsFlushIoctl]);
+#if ((defined DISK_CACHE_ENABLE) && (DISK_CACHE_ENABLE))
+    {
+        disk_cache_stat_t cache;
+
+        DiskCache_GetStat(&cache, 0U);
+        printf("cache     read %u hit %u miss, write %u hit %u miss, bypass %u/%u, %u evictions %u write-backs\n",
+               cache.readHits, cache.readMisses, cache.writeHits, cache.writeMisses, cache.bypassReads,
+               cache.bypassWrites, cache.evictions, cache.writeBacks);
+    }
+#endif
+#if ((defined FAST_MOUNT_ENABLE) && (FAST_MOUNT_ENABLE))
+    {
+        fast_mount_stat_t mount;
+
+        FastMount_GetStat(&mount, 0U);
+        printf("mount     %u mounts, FSINFO %u trusted %u untrusted, %u counts %u restarts %u errors, last %ums\n",
+               mount.mounts, mount.trusted, mount.untrusted, mount.counts, mount.restarts, mount.errors,
+               mount.countMs);
+    }
+#endif
+}
+
+static void HostUsage(void)
+{
+    fprintf(stderr,
+            "usage: fatfs_host [-s MB] [-f fat|fat32|exfat] [-r CMD,KB] [-w CMD,KB]\n"
+            "                  [-b KB,BLOCK] [-z OPS] [-e N] [-S SEED] [-L N] [-d N] [-t N] [image]\n");
+}
+
+int main(int argc, char *argv[])
+{
+    usb_msd_sim_latency_t readLatency  = {300U, 40U};
+    usb_msd_sim_latency_t writeLatency = {500U, 120U};
+    uint64_t megabytes                 = 64U;
+    uint32_t benchKb = 0U, benchBlock = 0U;
+    uint32_t fuzzOps  = 0U;
+    uint32_t dirFiles = 0U;
+    uint32_t trimCycles = 0U;
+    uint32_t failures = 0U;
+    BYTE format       = 0U;
+    const char *image;
+    int result = 0;
+    FRESULT res;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "s:f:r:w:b:z:e:S:L:d:t:h")) != -1)
+    {
+        switch (opt)
+        {
+            case 's':
+                megabytes = strtoull(optarg, NULL, 10);
+                break;
+            case 'f':
+                format = (strcmp(optarg, "exfat") == 0) ? FM_EXFAT :
+                         (strcmp(optarg, "fat32") == 0) ? FM_FAT32 :
+                         (strcmp(optarg, "fat") == 0)   ? FM_FAT :
+                                                          0U;
+                if (format == 0U)
+                {
+                    HostUsage();
+                    return 2;
+                }
+                break;
+            case 'r':
+            case 'w':
+                if (HostParsePair(optarg, (opt == 'r') ? &readLatency.command : &writeLatency.command,
+                                  (opt == 'r') ? &readLatency.kbyte : &writeLatency.kbyte) != 0)
+                {
+                    HostUsage();
+                    return 2;
+                }
+                break;
+            case 'b':
+                if (HostParsePair(optarg, &benchKb, &benchBlock) != 0)
+                {
+                    HostUsage();
+                    return 2;
+                }
+                break;
+            case 'z':
+                fuzzOps = (uint32_t)strtoul(optarg, NULL, 10);
+                break;
+            case 'd':
+                dirFiles = (uint32_t)strtoul(optarg, NULL, 10);
+                break;
+            case 't':
+                trimCycles = (uint32_t)strtoul(optarg, NULL, 10);
+                break;
+            case 'e':
+                failures = (uint32_t)strtoul(optarg, NULL, 10);
+                break;
+            case 'S':
+                s_hostSeed = (uint32_t)strtoul(optarg, NULL, 10);
+                s_hostSeed = (s_hostSeed != 0U) ? s_hostSeed : 1U;
+                break;
+            case 'L':
+                s_hostLuns = (uint8_t)strtoul(optarg, NULL, 10);
+                if ((s_hostLuns == 0U) || (s_hostLuns > USB_HOST_FATFS_LUNS))
+                {
+                    HostUsage();
+                    return 2;
+                }
+                break;
+            default:
+                HostUsage();
+                return 2;
+        }
+    }
+    image = (optind < argc) ? argv[optind] : NULL;
+
+    /* an existing image keeps its size unless -s asks for more */
+    if (UsbMsdSimOpen(0U, image, ((image != NULL) && (access(image, F_OK) == 0) && (format == 0U)) ? 0U :
+                                                                                                     megabytes << 20) != 0)
+    {
+        fprintf(stderr, "cannot open the disk\n");
+        return 1;
+    }
+    if ((s_hostLuns > 1U) && (UsbMsdSimOpen(1U, NULL, UsbMsdSimSectors(0U) * 512U) != 0))
+    {
+        fprintf(stderr, "cannot open the second disk\n");
+        UsbMsdSimClose();
+        return 1;
+    }
+    /* the get max lun answer on the target */
+    USB_HostMsdSetLunCount(s_hostLuns);
+    UsbMsdSimSetLatency(&readLatency, &writeLatency);
+#if ((defined DISK_CACHE_ENABLE) && (DISK_CACHE_ENABLE))
+    DiskCache_Init();
+#endif
+#if ((defined FAST_MOUNT_ENABLE) && (FAST_MOUNT_ENABLE))
+    FastMount_Init();
+#endif
+#if ((defined DIR_INDEX_ENABLE) && (DIR_INDEX_ENABLE))
+    DirIndex_Init();
+#endif
+
+    for (uint8_t lun = 0U; lun < s_hostLuns; lun++)
+    {
+        MKFS_PARM parm = {format, 0U, 0U, 0U, 0U};
+        TCHAR drive[4];
+
+        /* the RAM disk of the second LUN is always new */
+        if ((format == 0U) && (lun == 0U))
+        {
+            continue;
+        }
+        HostDrive(drive, lun);
+        parm.fmt = (format != 0U) ? format : FM_ANY;
+        res      = f_mkfs(drive, &parm, s_mkfsWork, sizeof(s_mkfsWork));
+        if (res != FR_OK)
+        {
+            fprintf(stderr, "%s mkfs error (%d)\n", drive, res);
+            UsbMsdSimClose();
+            return 1;
+        }
+    }
+    res = HostMount(1U);
+    if (res != FR_OK)
+    {
+        fprintf(stderr, "mount error (%d), format with -f\n", res);
+        UsbMsdSimClose();
+        return 1;
+    }
+
+    /* the disk traffic of the format and the mount is not part of the runs */
+    USB_HostMsdTransferGetStat(&(usb_host_fatfs_transfer_stat_t){0}, 1U);
+    UsbMsdSimGetStat(&(usb_msd_sim_stat_t){0}, 1U);
+    UsbMsdSimSetFailure(failures, s_hostSeed ^ 0x9e3779b9U);
+    if ((result == 0) && (benchKb != 0U))
+    {
+        result = HostBench(benchKb, benchBlock);
+    }
+    if ((result == 0) && (fuzzOps != 0U))
+    {
+        result = HostFuzz(fuzzOps);
+    }
+#if ((defined DIR_INDEX_ENABLE) && (DIR_INDEX_ENABLE))
+    if ((result == 0) && (dirFiles != 0U))
+    {
+        result = HostDirTest(dirFiles);
+    }
+#endif
+    /* it formats drive 1: again */
+    if ((result == 0) && (trimCycles != 0U))
+    {
+        result = HostTrimBench(trimCycles, format);
+    }
+    UsbMsdSimSetFailure(0U, 0U);
+
+    res = HostUnmount();
+    HostPrintStat();
+    UsbMsdSimClose();
+    return ((result == 0) && (res == FR_OK)) ? 0 : 1;
+}
@@ -0,0 +1,217 @@
+/*
+ * host_rtos.c
+ *
+ *  Created on: 2026/10/18
+ *      Author: M.Akino
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "FreeRTOS.h"
+#include "task.h"
+#include "semphr.h"
+#include "timers.h"
+#include "fsl_common.h"
+#include "host_rtos.h"
+
+/*
+ * The storage stack runs in one thread. Every command of the simulated disk completes inside the
+ * submit call, so a semaphore is always given before it is taken, and time only passes when the disk
+ * model says so. The same options and seed give the same command sequence and the same cycle counts.
+ */
+
+/*******************************************************************************
+ * Variables
+ ******************************************************************************/
+
+host_dwt_t g_HostDwt;
+uint32_t SystemCoreClock = 500000000U; /* i.MX RT1011 core clock */
+
+static uint64_t s_hostClockUs;
+static StaticTimer_t *s_hostTimers;
+
+/*******************************************************************************
+ * Code
+ ******************************************************************************/
+
+void *pvPortMalloc(size_t size)
+{
+    return malloc(size);
+}
+
+void vPortFree(void *p)
+{
+    free(p);
+}
+
+void HostClockAdvance(uint64_t us)
+{
+    s_hostClockUs += us;
+    g_HostDwt.CYCCNT = (uint32_t)(s_hostClockUs * (SystemCoreClock / 1000000U));
+}
+
+uint64_t HostClockUs(void)
+{
+    return s_hostClockUs;
+}
+
+TickType_t xTaskGetTickCount(void)
+{
+    return (TickType_t)((s_hostClockUs * configTICK_RATE_HZ) / 1000000U);
+}
+
+void vTaskDelay(TickType_t ticks)
+{
+    HostClockAdvance(((uint64_t)ticks * 1000000U) / configTICK_RATE_HZ);
+}
+
+static SemaphoreHandle_t HostSemaphoreInit(StaticSemaphore_t *sem, UBaseType_t max, UBaseType_t initial, uint8_t dynamic)
+{
+    if (sem != NULL)
+    {
+        sem->count   = initial;
+        sem->max     = max;
+        sem->dynamic = dynamic;
+    }
+    return sem;
+}
+
+SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t max, UBaseType_t initial)
+{
+    return HostSemaphoreInit(malloc(sizeof(StaticSemaphore_t)), max, initial, 1U);
+}
+
+SemaphoreHandle_t xSemaphoreCreateCountingStatic(UBaseType_t max, UBaseType_t initial, StaticSemaphore_t *buffer)
+{
+    return HostSemaphoreInit(buffer, max, initial, 0U);
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void)
+{
+    return HostSemaphoreInit(malloc(sizeof(StaticSemaphore_t)), 1U, 1U, 1U);
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutexStatic(StaticSemaphore_t *buffer)
+{
+    return HostSemaphoreInit(buffer, 1U, 1U, 0U);
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t semaphore)
+{
+    if (semaphore->dynamic)
+    {
+        free(semaphore);
+    }
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t wait)
+{
+    if (semaphore->count != 0U)
+    {
+        semaphore->count--;
+        return pdTRUE;
+    }
+    if (wait == 0U)
+    {
+        return pdFALSE;
+    }
+    /* nobody else can give it, a recursive lock or a lost completion */
+    fprintf(stderr, "xSemaphoreTake: deadlock on %p\n", (void *)semaphore);
+    abort();
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore)
+{
+    if (semaphore->count >= semaphore->max)
+    {
+        return pdFALSE;
+    }
+    semaphore->count++;
+    return pdTRUE;
+}
+
+static TimerHandle_t HostTimerInit(StaticTimer_t *timer,
+                                   const char *name,
+                                   TickType_t period,
+                                   UBaseType_t autoReload,
+                                   void *id,
+                                   TimerCallbackFunction_t callback,
+                                   uint8_t dynamic)
+{
+    if (timer != NULL)
+    {
+        timer->name       = name;
+        timer->period     = period;
+        timer->autoReload = autoReload;
+        timer->id         = id;
+        timer->callback   = callback;
+        timer->expiry     = 0U;
+        timer->active     = 0U;
+        timer->dynamic    = dynamic;
+        timer->next       = s_hostTimers;
+        s_hostTimers      = timer;
+    }
+    return timer;
+}
+
+TimerHandle_t xTimerCreate(
+    const char *name, TickType_t period, UBaseType_t autoReload, void *id, TimerCallbackFunction_t callback)
+{
+    return HostTimerInit(malloc(sizeof(StaticTimer_t)), name, period, autoReload, id, callback, 1U);
+}
+
+TimerHandle_t xTimerCreateStatic(const char *name,
+                                 TickType_t period,
+                                 UBaseType_t autoReload,
+                                 void *id,
+                                 TimerCallbackFunction_t callback,
+                                 StaticTimer_t *buffer)
+{
+    return HostTimerInit(buffer, name, period, autoReload, id, callback, 0U);
+}
+
+BaseType_t xTimerReset(TimerHandle_t timer, TickType_t wait)
+{
+    (void)wait;
+    timer->expiry = (uint64_t)xTaskGetTickCount() + timer->period;
+    timer->active = 1U;
+    return pdPASS;
+}
+
+BaseType_t xTimerStop(TimerHandle_t timer, TickType_t wait)
+{
+    (void)wait;
+    timer->active = 0U;
+    return pdPASS;
+}
+
+BaseType_t xTimerIsTimerActive(TimerHandle_t timer)
+{
+    return timer->active ? pdTRUE : pdFALSE;
+}
+
+void *pvTimerGetTimerID(TimerHandle_t timer)
+{
+    return timer->id;
+}
+
+void HostTimerPoll(void)
+{
+    uint64_t now = xTaskGetTickCount();
+
+    for (StaticTimer_t *timer = s_hostTimers; timer != NULL; timer = timer->next)
+    {
+        if (timer->active && (timer->expiry <= now))
+        {
+            if (timer->autoReload)
+            {
+                timer->expiry += timer->period;
+            }
+            else
+            {
+                timer->active = 0U;
+            }
+            timer->callback(timer);
+        }
+    }
+}
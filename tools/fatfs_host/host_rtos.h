@@ -0,0 +1,36 @@
+/*
+ * host_rtos.h
+ *
+ *  Created on: 2026/10/18
+ *      Author: M.Akino
+ */
+
+#ifndef HOST_RTOS_H_
+#define HOST_RTOS_H_
+
+#include <stdint.h>
+
+/*******************************************************************************
+ * API
+ ******************************************************************************/
+
+/*!
+ * @brief advance the simulated clock, DWT->CYCCNT and the tick count follow it.
+ *
+ * @param us    microseconds.
+ */
+extern void HostClockAdvance(uint64_t us);
+
+/*!
+ * @brief get the simulated clock.
+ *
+ * @return microseconds since start.
+ */
+extern uint64_t HostClockUs(void);
+
+/*!
+ * @brief run the callbacks of the expired timers, the host main loop stands in for the timer service task.
+ */
+extern void HostTimerPoll(void);
+
+#endif /* HOST_RTOS_H_ */
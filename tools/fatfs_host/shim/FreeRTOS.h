@@ -0,0 +1,41 @@
+/*
+ * FreeRTOS.h
+ *
+ *  Created on: 2026/10/18
+ *      Author: M.Akino
+ */
+
+#ifndef FREERTOS_H_
+#define FREERTOS_H_
+
+/* host stand-in for the FreeRTOS kernel, single thread, time is the simulated USB disk clock */
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+
+typedef uint32_t TickType_t;
+typedef long BaseType_t;
+typedef unsigned long UBaseType_t;
+
+#define configTICK_RATE_HZ (1000U)
+
+#define pdFALSE ((BaseType_t)0)
+#define pdTRUE ((BaseType_t)1)
+#define pdFAIL pdFALSE
+#define pdPASS pdTRUE
+#define portMAX_DELAY ((TickType_t)0xffffffffUL)
+#define portTICK_PERIOD_MS ((TickType_t)1000U / configTICK_RATE_HZ)
+#define pdMS_TO_TICKS(ms) ((TickType_t)(((uint64_t)(ms) * configTICK_RATE_HZ) / 1000U))
+
+/*******************************************************************************
+ * API
+ ******************************************************************************/
+
+extern void *pvPortMalloc(size_t size);
+extern void vPortFree(void *p);
+
+#endif /* FREERTOS_H_ */
@@ -0,0 +1,15 @@
+/*
+ * cr_section_macros.h
+ *
+ *  Created on: 2026/10/18
+ *      Author: M.Akino
+ */
+
+#ifndef CR_SECTION_MACROS_H_
+#define CR_SECTION_MACROS_H_
+
+/* one address space on the host, the linker section placement is dropped */
+#define __BSS(bank)
+#define __DATA(bank)
+
+#endif /* CR_SECTION_MACROS_H_ */
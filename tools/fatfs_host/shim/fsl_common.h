@@ -0,0 +1,53 @@
+/*
+ * fsl_common.h
+ *
+ *  Created on: 2026/10/18
+ *      Author: M.Akino
+ */
+
+#ifndef FSL_COMMON_H_
+#define FSL_COMMON_H_
+
+/* host stand-in for the MCUXpresso SDK common header, only what the storage stack uses */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+
+#ifndef __ALIGNED
+#define __ALIGNED(x) __attribute__((aligned(x)))
+#endif
+
+/*! @brief cycle counter of the data watchpoint and trace unit, counts the simulated clock at SystemCoreClock */
+typedef struct _host_dwt
+{
+    volatile uint32_t CYCCNT;
+    volatile uint32_t CTRL;
+} host_dwt_t;
+
+#define DWT_CTRL_CYCCNTENA_Msk (1UL)
+
+extern host_dwt_t g_HostDwt;
+#define DWT (&g_HostDwt)
+
+extern uint32_t SystemCoreClock;
+
+/*******************************************************************************
+ * API
+ ******************************************************************************/
+
+static inline uint32_t DisableGlobalIRQ(void)
+{
+    return 0U;
+}
+
+static inline void EnableGlobalIRQ(uint32_t primask)
+{
+    (void)primask;
+}
+
+#endif /* FSL_COMMON_H_ */
@@ -0,0 +1,46 @@
+/*
+ * semphr.h
+ *
+ *  Created on: 2026/10/18
+ *      Author: M.Akino
+ */
+
+#ifndef SEMPHR_H_
+#define SEMPHR_H_
+
+#include "FreeRTOS.h"
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+
+/*! @brief counting semaphore or mutex, a take that would block can never be satisfied by another task */
+typedef struct _host_semaphore
+{
+    UBaseType_t count;   /*!< available */
+    UBaseType_t max;     /*!< maximum count */
+    uint8_t dynamic;     /*!< 1: allocated by the create call */
+} StaticSemaphore_t;
+
+typedef StaticSemaphore_t *SemaphoreHandle_t;
+
+/*******************************************************************************
+ * API
+ ******************************************************************************/
+
+extern SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t max, UBaseType_t initial);
+extern SemaphoreHandle_t xSemaphoreCreateCountingStatic(UBaseType_t max, UBaseType_t initial, StaticSemaphore_t *buffer);
+extern SemaphoreHandle_t xSemaphoreCreateMutex(void);
+extern SemaphoreHandle_t xSemaphoreCreateMutexStatic(StaticSemaphore_t *buffer);
+extern void vSemaphoreDelete(SemaphoreHandle_t semaphore);
+
+/*!
+ * @brief take the semaphore. Waiting for it aborts the program, in one thread that is a deadlock.
+ *
+ * @param semaphore  semaphore or mutex.
+ * @param wait       0: fail at once when it is not available.
+ */
+extern BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t wait);
+extern BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore);
+
+#endif /* SEMPHR_H_ */
@@ -0,0 +1,35 @@
+/*
+ * task.h
+ *
+ *  Created on: 2026/10/18
+ *      Author: M.Akino
+ */
+
+#ifndef TASK_H_
+#define TASK_H_
+
+#include "FreeRTOS.h"
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+
+/* one thread and no interrupts, nothing to mask */
+#define taskENTER_CRITICAL()
+#define taskEXIT_CRITICAL()
+
+/*******************************************************************************
+ * API
+ ******************************************************************************/
+
+/*!
+ * @brief ticks of the simulated clock.
+ */
+extern TickType_t xTaskGetTickCount(void);
+
+/*!
+ * @brief advance the simulated clock, nothing else runs meanwhile.
+ */
+extern void vTaskDelay(TickType_t ticks);
+
+#endif /* TASK_H_ */
@@ -0,0 +1,53 @@
+/*
+ * timers.h
+ *
+ *  Created on: 2026/10/18
+ *      Author: M.Akino
+ */
+
+#ifndef TIMERS_H_
+#define TIMERS_H_
+
+#include "FreeRTOS.h"
+#include "semphr.h"
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+
+struct _host_timer;
+typedef struct _host_timer *TimerHandle_t;
+typedef void (*TimerCallbackFunction_t)(TimerHandle_t timer);
+
+/*! @brief software timer, expires on the simulated clock and runs from HostTimerPoll */
+typedef struct _host_timer
+{
+    const char *name;                 /*!< timer name */
+    TickType_t period;                /*!< period in ticks */
+    UBaseType_t autoReload;           /*!< pdTRUE: restart on expiry */
+    void *id;                         /*!< timer ID */
+    TimerCallbackFunction_t callback; /*!< expiry callback */
+    uint64_t expiry;                  /*!< tick of the next expiry */
+    uint8_t active;                   /*!< 1: running */
+    uint8_t dynamic;                  /*!< 1: allocated by the create call */
+    struct _host_timer *next;         /*!< created timers */
+} StaticTimer_t;
+
+/*******************************************************************************
+ * API
+ ******************************************************************************/
+
+extern TimerHandle_t xTimerCreate(
+    const char *name, TickType_t period, UBaseType_t autoReload, void *id, TimerCallbackFunction_t callback);
+extern TimerHandle_t xTimerCreateStatic(const char *name,
+                                        TickType_t period,
+                                        UBaseType_t autoReload,
+                                        void *id,
+                                        TimerCallbackFunction_t callback,
+                                        StaticTimer_t *buffer);
+extern BaseType_t xTimerReset(TimerHandle_t timer, TickType_t wait);
+extern BaseType_t xTimerStop(TimerHandle_t timer, TickType_t wait);
+extern BaseType_t xTimerIsTimerActive(TimerHandle_t timer);
+extern void *pvTimerGetTimerID(TimerHandle_t timer);
+
+#endif /* TIMERS_H_ */
@@ -0,0 +1,44 @@
+/*
+ * usb_host.h
+ *
+ *  Created on: 2026/10/18
+ *      Author: M.Akino
+ */
+
+#ifndef USB_HOST_H_
+#define USB_HOST_H_
+
+/* host stand-in for the USB host stack types used by the FatFs disk glue */
+
+#include <stdint.h>
+#include "fsl_common.h"
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+
+typedef enum _usb_status
+{
+    kStatus_USB_Success = 0x00U,
+    kStatus_USB_Error,
+    kStatus_USB_Busy,
+    kStatus_USB_InvalidHandle,
+    kStatus_USB_InvalidParameter,
+    kStatus_USB_TransferCancel,
+    kStatus_USB_MSDStatusFail,
+} usb_status_t;
+
+typedef void *usb_host_handle;
+typedef void *usb_host_class_handle;
+
+typedef void (*transfer_callback_t)(void *param, uint8_t *data, uint32_t dataLen, usb_status_t status);
+
+#define USB_CACHE_LINESIZE (32U)
+#define USB_DATA_ALIGN_SIZE USB_CACHE_LINESIZE
+#define USB_DMA_NONINIT_DATA_ALIGN(n) __attribute__((aligned(n)))
+
+#define USB_LONG_FROM_BIG_ENDIAN_ADDRESS(n)                                                        \
+    ((uint32_t)((((uint32_t)n[0]) << 24U) | (((uint32_t)n[1]) << 16U) | (((uint32_t)n[2]) << 8U) | \
+                (((uint32_t)n[3]) << 0U)))
+
+#endif /* USB_HOST_H_ */
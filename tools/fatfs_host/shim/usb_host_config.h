@@ -0,0 +1,15 @@
+/*
+ * usb_host_config.h
+ *
+ *  Created on: 2026/10/18
+ *      Author: M.Akino
+ */
+
+#ifndef USB_HOST_CONFIG_H_
+#define USB_HOST_CONFIG_H_
+
+/* shadows soft/source/usb_host_config.h, the host build has no EHCI controller */
+
+#define USB_HOST_CONFIG_MSD (1U)
+
+#endif /* USB_HOST_CONFIG_H_ */
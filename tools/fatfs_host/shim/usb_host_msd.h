@@ -0,0 +1,122 @@
+/*
+ * usb_host_msd.h
+ *
+ *  Created on: 2026/10/18
+ *      Author: M.Akino
+ */
+
+#ifndef USB_HOST_MSD_H_
+#define USB_HOST_MSD_H_
+
+/* host stand-in for the MSD class driver API, implemented by usb_msd_sim.c */
+
+#include "usb_host.h"
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+
+#define USB_HOST_MSD_COMMAND_QUEUE_LENGTH (1U)
+
+/*! @brief UFI read capacity data structure */
+typedef struct _usb_host_ufi_read_capacity
+{
+    uint8_t lastLogicalBlockAddress[4]; /*!< The logical block number*/
+    uint8_t blockLengthInBytes[4];      /*!< Block size*/
+} usb_host_ufi_read_capacity_t;
+
+/*! @brief SBC read capacity (16) data structure */
+typedef struct _usb_host_ufi_read_capacity16
+{
+    uint8_t lastLogicalBlockAddress[8]; /*!< The logical block number*/
+    uint8_t blockLengthInBytes[4];      /*!< Block size*/
+    uint8_t protection;                 /*!< P_TYPE and PROT_EN*/
+    uint8_t exponents;                  /*!< Logical blocks per physical block exponent*/
+    uint8_t lowestAlignedLba[2];        /*!< LBPME (bit 7 of the first byte), LBPRZ and the lowest aligned LBA*/
+    uint8_t reserved[16];               /*!< Reserved field*/
+} usb_host_ufi_read_capacity16_t;
+
+/*! @brief LBPME bit in lowestAlignedLba[0], the unit supports UNMAP */
+#define USB_HOST_UFI_READ_CAPACITY16_LBPME (0x80U)
+
+/*! @brief UFI sense data structure */
+typedef struct _usb_host_ufi_sense_data
+{
+    uint8_t errorCode;                    /*!< 70h, current errors */
+    uint8_t reserved1;                    /*!< Reserved field*/
+    uint8_t senseKey;                     /*!< sense key */
+    uint8_t information[4];               /*!< command-specific information */
+    uint8_t additionalSenseLength;        /*!< ten more bytes follow */
+    uint8_t reserved2[4];                 /*!< Reserved field*/
+    uint8_t additionalSenseCode;          /*!< additional sense code */
+    uint8_t additionalSenseCodeQualifier; /*!< additional sense code qualifier */
+    uint8_t reserved3[4];                 /*!< Reserved field*/
+} usb_host_ufi_sense_data_t;
+
+/*******************************************************************************
+ * API
+ ******************************************************************************/
+
+extern usb_status_t USB_HostMsdRead10(usb_host_class_handle classHandle,
+                                      uint8_t logicalUnit,
+                                      uint32_t blockAddress,
+                                      uint8_t *buffer,
+                                      uint32_t bufferLength,
+                                      uint32_t blockNumber,
+                                      transfer_callback_t callbackFn,
+                                      void *callbackParam);
+extern usb_status_t USB_HostMsdWrite10(usb_host_class_handle classHandle,
+                                       uint8_t logicalUnit,
+                                       uint32_t blockAddress,
+                                       uint8_t *buffer,
+                                       uint32_t bufferLength,
+                                       uint32_t blockNumber,
+                                       transfer_callback_t callbackFn,
+                                       void *callbackParam);
+extern usb_status_t USB_HostMsdReadCapacity(usb_host_class_handle classHandle,
+                                            uint8_t logicalUnit,
+                                            uint8_t *buffer,
+                                            uint32_t bufferLength,
+                                            transfer_callback_t callbackFn,
+                                            void *callbackParam);
+extern usb_status_t USB_HostMsdReadCapacity16(usb_host_class_handle classHandle,
+                                              uint8_t logicalUnit,
+                                              uint8_t *buffer,
+                                              uint32_t bufferLength,
+                                              transfer_callback_t callbackFn,
+                                              void *callbackParam);
+extern usb_status_t USB_HostMsdRead16(usb_host_class_handle classHandle,
+                                      uint8_t logicalUnit,
+                                      uint64_t blockAddress,
+                                      uint8_t *buffer,
+                                      uint32_t bufferLength,
+                                      uint32_t blockNumber,
+                                      transfer_callback_t callbackFn,
+                                      void *callbackParam);
+extern usb_status_t USB_HostMsdWrite16(usb_host_class_handle classHandle,
+                                       uint8_t logicalUnit,
+                                       uint64_t blockAddress,
+                                       uint8_t *buffer,
+                                       uint32_t bufferLength,
+                                       uint32_t blockNumber,
+                                       transfer_callback_t callbackFn,
+                                       void *callbackParam);
+extern usb_status_t USB_HostMsdUnmap(usb_host_class_handle classHandle,
+                                     uint8_t logicalUnit,
+                                     uint64_t blockAddress,
+                                     uint32_t blockNumber,
+                                     uint8_t *buffer,
+                                     transfer_callback_t callbackFn,
+                                     void *callbackParam);
+extern usb_status_t USB_HostMsdTestUnitReady(usb_host_class_handle classHandle,
+                                             uint8_t logicalUnit,
+                                             transfer_callback_t callbackFn,
+                                             void *callbackParam);
+extern usb_status_t USB_HostMsdRequestSense(usb_host_class_handle classHandle,
+                                            uint8_t logicalUnit,
+                                            uint8_t *buffer,
+                                            uint32_t bufferLength,
+                                            transfer_callback_t callbackFn,
+                                            void *callbackParam);
+
+#endif /* USB_HOST_MSD_H_ */
@@ -0,0 +1,545 @@
+/*
+ * usb_msd_sim.c
+ *
+ *  Created on: 2026/10/18
+ *      Author: M.Akino
+ */
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "usb_host_msd.h"
+#include "host_rtos.h"
+#include "usb_msd_sim.h"
+
+/*
+ * MSD class driver stand-in. The commands work on a memory-mapped image file or a RAM disk and complete
+ * before they return: the data is copied, the simulated clock advances by the latency model and the
+ * callback runs, like the class driver calling back from the USB task after the CSW.
+ */
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+
+#define USB_MSD_SIM_SECTOR_SIZE (512U)
+/* a card reader with two slots at most */
+#define USB_MSD_SIM_LUNS (2U)
+
+typedef struct _usb_msd_sim_disk
+{
+    uint8_t *data;     /*!< mapped image or RAM disk, NULL: no media */
+    uint64_t bytes;    /*!< size, whole sectors */
+    int fd;            /*!< image file, -1: RAM disk */
+    uint8_t *mapped;   /*!< flash model: one bit per sector holding a valid page, NULL: no model */
+    uint64_t valid;    /*!< bits set in mapped */
+    uint64_t erased;   /*!< pages never written since the stick was new */
+    uint64_t physical; /*!< logical sectors plus the spare pages */
+    double gcCarry;    /*!< fraction of a page the garbage collection still owes */
+} usb_msd_sim_disk_t;
+
+/*******************************************************************************
+ * Variables
+ ******************************************************************************/
+
+/* the handle the disk glue sends the commands to, non-NULL while a disk is attached */
+extern usb_host_class_handle g_UsbFatfsClassHandle;
+usb_host_handle g_HostHandle;
+
+static usb_msd_sim_disk_t s_simDisk[USB_MSD_SIM_LUNS] = {{NULL, 0U, -1}, {NULL, 0U, -1}};
+static usb_msd_sim_latency_t s_simRead  = {300U, 40U};
+static usb_msd_sim_latency_t s_simWrite = {500U, 120U};
+static usb_msd_sim_flash_t s_simFlash   = {0U, 60U, 1U};
+static uint32_t s_simFailInterval;
+static uint32_t s_simFailSeed = 1U;
+static uint8_t s_simFailedLast;
+static usb_msd_sim_stat_t s_simStat;
+
+/*******************************************************************************
+ * Code
+ ******************************************************************************/
+
+/* a new stick: all pages erased, nothing valid */
+static int UsbMsdSimFlashReset(usb_msd_sim_disk_t *disk)
+{
+    uint64_t sectors = disk->bytes / USB_MSD_SIM_SECTOR_SIZE;
+
+    free(disk->mapped);
+    disk->mapped  = NULL;
+    disk->valid   = 0U;
+    disk->gcCarry = 0.0;
+    if ((s_simFlash.spare == 0U) || (disk->data == NULL))
+    {
+        return 0;
+    }
+    disk->mapped = calloc(1U, (size_t)((sectors + 7U) / 8U));
+    if (disk->mapped == NULL)
+    {
+        return -1;
+    }
+    disk->physical = sectors + (sectors * s_simFlash.spare) / 1000U;
+    disk->erased   = disk->physical;
+    return 0;
+}
+
+static void UsbMsdSimRelease(usb_msd_sim_disk_t *disk)
+{
+    if (disk->fd >= 0)
+    {
+        if (disk->data != NULL)
+        {
+            (void)msync(disk->data, (size_t)disk->bytes, MS_SYNC);
+            (void)munmap(disk->data, (size_t)disk->bytes);
+        }
+        (void)close(disk->fd);
+        disk->fd = -1;
+    }
+    else
+    {
+        free(disk->data);
+    }
+    disk->data  = NULL;
+    disk->bytes = 0U;
+    (void)UsbMsdSimFlashReset(disk);
+}
+
+/* the media of a logical unit, NULL: no such unit or no media */
+static usb_msd_sim_disk_t *UsbMsdSimGetDisk(usb_host_class_handle classHandle, uint8_t logicalUnit)
+{
+    if ((classHandle == NULL) || (classHandle != g_UsbFatfsClassHandle) || (logicalUnit >= USB_MSD_SIM_LUNS) ||
+        (s_simDisk[logicalUnit].data == NULL))
+    {
+        return NULL;
+    }
+    return &s_simDisk[logicalUnit];
+}
+
+int UsbMsdSimOpen(uint8_t lun, const char *path, uint64_t bytes)
+{
+    usb_msd_sim_disk_t *disk;
+    struct stat st;
+
+    if (lun >= USB_MSD_SIM_LUNS)
+    {
+        return -1;
+    }
+    disk = &s_simDisk[lun];
+    UsbMsdSimRelease(disk);
+    if (path == NULL)
+    {
+        disk->data = calloc(1U, (size_t)bytes);
+        if (disk->data == NULL)
+        {
+            return -1;
+        }
+    }
+    else
+    {
+        disk->fd = open(path, O_RDWR | O_CREAT, 0644);
+        if ((disk->fd < 0) || (fstat(disk->fd, &st) != 0))
+        {
+            perror(path);
+            UsbMsdSimRelease(disk);
+            return -1;
+        }
+        if (bytes == 0U)
+        {
+            bytes = (uint64_t)st.st_size;
+        }
+        if (((uint64_t)st.st_size < bytes) && (ftruncate(disk->fd, (off_t)bytes) != 0))
+        {
+            perror(path);
+            UsbMsdSimRelease(disk);
+            return -1;
+        }
+        disk->data = mmap(NULL, (size_t)bytes, PROT_READ | PROT_WRITE, MAP_SHARED, disk->fd, 0);
+        if (disk->data == MAP_FAILED)
+        {
+            perror(path);
+            disk->data = NULL;
+            UsbMsdSimRelease(disk);
+            return -1;
+        }
+    }
+    disk->bytes = bytes - (bytes % USB_MSD_SIM_SECTOR_SIZE);
+    if (UsbMsdSimFlashReset(disk) != 0)
+    {
+        UsbMsdSimRelease(disk);
+        return -1;
+    }
+    g_UsbFatfsClassHandle = &s_simStat;
+    return 0;
+}
+
+void UsbMsdSimClose(void)
+{
+    g_UsbFatfsClassHandle = NULL;
+    for (uint8_t lun = 0U; lun < USB_MSD_SIM_LUNS; lun++)
+    {
+        UsbMsdSimRelease(&s_simDisk[lun]);
+    }
+}
+
+void UsbMsdSimSetLatency(const usb_msd_sim_latency_t *read, const usb_msd_sim_latency_t *write)
+{
+    s_simRead  = *read;
+    s_simWrite = *write;
+}
+
+void UsbMsdSimSetFailure(uint32_t interval, uint32_t seed)
+{
+    s_simFailInterval = interval;
+    s_simFailSeed     = (seed != 0U) ? seed : 1U;
+    s_simFailedLast   = 0U;
+}
+
+int UsbMsdSimSetFlash(const usb_msd_sim_flash_t *flash)
+{
+    int result = 0;
+
+    s_simFlash = *flash;
+    for (uint8_t lun = 0U; lun < USB_MSD_SIM_LUNS; lun++)
+    {
+        result |= UsbMsdSimFlashReset(&s_simDisk[lun]);
+    }
+    return result;
+}
+
+uint64_t UsbMsdSimSectors(uint8_t lun)
+{
+    return (lun < USB_MSD_SIM_LUNS) ? (s_simDisk[lun].bytes / USB_MSD_SIM_SECTOR_SIZE) : 0U;
+}
+
+void UsbMsdSimGetStat(usb_msd_sim_stat_t *stat, uint8_t reset)
+{
+    *stat = s_simStat;
+    if (reset)
+    {
+        memset(&s_simStat, 0, sizeof(s_simStat));
+    }
+}
+
+static void UsbMsdSimElapse(const usb_msd_sim_latency_t *latency, uint32_t sectors)
+{
+    uint64_t us = latency->command + ((uint64_t)sectors * USB_MSD_SIM_SECTOR_SIZE * latency->kbyte) / 1024U;
+
+    s_simStat.busyUs += us;
+    HostClockAdvance(us);
+}
+
+/* map the written sectors to new pages, the erased pages are used up first and then each page written
+   waits for the garbage collection to copy u / (1 - u) valid pages */
+static void UsbMsdSimFlashWrite(usb_msd_sim_disk_t *disk, uint64_t sector, uint32_t count)
+{
+    uint64_t pages = count;
+    double u;
+    double copies;
+
+    if (disk->mapped == NULL)
+    {
+        return;
+    }
+    for (uint64_t s = sector; s < (sector + count); s++)
+    {
+        if ((disk->mapped[s / 8U] & (1U << (s % 8U))) == 0U)
+        {
+            disk->mapped[s / 8U] |= (uint8_t)(1U << (s % 8U));
+            disk->valid++;
+        }
+    }
+    if (disk->erased >= pages)
+    {
+        disk->erased -= pages;
+        return;
+    }
+    pages -= disk->erased;
+    disk->erased = 0U;
+    /* valid <= logical sectors < physical pages, u stays below 1 */
+    u      = (double)disk->valid / (double)disk->physical;
+    copies = disk->gcCarry + (double)pages * u / (1.0 - u);
+    disk->gcCarry = copies - (double)(uint64_t)copies;
+    s_simStat.gcSectors += (uint64_t)copies;
+    UsbMsdSimElapse(&(usb_msd_sim_latency_t){0U, s_simFlash.copyKbyte}, (uint32_t)copies);
+}
+
+static void UsbMsdSimFlashUnmap(usb_msd_sim_disk_t *disk, uint64_t sector, uint32_t count)
+{
+    if (disk->fd < 0)
+    {
+        memset(&disk->data[sector * USB_MSD_SIM_SECTOR_SIZE], 0, (size_t)count * USB_MSD_SIM_SECTOR_SIZE);
+    }
+    if (disk->mapped == NULL)
+    {
+        return;
+    }
+    for (uint64_t s = sector; s < (sector + count); s++)
+    {
+        if ((disk->mapped[s / 8U] & (1U << (s % 8U))) != 0U)
+        {
+            disk->mapped[s / 8U] &= (uint8_t)~(1U << (s % 8U));
+            disk->valid--;
+        }
+    }
+}
+
+static uint8_t UsbMsdSimFail(void)
+{
+    if ((s_simFailInterval == 0U) || s_simFailedLast)
+    {
+        s_simFailedLast = 0U;
+        return 0U;
+    }
+    /* xorshift32 */
+    s_simFailSeed ^= s_simFailSeed << 13;
+    s_simFailSeed ^= s_simFailSeed >> 17;
+    s_simFailSeed ^= s_simFailSeed << 5;
+    s_simFailedLast = ((s_simFailSeed % s_simFailInterval) == 0U);
+    if (s_simFailedLast)
+    {
+        s_simStat.failures++;
+    }
+    return s_simFailedLast;
+}
+
+static usb_status_t UsbMsdSimTransfer(uint8_t write,
+                                      usb_host_class_handle classHandle,
+                                      uint8_t logicalUnit,
+                                      uint64_t blockAddress,
+                                      uint8_t *buffer,
+                                      uint32_t bufferLength,
+                                      uint32_t blockNumber,
+                                      transfer_callback_t callbackFn,
+                                      void *callbackParam)
+{
+    usb_msd_sim_disk_t *disk = UsbMsdSimGetDisk(classHandle, logicalUnit);
+    uint64_t offset          = (uint64_t)blockAddress * USB_MSD_SIM_SECTOR_SIZE;
+    usb_status_t status      = kStatus_USB_Success;
+
+    if ((classHandle == NULL) || (classHandle != g_UsbFatfsClassHandle))
+    {
+        return kStatus_USB_InvalidHandle;
+    }
+    if ((disk == NULL) || (bufferLength != (blockNumber * USB_MSD_SIM_SECTOR_SIZE)) ||
+        ((offset + bufferLength) > disk->bytes))
+    {
+        /* the stick answers with a failed CSW, ILLEGAL REQUEST */
+        status = kStatus_USB_MSDStatusFail;
+    }
+    else if (UsbMsdSimFail())
+    {
+        status = kStatus_USB_MSDStatusFail;
+    }
+    else if (write)
+    {
+        memcpy(&disk->data[offset], buffer, bufferLength);
+        UsbMsdSimFlashWrite(disk, blockAddress, blockNumber);
+    }
+    else
+    {
+        memcpy(buffer, &disk->data[offset], bufferLength);
+    }
+
+    if (write)
+    {
+        s_simStat.writeCommands++;
+        s_simStat.writeSectors += (status == kStatus_USB_Success) ? blockNumber : 0U;
+        UsbMsdSimElapse(&s_simWrite, blockNumber);
+    }
+    else
+    {
+        s_simStat.readCommands++;
+        s_simStat.readSectors += (status == kStatus_USB_Success) ? blockNumber : 0U;
+        UsbMsdSimElapse(&s_simRead, blockNumber);
+    }
+    callbackFn(callbackParam, buffer, (status == kStatus_USB_Success) ? bufferLength : 0U, status);
+    return kStatus_USB_Success;
+}
+
+usb_status_t USB_HostMsdRead10(usb_host_class_handle classHandle,
+                               uint8_t logicalUnit,
+                               uint32_t blockAddress,
+                               uint8_t *buffer,
+                               uint32_t bufferLength,
+                               uint32_t blockNumber,
+                               transfer_callback_t callbackFn,
+                               void *callbackParam)
+{
+    return UsbMsdSimTransfer(0U, classHandle, logicalUnit, blockAddress, buffer, bufferLength, blockNumber, callbackFn,
+                             callbackParam);
+}
+
+usb_status_t USB_HostMsdWrite10(usb_host_class_handle classHandle,
+                                uint8_t logicalUnit,
+                                uint32_t blockAddress,
+                                uint8_t *buffer,
+                                uint32_t bufferLength,
+                                uint32_t blockNumber,
+                                transfer_callback_t callbackFn,
+                                void *callbackParam)
+{
+    return UsbMsdSimTransfer(1U, classHandle, logicalUnit, blockAddress, buffer, bufferLength, blockNumber, callbackFn,
+                             callbackParam);
+}
+
+usb_status_t USB_HostMsdRead16(usb_host_class_handle classHandle,
+                               uint8_t logicalUnit,
+                               uint64_t blockAddress,
+                               uint8_t *buffer,
+                               uint32_t bufferLength,
+                               uint32_t blockNumber,
+                               transfer_callback_t callbackFn,
+                               void *callbackParam)
+{
+    return UsbMsdSimTransfer(0U, classHandle, logicalUnit, blockAddress, buffer, bufferLength, blockNumber, callbackFn,
+                             callbackParam);
+}
+
+usb_status_t USB_HostMsdWrite16(usb_host_class_handle classHandle,
+                                uint8_t logicalUnit,
+                                uint64_t blockAddress,
+                                uint8_t *buffer,
+                                uint32_t bufferLength,
+                                uint32_t blockNumber,
+                                transfer_callback_t callbackFn,
+                                void *callbackParam)
+{
+    return UsbMsdSimTransfer(1U, classHandle, logicalUnit, blockAddress, buffer, bufferLength, blockNumber, callbackFn,
+                             callbackParam);
+}
+
+usb_status_t USB_HostMsdUnmap(usb_host_class_handle classHandle,
+                              uint8_t logicalUnit,
+                              uint64_t blockAddress,
+                              uint32_t blockNumber,
+                              uint8_t *buffer,
+                              transfer_callback_t callbackFn,
+                              void *callbackParam)
+{
+    usb_msd_sim_disk_t *disk = UsbMsdSimGetDisk(classHandle, logicalUnit);
+    usb_status_t status      = kStatus_USB_Success;
+
+    if ((classHandle == NULL) || (classHandle != g_UsbFatfsClassHandle))
+    {
+        return kStatus_USB_InvalidHandle;
+    }
+    if ((disk == NULL) || (!s_simFlash.unmap) || (blockNumber == 0U) ||
+        (((blockAddress + blockNumber) * USB_MSD_SIM_SECTOR_SIZE) > disk->bytes))
+    {
+        /* ILLEGAL REQUEST: not supported or out of range */
+        status = kStatus_USB_MSDStatusFail;
+    }
+    else
+    {
+        UsbMsdSimFlashUnmap(disk, blockAddress, blockNumber);
+        s_simStat.unmapSectors += blockNumber;
+    }
+    s_simStat.unmapCommands++;
+    /* the stick only updates its page map */
+    UsbMsdSimElapse(&s_simWrite, 0U);
+    callbackFn(callbackParam, buffer, (status == kStatus_USB_Success) ? 24U : 0U, status);
+    return kStatus_USB_Success;
+}
+
+usb_status_t USB_HostMsdReadCapacity16(usb_host_class_handle classHandle,
+                                       uint8_t logicalUnit,
+                                       uint8_t *buffer,
+                                       uint32_t bufferLength,
+                                       transfer_callback_t callbackFn,
+                                       void *callbackParam)
+{
+    usb_host_ufi_read_capacity16_t *capacity = (usb_host_ufi_read_capacity16_t *)buffer;
+    uint64_t last                            = UsbMsdSimSectors(logicalUnit) - 1U;
+
+    if ((UsbMsdSimGetDisk(classHandle, logicalUnit) == NULL) || (bufferLength < sizeof(*capacity)))
+    {
+        return kStatus_USB_InvalidParameter;
+    }
+    memset(capacity, 0, sizeof(*capacity));
+    for (uint32_t i = 0U; i < 8U; ++i)
+    {
+        capacity->lastLogicalBlockAddress[i] = (uint8_t)(last >> (56U - 8U * i));
+    }
+    for (uint32_t i = 0U; i < 4U; ++i)
+    {
+        capacity->blockLengthInBytes[i] = (uint8_t)(USB_MSD_SIM_SECTOR_SIZE >> (24U - 8U * i));
+    }
+    capacity->lowestAlignedLba[0] = s_simFlash.unmap ? USB_HOST_UFI_READ_CAPACITY16_LBPME : 0U;
+    s_simStat.otherCommands++;
+    UsbMsdSimElapse(&s_simRead, 0U);
+    callbackFn(callbackParam, buffer, sizeof(*capacity), kStatus_USB_Success);
+    return kStatus_USB_Success;
+}
+
+usb_status_t USB_HostMsdReadCapacity(usb_host_class_handle classHandle,
+                                     uint8_t logicalUnit,
+                                     uint8_t *buffer,
+                                     uint32_t bufferLength,
+                                     transfer_callback_t callbackFn,
+                                     void *callbackParam)
+{
+    usb_host_ufi_read_capacity_t *capacity = (usb_host_ufi_read_capacity_t *)buffer;
+    uint64_t last                          = UsbMsdSimSectors(logicalUnit) - 1U;
+
+    if ((UsbMsdSimGetDisk(classHandle, logicalUnit) == NULL) || (bufferLength < sizeof(*capacity)))
+    {
+        return kStatus_USB_InvalidParameter;
+    }
+    /* READ CAPACITY(10) saturates, the 2TB limit of the 32bit commands */
+    if (last > 0xffffffffU)
+    {
+        last = 0xffffffffU;
+    }
+    for (uint32_t i = 0U; i < 4U; ++i)
+    {
+        capacity->lastLogicalBlockAddress[i] = (uint8_t)(last >> (24U - 8U * i));
+        capacity->blockLengthInBytes[i]      = (uint8_t)(USB_MSD_SIM_SECTOR_SIZE >> (24U - 8U * i));
+    }
+    s_simStat.otherCommands++;
+    UsbMsdSimElapse(&s_simRead, 0U);
+    callbackFn(callbackParam, buffer, sizeof(*capacity), kStatus_USB_Success);
+    return kStatus_USB_Success;
+}
+
+usb_status_t USB_HostMsdTestUnitReady(usb_host_class_handle classHandle,
+                                      uint8_t logicalUnit,
+                                      transfer_callback_t callbackFn,
+                                      void *callbackParam)
+{
+    (void)logicalUnit;
+    if ((classHandle == NULL) || (classHandle != g_UsbFatfsClassHandle))
+    {
+        return kStatus_USB_InvalidHandle;
+    }
+    s_simStat.otherCommands++;
+    UsbMsdSimElapse(&s_simRead, 0U);
+    callbackFn(callbackParam, NULL, 0U, kStatus_USB_Success);
+    return kStatus_USB_Success;
+}
+
+usb_status_t USB_HostMsdRequestSense(usb_host_class_handle classHandle,
+                                     uint8_t logicalUnit,
+                                     uint8_t *buffer,
+                                     uint32_t bufferLength,
+                                     transfer_callback_t callbackFn,
+                                     void *callbackParam)
+{
+    (void)logicalUnit;
+    if ((classHandle == NULL) || (classHandle != g_UsbFatfsClassHandle))
+    {
+        return kStatus_USB_InvalidHandle;
+    }
+    /* no sense: errorCode 70h, sense key 0 */
+    memset(buffer, 0, bufferLength);
+    if (bufferLength > 0U)
+    {
+        buffer[0] = 0x70U;
+    }
+    s_simStat.otherCommands++;
+    UsbMsdSimElapse(&s_simRead, 0U);
+    callbackFn(callbackParam, buffer, bufferLength, kStatus_USB_Success);
+    return kStatus_USB_Success;
+}
@@ -0,0 +1,119 @@
+/*
+ * usb_msd_sim.h
+ *
+ *  Created on: 2026/10/18
+ *      Author: M.Akino
+ */
+
+#ifndef USB_MSD_SIM_H_
+#define USB_MSD_SIM_H_
+
+#include <stdint.h>
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+
+/*! @brief simulated command time: command + sectors * 512 / 1024 * kbyte microseconds */
+typedef struct _usb_msd_sim_latency
+{
+    uint32_t command; /*!< microseconds per command, CBW/CSW and the stick's own lookup */
+    uint32_t kbyte;   /*!< microseconds per KB of data */
+} usb_msd_sim_latency_t;
+
+/*! @brief flash translation layer model
+ *
+ * The stick maps each written sector to a flash page and has spare pages beyond the logical size. The
+ * erased pages of a new stick take the first writes for free, after that every write waits for the garbage
+ * collection to copy the valid pages out of the blocks it erases. With the valid pages spread evenly that is
+ * u / (1 - u) pages per page written, u being the valid share of all pages: deleted files keep their
+ * pages valid until UNMAP tells the stick, so a full stick without it copies most of what it erases.
+ */
+typedef struct _usb_msd_sim_flash
+{
+    uint32_t spare;     /*!< spare pages in permille of the logical sectors, 0: no flash model */
+    uint32_t copyKbyte; /*!< microseconds per KB copied by the garbage collection */
+    uint8_t unmap;      /*!< 1: READ CAPACITY(16) reports LBPME and UNMAP invalidates the pages */
+} usb_msd_sim_flash_t;
+
+/*! @brief simulated disk statistics */
+typedef struct _usb_msd_sim_stat
+{
+    uint32_t readCommands;  /*!< read10/16 commands, all logical units */
+    uint32_t readSectors;   /*!< sectors read */
+    uint32_t writeCommands; /*!< write10/16 commands */
+    uint32_t writeSectors;  /*!< sectors written */
+    uint32_t unmapCommands; /*!< UNMAP commands */
+    uint32_t unmapSectors;  /*!< sectors unmapped */
+    uint32_t otherCommands; /*!< test unit ready, request sense, read capacity (10/16) */
+    uint32_t failures;      /*!< injected command failures */
+    uint64_t gcSectors;     /*!< pages copied by the garbage collection of the flash model */
+    uint64_t busyUs;        /*!< simulated time spent in commands */
+} usb_msd_sim_stat_t;
+
+/*******************************************************************************
+ * API
+ ******************************************************************************/
+
+/*!
+ * @brief insert the media of a logical unit: map an image file, or allocate a zeroed RAM disk when path is NULL.
+ *
+ * The device attaches with the first media, LUN 0 and 1 are served.
+ *
+ * @param lun     logical unit number.
+ * @param path    image file, created or extended to bytes when it is shorter.
+ * @param bytes   disk size, 0: the size of the existing image.
+ * @return 0 on success.
+ */
+extern int UsbMsdSimOpen(uint8_t lun, const char *path, uint64_t bytes);
+
+/*!
+ * @brief detach the device, the image files are written back.
+ */
+extern void UsbMsdSimClose(void);
+
+/*!
+ * @brief set the latency model.
+ *
+ * @param read    read10 latency.
+ * @param write   write10 latency.
+ */
+extern void UsbMsdSimSetLatency(const usb_msd_sim_latency_t *read, const usb_msd_sim_latency_t *write);
+
+/*!
+ * @brief fail a read10/write10 with a CSW error about once every interval commands, never twice in a
+ * row so the driver retry has to absorb it.
+ *
+ * @param interval  0: no failures.
+ * @param seed      random seed.
+ */
+extern void UsbMsdSimSetFailure(uint32_t interval, uint32_t seed);
+
+/*!
+ * @brief set the flash model and the UNMAP support, every logical unit starts over as a new stick.
+ *
+ * Without the model (spare 0, the default) writes cost the write10 latency only. A RAM disk reads zeros
+ * from unmapped sectors so a trim of live data shows up as a data error, an image keeps the data.
+ *
+ * @param flash   model parameters.
+ * @return 0 on success, -1: no memory for the page map.
+ */
+extern int UsbMsdSimSetFlash(const usb_msd_sim_flash_t *flash);
+
+/*!
+ * @brief get the media size of a logical unit.
+ *
+ * @param lun     logical unit number.
+ * @return number of 512 byte sectors, 0: no media.
+ */
+extern uint64_t UsbMsdSimSectors(uint8_t lun);
+
+/*!
+ * @brief take a snapshot of the statistics and optionally clear them.
+ *
+ * @param stat    snapshot destination.
+ * @param reset   1: clear the statistics after the snapshot.
+ */
+extern void UsbMsdSimGetStat(usb_msd_sim_stat_t *stat, uint8_t reset);
+
+#endif /* USB_MSD_SIM_H_ */
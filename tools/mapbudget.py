@@ -0,0 +1,73 @@
+#!/usr/bin/env python3
+#
+# mapbudget.py
+#
+#  Created on: 2026/10/18
+#      Author: M.Akino
+#
+# Memory budget report from the GNU ld map file of the MCUXpresso build
+# (soft/Debug/evkmimxrt1010UsbMidiHost.map).
+# Prints the use of each memory region and its largest input sections,
+# e.g. to check the task stack area in SRAM_ITC and the FreeRTOS heap and
+# USB buffers in SRAM_DTC of both STATIC_ALLOCATION_ENABLE builds.
+#
+# usage: mapbudget.py FILE.map [top count]
+
+import re
+import sys
+
+REGION = re.compile(r'^(\S+)\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)(\s+\S+)?\s*$')
+SECTION = re.compile(r'^ (\S+)?\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)\s+(\S.*)$')
+NAME_ONLY = re.compile(r'^ (\S+)\s*$')
+
+
+def parse(path):
+    regions = []
+    sections = []
+    state = None
+    pending = None
+    with open(path, errors='replace') as f:
+        for line in f:
+            line = line.rstrip('\r\n')
+            if line.startswith('Memory Configuration'):
+                state = 'memory'
+                continue
+            if line.startswith('Linker script and memory map'):
+                state = 'map'
+                continue
+            if state == 'memory':
+                m = REGION.match(line)
+                if m and m.group(1) not in ('Name', '*default*'):
+                    regions.append((m.group(1), int(m.group(2), 16), int(m.group(3), 16)))
+            elif state == 'map':
+                m = SECTION.match(line)
+                if m:
+                    name = m.group(1) or pending
+                    pending = None
+                    addr, size = int(m.group(2), 16), int(m.group(3), 16)
+                    if name and size and addr:
+                        sections.append((name, addr, size, m.group(4).strip()))
+                    continue
+                m = NAME_ONLY.match(line)
+                pending = m.group(1) if m else None
+    return regions, sections
+
+
+def main(argv):
+    if len(argv) < 2:
+        raise SystemExit('usage: %s FILE.map [top count]' % argv[0])
+    top = int(argv[2]) if len(argv) > 2 else 10
+    regions, sections = parse(argv[1])
+    for name, origin, length in regions:
+        if length == 0:
+            continue
+        inside = [s for s in sections if origin <= s[1] < origin + length]
+        used = sum(s[2] for s in inside)
+        print('%-14s 0x%08x %8d / %8d bytes (%5.1f%%) free %d' %
+              (name, origin, used, length, used * 100.0 / length, length - used))
+        for sname, addr, size, obj in sorted(inside, key=lambda s: -s[2])[:top]:
+            print('    %8d  0x%08x  %-40s %s' % (size, addr, sname, obj))
+
+
+if __name__ == '__main__':
+    main(sys.argv)
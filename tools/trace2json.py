@@ -0,0 +1,123 @@
+#!/usr/bin/env python3
+#
+# trace2json.py
+#
+#  Created on: 2026/10/18
+#      Author: M.Akino
+#
+# Convert a trace file written by the DebugMonitor "TraceSave" command
+# (soft/source/trace_recorder.h) to the Chrome trace event format.
+# Open the output with https://ui.perfetto.dev or chrome://tracing.
+#
+# usage: trace2json.py TRACE.BIN [out.json]
+
+import json
+import struct
+import sys
+
+HEADER = struct.Struct('<4sHHIIII')
+TASK = struct.Struct('<I12s')
+RECORD = struct.Struct('<IBBH')
+
+EV_TASK_SWITCH_IN = 1
+EV_ISR_ENTER = 2
+EV_ISR_EXIT = 3
+EV_NOTIFY = 4
+EV_NOTIFY_FROM_ISR = 5
+EV_NOTIFY_GIVE_FROM_ISR = 6
+EV_NOTIFY_TAKE = 7
+EV_NOTIFY_WAIT = 8
+EV_USB_SUBMIT = 9
+EV_USB_DONE = 10
+EV_USB_ERROR = 11
+EV_USER = 12
+
+NOTIFY_NAME = {
+    EV_NOTIFY: 'notify',
+    EV_NOTIFY_FROM_ISR: 'notify from isr',
+    EV_NOTIFY_GIVE_FROM_ISR: 'notify give from isr',
+    EV_NOTIFY_TAKE: 'notify take',
+    EV_NOTIFY_WAIT: 'notify wait',
+}
+
+PID = 1
+TID_ISR = 1000
+TID_USB = 1001
+TID_USER = 1002
+
+
+def load(path):
+    with open(path, 'rb') as f:
+        data = f.read()
+    magic, version, size, clock, records, tasks, dropped = HEADER.unpack_from(data, 0)
+    if magic != b'RTRC' or version != 1 or size != RECORD.size:
+        raise SystemExit('%s: not a version 1 trace file' % path)
+    ofs = HEADER.size
+    names = {}
+    for _ in range(tasks):
+        number, name = TASK.unpack_from(data, ofs)
+        names[number] = name.split(b'\0', 1)[0].decode('ascii', 'replace')
+        ofs += TASK.size
+    recs = [RECORD.unpack_from(data, ofs + i * RECORD.size) for i in range(records)]
+    return clock, dropped, names, recs
+
+
+def convert(clock, dropped, names, recs):
+    events = []
+    per_us = clock / 1000000.0
+
+    def meta(tid, name):
+        events.append({'ph': 'M', 'pid': PID, 'tid': tid, 'name': 'thread_name', 'args': {'name': name}})
+
+    for number, name in sorted(names.items()):
+        meta(number, name)
+    meta(TID_ISR, 'ISR')
+    meta(TID_USB, 'USB')
+    meta(TID_USER, 'user')
+
+    now = 0  # unwrapped cycles since the first record
+    last = recs[0][0] if recs else 0
+    running = None  # (task number, start us)
+    for cycles, event, arg8, arg16 in recs:
+        now += (cycles - last) & 0xFFFFFFFF
+        last = cycles
+        ts = now / per_us
+
+        if event == EV_TASK_SWITCH_IN:
+            if running is not None:
+                events.append({'ph': 'X', 'pid': PID, 'tid': running[0], 'ts': running[1],
+                               'dur': ts - running[1], 'name': names.get(running[0], 'task %d' % running[0])})
+            running = (arg16, ts)
+        elif event == EV_ISR_ENTER:
+            events.append({'ph': 'B', 'pid': PID, 'tid': TID_ISR, 'ts': ts, 'name': 'IRQ %d' % arg8})
+        elif event == EV_ISR_EXIT:
+            events.append({'ph': 'E', 'pid': PID, 'tid': TID_ISR, 'ts': ts, 'name': 'IRQ %d' % arg8})
+        elif event in NOTIFY_NAME:
+            events.append({'ph': 'i', 's': 't', 'pid': PID, 'tid': arg16, 'ts': ts,
+                           'name': NOTIFY_NAME[event], 'args': {'index': arg8}})
+        elif event in (EV_USB_SUBMIT, EV_USB_DONE, EV_USB_ERROR):
+            ep = 'EP%d %s' % (arg8 & 0x0F, 'IN' if arg8 & 0x80 else 'OUT')
+            kind = {EV_USB_SUBMIT: 'submit', EV_USB_DONE: 'done', EV_USB_ERROR: 'error'}[event]
+            args = {'status': arg16} if event == EV_USB_ERROR else {'length': arg16}
+            events.append({'ph': 'i', 's': 't', 'pid': PID, 'tid': TID_USB, 'ts': ts,
+                           'name': '%s %s' % (ep, kind), 'args': args})
+        elif event == EV_USER:
+            events.append({'ph': 'i', 's': 't', 'pid': PID, 'tid': TID_USER, 'ts': ts,
+                           'name': 'user', 'args': {'arg8': arg8, 'arg16': arg16}})
+
+    return {'traceEvents': events, 'displayTimeUnit': 'ns',
+            'otherData': {'coreClock': clock, 'records': len(recs), 'dropped': dropped}}
+
+
+def main(argv):
+    if len(argv) < 2:
+        raise SystemExit('usage: %s TRACE.BIN [out.json]' % argv[0])
+    out = argv[2] if len(argv) > 2 else argv[1].rsplit('.', 1)[0] + '.json'
+    trace = convert(*load(argv[1]))
+    with open(out, 'w') as f:
+        json.dump(trace, f)
+    print('%s: %d events -> %s' % (argv[1], len(trace['traceEvents']), out))
+
+
+if __name__ == '__main__':
+    main(sys.argv)